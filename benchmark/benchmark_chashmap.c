@@ -31,8 +31,42 @@ void benchmark_chashmap_set()
     hashmap_free(map);
 }
 
+void benchmark_chashmap_miss()
+{
+    hashmap *map;
+    clock_t start_t, end_t;
+    int found = 0;
+
+    map = hashmap_new(sizeof(int), sizeof(int), 123456, NULL, NULL);
+    for (int i = 0; i < TEST_SIZE; i++)
+    {
+        hashmap_set(map, &i, &i);
+    }
+
+    for (int filter = 0; filter < 2; filter++)
+    {
+        if (filter)
+        {
+            hashmap_filter_enable(map, 10, 1);
+        }
+
+        start_t = clock();
+        for (int i = TEST_SIZE; i < TEST_SIZE * 10; i++)
+        {
+            found += hashmap_exist(map, &i);
+        }
+        end_t = clock();
+        printf("filter %i miss %i th time consuming: %fs\n", filter, TEST_SIZE * 9, (double)(end_t - start_t) / CLOCKS_PER_SEC);
+    }
+
+    hashmap_filter_stats stats = hashmap_filter_get_stats(map->filter);
+    printf("filter bytes %zu fpr %f found %i\n", stats.bytes, stats.fpr, found);
+    hashmap_free(map);
+}
+
 int main()
 {
     benchmark_chashmap_set();
+    benchmark_chashmap_miss();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "../chashmap_parallel.h"
+#include "../cpool.h"
+#include "../cvec_sort.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define FOR_SIZE  200000000
+#define SORT_SIZE 10000000
+#define MAP_SIZE  2000000
+#define MAX_THREADS 64
+
+static double wall()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void hash_range(usize begin, usize end, void *ctx)
+{
+    u64 h = 0;
+    for (usize i = begin; i < end; i++)
+    {
+        u64 x = i * 0x9e3779b97f4a7c15ull;
+        h += x ^ (x >> 29);
+    }
+    __atomic_add_fetch((u64 *)ctx, h, __ATOMIC_RELAXED);
+}
+
+static void sum_value(void *key, void *value, void *ctx)
+{
+    (void)key;
+    __atomic_add_fetch((u64 *)ctx, *(u64 *)value, __ATOMIC_RELAXED);
+}
+
+int main()
+{
+    vec *src = vec_new(sizeof(u32));
+    u64 rng = 88172645463325252ull;
+    for (usize i = 0; i < SORT_SIZE; i++)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        u32 x = (u32)rng;
+        vec_push(src, &x);
+    }
+
+    hashmap *map = hashmap_new(sizeof(u64), sizeof(u64), 0, NULL, NULL);
+    for (u64 i = 0; i < MAP_SIZE; i++)
+    {
+        hashmap_set(map, &i, &i);
+    }
+
+    double base_for = 0, base_sort = 0, base_map = 0;
+    for (usize threads = 1; threads <= MAX_THREADS; threads *= 2)
+    {
+        cpool *pool = cpool_new(threads);
+        double start_t, t;
+        u64 sum = 0;
+
+        start_t = wall();
+        cpool_parallel_for(pool, 0, FOR_SIZE, 0, hash_range, &sum);
+        t = wall() - start_t;
+        base_for = threads == 1 ? t : base_for;
+        printf("cpool_parallel_for %i %zu threads time consuming: %fs speedup %.2f\n", FOR_SIZE, threads, t, base_for / t);
+
+        vec *v = vec_clone(src);
+        start_t = wall();
+        vec_sort_pool(v, NULL, pool);
+        t = wall() - start_t;
+        base_sort = threads == 1 ? t : base_sort;
+        printf("vec_sort_pool %i %zu threads time consuming: %fs speedup %.2f\n", SORT_SIZE, threads, t, base_sort / t);
+        vec_free(v);
+
+        sum = 0;
+        start_t = wall();
+        hashmap_parallel_for_each(map, pool, sum_value, &sum);
+        t = wall() - start_t;
+        base_map = threads == 1 ? t : base_map;
+        printf("hashmap_parallel_for_each %i %zu threads time consuming: %fs speedup %.2f\n", MAP_SIZE, threads, t, base_map / t);
+
+        cpool_free(pool);
+    }
+
+    hashmap_free(map);
+    vec_free(src);
+    return 0;
+}
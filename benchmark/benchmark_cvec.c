@@ -0,0 +1,206 @@
+#ifdef BENCHMARK_AMALGAMATION
+#define CEXTLIB_IMPLEMENTATION
+#include "../cextlib.h"
+#else
+#include "../chashmap.h"
+#include "../cstring.h"
+#include "../cvec.h"
+#endif
+#include <stdio.h>
+#include <time.h>
+
+#define TEST_SIZE 50000000
+#define MAP_SIZE  1000000
+#define FIND_SIZE 100000000
+#define BULK_SIZE 1000000
+#define BULK_K    10000
+
+void benchmark_cvec_push_get()
+{
+    clock_t start_t, end_t;
+    vec *v = vec_new(sizeof(int));
+
+    start_t = clock();
+    for (int i = 0; i < TEST_SIZE; i++)
+    {
+        vec_push(v, &i);
+    }
+    end_t = clock();
+    printf("vec_push %i th time consuming: %fs\n", TEST_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC);
+
+    i64 sum = 0;
+    start_t = clock();
+    for (int round = 0; round < 4; round++)
+    {
+        for (size i = 0; i < TEST_SIZE; i++)
+        {
+            sum += *(int *)vec_get(v, i);
+        }
+    }
+    end_t = clock();
+    printf("vec_get %i th time consuming: %fs sum %lld\n", TEST_SIZE * 4, (double)(end_t - start_t) / CLOCKS_PER_SEC, (long long)sum);
+    vec_free(v);
+}
+
+VEC_DEFINE(vec_int, int)
+
+void benchmark_cvec_typed_push_get()
+{
+    clock_t start_t, end_t;
+    vec *v = vec_int_new();
+
+    start_t = clock();
+    for (int i = 0; i < TEST_SIZE; i++)
+    {
+        vec_int_push(v, i);
+    }
+    end_t = clock();
+    printf("vec_int_push %i th time consuming: %fs\n", TEST_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC);
+
+    i64 sum = 0;
+    start_t = clock();
+    for (int round = 0; round < 4; round++)
+    {
+        for (size i = 0; i < TEST_SIZE; i++)
+        {
+            sum += *vec_int_get(v, i);
+        }
+    }
+    end_t = clock();
+    printf("vec_int_get %i th time consuming: %fs sum %lld\n", TEST_SIZE * 4, (double)(end_t - start_t) / CLOCKS_PER_SEC, (long long)sum);
+    vec_free(v);
+}
+
+b32 int_eq(void *a, void *b)
+{
+    return *(int *)a == *(int *)b;
+}
+
+void benchmark_cvec_find()
+{
+    clock_t start_t, end_t;
+    vec *v = vec_int_new();
+    for (int i = 0; i < FIND_SIZE; i++)
+    {
+        vec_int_push(v, i & 0xffff);
+    }
+    double gb = (double)FIND_SIZE * sizeof(int) / 1e9;
+
+    int miss = -1;
+    start_t = clock();
+    size r = vec_find(v, &miss, int_eq);
+    end_t = clock();
+    printf("vec_find %i th time consuming: %fs %.2fGB/s ret %td\n", FIND_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC, gb / ((double)(end_t - start_t) / CLOCKS_PER_SEC), r);
+
+    start_t = clock();
+    r = vec_find_default(v, &miss);
+    end_t = clock();
+    printf("vec_find_default %i th time consuming: %fs %.2fGB/s ret %td\n", FIND_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC, gb / ((double)(end_t - start_t) / CLOCKS_PER_SEC), r);
+
+    int hit = 7;
+    start_t = clock();
+    r = vec_count_eq(v, &hit);
+    end_t = clock();
+    printf("vec_count_eq %i th time consuming: %fs %.2fGB/s ret %td\n", FIND_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC, gb / ((double)(end_t - start_t) / CLOCKS_PER_SEC), r);
+
+    u64 *bitmap = (u64 *)malloc((FIND_SIZE + 63) / 64 * sizeof(u64));
+    start_t = clock();
+    r = vec_find_all(v, &hit, bitmap);
+    end_t = clock();
+    printf("vec_find_all %i th time consuming: %fs %.2fGB/s ret %td\n", FIND_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC, gb / ((double)(end_t - start_t) / CLOCKS_PER_SEC), r);
+    free(bitmap);
+    vec_free(v);
+}
+
+void benchmark_cvec_bulk()
+{
+    clock_t start_t, end_t;
+    int *src = (int *)malloc(BULK_K * sizeof(int));
+    for (int i = 0; i < BULK_K; i++)
+    {
+        src[i] = i;
+    }
+
+    vec *v = vec_int_new();
+    vec_reserve(v, BULK_SIZE);
+    for (int i = 0; i < BULK_SIZE; i++)
+    {
+        vec_int_push(v, i);
+    }
+    start_t = clock();
+    for (int i = 0; i < BULK_K; i++)
+    {
+        vec_insert(v, src + i, BULK_SIZE / 2 + i);
+    }
+    end_t = clock();
+    printf("vec_insert %i x %i th time consuming: %fs\n", BULK_K, BULK_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC);
+
+    start_t = clock();
+    for (int i = 0; i < BULK_K; i++)
+    {
+        vec_remove(v, BULK_SIZE / 2);
+    }
+    end_t = clock();
+    printf("vec_remove %i x %i th time consuming: %fs\n", BULK_K, BULK_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC);
+
+    start_t = clock();
+    vec_insert_n(v, BULK_SIZE / 2, src, BULK_K);
+    end_t = clock();
+    printf("vec_insert_n %i x %i th time consuming: %fs\n", BULK_K, BULK_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC);
+
+    start_t = clock();
+    vec_remove_range(v, BULK_SIZE / 2, BULK_SIZE / 2 + BULK_K);
+    end_t = clock();
+    printf("vec_remove_range %i x %i th time consuming: %fs\n", BULK_K, BULK_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC);
+    vec_free(v);
+    free(src);
+}
+
+void benchmark_cstring_push_char()
+{
+    clock_t start_t, end_t;
+    string *s = string_new(16);
+
+    start_t = clock();
+    for (int i = 0; i < TEST_SIZE; i++)
+    {
+        string_push_char(s, (char)('a' + i % 26));
+    }
+    end_t = clock();
+    printf("string_push_char %i th time consuming: %fs len %td\n", TEST_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC, s->len);
+    string_free(s);
+}
+
+void benchmark_chashmap_get()
+{
+    clock_t start_t, end_t;
+    hashmap *map = hashmap_new_with_cap(MAP_SIZE * 2, sizeof(u64), sizeof(u64), 123456, NULL, NULL);
+    for (u64 i = 0; i < MAP_SIZE; i++)
+    {
+        hashmap_set(map, &i, &i);
+    }
+
+    u64 sum = 0;
+    start_t = clock();
+    for (int round = 0; round < 10; round++)
+    {
+        for (u64 i = 0; i < MAP_SIZE; i++)
+        {
+            sum += *(u64 *)hashmap_get(map, &i);
+        }
+    }
+    end_t = clock();
+    printf("hashmap_get %i th time consuming: %fs sum %llu\n", MAP_SIZE * 10, (double)(end_t - start_t) / CLOCKS_PER_SEC, (unsigned long long)sum);
+    hashmap_free(map);
+}
+
+int main()
+{
+    benchmark_cvec_push_get();
+    benchmark_cvec_typed_push_get();
+    benchmark_cvec_find();
+    benchmark_cvec_bulk();
+    benchmark_cstring_push_char();
+    benchmark_chashmap_get();
+    return 0;
+}
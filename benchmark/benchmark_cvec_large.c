@@ -0,0 +1,52 @@
+#include "../cvec.h"
+#include <stdio.h>
+#include <time.h>
+
+// 超过u32的元素个数, 约4GB内存
+#ifndef LARGE_SIZE
+#define LARGE_SIZE (((i64)1 << 32) + 1024)
+#endif
+
+void benchmark_cvec_large_push_get()
+{
+    clock_t start_t, end_t;
+    vec *v = vec_new(sizeof(u8));
+
+    start_t = clock();
+    for (i64 i = 0; i < LARGE_SIZE; i++)
+    {
+        u8 b = (u8)i;
+        if (vec_push(v, &b) < 0)
+        {
+            printf("vec_push failed at %lld\n", (long long)i);
+            vec_free(v);
+            return;
+        }
+    }
+    end_t = clock();
+    printf("vec_push %lld th time consuming: %fs len %zu cap %zu mapped %d\n", (long long)LARGE_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC, v->len, v->cap, v->mem_kind == VEC_MEM_MAPPED);
+
+    u64 sum = 0;
+    start_t = clock();
+    for (size i = 0; i < LARGE_SIZE; i++)
+    {
+        sum += *(u8 *)vec_get(v, i);
+    }
+    end_t = clock();
+    printf("vec_get %lld th time consuming: %fs sum %llu last %d\n", (long long)LARGE_SIZE, (double)(end_t - start_t) / CLOCKS_PER_SEC, (unsigned long long)sum, *(u8 *)vec_get(v, -1));
+
+    start_t = clock();
+    vec *s = vec_slice(v, LARGE_SIZE - 1024, LARGE_SIZE);
+    vec *c = vec_clone(s);
+    end_t = clock();
+    printf("vec_slice vec_clone time consuming: %fs len %zu\n", (double)(end_t - start_t) / CLOCKS_PER_SEC, c->len);
+    vec_free(c);
+    vec_free(s);
+    vec_free(v);
+}
+
+int main()
+{
+    benchmark_cvec_large_push_get();
+    return 0;
+}
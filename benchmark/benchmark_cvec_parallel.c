@@ -0,0 +1,101 @@
+#include "../cvec_parallel.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_SIZE 100000000
+
+static double wall()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void scale(const void *in, void *out, usize n, void *ctx)
+{
+    const i32 *p = (const i32 *)in;
+    i32 *q = (i32 *)out;
+    i32 k = *(i32 *)ctx;
+    for (usize i = 0; i < n; i++)
+    {
+        q[i] = p[i] * k + 1;
+    }
+}
+
+static b32 is_positive(const void *elem, void *ctx)
+{
+    (void)ctx;
+    return *(const i32 *)elem > 0;
+}
+
+static void add_i32(void *acc, const void *x, void *ctx)
+{
+    (void)ctx;
+    *(i32 *)acc += *(const i32 *)x;
+}
+
+int main()
+{
+    vec *src = vec_new(sizeof(i32));
+    vec_reserve(src, TEST_SIZE);
+    u32 rng = 2463534242u;
+    for (int i = 0; i < TEST_SIZE; i++)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        i32 x = (i32)(rng % 2001) - 1000;
+        vec_push(src, &x);
+    }
+    vec *dst = vec_new(sizeof(i32));
+    i32 k = 3, zero = 0, r = 0;
+    double start_t;
+
+    // 单线程循环, dst预先写一遍避免计入缺页
+    vec_reserve(dst, TEST_SIZE);
+    memset(dst->mem, 0, (usize)TEST_SIZE * sizeof(i32));
+    start_t = wall();
+    scale(src->mem, dst->mem, TEST_SIZE, &k);
+    dst->len = TEST_SIZE;
+    printf("loop map %i time consuming: %fs\n", TEST_SIZE, wall() - start_t);
+
+    start_t = wall();
+    r = 0;
+    for (int i = 0; i < TEST_SIZE; i++)
+    {
+        r += ((i32 *)src->mem)[i];
+    }
+    printf("loop sum %i time consuming: %fs ret %d\n", TEST_SIZE, wall() - start_t, r);
+
+    for (usize threads = 1; threads <= 8; threads *= 2)
+    {
+        cpool *pool = cpool_new(threads);
+
+        start_t = wall();
+        vec_map(dst, src, scale, &k, pool);
+        printf("vec_map %i %zu threads time consuming: %fs\n", TEST_SIZE, threads, wall() - start_t);
+
+        start_t = wall();
+        vec_filter(dst, src, is_positive, NULL, pool);
+        printf("vec_filter %i %zu threads time consuming: %fs len %zu\n", TEST_SIZE, threads, wall() - start_t, (usize)dst->len);
+
+        start_t = wall();
+        vec_reduce(src, &r, &zero, vec_op_sum_i32, NULL, pool);
+        printf("vec_reduce sum %i %zu threads time consuming: %fs ret %d\n", TEST_SIZE, threads, wall() - start_t, r);
+
+        start_t = wall();
+        vec_reduce(src, &r, &zero, add_i32, NULL, pool);
+        printf("vec_reduce generic %i %zu threads time consuming: %fs ret %d\n", TEST_SIZE, threads, wall() - start_t, r);
+
+        start_t = wall();
+        vec_scan(dst, src, &zero, vec_op_sum_i32, NULL, pool);
+        printf("vec_scan sum %i %zu threads time consuming: %fs ret %d\n", TEST_SIZE, threads, wall() - start_t, ((i32 *)dst->mem)[TEST_SIZE - 1]);
+
+        cpool_free(pool);
+    }
+
+    vec_free(src);
+    vec_free(dst);
+    return 0;
+}
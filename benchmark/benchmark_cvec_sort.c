@@ -0,0 +1,175 @@
+#include "../cvec_sort.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 使用墙上时间, 多线程排序的时间与CPU核数有关
+// 可以用-DSORT_MAX_SIZE=1000000000测试10亿个元素, 需要约8GB内存
+#ifndef SORT_MAX_SIZE
+#define SORT_MAX_SIZE 100000000
+#endif
+
+typedef struct rec
+{
+    u64 key;
+    u64 payload;
+} rec;
+
+static int cmp_u32(const void *a, const void *b)
+{
+    u32 x = *(const u32 *)a, y = *(const u32 *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int cmp_rec(const void *a, const void *b)
+{
+    u64 x = ((const rec *)a)->key, y = ((const rec *)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+static u64 key_rec(const void *elem)
+{
+    return ((const rec *)elem)->key;
+}
+
+static u64 rng_state = 88172645463325252ull;
+
+static u64 rng()
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void fill(vec *v, usize n)
+{
+    rng_state = 88172645463325252ull;
+    v->len = 0;
+    for (usize i = 0; i < n; i++)
+    {
+        rec r = {rng(), i};
+        vec_push(v, &r);
+    }
+}
+
+static double wall()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void benchmark_sort(const char *name, usize vsize, usize n, int (*cmp)(const void *, const void *), u64 (*key)(const void *))
+{
+    vec *v = vec_new(vsize);
+    double start_t;
+
+    fill(v, n);
+    start_t = wall();
+    qsort(v->mem, v->len, v->vsize, cmp);
+    printf("%s %zu qsort time consuming: %fs\n", name, n, wall() - start_t);
+
+    fill(v, n);
+    start_t = wall();
+    vec_sort(v, vsize == sizeof(rec) ? cmp : NULL);
+    printf("%s %zu vec_sort time consuming: %fs\n", name, n, wall() - start_t);
+
+    fill(v, n);
+    start_t = wall();
+    vec_sort_radix(v, key);
+    printf("%s %zu vec_sort_radix time consuming: %fs\n", name, n, wall() - start_t);
+
+    for (usize threads = 2; threads <= 8; threads *= 2)
+    {
+        fill(v, n);
+        start_t = wall();
+        vec_sort_parallel(v, vsize == sizeof(rec) ? cmp : NULL, threads);
+        printf("%s %zu vec_sort_parallel %zu threads time consuming: %fs\n", name, n, threads, wall() - start_t);
+    }
+
+    vec_free(v);
+}
+
+void benchmark_sorted(usize n)
+{
+    vec *a = vec_new(sizeof(u32));
+    vec *b = vec_new(sizeof(u32));
+    double start_t;
+    usize hit = 0;
+
+    rng_state = 88172645463325252ull;
+    for (usize i = 0; i < n; i++)
+    {
+        u32 x = (u32)rng() % (n * 4), y = (u32)rng() % (n * 4);
+        vec_push(a, &x);
+        vec_push(b, &y);
+    }
+    vec_sort(a, NULL);
+    vec_dedup_sorted(a, NULL);
+    vec_sort(b, NULL);
+    vec_dedup_sorted(b, NULL);
+
+    start_t = wall();
+    for (usize i = 0; i < n; i++)
+    {
+        u32 x = ((u32 *)b->mem)[i * 2654435761u % b->len];
+        hit += bsearch(&x, a->mem, a->len, sizeof(u32), cmp_u32) != NULL;
+    }
+    printf("u32 %zu bsearch time consuming: %fs (%zu)\n", n, wall() - start_t, hit);
+
+    hit = 0;
+    start_t = wall();
+    for (usize i = 0; i < n; i++)
+    {
+        hit += vec_contains_sorted(a, (u32 *)b->mem + i * 2654435761u % b->len, NULL);
+    }
+    printf("u32 %zu vec_contains_sorted time consuming: %fs (%zu)\n", n, wall() - start_t, hit);
+
+    start_t = wall();
+    vec *r = vec_intersect_sorted(a, b, cmp_u32);
+    printf("u32 %zu vec_intersect_sorted cmp time consuming: %fs (%zu)\n", n, wall() - start_t, (usize)r->len);
+    vec_free(r);
+
+    start_t = wall();
+    r = vec_intersect_sorted(a, b, NULL);
+    printf("u32 %zu vec_intersect_sorted time consuming: %fs (%zu)\n", n, wall() - start_t, (usize)r->len);
+    vec_free(r);
+
+    // 较小的一边只有1/1000时倍增查找
+    vec *c = vec_slice(b, 0, b->len / 1000);
+    start_t = wall();
+    for (int k = 0; k < 100; k++)
+    {
+        r = vec_intersect_sorted(c, a, NULL);
+        vec_free(r);
+    }
+    printf("u32 %zu x %zu vec_intersect_sorted gallop 100 times time consuming: %fs\n", (usize)c->len, (usize)a->len, wall() - start_t);
+
+    start_t = wall();
+    r = vec_union_sorted(a, b, NULL);
+    printf("u32 %zu vec_union_sorted time consuming: %fs (%zu)\n", n, wall() - start_t, (usize)r->len);
+    vec_free(r);
+
+    vec_free(a);
+    vec_free(b);
+    vec_free(c);
+}
+
+int main()
+{
+    for (usize n = 10000000; n <= SORT_MAX_SIZE; n *= 10)
+    {
+        benchmark_sort("u32", sizeof(u32), n, cmp_u32, NULL);
+        benchmark_sort("u64", sizeof(u64), n, cmp_u64, NULL);
+    }
+    benchmark_sort("rec16", sizeof(rec), 10000000, cmp_rec, key_rec);
+    benchmark_sorted(10000000);
+    return 0;
+}
@@ -0,0 +1,1191 @@
+#include "cart.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define PTR_LEN sizeof(uintptr_t)
+
+#define ART_IS_LEAF(p) ((uintptr_t)(p) & 1)
+#define ART_LEAF(p)    ((art_leaf *)((uintptr_t)(p) & ~(uintptr_t)1))
+#define ART_TAG(l)     ((void *)((uintptr_t)(l) | 1))
+
+static inline usize _art_min(usize a, usize b)
+{
+    return a < b ? a : b;
+}
+
+// ============================================================================
+//  叶子节点
+// ============================================================================
+
+static inline u8 *_art_leaf_key(const art *tree, art_leaf *leaf)
+{
+    return leaf->data + tree->vdsize + 1;
+}
+
+static inline void *art_leaf_value(const art *tree, art_leaf *leaf)
+{
+    if (tree->vsize == 0)
+    {
+        return (void *)(*(uintptr_t *)leaf->data);
+    }
+
+    return leaf->data[tree->vdsize] ? leaf->data : NULL;
+}
+
+static void _art_leaf_put_value(const art *tree, art_leaf *leaf, const void *value)
+{
+    if (tree->vsize == 0)
+    {
+        *(uintptr_t *)leaf->data = (uintptr_t)value;
+        return;
+    }
+
+    if (value == NULL)
+    {
+        leaf->data[tree->vdsize] = 0;
+        return;
+    }
+
+    memcpy(leaf->data, value, tree->vdsize);
+    leaf->data[tree->vdsize] = 1;
+}
+
+static art_leaf *_art_leaf_new(const art *tree, const u8 *key, usize len, const void *value)
+{
+    art_leaf *leaf = malloc(sizeof(art_leaf) + tree->vdsize + 1 + len);
+    if (leaf == NULL)
+    {
+        return NULL;
+    }
+
+    leaf->len = len;
+    memcpy(_art_leaf_key(tree, leaf), key, len);
+    _art_leaf_put_value(tree, leaf, value);
+    return leaf;
+}
+
+static void _art_leaf_free(art *tree, art_leaf *leaf)
+{
+    void *value = art_leaf_value(tree, leaf);
+    if (tree->vfree && value)
+    {
+        tree->vfree(value);
+    }
+
+    free(leaf);
+}
+
+static inline b32 _art_leaf_match(const art *tree, art_leaf *leaf, const u8 *key, usize len)
+{
+    return leaf->len == len && memcmp(_art_leaf_key(tree, leaf), key, len) == 0;
+}
+
+// ============================================================================
+//  内部节点
+// ============================================================================
+
+static art_node *_art_node_new(u8 type)
+{
+    usize node_size = 0;
+    switch (type)
+    {
+    case ART_NODE4:
+        node_size = sizeof(art_node4);
+        break;
+    case ART_NODE16:
+        node_size = sizeof(art_node16);
+        break;
+    case ART_NODE48:
+        node_size = sizeof(art_node48);
+        break;
+    case ART_NODE256:
+        node_size = sizeof(art_node256);
+        break;
+    }
+
+    art_node *node = calloc(1, node_size);
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    node->type = type;
+    return node;
+}
+
+static void _art_copy_header(art_node *dst, const art_node *src)
+{
+    dst->count = src->count;
+    dst->prefix_len = src->prefix_len;
+    dst->end = src->end;
+    memcpy(dst->prefix, src->prefix, _art_min(ART_MAX_PREFIX, src->prefix_len));
+}
+
+static void _art_free_child(art *tree, void *child)
+{
+    if (ART_IS_LEAF(child))
+    {
+        _art_leaf_free(tree, ART_LEAF(child));
+        return;
+    }
+
+    art_node *node = (art_node *)child;
+    switch (node->type)
+    {
+    case ART_NODE4:
+        for (usize i = 0; i < node->count; i++)
+        {
+            _art_free_child(tree, ((art_node4 *)node)->children[i]);
+        }
+        break;
+    case ART_NODE16:
+        for (usize i = 0; i < node->count; i++)
+        {
+            _art_free_child(tree, ((art_node16 *)node)->children[i]);
+        }
+        break;
+    case ART_NODE48:
+        for (usize i = 0; i < 48; i++)
+        {
+            if (((art_node48 *)node)->children[i])
+            {
+                _art_free_child(tree, ((art_node48 *)node)->children[i]);
+            }
+        }
+        break;
+    case ART_NODE256:
+        for (usize i = 0; i < 256; i++)
+        {
+            if (((art_node256 *)node)->children[i])
+            {
+                _art_free_child(tree, ((art_node256 *)node)->children[i]);
+            }
+        }
+        break;
+    }
+
+    if (node->end)
+    {
+        _art_leaf_free(tree, node->end);
+    }
+    free(node);
+}
+
+/**
+ * @brief node16中等于c的位置, SSE2一次比较16个字节
+ */
+static inline int _art_node16_find(const art_node16 *node, u8 c)
+{
+#if defined(__SSE2__)
+    __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)c), _mm_loadu_si128((const __m128i *)node->keys));
+    u32 mask = (u32)_mm_movemask_epi8(cmp) & ((1u << node->n.count) - 1);
+    return mask ? __builtin_ctz(mask) : -1;
+#else
+    for (int i = 0; i < node->n.count; i++)
+    {
+        if (node->keys[i] == c)
+        {
+            return i;
+        }
+    }
+    return -1;
+#endif
+}
+
+/**
+ * @brief node16中小于c的key个数, 即有序插入的位置
+ */
+static inline usize _art_node16_lower(const art_node16 *node, u8 c)
+{
+#if defined(__SSE2__)
+    // 无符号比较: 翻转符号位后按有符号比较
+    __m128i sign = _mm_set1_epi8((char)0x80);
+    __m128i target = _mm_xor_si128(_mm_set1_epi8((char)c), sign);
+    __m128i keys = _mm_xor_si128(_mm_loadu_si128((const __m128i *)node->keys), sign);
+    u32 mask = (u32)_mm_movemask_epi8(_mm_cmplt_epi8(keys, target)) & ((1u << node->n.count) - 1);
+    return (usize)__builtin_popcount(mask);
+#else
+    usize i = 0;
+    while (i < node->n.count && node->keys[i] < c)
+    {
+        i++;
+    }
+    return i;
+#endif
+}
+
+static void **_art_find_child(art_node *node, u8 c)
+{
+    switch (node->type)
+    {
+    case ART_NODE4:
+    {
+        art_node4 *n4 = (art_node4 *)node;
+        for (usize i = 0; i < node->count; i++)
+        {
+            if (n4->keys[i] == c)
+            {
+                return &n4->children[i];
+            }
+        }
+        return NULL;
+    }
+    case ART_NODE16:
+    {
+        art_node16 *n16 = (art_node16 *)node;
+        int i = _art_node16_find(n16, c);
+        return i < 0 ? NULL : &n16->children[i];
+    }
+    case ART_NODE48:
+    {
+        art_node48 *n48 = (art_node48 *)node;
+        return n48->index[c] ? &n48->children[n48->index[c] - 1] : NULL;
+    }
+    case ART_NODE256:
+    {
+        art_node256 *n256 = (art_node256 *)node;
+        return n256->children[c] ? &n256->children[c] : NULL;
+    }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 子树中字节序最小的叶子节点, 用于读取超出ART_MAX_PREFIX的压缩路径
+ */
+static art_leaf *_art_minimum(void *child)
+{
+    while (!ART_IS_LEAF(child))
+    {
+        art_node *node = (art_node *)child;
+        if (node->end)
+        {
+            return node->end;
+        }
+
+        switch (node->type)
+        {
+        case ART_NODE4:
+            child = ((art_node4 *)node)->children[0];
+            break;
+        case ART_NODE16:
+            child = ((art_node16 *)node)->children[0];
+            break;
+        case ART_NODE48:
+        {
+            art_node48 *n48 = (art_node48 *)node;
+            usize i = 0;
+            while (!n48->index[i])
+            {
+                i++;
+            }
+            child = n48->children[n48->index[i] - 1];
+            break;
+        }
+        case ART_NODE256:
+        {
+            art_node256 *n256 = (art_node256 *)node;
+            usize i = 0;
+            while (!n256->children[i])
+            {
+                i++;
+            }
+            child = n256->children[i];
+            break;
+        }
+        }
+    }
+
+    return ART_LEAF(child);
+}
+
+/**
+ * @brief 比较节点中保存的压缩路径, 查找时使用, 超出ART_MAX_PREFIX的部分由叶子节点确认
+ *
+ * @return 匹配的字节数
+ */
+static usize _art_check_prefix(const art_node *node, const u8 *key, usize len, usize depth)
+{
+    usize max = _art_min(_art_min(node->prefix_len, ART_MAX_PREFIX), len - depth);
+    for (usize i = 0; i < max; i++)
+    {
+        if (node->prefix[i] != key[depth + i])
+        {
+            return i;
+        }
+    }
+
+    return max;
+}
+
+/**
+ * @brief 完整比较压缩路径
+ *
+ * @return 第一个不匹配的位置, 全部匹配返回prefix_len
+ */
+static usize _art_prefix_mismatch(const art *tree, art_node *node, const u8 *key, usize len, usize depth)
+{
+    usize max = _art_min(_art_min(node->prefix_len, ART_MAX_PREFIX), len - depth);
+    usize i = 0;
+    for (; i < max; i++)
+    {
+        if (node->prefix[i] != key[depth + i])
+        {
+            return i;
+        }
+    }
+
+    if (node->prefix_len > ART_MAX_PREFIX)
+    {
+        art_leaf *leaf = _art_minimum(node);
+        const u8 *lkey = _art_leaf_key(tree, leaf);
+        max = _art_min(node->prefix_len, len - depth);
+        for (; i < max; i++)
+        {
+            if (lkey[depth + i] != key[depth + i])
+            {
+                return i;
+            }
+        }
+    }
+
+    return i;
+}
+
+// ============================================================================
+//  增加和删除子节点, 节点类型随子节点个数变化
+// ============================================================================
+
+static int _art_add_child(art_node *node, void **ref, u8 c, void *child);
+
+static int _art_add_child4(art_node4 *node, void **ref, u8 c, void *child)
+{
+    if (node->n.count < 4)
+    {
+        usize i = 0;
+        while (i < node->n.count && node->keys[i] < c)
+        {
+            i++;
+        }
+        memmove(node->keys + i + 1, node->keys + i, node->n.count - i);
+        memmove(node->children + i + 1, node->children + i, PTR_LEN * (node->n.count - i));
+        node->keys[i] = c;
+        node->children[i] = child;
+        node->n.count++;
+        return 0;
+    }
+
+    art_node16 *grown = (art_node16 *)_art_node_new(ART_NODE16);
+    if (grown == NULL)
+    {
+        return 1;
+    }
+
+    _art_copy_header(&grown->n, &node->n);
+    memcpy(grown->keys, node->keys, 4);
+    memcpy(grown->children, node->children, PTR_LEN * 4);
+    *ref = grown;
+    free(node);
+    return _art_add_child(&grown->n, ref, c, child);
+}
+
+static int _art_add_child16(art_node16 *node, void **ref, u8 c, void *child)
+{
+    if (node->n.count < 16)
+    {
+        usize i = _art_node16_lower(node, c);
+        memmove(node->keys + i + 1, node->keys + i, node->n.count - i);
+        memmove(node->children + i + 1, node->children + i, PTR_LEN * (node->n.count - i));
+        node->keys[i] = c;
+        node->children[i] = child;
+        node->n.count++;
+        return 0;
+    }
+
+    art_node48 *grown = (art_node48 *)_art_node_new(ART_NODE48);
+    if (grown == NULL)
+    {
+        return 1;
+    }
+
+    _art_copy_header(&grown->n, &node->n);
+    memcpy(grown->children, node->children, PTR_LEN * 16);
+    for (usize i = 0; i < 16; i++)
+    {
+        grown->index[node->keys[i]] = (u8)(i + 1);
+    }
+    *ref = grown;
+    free(node);
+    return _art_add_child(&grown->n, ref, c, child);
+}
+
+static int _art_add_child48(art_node48 *node, void **ref, u8 c, void *child)
+{
+    if (node->n.count < 48)
+    {
+        usize i = 0;
+        while (node->children[i])
+        {
+            i++;
+        }
+        node->children[i] = child;
+        node->index[c] = (u8)(i + 1);
+        node->n.count++;
+        return 0;
+    }
+
+    art_node256 *grown = (art_node256 *)_art_node_new(ART_NODE256);
+    if (grown == NULL)
+    {
+        return 1;
+    }
+
+    _art_copy_header(&grown->n, &node->n);
+    for (usize i = 0; i < 256; i++)
+    {
+        if (node->index[i])
+        {
+            grown->children[i] = node->children[node->index[i] - 1];
+        }
+    }
+    *ref = grown;
+    free(node);
+    return _art_add_child(&grown->n, ref, c, child);
+}
+
+static int _art_add_child(art_node *node, void **ref, u8 c, void *child)
+{
+    switch (node->type)
+    {
+    case ART_NODE4:
+        return _art_add_child4((art_node4 *)node, ref, c, child);
+    case ART_NODE16:
+        return _art_add_child16((art_node16 *)node, ref, c, child);
+    case ART_NODE48:
+        return _art_add_child48((art_node48 *)node, ref, c, child);
+    case ART_NODE256:
+    {
+        art_node256 *n256 = (art_node256 *)node;
+        n256->children[c] = child;
+        node->count++;
+        return 0;
+    }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief 只剩一个子节点且没有结束的key时, node4与子节点合并
+ */
+static void _art_collapse4(art_node4 *node, void **ref)
+{
+    if (node->n.count == 0)
+    {
+        // 只剩下结束在此节点的key
+        *ref = ART_TAG(node->n.end);
+        free(node);
+        return;
+    }
+
+    if (node->n.count > 1 || node->n.end)
+    {
+        return;
+    }
+
+    void *child = node->children[0];
+    if (!ART_IS_LEAF(child))
+    {
+        // 合并压缩路径: 本节点路径 + 分支字节 + 子节点路径
+        art_node *sub = (art_node *)child;
+        usize prefix = node->n.prefix_len;
+        if (prefix < ART_MAX_PREFIX)
+        {
+            node->n.prefix[prefix] = node->keys[0];
+            prefix++;
+        }
+        if (prefix < ART_MAX_PREFIX)
+        {
+            usize sub_prefix = _art_min(sub->prefix_len, ART_MAX_PREFIX - prefix);
+            memcpy(node->n.prefix + prefix, sub->prefix, sub_prefix);
+            prefix += sub_prefix;
+        }
+        memcpy(sub->prefix, node->n.prefix, _art_min(prefix, ART_MAX_PREFIX));
+        sub->prefix_len += node->n.prefix_len + 1;
+    }
+
+    *ref = child;
+    free(node);
+}
+
+static void _art_remove_child(art_node *node, void **ref, u8 c, void **slot)
+{
+    switch (node->type)
+    {
+    case ART_NODE4:
+    {
+        art_node4 *n4 = (art_node4 *)node;
+        usize i = (usize)(slot - n4->children);
+        memmove(n4->keys + i, n4->keys + i + 1, node->count - i - 1);
+        memmove(n4->children + i, n4->children + i + 1, PTR_LEN * (node->count - i - 1));
+        node->count--;
+        _art_collapse4(n4, ref);
+        return;
+    }
+    case ART_NODE16:
+    {
+        art_node16 *n16 = (art_node16 *)node;
+        usize i = (usize)(slot - n16->children);
+        memmove(n16->keys + i, n16->keys + i + 1, node->count - i - 1);
+        memmove(n16->children + i, n16->children + i + 1, PTR_LEN * (node->count - i - 1));
+        node->count--;
+        if (node->count > 3)
+        {
+            return;
+        }
+
+        art_node4 *shrunk = (art_node4 *)_art_node_new(ART_NODE4);
+        if (shrunk == NULL)
+        {
+            // 保持node16
+            return;
+        }
+        _art_copy_header(&shrunk->n, node);
+        memcpy(shrunk->keys, n16->keys, node->count);
+        memcpy(shrunk->children, n16->children, PTR_LEN * node->count);
+        *ref = shrunk;
+        free(node);
+        return;
+    }
+    case ART_NODE48:
+    {
+        art_node48 *n48 = (art_node48 *)node;
+        n48->children[n48->index[c] - 1] = NULL;
+        n48->index[c] = 0;
+        node->count--;
+        if (node->count > 12)
+        {
+            return;
+        }
+
+        art_node16 *shrunk = (art_node16 *)_art_node_new(ART_NODE16);
+        if (shrunk == NULL)
+        {
+            return;
+        }
+        _art_copy_header(&shrunk->n, node);
+        usize j = 0;
+        for (usize i = 0; i < 256; i++)
+        {
+            if (n48->index[i])
+            {
+                shrunk->keys[j] = (u8)i;
+                shrunk->children[j] = n48->children[n48->index[i] - 1];
+                j++;
+            }
+        }
+        *ref = shrunk;
+        free(node);
+        return;
+    }
+    case ART_NODE256:
+    {
+        art_node256 *n256 = (art_node256 *)node;
+        n256->children[c] = NULL;
+        node->count--;
+        if (node->count > 37)
+        {
+            return;
+        }
+
+        art_node48 *shrunk = (art_node48 *)_art_node_new(ART_NODE48);
+        if (shrunk == NULL)
+        {
+            return;
+        }
+        _art_copy_header(&shrunk->n, node);
+        usize j = 0;
+        for (usize i = 0; i < 256; i++)
+        {
+            if (n256->children[i])
+            {
+                shrunk->children[j] = n256->children[i];
+                shrunk->index[i] = (u8)(j + 1);
+                j++;
+            }
+        }
+        *ref = shrunk;
+        free(node);
+        return;
+    }
+    }
+}
+
+// ============================================================================
+//  art
+// ============================================================================
+
+art *art_new(usize vsize)
+{
+    art *tree = malloc(sizeof(art));
+    if (tree == NULL)
+    {
+        return NULL;
+    }
+
+    tree->root = NULL;
+    tree->len = 0;
+    *(usize *)&tree->vsize = vsize;
+    *(usize *)&tree->vdsize = vsize ? vsize : PTR_LEN;
+    tree->vfree = NULL;
+    return tree;
+}
+
+void art_free(art *tree)
+{
+    if (tree == NULL)
+    {
+        return;
+    }
+
+    if (tree->root)
+    {
+        _art_free_child(tree, tree->root);
+    }
+
+    free(tree);
+}
+
+void art_set_vfree(art *tree, void (*vfree)(void *value))
+{
+    tree->vfree = vfree;
+}
+
+/**
+ * @brief 叶子节点挂到depth处的节点下, key在此结束时作为end
+ */
+static int _art_attach(const art *tree, art_node *node, void **ref, art_leaf *leaf, usize depth)
+{
+    if (leaf->len == depth)
+    {
+        node->end = leaf;
+        return 0;
+    }
+
+    return _art_add_child(node, ref, _art_leaf_key(tree, leaf)[depth], ART_TAG(leaf));
+}
+
+static void _art_update(art *tree, art_leaf *leaf, void *value)
+{
+    void *old = art_leaf_value(tree, leaf);
+    if (tree->vfree && old)
+    {
+        tree->vfree(old);
+    }
+
+    _art_leaf_put_value(tree, leaf, value);
+}
+
+static int _art_insert(art *tree, void **ref, const u8 *key, usize len, usize depth, void *value)
+{
+    void *child = *ref;
+    if (child == NULL)
+    {
+        art_leaf *leaf = _art_leaf_new(tree, key, len, value);
+        if (leaf == NULL)
+        {
+            return 1;
+        }
+
+        *ref = ART_TAG(leaf);
+        tree->len++;
+        return 0;
+    }
+
+    if (ART_IS_LEAF(child))
+    {
+        art_leaf *old = ART_LEAF(child);
+        if (_art_leaf_match(tree, old, key, len))
+        {
+            _art_update(tree, old, value);
+            return 0;
+        }
+
+        // 叶子节点分裂为node4, 公共部分作为压缩路径
+        art_leaf *leaf = _art_leaf_new(tree, key, len, value);
+        art_node *node = _art_node_new(ART_NODE4);
+        if (leaf == NULL || node == NULL)
+        {
+            free2(leaf);
+            free2(node);
+            return 1;
+        }
+
+        const u8 *okey = _art_leaf_key(tree, old);
+        usize max = _art_min(old->len, len) - depth;
+        usize common = 0;
+        while (common < max && okey[depth + common] == key[depth + common])
+        {
+            common++;
+        }
+
+        node->prefix_len = (u32)common;
+        memcpy(node->prefix, key + depth, _art_min(common, ART_MAX_PREFIX));
+        _art_attach(tree, node, NULL, old, depth + common);
+        _art_attach(tree, node, NULL, leaf, depth + common);
+        *ref = node;
+        tree->len++;
+        return 0;
+    }
+
+    art_node *node = (art_node *)child;
+    if (node->prefix_len)
+    {
+        usize diff = _art_prefix_mismatch(tree, node, key, len, depth);
+        if (diff < node->prefix_len)
+        {
+            // 在不匹配的位置拆分压缩路径
+            art_leaf *leaf = _art_leaf_new(tree, key, len, value);
+            art_node *parent = _art_node_new(ART_NODE4);
+            if (leaf == NULL || parent == NULL)
+            {
+                free2(leaf);
+                free2(parent);
+                return 1;
+            }
+
+            parent->prefix_len = (u32)diff;
+            memcpy(parent->prefix, node->prefix, _art_min(diff, ART_MAX_PREFIX));
+
+            u8 c;
+            if (node->prefix_len <= ART_MAX_PREFIX)
+            {
+                c = node->prefix[diff];
+                node->prefix_len -= (u32)(diff + 1);
+                memmove(node->prefix, node->prefix + diff + 1, _art_min(node->prefix_len, ART_MAX_PREFIX));
+            }
+            else
+            {
+                const u8 *lkey = _art_leaf_key(tree, _art_minimum(node));
+                c = lkey[depth + diff];
+                node->prefix_len -= (u32)(diff + 1);
+                memcpy(node->prefix, lkey + depth + diff + 1, _art_min(node->prefix_len, ART_MAX_PREFIX));
+            }
+
+            _art_add_child(parent, NULL, c, node);
+            _art_attach(tree, parent, NULL, leaf, depth + diff);
+            *ref = parent;
+            tree->len++;
+            return 0;
+        }
+
+        depth += node->prefix_len;
+    }
+
+    if (depth == len)
+    {
+        if (node->end)
+        {
+            _art_update(tree, node->end, value);
+            return 0;
+        }
+
+        node->end = _art_leaf_new(tree, key, len, value);
+        if (node->end == NULL)
+        {
+            return 1;
+        }
+        tree->len++;
+        return 0;
+    }
+
+    void **slot = _art_find_child(node, key[depth]);
+    if (slot)
+    {
+        return _art_insert(tree, slot, key, len, depth + 1, value);
+    }
+
+    art_leaf *leaf = _art_leaf_new(tree, key, len, value);
+    if (leaf == NULL)
+    {
+        return 1;
+    }
+
+    if (_art_add_child(node, ref, key[depth], ART_TAG(leaf)))
+    {
+        free(leaf);
+        return 1;
+    }
+
+    tree->len++;
+    return 0;
+}
+
+int art_set(art *tree, const u8 *key, usize len, void *value)
+{
+    if ((key == NULL && len) || len > UINT32_MAX)
+    {
+        return 1;
+    }
+
+    return _art_insert(tree, &tree->root, key, len, 0, value);
+}
+
+static art_leaf *_art_search(art *tree, const u8 *key, usize len)
+{
+    void *child = tree->root;
+    usize depth = 0;
+    while (child)
+    {
+        if (ART_IS_LEAF(child))
+        {
+            art_leaf *leaf = ART_LEAF(child);
+            return _art_leaf_match(tree, leaf, key, len) ? leaf : NULL;
+        }
+
+        art_node *node = (art_node *)child;
+        if (node->prefix_len)
+        {
+            if (_art_check_prefix(node, key, len, depth) != _art_min(node->prefix_len, ART_MAX_PREFIX))
+            {
+                return NULL;
+            }
+
+            depth += node->prefix_len;
+            if (depth > len)
+            {
+                return NULL;
+            }
+        }
+
+        if (depth == len)
+        {
+            // 超出ART_MAX_PREFIX的路径没有比较过
+            art_leaf *leaf = node->end;
+            return leaf && _art_leaf_match(tree, leaf, key, len) ? leaf : NULL;
+        }
+
+        void **slot = _art_find_child(node, key[depth]);
+        child = slot ? *slot : NULL;
+        depth++;
+    }
+
+    return NULL;
+}
+
+void *art_get(art *tree, const u8 *key, usize len)
+{
+    art_leaf *leaf = _art_search(tree, key, len);
+    return leaf ? art_leaf_value(tree, leaf) : NULL;
+}
+
+b32 art_exist(art *tree, const u8 *key, usize len)
+{
+    return _art_search(tree, key, len) != NULL;
+}
+
+/**
+ * @brief 递归移除
+ *
+ * @return 被移除的叶子节点 不存在返回NULL
+ */
+static art_leaf *_art_delete(art *tree, void **ref, const u8 *key, usize len, usize depth)
+{
+    void *child = *ref;
+    if (child == NULL)
+    {
+        return NULL;
+    }
+
+    if (ART_IS_LEAF(child))
+    {
+        art_leaf *leaf = ART_LEAF(child);
+        if (!_art_leaf_match(tree, leaf, key, len))
+        {
+            return NULL;
+        }
+
+        *ref = NULL;
+        return leaf;
+    }
+
+    art_node *node = (art_node *)child;
+    if (node->prefix_len)
+    {
+        if (_art_check_prefix(node, key, len, depth) != _art_min(node->prefix_len, ART_MAX_PREFIX))
+        {
+            return NULL;
+        }
+
+        depth += node->prefix_len;
+        if (depth > len)
+        {
+            return NULL;
+        }
+    }
+
+    if (depth == len)
+    {
+        art_leaf *leaf = node->end;
+        if (leaf == NULL || !_art_leaf_match(tree, leaf, key, len))
+        {
+            return NULL;
+        }
+
+        node->end = NULL;
+        if (node->type == ART_NODE4)
+        {
+            _art_collapse4((art_node4 *)node, ref);
+        }
+        return leaf;
+    }
+
+    void **slot = _art_find_child(node, key[depth]);
+    if (slot == NULL)
+    {
+        return NULL;
+    }
+
+    if (ART_IS_LEAF(*slot))
+    {
+        art_leaf *leaf = ART_LEAF(*slot);
+        if (!_art_leaf_match(tree, leaf, key, len))
+        {
+            return NULL;
+        }
+
+        _art_remove_child(node, ref, key[depth], slot);
+        return leaf;
+    }
+
+    return _art_delete(tree, slot, key, len, depth + 1);
+}
+
+int art_remove(art *tree, const u8 *key, usize len)
+{
+    art_leaf *leaf = _art_delete(tree, &tree->root, key, len, 0);
+    if (leaf)
+    {
+        _art_leaf_free(tree, leaf);
+        tree->len--;
+    }
+
+    return 0;
+}
+
+size art_count(art *tree)
+{
+    return tree->len;
+}
+
+static inline b32 _art_leaf_is_prefix(const art *tree, art_leaf *leaf, const u8 *key, usize len)
+{
+    return leaf->len <= len && memcmp(_art_leaf_key(tree, leaf), key, leaf->len) == 0;
+}
+
+size art_longest_prefix(art *tree, const u8 *key, usize len, void **value)
+{
+    art_leaf *best = NULL;
+    void *child = tree->root;
+    usize depth = 0;
+    while (child)
+    {
+        if (ART_IS_LEAF(child))
+        {
+            art_leaf *leaf = ART_LEAF(child);
+            if (_art_leaf_is_prefix(tree, leaf, key, len))
+            {
+                best = leaf;
+            }
+            break;
+        }
+
+        art_node *node = (art_node *)child;
+        if (node->prefix_len)
+        {
+            if (_art_check_prefix(node, key, len, depth) != _art_min(node->prefix_len, ART_MAX_PREFIX))
+            {
+                break;
+            }
+
+            depth += node->prefix_len;
+            if (depth > len)
+            {
+                break;
+            }
+        }
+
+        // 压缩路径可能只比较了一部分, 候选key都完整比较
+        if (node->end && _art_leaf_is_prefix(tree, node->end, key, len))
+        {
+            best = node->end;
+        }
+
+        if (depth == len)
+        {
+            break;
+        }
+
+        void **slot = _art_find_child(node, key[depth]);
+        child = slot ? *slot : NULL;
+        depth++;
+    }
+
+    if (best == NULL)
+    {
+        return -1;
+    }
+
+    if (value)
+    {
+        *value = art_leaf_value(tree, best);
+    }
+    return (size)best->len;
+}
+
+/**
+ * @brief 按字节序遍历子树, end在子节点之前
+ *
+ * @return func返回非0时返回非0
+ */
+static int _art_walk(art *tree, void *child, int (*func)(const u8 *key, usize len, void *value, void *ctx), void *ctx)
+{
+    if (ART_IS_LEAF(child))
+    {
+        art_leaf *leaf = ART_LEAF(child);
+        return func(_art_leaf_key(tree, leaf), leaf->len, art_leaf_value(tree, leaf), ctx);
+    }
+
+    art_node *node = (art_node *)child;
+    if (node->end && _art_walk(tree, ART_TAG(node->end), func, ctx))
+    {
+        return 1;
+    }
+
+    switch (node->type)
+    {
+    case ART_NODE4:
+        for (usize i = 0; i < node->count; i++)
+        {
+            if (_art_walk(tree, ((art_node4 *)node)->children[i], func, ctx))
+            {
+                return 1;
+            }
+        }
+        break;
+    case ART_NODE16:
+        for (usize i = 0; i < node->count; i++)
+        {
+            if (_art_walk(tree, ((art_node16 *)node)->children[i], func, ctx))
+            {
+                return 1;
+            }
+        }
+        break;
+    case ART_NODE48:
+    {
+        art_node48 *n48 = (art_node48 *)node;
+        for (usize i = 0; i < 256; i++)
+        {
+            if (n48->index[i] && _art_walk(tree, n48->children[n48->index[i] - 1], func, ctx))
+            {
+                return 1;
+            }
+        }
+        break;
+    }
+    case ART_NODE256:
+    {
+        art_node256 *n256 = (art_node256 *)node;
+        for (usize i = 0; i < 256; i++)
+        {
+            if (n256->children[i] && _art_walk(tree, n256->children[i], func, ctx))
+            {
+                return 1;
+            }
+        }
+        break;
+    }
+    }
+
+    return 0;
+}
+
+void art_foreach(art *tree, int (*func)(const u8 *key, usize len, void *value, void *ctx), void *ctx)
+{
+    if (tree->root)
+    {
+        _art_walk(tree, tree->root, func, ctx);
+    }
+}
+
+void art_prefix_foreach(art *tree, const u8 *prefix, usize len, int (*func)(const u8 *key, usize len, void *value, void *ctx), void *ctx)
+{
+    void *child = tree->root;
+    usize depth = 0;
+    while (child)
+    {
+        if (ART_IS_LEAF(child))
+        {
+            art_leaf *leaf = ART_LEAF(child);
+            if (leaf->len >= len && memcmp(_art_leaf_key(tree, leaf), prefix, len) == 0)
+            {
+                func(_art_leaf_key(tree, leaf), leaf->len, art_leaf_value(tree, leaf), ctx);
+            }
+            return;
+        }
+
+        if (depth == len)
+        {
+            _art_walk(tree, child, func, ctx);
+            return;
+        }
+
+        art_node *node = (art_node *)child;
+        if (node->prefix_len)
+        {
+            // prefix可能在压缩路径中间结束
+            usize matched = _art_prefix_mismatch(tree, node, prefix, len, depth);
+            if (depth + matched == len)
+            {
+                _art_walk(tree, child, func, ctx);
+                return;
+            }
+
+            if (matched < node->prefix_len)
+            {
+                return;
+            }
+
+            depth += node->prefix_len;
+        }
+
+        void **slot = _art_find_child(node, prefix[depth]);
+        child = slot ? *slot : NULL;
+        depth++;
+    }
+}
+
+// ============================================================================
+//  string key
+// ============================================================================
+
+int art_set_string(art *tree, const string *key, void *value)
+{
+    return art_set(tree, key->buf, (usize)key->len, value);
+}
+
+void *art_get_string(art *tree, const string *key)
+{
+    return art_get(tree, key->buf, (usize)key->len);
+}
+
+int art_remove_string(art *tree, const string *key)
+{
+    return art_remove(tree, key->buf, (usize)key->len);
+}
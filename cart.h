@@ -0,0 +1,212 @@
+#ifndef __CART_H
+#define __CART_H
+
+#include "cstring.h"
+#include "ctype.h"
+
+// 节点中保存的压缩路径长度, 超出部分从子树中的叶子节点读取
+#define ART_MAX_PREFIX 10
+
+#define ART_NODE4   1
+#define ART_NODE16  2
+#define ART_NODE48  3
+#define ART_NODE256 4
+
+// ============================================================================
+// art 自适应基数树, key为任意字节串, 按字节序有序, 支持前缀查询
+// ============================================================================
+
+typedef struct art_leaf
+{
+    usize len;
+    // value, value flag, 然后是key
+    _Alignas(8) u8 data[];
+} art_leaf;
+
+typedef struct art_node
+{
+    u8 type;
+    // 子节点个数
+    u16 count;
+    // 压缩路径长度
+    u32 prefix_len;
+    u8 prefix[ART_MAX_PREFIX];
+    // 在此节点结束的key, 是其他key的前缀
+    art_leaf *end;
+} art_node;
+
+// 子节点指针最低位为1时是叶子节点
+typedef struct
+{
+    art_node n;
+    u8 keys[4];
+    void *children[4];
+} art_node4;
+
+typedef struct
+{
+    art_node n;
+    u8 keys[16];
+    void *children[16];
+} art_node16;
+
+typedef struct
+{
+    art_node n;
+    // 字节对应的children下标加1, 0为不存在
+    u8 index[256];
+    void *children[48];
+} art_node48;
+
+typedef struct
+{
+    art_node n;
+    void *children[256];
+} art_node256;
+
+typedef struct art_header
+{
+    void *root;
+    usize len;
+    const usize vsize;
+    const usize vdsize;
+    // 动态函数
+    void (*vfree)(void *value);
+} art;
+
+/**
+ * @brief 创建art, key按值拷贝
+ *
+ * @param vsize value大小, 为0时保存value指针
+ * @return 返回新创建的art指针, 内存分配失败返回NULL
+ */
+art *art_new(usize vsize);
+
+/**
+ * @brief art释放
+ *
+ * @param tree
+ */
+void art_free(art *tree);
+
+/**
+ * @brief 设置value释放函数
+ *
+ * @param tree
+ * @param vfree
+ */
+void art_set_vfree(art *tree, void (*vfree)(void *value));
+
+/**
+ * @brief 插入或更新key val
+ *
+ * @param tree
+ * @param key
+ * @param len key长度, 可以为0
+ * @param value
+ * @return 成功返回0 失败返回非0
+ */
+int art_set(art *tree, const u8 *key, usize len, void *value);
+
+/**
+ * @brief 查找key
+ *
+ * @param tree
+ * @param key
+ * @param len
+ * @return 查找到返回val所在指针 否则返回NULL
+ */
+void *art_get(art *tree, const u8 *key, usize len);
+
+/**
+ * @brief 查找key是否存在
+ *
+ * @param tree
+ * @param key
+ * @param len
+ * @return 存在返回1 否则返回0
+ */
+b32 art_exist(art *tree, const u8 *key, usize len);
+
+/**
+ * @brief 移除元素
+ *
+ * @param tree
+ * @param key
+ * @param len
+ * @return 成功返回0 失败返回非0
+ */
+int art_remove(art *tree, const u8 *key, usize len);
+
+/**
+ * @brief 元素个数
+ *
+ * @param tree
+ * @return 返回元素个数
+ */
+size art_count(art *tree);
+
+/**
+ * @brief 最长前缀匹配, 查找是key前缀的最长的key
+ *
+ * @param tree
+ * @param key
+ * @param len
+ * @param value 不为NULL时写入val所在指针
+ * @return 匹配的key长度 没有匹配返回-1
+ */
+size art_longest_prefix(art *tree, const u8 *key, usize len, void **value);
+
+/**
+ * @brief 按key字节序遍历
+ *
+ * @param tree
+ * @param func 返回非0时停止遍历
+ * @param ctx
+ */
+void art_foreach(art *tree, int (*func)(const u8 *key, usize len, void *value, void *ctx), void *ctx);
+
+/**
+ * @brief 按key字节序遍历以prefix开头的key
+ *
+ * @param tree
+ * @param prefix
+ * @param len
+ * @param func 返回非0时停止遍历
+ * @param ctx
+ */
+void art_prefix_foreach(art *tree, const u8 *prefix, usize len, int (*func)(const u8 *key, usize len, void *value, void *ctx), void *ctx);
+
+// ============================================================================
+//  string key
+// ============================================================================
+
+/**
+ * @brief 以string为key插入或更新
+ *
+ * @param tree
+ * @param key
+ * @param value
+ * @return 成功返回0 失败返回非0
+ */
+int art_set_string(art *tree, const string *key, void *value);
+
+/**
+ * @brief 以string为key查找
+ *
+ * @param tree
+ * @param key
+ * @return 查找到返回val所在指针 否则返回NULL
+ */
+void *art_get_string(art *tree, const string *key);
+
+/**
+ * @brief 以string为key移除
+ *
+ * @param tree
+ * @param key
+ * @return 成功返回0 失败返回非0
+ */
+int art_remove_string(art *tree, const string *key);
+
+#endif // __CART_H
@@ -0,0 +1,1124 @@
+#include "cbtree.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#define PTR_LEN sizeof(uintptr_t)
+
+static inline usize _btree_align8(usize n)
+{
+    return (n + 7) & ~(usize)7;
+}
+
+// ============================================================================
+//  节点内查找, 整数key统计小于目标的key个数, 有序数组中即为lower bound
+// ============================================================================
+
+static inline usize _btree_count_lt_u64(const u64 *keys, usize n, u64 key)
+{
+    usize count = 0;
+    usize i = 0;
+#if defined(__AVX2__)
+    // 无符号比较: 翻转符号位后按有符号比较
+    __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    __m256i target = _mm256_xor_si256(_mm256_set1_epi64x((long long)key), sign);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(keys + i)), sign);
+        __m256i lt = _mm256_cmpgt_epi64(target, v);
+        count += (usize)__builtin_popcount((u32)_mm256_movemask_pd(_mm256_castsi256_pd(lt)));
+    }
+#elif defined(__SSE4_2__)
+    __m128i sign = _mm_set1_epi64x(INT64_MIN);
+    __m128i target = _mm_xor_si128(_mm_set1_epi64x((long long)key), sign);
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(keys + i)), sign);
+        __m128i lt = _mm_cmpgt_epi64(target, v);
+        count += (usize)__builtin_popcount((u32)_mm_movemask_pd(_mm_castsi128_pd(lt)));
+    }
+#endif
+    // 无分支计数, 节点key个数有限, 线性扫描优于二分
+    for (; i < n; i++)
+    {
+        count += keys[i] < key;
+    }
+
+    return count;
+}
+
+static inline usize _btree_count_lt_u32(const u32 *keys, usize n, u32 key)
+{
+    usize count = 0;
+    usize i = 0;
+#if defined(__AVX2__)
+    __m256i sign = _mm256_set1_epi32(INT32_MIN);
+    __m256i target = _mm256_xor_si256(_mm256_set1_epi32((int)key), sign);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(keys + i)), sign);
+        __m256i lt = _mm256_cmpgt_epi32(target, v);
+        count += (usize)__builtin_popcount((u32)_mm256_movemask_ps(_mm256_castsi256_ps(lt)));
+    }
+#elif defined(__SSE2__)
+    __m128i sign = _mm_set1_epi32(INT32_MIN);
+    __m128i target = _mm_xor_si128(_mm_set1_epi32((int)key), sign);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(keys + i)), sign);
+        __m128i lt = _mm_cmpgt_epi32(target, v);
+        count += (usize)__builtin_popcount((u32)_mm_movemask_ps(_mm_castsi128_ps(lt)));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        count += keys[i] < key;
+    }
+
+    return count;
+}
+
+static inline u8 *_btree_keys(btree_node *node)
+{
+    return node->data;
+}
+
+static inline u8 *_btree_node_key(const btree *tree, btree_node *node, usize i)
+{
+    return node->data + tree->kdsize * i;
+}
+
+static inline btree_node **_btree_children(const btree *tree, btree_node *node)
+{
+    return (btree_node **)(node->data + tree->children_off);
+}
+
+static inline u8 *_btree_node_value(const btree *tree, btree_node *node, usize i)
+{
+    return node->data + tree->values_off + tree->vdsize * i;
+}
+
+static inline u8 *_btree_node_flags(const btree *tree, btree_node *node)
+{
+    return node->data + tree->flags_off;
+}
+
+static inline void *btree_key(const btree *tree, btree_node *node, usize i)
+{
+    u8 *slot = _btree_node_key(tree, node, i);
+    if (tree->ksize == 0)
+    {
+        return (void *)(*(uintptr_t *)slot);
+    }
+
+    return slot;
+}
+
+static inline void *btree_value(const btree *tree, btree_node *node, usize i)
+{
+    u8 *slot = _btree_node_value(tree, node, i);
+    if (tree->vsize == 0)
+    {
+        return (void *)(*(uintptr_t *)slot);
+    }
+
+    return _btree_node_flags(tree, node)[i] ? slot : NULL;
+}
+
+static inline int _btree_cmp(const btree *tree, btree_node *node, usize i, const void *key)
+{
+    return tree->cmp(btree_key(tree, node, i), key, tree->kdsize);
+}
+
+/**
+ * @brief 第一个不小于key的位置
+ */
+static usize _btree_lower(const btree *tree, btree_node *node, const void *key)
+{
+    switch (tree->key_kind)
+    {
+    case BTREE_KEY_U64:
+        return _btree_count_lt_u64((const u64 *)_btree_keys(node), node->n, *(const u64 *)key);
+    case BTREE_KEY_U32:
+        return _btree_count_lt_u32((const u32 *)_btree_keys(node), node->n, *(const u32 *)key);
+    }
+
+    usize lo = 0;
+    usize hi = node->n;
+    while (lo < hi)
+    {
+        usize mid = lo + (hi - lo) / 2;
+        if (_btree_cmp(tree, node, mid, key) < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * @brief 第一个大于key的位置
+ */
+static usize _btree_upper(const btree *tree, btree_node *node, const void *key)
+{
+    switch (tree->key_kind)
+    {
+    case BTREE_KEY_U64:
+    {
+        u64 k = *(const u64 *)key;
+        return k == UINT64_MAX ? node->n : _btree_count_lt_u64((const u64 *)_btree_keys(node), node->n, k + 1);
+    }
+    case BTREE_KEY_U32:
+    {
+        u32 k = *(const u32 *)key;
+        return k == UINT32_MAX ? node->n : _btree_count_lt_u32((const u32 *)_btree_keys(node), node->n, k + 1);
+    }
+    }
+
+    usize lo = 0;
+    usize hi = node->n;
+    while (lo < hi)
+    {
+        usize mid = lo + (hi - lo) / 2;
+        if (_btree_cmp(tree, node, mid, key) <= 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static int _btree_cmp_u64(const void *key1, const void *key2, usize ksize)
+{
+    u64 a = *(const u64 *)key1;
+    u64 b = *(const u64 *)key2;
+    return (a > b) - (a < b);
+}
+
+static int _btree_cmp_u32(const void *key1, const void *key2, usize ksize)
+{
+    u32 a = *(const u32 *)key1;
+    u32 b = *(const u32 *)key2;
+    return (a > b) - (a < b);
+}
+
+// ============================================================================
+//  节点
+// ============================================================================
+
+static btree_node *_btree_node_new(const btree *tree, b32 leaf)
+{
+    // 多留一个key的位置, 插入后再分裂
+    usize dsize = leaf ? tree->flags_off + (usize)tree->fanout + 1
+                       : tree->children_off + PTR_LEN * ((usize)tree->fanout + 2);
+    btree_node *node = malloc(sizeof(btree_node) + dsize);
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    node->n = 0;
+    node->leaf = leaf;
+    node->prev = NULL;
+    node->next = NULL;
+    return node;
+}
+
+static void _btree_free_kv(btree *tree, btree_node *node, usize i)
+{
+    if (tree->kfree)
+    {
+        tree->kfree(btree_key(tree, node, i));
+    }
+
+    void *value = btree_value(tree, node, i);
+    if (tree->vfree && value)
+    {
+        tree->vfree(value);
+    }
+}
+
+static void _btree_node_free(btree *tree, btree_node *node, b32 free_kv)
+{
+    if (node->leaf && free_kv)
+    {
+        for (usize i = 0; i < node->n; i++)
+        {
+            _btree_free_kv(tree, node, i);
+        }
+    }
+    else if (!node->leaf)
+    {
+        btree_node **children = _btree_children(tree, node);
+        for (usize i = 0; i <= node->n; i++)
+        {
+            _btree_node_free(tree, children[i], free_kv);
+        }
+    }
+
+    free(node);
+}
+
+static void _btree_put_key(const btree *tree, btree_node *node, usize i, const void *key)
+{
+    u8 *slot = _btree_node_key(tree, node, i);
+    if (tree->ksize == 0)
+    {
+        *(uintptr_t *)slot = (uintptr_t)key;
+        return;
+    }
+
+    memcpy(slot, key, tree->kdsize);
+}
+
+static void _btree_put_value(const btree *tree, btree_node *node, usize i, const void *value)
+{
+    u8 *slot = _btree_node_value(tree, node, i);
+    if (tree->vsize == 0)
+    {
+        *(uintptr_t *)slot = (uintptr_t)value;
+        return;
+    }
+
+    u8 *flags = _btree_node_flags(tree, node);
+    if (value == NULL)
+    {
+        flags[i] = 0;
+        return;
+    }
+
+    memcpy(slot, value, tree->vdsize);
+    flags[i] = 1;
+}
+
+/**
+ * @brief 叶子节点[from, from + n)的kv移动到to开始的位置
+ */
+static void _btree_leaf_move(const btree *tree, btree_node *dst, usize to, btree_node *src, usize from, usize n)
+{
+    memmove(_btree_node_key(tree, dst, to), _btree_node_key(tree, src, from), tree->kdsize * n);
+    memmove(_btree_node_value(tree, dst, to), _btree_node_value(tree, src, from), tree->vdsize * n);
+    memmove(_btree_node_flags(tree, dst) + to, _btree_node_flags(tree, src) + from, n);
+}
+
+/**
+ * @brief 内部节点key[from, from + n)移动到to开始的位置
+ */
+static void _btree_keys_move(const btree *tree, btree_node *dst, usize to, btree_node *src, usize from, usize n)
+{
+    memmove(_btree_node_key(tree, dst, to), _btree_node_key(tree, src, from), tree->kdsize * n);
+}
+
+/**
+ * @brief 内部节点子节点[from, from + n)移动到to开始的位置
+ */
+static void _btree_children_move(const btree *tree, btree_node *dst, usize to, btree_node *src, usize from, usize n)
+{
+    memmove(_btree_children(tree, dst) + to, _btree_children(tree, src) + from, PTR_LEN * n);
+}
+
+// ============================================================================
+//  btree
+// ============================================================================
+
+btree *btree_new(usize ksize, usize vsize, int cmp(const void *, const void *, usize))
+{
+    btree *tree = malloc(sizeof(btree));
+    if (tree == NULL)
+    {
+        return NULL;
+    }
+
+    usize kdsize = ksize ? ksize : PTR_LEN;
+    usize vdsize = vsize ? vsize : PTR_LEN;
+    // 节点key数组约为BTREE_NODE_KEY_BYTES字节, 取偶数使合并后不超过fanout
+    usize fanout = BTREE_NODE_KEY_BYTES / kdsize;
+    fanout = fanout < BTREE_MIN_KEYS ? BTREE_MIN_KEYS : fanout;
+    fanout = fanout > 1024 ? 1024 : fanout;
+    fanout &= ~(usize)1;
+
+    tree->root = NULL;
+    tree->first = NULL;
+    tree->last = NULL;
+    tree->len = 0;
+    *(usize *)&tree->ksize = ksize;
+    *(usize *)&tree->vsize = vsize;
+    *(usize *)&tree->kdsize = kdsize;
+    *(usize *)&tree->vdsize = vdsize;
+    *(u16 *)&tree->fanout = (u16)fanout;
+    *(usize *)&tree->values_off = _btree_align8(kdsize * (fanout + 1));
+    *(usize *)&tree->flags_off = tree->values_off + vdsize * (fanout + 1);
+    *(usize *)&tree->children_off = _btree_align8(kdsize * (fanout + 1));
+    tree->kfree = NULL;
+    tree->vfree = NULL;
+
+    tree->key_kind = BTREE_KEY_GENERIC;
+    tree->cmp = cmp ? cmp : memcmp;
+    if (cmp == NULL && ksize == sizeof(u64))
+    {
+        tree->key_kind = BTREE_KEY_U64;
+        tree->cmp = _btree_cmp_u64;
+    }
+    else if (cmp == NULL && ksize == sizeof(u32))
+    {
+        tree->key_kind = BTREE_KEY_U32;
+        tree->cmp = _btree_cmp_u32;
+    }
+
+    tree->sep = malloc(kdsize);
+    if (tree->sep == NULL)
+    {
+        free(tree);
+        return NULL;
+    }
+
+    return tree;
+}
+
+void btree_free(btree *tree)
+{
+    if (tree == NULL)
+    {
+        return;
+    }
+
+    if (tree->root)
+    {
+        _btree_node_free(tree, tree->root, 1);
+    }
+
+    free(tree->sep);
+    free(tree);
+}
+
+void btree_set_kfree(btree *tree, void (*kfree)(void *key))
+{
+    tree->kfree = kfree;
+}
+
+void btree_set_vfree(btree *tree, void (*vfree)(void *value))
+{
+    tree->vfree = vfree;
+}
+
+/**
+ * @brief 分裂已溢出(n == fanout + 1)的节点, 上移的key写入tree->sep
+ *
+ * @param right 预先分配的新右节点, 类型与node相同
+ * @return 新的右节点
+ */
+static btree_node *_btree_split(btree *tree, btree_node *node, btree_node *right)
+{
+    usize n = node->n;
+    usize mid = n / 2;
+    if (node->leaf)
+    {
+        // 叶子节点复制右节点第一个key作为分隔
+        _btree_leaf_move(tree, right, 0, node, mid, n - mid);
+        right->n = (u16)(n - mid);
+        node->n = (u16)mid;
+        memcpy(tree->sep, _btree_node_key(tree, right, 0), tree->kdsize);
+
+        right->prev = node;
+        right->next = node->next;
+        if (node->next)
+        {
+            node->next->prev = right;
+        }
+        else
+        {
+            tree->last = right;
+        }
+        node->next = right;
+        return right;
+    }
+
+    // 内部节点中间key上移
+    memcpy(tree->sep, _btree_node_key(tree, node, mid), tree->kdsize);
+    _btree_keys_move(tree, right, 0, node, mid + 1, n - mid - 1);
+    _btree_children_move(tree, right, 0, node, mid + 1, n - mid);
+    right->n = (u16)(n - mid - 1);
+    node->n = (u16)mid;
+    return right;
+}
+
+/**
+ * @brief 取出一个预先分配的节点, 节点通过next串联
+ */
+static btree_node *_btree_spare_pop(btree_node **spare)
+{
+    btree_node *node = *spare;
+    *spare = node->next;
+    node->next = NULL;
+    return node;
+}
+
+/**
+ * @brief 递归插入不存在的key, 分裂使用spare中预先分配的节点, 不会失败
+ *
+ * @return 节点分裂时返回新的右节点, 分隔key在tree->sep, 否则返回NULL
+ */
+static btree_node *_btree_insert(btree *tree, btree_node *node, void *key, void *value, btree_node **spare)
+{
+    if (node->leaf)
+    {
+        usize i = _btree_lower(tree, node, key);
+        _btree_leaf_move(tree, node, i + 1, node, i, node->n - i);
+        _btree_put_key(tree, node, i, key);
+        _btree_put_value(tree, node, i, value);
+        node->n++;
+        tree->len++;
+    }
+    else
+    {
+        usize i = _btree_upper(tree, node, key);
+        btree_node *right = _btree_insert(tree, _btree_children(tree, node)[i], key, value, spare);
+        if (right == NULL)
+        {
+            return NULL;
+        }
+
+        _btree_keys_move(tree, node, i + 1, node, i, node->n - i);
+        _btree_children_move(tree, node, i + 2, node, i + 1, node->n - i);
+        memcpy(_btree_node_key(tree, node, i), tree->sep, tree->kdsize);
+        _btree_children(tree, node)[i + 1] = right;
+        node->n++;
+    }
+
+    if (node->n <= tree->fanout)
+    {
+        return NULL;
+    }
+
+    return _btree_split(tree, node, _btree_spare_pop(spare));
+}
+
+int btree_set(btree *tree, void *key, void *value)
+{
+    if (key == NULL)
+    {
+        return 1;
+    }
+
+    if (tree->root == NULL)
+    {
+        tree->root = _btree_node_new(tree, 1);
+        if (tree->root == NULL)
+        {
+            return 1;
+        }
+        tree->first = tree->root;
+        tree->last = tree->root;
+    }
+
+    // 沿路径统计从叶子向上连续已满的节点, 即插入后需要分裂的节点
+    usize full = 0, depth = 0;
+    btree_node *node = tree->root;
+    while (!node->leaf)
+    {
+        full = node->n >= tree->fanout ? full + 1 : 0;
+        depth++;
+        node = _btree_children(tree, node)[_btree_upper(tree, node, key)];
+    }
+
+    usize i = _btree_lower(tree, node, key);
+    if (i < node->n && _btree_cmp(tree, node, i, key) == 0)
+    {
+        void *old = btree_value(tree, node, i);
+        if (tree->vfree && old)
+        {
+            tree->vfree(old);
+        }
+        _btree_put_value(tree, node, i, value);
+        return 0;
+    }
+    full = node->n >= tree->fanout ? full + 1 : 0;
+    depth++;
+
+    // 先分配分裂需要的节点, 根节点也分裂时多一个新根; 分配失败时树不变.
+    // 最先分裂的叶子节点在链表头
+    usize needed = full + (full == depth ? 1 : 0);
+    btree_node *spare = NULL;
+    for (usize k = 0; k < needed; k++)
+    {
+        btree_node *extra = _btree_node_new(tree, k == needed - 1);
+        if (extra == NULL)
+        {
+            while (spare)
+            {
+                free(_btree_spare_pop(&spare));
+            }
+            return 1;
+        }
+        extra->next = spare;
+        spare = extra;
+    }
+
+    btree_node *right = _btree_insert(tree, tree->root, key, value, &spare);
+    if (right)
+    {
+        btree_node *root = _btree_spare_pop(&spare);
+        memcpy(_btree_node_key(tree, root, 0), tree->sep, tree->kdsize);
+        _btree_children(tree, root)[0] = tree->root;
+        _btree_children(tree, root)[1] = right;
+        root->n = 1;
+        tree->root = root;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 逐层构建内部节点
+ *
+ * @param nodes 下一层节点, 构建后替换为本层节点
+ * @param lows 各节点子树中最小的key
+ * @param count 下一层节点个数, 构建后替换为本层节点个数
+ * @return 成功返回0 失败返回非0
+ */
+static int _btree_load_level(btree *tree, btree_node **nodes, const u8 **lows, usize *count)
+{
+    usize n = *count;
+    usize per = (usize)tree->fanout + 1;
+    usize parents = (n + per - 1) / per;
+    usize base = n / parents;
+    usize extra = n % parents;
+
+    usize c = 0;
+    for (usize p = 0; p < parents; p++)
+    {
+        btree_node *parent = _btree_node_new(tree, 0);
+        if (parent == NULL)
+        {
+            // 未挂到父节点的子节点
+            for (usize i = c; i < n; i++)
+            {
+                _btree_node_free(tree, nodes[i], 0);
+            }
+            for (usize i = 0; i < p; i++)
+            {
+                _btree_node_free(tree, nodes[i], 0);
+            }
+            return 1;
+        }
+
+        usize take = base + (p < extra);
+        const u8 *low = lows[c];
+        btree_node **children = _btree_children(tree, parent);
+        for (usize i = 0; i < take; i++, c++)
+        {
+            children[i] = nodes[c];
+            if (i > 0)
+            {
+                memcpy(_btree_node_key(tree, parent, i - 1), lows[c], tree->kdsize);
+            }
+        }
+        parent->n = (u16)(take - 1);
+
+        // c > p, 覆盖已经挂到父节点的位置
+        nodes[p] = parent;
+        lows[p] = low;
+    }
+
+    *count = parents;
+    return 0;
+}
+
+int btree_load_sorted(btree *tree, const void *keys, const void *values, usize n)
+{
+    if (tree->root != NULL)
+    {
+        return 1;
+    }
+
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    const u8 *kdata = (const u8 *)keys;
+    const u8 *vdata = (const u8 *)values;
+    const void *prev = NULL;
+    for (usize i = 0; i < n; i++)
+    {
+        const void *key = tree->ksize ? kdata + tree->kdsize * i : ((const void **)keys)[i];
+        if (key == NULL || (prev && tree->cmp(prev, key, tree->kdsize) >= 0))
+        {
+            return 1;
+        }
+        prev = key;
+    }
+
+    usize fanout = tree->fanout;
+    usize leaves = (n + fanout - 1) / fanout;
+    btree_node **nodes = malloc(PTR_LEN * leaves);
+    const u8 **lows = malloc(PTR_LEN * leaves);
+    if (nodes == NULL || lows == NULL)
+    {
+        free2(nodes);
+        free2(lows);
+        return 1;
+    }
+
+    // 平均分配, 每个叶子节点不少于fanout / 2个key
+    usize base = n / leaves;
+    usize extra = n % leaves;
+    usize k = 0;
+    btree_node *prev_leaf = NULL;
+    for (usize l = 0; l < leaves; l++)
+    {
+        btree_node *leaf = _btree_node_new(tree, 1);
+        if (leaf == NULL)
+        {
+            for (usize i = 0; i < l; i++)
+            {
+                _btree_node_free(tree, nodes[i], 0);
+            }
+            free(nodes);
+            free(lows);
+            return 1;
+        }
+
+        usize take = base + (l < extra);
+        if (tree->ksize)
+        {
+            memcpy(_btree_node_key(tree, leaf, 0), kdata + tree->kdsize * k, tree->kdsize * take);
+        }
+        else
+        {
+            memcpy(_btree_node_key(tree, leaf, 0), (const void **)keys + k, PTR_LEN * take);
+        }
+
+        for (usize i = 0; i < take; i++)
+        {
+            const void *value = NULL;
+            if (values)
+            {
+                value = tree->vsize ? vdata + tree->vdsize * (k + i) : ((const void **)values)[k + i];
+            }
+            _btree_put_value(tree, leaf, i, value);
+        }
+
+        leaf->n = (u16)take;
+        leaf->prev = prev_leaf;
+        if (prev_leaf)
+        {
+            prev_leaf->next = leaf;
+        }
+        prev_leaf = leaf;
+        nodes[l] = leaf;
+        lows[l] = _btree_node_key(tree, leaf, 0);
+        k += take;
+    }
+
+    tree->first = nodes[0];
+    tree->last = prev_leaf;
+
+    usize count = leaves;
+    while (count > 1)
+    {
+        if (_btree_load_level(tree, nodes, lows, &count))
+        {
+            tree->first = NULL;
+            tree->last = NULL;
+            free(nodes);
+            free(lows);
+            return 1;
+        }
+    }
+
+    tree->root = nodes[0];
+    tree->len = n;
+    free(nodes);
+    free(lows);
+    return 0;
+}
+
+static btree_node *_btree_find_leaf(btree *tree, const void *key)
+{
+    btree_node *node = tree->root;
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    while (!node->leaf)
+    {
+        node = _btree_children(tree, node)[_btree_upper(tree, node, key)];
+    }
+
+    return node;
+}
+
+/**
+ * @brief 查找key所在叶子节点和下标
+ *
+ * @return 查找到返回叶子节点 否则返回NULL
+ */
+static btree_node *_btree_find(btree *tree, const void *key, usize *index)
+{
+    btree_node *leaf = _btree_find_leaf(tree, key);
+    if (leaf == NULL)
+    {
+        return NULL;
+    }
+
+    usize i = _btree_lower(tree, leaf, key);
+    if (i < leaf->n && _btree_cmp(tree, leaf, i, key) == 0)
+    {
+        *index = i;
+        return leaf;
+    }
+
+    return NULL;
+}
+
+void *btree_get(btree *tree, const void *key)
+{
+    usize i;
+    btree_node *leaf = _btree_find(tree, key, &i);
+    return leaf ? btree_value(tree, leaf, i) : NULL;
+}
+
+b32 btree_exist(btree *tree, const void *key)
+{
+    usize i;
+    return _btree_find(tree, key, &i) != NULL;
+}
+
+/**
+ * @brief 子节点idx的key个数低于下限, 从兄弟节点借或与兄弟节点合并
+ */
+static void _btree_rebalance(btree *tree, btree_node *parent, usize idx)
+{
+    usize min = tree->fanout / 2;
+    btree_node **children = _btree_children(tree, parent);
+    btree_node *child = children[idx];
+    btree_node *left = idx > 0 ? children[idx - 1] : NULL;
+    btree_node *right = idx < parent->n ? children[idx + 1] : NULL;
+
+    if (left && left->n > min)
+    {
+        if (child->leaf)
+        {
+            _btree_leaf_move(tree, child, 1, child, 0, child->n);
+            _btree_leaf_move(tree, child, 0, left, left->n - 1, 1);
+            memcpy(_btree_node_key(tree, parent, idx - 1), _btree_node_key(tree, child, 0), tree->kdsize);
+        }
+        else
+        {
+            _btree_keys_move(tree, child, 1, child, 0, child->n);
+            _btree_children_move(tree, child, 1, child, 0, child->n + 1);
+            memcpy(_btree_node_key(tree, child, 0), _btree_node_key(tree, parent, idx - 1), tree->kdsize);
+            _btree_children(tree, child)[0] = _btree_children(tree, left)[left->n];
+            memcpy(_btree_node_key(tree, parent, idx - 1), _btree_node_key(tree, left, left->n - 1), tree->kdsize);
+        }
+        left->n--;
+        child->n++;
+        return;
+    }
+
+    if (right && right->n > min)
+    {
+        if (child->leaf)
+        {
+            _btree_leaf_move(tree, child, child->n, right, 0, 1);
+            _btree_leaf_move(tree, right, 0, right, 1, right->n - 1);
+            memcpy(_btree_node_key(tree, parent, idx), _btree_node_key(tree, right, 0), tree->kdsize);
+        }
+        else
+        {
+            memcpy(_btree_node_key(tree, child, child->n), _btree_node_key(tree, parent, idx), tree->kdsize);
+            _btree_children(tree, child)[child->n + 1] = _btree_children(tree, right)[0];
+            memcpy(_btree_node_key(tree, parent, idx), _btree_node_key(tree, right, 0), tree->kdsize);
+            _btree_keys_move(tree, right, 0, right, 1, right->n - 1);
+            _btree_children_move(tree, right, 0, right, 1, right->n);
+        }
+        right->n--;
+        child->n++;
+        return;
+    }
+
+    // 合并children[k]和children[k + 1], 移除分隔key[k]
+    usize k = left ? idx - 1 : idx;
+    left = children[k];
+    right = children[k + 1];
+    if (left->leaf)
+    {
+        _btree_leaf_move(tree, left, left->n, right, 0, right->n);
+        left->n += right->n;
+        left->next = right->next;
+        if (right->next)
+        {
+            right->next->prev = left;
+        }
+        else
+        {
+            tree->last = left;
+        }
+    }
+    else
+    {
+        memcpy(_btree_node_key(tree, left, left->n), _btree_node_key(tree, parent, k), tree->kdsize);
+        _btree_keys_move(tree, left, left->n + 1, right, 0, right->n);
+        _btree_children_move(tree, left, left->n + 1, right, 0, right->n + 1);
+        left->n += right->n + 1;
+    }
+    free(right);
+
+    _btree_keys_move(tree, parent, k, parent, k + 1, parent->n - k - 1);
+    _btree_children_move(tree, parent, k + 1, parent, k + 2, parent->n - k - 1);
+    parent->n--;
+}
+
+/**
+ * @brief 递归移除
+ *
+ * @param removed 指针key在分隔key更新后才释放, 这里返回被移除的key
+ * @return 移除成功返回1 key不存在返回0
+ */
+static b32 _btree_delete(btree *tree, btree_node *node, const void *key, void **removed)
+{
+    if (node->leaf)
+    {
+        usize i = _btree_lower(tree, node, key);
+        if (i >= node->n || _btree_cmp(tree, node, i, key) != 0)
+        {
+            return 0;
+        }
+
+        if (tree->ksize == 0)
+        {
+            *removed = btree_key(tree, node, i);
+            void *value = btree_value(tree, node, i);
+            if (tree->vfree && value)
+            {
+                tree->vfree(value);
+            }
+        }
+        else
+        {
+            _btree_free_kv(tree, node, i);
+        }
+        _btree_leaf_move(tree, node, i, node, i + 1, node->n - i - 1);
+        node->n--;
+        tree->len--;
+        return 1;
+    }
+
+    usize i = _btree_upper(tree, node, key);
+    btree_node *child = _btree_children(tree, node)[i];
+    if (!_btree_delete(tree, child, key, removed))
+    {
+        return 0;
+    }
+
+    // 被移除的key作为分隔时换成右子树当前最小的key, 避免引用已释放的指针key
+    if (i > 0 && _btree_cmp(tree, node, i - 1, key) == 0)
+    {
+        btree_node *low = child;
+        while (!low->leaf)
+        {
+            low = _btree_children(tree, low)[0];
+        }
+        memcpy(_btree_node_key(tree, node, i - 1), _btree_node_key(tree, low, 0), tree->kdsize);
+    }
+
+    if (child->n < tree->fanout / 2)
+    {
+        _btree_rebalance(tree, node, i);
+    }
+
+    return 1;
+}
+
+int btree_remove(btree *tree, const void *key)
+{
+    void *removed = NULL;
+    if (tree->root == NULL || !_btree_delete(tree, tree->root, key, &removed))
+    {
+        return 0;
+    }
+
+    if (tree->kfree && removed)
+    {
+        tree->kfree(removed);
+    }
+
+    btree_node *root = tree->root;
+    if (root->leaf && root->n == 0)
+    {
+        free(root);
+        tree->root = NULL;
+        tree->first = NULL;
+        tree->last = NULL;
+    }
+    else if (!root->leaf && root->n == 0)
+    {
+        tree->root = _btree_children(tree, root)[0];
+        free(root);
+    }
+
+    return 0;
+}
+
+size btree_count(btree *tree)
+{
+    return tree->len;
+}
+
+void btree_range(btree *tree, const void *lo, const void *hi, int (*func)(void *key, void *value, void *ctx), void *ctx)
+{
+    btree_iterator iter = lo ? btree_seek(tree, lo) : btree_begin(tree);
+    for (; btree_iter_valid(&iter); btree_iter_next(&iter))
+    {
+        if (hi && _btree_cmp(tree, iter.leaf, iter.pos, hi) >= 0)
+        {
+            return;
+        }
+
+        if (func(btree_key(tree, iter.leaf, iter.pos), btree_value(tree, iter.leaf, iter.pos), ctx))
+        {
+            return;
+        }
+    }
+}
+
+// ============================================================================
+//  btree迭代器
+// ============================================================================
+
+btree_iterator btree_begin(btree *tree)
+{
+    return (btree_iterator){tree, tree->first, 0};
+}
+
+btree_iterator btree_last(btree *tree)
+{
+    if (tree->last == NULL)
+    {
+        return (btree_iterator){tree, NULL, 0};
+    }
+
+    return (btree_iterator){tree, tree->last, (u16)(tree->last->n - 1)};
+}
+
+btree_iterator btree_seek(btree *tree, const void *key)
+{
+    btree_iterator iter = {tree, _btree_find_leaf(tree, key), 0};
+    if (iter.leaf)
+    {
+        usize i = _btree_lower(tree, iter.leaf, key);
+        if (i == iter.leaf->n)
+        {
+            iter.leaf = iter.leaf->next;
+            i = 0;
+        }
+        iter.pos = (u16)i;
+    }
+
+    return iter;
+}
+
+btree_iterator btree_upper(btree *tree, const void *key)
+{
+    btree_iterator iter = {tree, _btree_find_leaf(tree, key), 0};
+    if (iter.leaf)
+    {
+        usize i = _btree_upper(tree, iter.leaf, key);
+        if (i == iter.leaf->n)
+        {
+            iter.leaf = iter.leaf->next;
+            i = 0;
+        }
+        iter.pos = (u16)i;
+    }
+
+    return iter;
+}
+
+btree_iterator btree_floor(btree *tree, const void *key)
+{
+    btree_iterator iter = {tree, _btree_find_leaf(tree, key), 0};
+    if (iter.leaf)
+    {
+        usize i = _btree_upper(tree, iter.leaf, key);
+        if (i == 0)
+        {
+            iter.leaf = iter.leaf->prev;
+            i = iter.leaf ? iter.leaf->n : 0;
+        }
+        iter.pos = (u16)(i ? i - 1 : 0);
+    }
+
+    return iter;
+}
+
+b32 btree_iter_valid(btree_iterator *iter)
+{
+    return iter->leaf != NULL;
+}
+
+void btree_iter_next(btree_iterator *iter)
+{
+    if (iter->leaf == NULL)
+    {
+        return;
+    }
+
+    if (++iter->pos >= iter->leaf->n)
+    {
+        iter->leaf = iter->leaf->next;
+        iter->pos = 0;
+    }
+}
+
+void btree_iter_prev(btree_iterator *iter)
+{
+    if (iter->leaf == NULL)
+    {
+        return;
+    }
+
+    if (iter->pos == 0)
+    {
+        iter->leaf = iter->leaf->prev;
+        iter->pos = iter->leaf ? (u16)(iter->leaf->n - 1) : 0;
+        return;
+    }
+
+    iter->pos--;
+}
+
+void *btree_iter_key(btree_iterator *iter)
+{
+    if (iter->leaf == NULL)
+    {
+        return NULL;
+    }
+
+    return btree_key(iter->tree, iter->leaf, iter->pos);
+}
+
+void *btree_iter_value(btree_iterator *iter)
+{
+    if (iter->leaf == NULL)
+    {
+        return NULL;
+    }
+
+    return btree_value(iter->tree, iter->leaf, iter->pos);
+}
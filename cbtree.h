@@ -0,0 +1,249 @@
+#ifndef __CBTREE_H
+#define __CBTREE_H
+
+#include "ctype.h"
+
+// 节点中key数组的目标字节数, 节点key数量由此和key大小决定
+#define BTREE_NODE_KEY_BYTES 256
+#define BTREE_MIN_KEYS       4
+
+// key类型, ksize为4或8且cmp为NULL时按无符号整数排序, 节点内查找使用SIMD
+#define BTREE_KEY_GENERIC 0
+#define BTREE_KEY_U32     1
+#define BTREE_KEY_U64     2
+
+// ============================================================================
+// btree 有序表, B+树, kv只存放在叶子节点, 叶子节点双向链接
+// ============================================================================
+
+typedef struct btree_node
+{
+    // key个数
+    u16 n;
+    b32 leaf;
+    // 叶子节点链表
+    struct btree_node *prev;
+    struct btree_node *next;
+    // key, 然后是叶子节点的value和flag或内部节点的子节点指针
+    _Alignas(8) u8 data[];
+} btree_node;
+
+typedef struct btree_header
+{
+    btree_node *root;
+    // 最小和最大key所在的叶子节点
+    btree_node *first;
+    btree_node *last;
+    usize len;
+    const usize ksize;
+    const usize vsize;
+    const usize kdsize;
+    const usize vdsize;
+    // 节点最多fanout个key, 除根节点外最少fanout / 2个
+    const u16 fanout;
+    // 节点data中各部分的偏移
+    const usize values_off;
+    const usize flags_off;
+    const usize children_off;
+    int key_kind;
+    // 分裂时上移的key
+    u8 *sep;
+    // 动态函数
+    int (*cmp)(const void *key1, const void *key2, usize ksize);
+    void (*kfree)(void *key);
+    void (*vfree)(void *value);
+} btree;
+
+typedef struct
+{
+    const btree *tree;
+    btree_node *leaf;
+    u16 pos;
+} btree_iterator;
+
+/**
+ * @brief 创建btree
+ *
+ * @param ksize key大小, 为0时保存key指针
+ * @param vsize value大小, 为0时保存value指针
+ * @param cmp 比较函数, NULL时4或8字节key按无符号整数比较, 其他按memcmp
+ * @return 返回新创建的btree指针, 内存分配失败返回NULL
+ */
+btree *btree_new(usize ksize, usize vsize, int cmp(const void *, const void *, usize));
+
+/**
+ * @brief btree释放
+ *
+ * @param tree
+ */
+void btree_free(btree *tree);
+
+/**
+ * @brief 设置key释放函数
+ *
+ * @param tree
+ * @param kfree
+ */
+void btree_set_kfree(btree *tree, void (*kfree)(void *key));
+
+/**
+ * @brief 设置value释放函数
+ *
+ * @param tree
+ * @param vfree
+ */
+void btree_set_vfree(btree *tree, void (*vfree)(void *value));
+
+/**
+ * @brief 插入或更新key val
+ *
+ * @param tree
+ * @param key 不能为NULL
+ * @param value
+ * @return 成功返回0 失败返回非0
+ */
+int btree_set(btree *tree, void *key, void *value);
+
+/**
+ * @brief 从升序且不重复的数组批量构建, 树必须为空, 叶子节点按满节点填充
+ *
+ * @param tree
+ * @param keys 连续存放的key, ksize为0时为key指针数组
+ * @param values 连续存放的value, ksize为0时为value指针数组, NULL时value都为NULL
+ * @param n 个数
+ * @return 成功返回0 树不为空、key不是严格升序或内存分配失败返回非0
+ */
+int btree_load_sorted(btree *tree, const void *keys, const void *values, usize n);
+
+/**
+ * @brief 查找key
+ *
+ * @param tree
+ * @param key
+ * @return 查找到返回val所在指针 否则返回NULL
+ */
+void *btree_get(btree *tree, const void *key);
+
+/**
+ * @brief 查找key是否存在
+ *
+ * @param tree
+ * @param key
+ * @return 存在返回1 否则返回0
+ */
+b32 btree_exist(btree *tree, const void *key);
+
+/**
+ * @brief 移除元素
+ *
+ * @param tree
+ * @param key
+ * @return 成功返回0 失败返回非0
+ */
+int btree_remove(btree *tree, const void *key);
+
+/**
+ * @brief 元素个数
+ *
+ * @param tree
+ * @return 返回元素个数
+ */
+size btree_count(btree *tree);
+
+/**
+ * @brief 遍历[lo, hi)中的元素, 按key升序
+ *
+ * @param tree
+ * @param lo NULL为从最小key开始
+ * @param hi NULL为到最大key结束
+ * @param func 返回非0时停止遍历
+ * @param ctx
+ */
+void btree_range(btree *tree, const void *lo, const void *hi, int (*func)(void *key, void *value, void *ctx), void *ctx);
+
+// ============================================================================
+//  btree迭代器, 树被修改后失效
+// ============================================================================
+
+/**
+ * @brief 指向最小key的迭代器
+ *
+ * @param tree
+ * @return btree_iterator
+ */
+btree_iterator btree_begin(btree *tree);
+
+/**
+ * @brief 指向最大key的迭代器
+ *
+ * @param tree
+ * @return btree_iterator
+ */
+btree_iterator btree_last(btree *tree);
+
+/**
+ * @brief 指向第一个不小于key的元素(ceiling)
+ *
+ * @param tree
+ * @param key
+ * @return btree_iterator
+ */
+btree_iterator btree_seek(btree *tree, const void *key);
+
+/**
+ * @brief 指向第一个大于key的元素
+ *
+ * @param tree
+ * @param key
+ * @return btree_iterator
+ */
+btree_iterator btree_upper(btree *tree, const void *key);
+
+/**
+ * @brief 指向最后一个不大于key的元素(floor)
+ *
+ * @param tree
+ * @param key
+ * @return btree_iterator
+ */
+btree_iterator btree_floor(btree *tree, const void *key);
+
+/**
+ * @brief 迭代器是否指向元素
+ *
+ * @param iter
+ * @return 指向元素返回1 已越过两端返回0
+ */
+b32 btree_iter_valid(btree_iterator *iter);
+
+/**
+ * @brief 移动到下一个元素
+ *
+ * @param iter
+ */
+void btree_iter_next(btree_iterator *iter);
+
+/**
+ * @brief 移动到上一个元素
+ *
+ * @param iter
+ */
+void btree_iter_prev(btree_iterator *iter);
+
+/**
+ * @brief 迭代器指向的key
+ *
+ * @param iter
+ * @return key, 迭代器无效时返回NULL
+ */
+void *btree_iter_key(btree_iterator *iter);
+
+/**
+ * @brief 迭代器指向的value
+ *
+ * @param iter
+ * @return val所在指针, 迭代器无效或value为NULL时返回NULL
+ */
+void *btree_iter_value(btree_iterator *iter);
+
+#endif // __CBTREE_H
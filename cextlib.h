@@ -0,0 +1,57 @@
+#ifndef __CEXTLIB_H
+#define __CEXTLIB_H
+
+// ============================================================================
+// 单头文件构建
+//
+// 只包含此头文件, 并在其中一个.c文件中包含前定义CEXTLIB_IMPLEMENTATION:
+//
+//     #define CEXTLIB_IMPLEMENTATION
+//     #include "cextlib.h"
+//
+// 热路径函数(vec_push, vec_get, string_push_char, hashmap_count等)在每个文件中为static inline,
+// 其余函数只在定义了CEXTLIB_IMPLEMENTATION的文件中编译,
+// 同一文件中对hashmap_get等函数的调用也可以被内联
+// 不能与单独编译的.c文件混用
+// ============================================================================
+
+#define CEXTLIB_AMALGAMATION
+
+#include "ctype.h"
+
+#include "cpool.h"
+#include "cstring.h"
+#include "cvec.h"
+#include "chashmap.h"
+#include "chashmap_parallel.h"
+#include "chamt.h"
+#include "clru.h"
+#include "cttl.h"
+#include "cvec_index.h"
+#include "cvec_sort.h"
+#include "cvec_parallel.h"
+#include "cbtree.h"
+#include "cart.h"
+#include "chll.h"
+
+#endif // __CEXTLIB_H
+
+#if defined(CEXTLIB_IMPLEMENTATION) && !defined(__CEXTLIB_IMPLEMENTATION_DONE)
+#define __CEXTLIB_IMPLEMENTATION_DONE
+
+#include "cpool.c"
+#include "cstring.c"
+#include "cvec.c"
+#include "chashmap.c"
+#include "chashmap_parallel.c"
+#include "chamt.c"
+#include "clru.c"
+#include "cttl.c"
+#include "cvec_index.c"
+#include "cvec_sort.c"
+#include "cvec_parallel.c"
+#include "cbtree.c"
+#include "cart.c"
+#include "chll.c"
+
+#endif // CEXTLIB_IMPLEMENTATION
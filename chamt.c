@@ -0,0 +1,714 @@
+#include "chamt.h"
+#include "chashmap.h"
+#include <string.h>
+
+#define PTR_LEN        sizeof(uintptr_t)
+#define HAMT_MASK      (HAMT_WIDTH - 1)
+#define HAMT_MAX_SHIFT 64 // hash用尽后使用冲突节点
+
+static inline usize align8(usize n)
+{
+    return (n + 7) & ~(usize)7;
+}
+
+static inline u32 _hamt_frag(u64 hash, u32 shift)
+{
+    return (u32)(hash >> shift) & HAMT_MASK;
+}
+
+static inline u32 _hamt_index(u32 bitmap, u32 bit)
+{
+    return (u32)__builtin_popcount(bitmap & (bit - 1));
+}
+
+static inline u32 _hamt_node_nodes(const hamt_node *node)
+{
+    return (u32)__builtin_popcount(node->nodemap);
+}
+
+static inline u32 _hamt_node_datas(const hamt_node *node)
+{
+    return node->collisions ? node->collisions : (u32)__builtin_popcount(node->datamap);
+}
+
+static inline hamt_node **_hamt_children(hamt_node *node)
+{
+    return (hamt_node **)node->data;
+}
+
+static inline u8 *_hamt_entry(const hamt *map, hamt_node *node, u32 n_nodes, u32 i)
+{
+    return node->data + (PTR_LEN * n_nodes) + (map->esize * i);
+}
+
+static inline void *hamt_key(const hamt *map, u8 *entry)
+{
+    if (map->ksize == 0)
+    {
+        return (void *)(*(uintptr_t *)entry);
+    }
+
+    return entry;
+}
+
+static inline void *hamt_value(const hamt *map, u8 *entry)
+{
+    if (map->vsize == 0)
+    {
+        return (void *)(*(uintptr_t *)(entry + map->voffset));
+    }
+
+    return entry[map->foffset] ? entry + map->voffset : NULL;
+}
+
+static void _hamt_put_key(const hamt *map, u8 *entry, const void *key)
+{
+    if (map->ksize == 0)
+    {
+        *(uintptr_t *)entry = (uintptr_t)key;
+        return;
+    }
+
+    memcpy(entry, key, map->kdsize);
+}
+
+static void _hamt_put_value(const hamt *map, u8 *entry, const void *value)
+{
+    if (map->vsize == 0)
+    {
+        *(uintptr_t *)(entry + map->voffset) = (uintptr_t)value;
+        return;
+    }
+
+    if (!value)
+    {
+        memset(entry + map->voffset, 0, map->vdsize);
+        entry[map->foffset] = 0;
+        return;
+    }
+
+    memcpy(entry + map->voffset, value, map->vdsize);
+    entry[map->foffset] = 1;
+}
+
+static inline u64 _hamt_hash(const hamt *map, const void *key)
+{
+    return map->hasher(key, map->kdsize, map->seed);
+}
+
+static inline b32 _hamt_key_eq(const hamt *map, u8 *entry, const void *key)
+{
+    return map->cmp(hamt_key(map, entry), key, map->kdsize) == 0;
+}
+
+static inline b32 _hamt_node_unique(hamt_node *node)
+{
+    return __atomic_load_n(&node->refcount, __ATOMIC_ACQUIRE) == 1;
+}
+
+static inline void _hamt_node_retain(hamt_node *node)
+{
+    __atomic_add_fetch(&node->refcount, 1, __ATOMIC_RELAXED);
+}
+
+static void _hamt_node_release(hamt_node *node)
+{
+    if (!node || __atomic_sub_fetch(&node->refcount, 1, __ATOMIC_ACQ_REL) != 0)
+    {
+        return;
+    }
+
+    u32 n_nodes = _hamt_node_nodes(node);
+    for (u32 i = 0; i < n_nodes; i++)
+    {
+        _hamt_node_release(_hamt_children(node)[i]);
+    }
+    free(node);
+}
+
+static hamt_node *_hamt_node_alloc(const hamt *map, u32 n_nodes, u32 n_data)
+{
+    hamt_node *node = (hamt_node *)malloc(sizeof(hamt_node) + (PTR_LEN * n_nodes) + (map->esize * n_data));
+    if (!node)
+    {
+        return NULL;
+    }
+
+    node->refcount = 1;
+    node->datamap = 0;
+    node->nodemap = 0;
+    node->collisions = 0;
+    return node;
+}
+
+/**
+ * @brief 节点内容已经拷贝到新节点后处理旧节点, 独占时直接释放, 共享时新节点也引用子节点
+ *
+ * @param node
+ * @param n_nodes
+ */
+static void _hamt_node_dispose(hamt_node *node, u32 n_nodes)
+{
+    if (_hamt_node_unique(node))
+    {
+        free(node);
+        return;
+    }
+
+    for (u32 i = 0; i < n_nodes; i++)
+    {
+        _hamt_node_retain(_hamt_children(node)[i]);
+    }
+    _hamt_node_release(node);
+}
+
+/**
+ * @brief 获取可以原地修改的节点, 共享的节点会被复制
+ *
+ * @param map
+ * @param node 接管一个引用
+ * @return 失败返回NULL, node不变
+ */
+static hamt_node *_hamt_node_own(const hamt *map, hamt_node *node)
+{
+    if (_hamt_node_unique(node))
+    {
+        return node;
+    }
+
+    u32 n_nodes = _hamt_node_nodes(node);
+    u32 n_data = _hamt_node_datas(node);
+    hamt_node *copy = _hamt_node_alloc(map, n_nodes, n_data);
+    if (!copy)
+    {
+        return NULL;
+    }
+
+    copy->datamap = node->datamap;
+    copy->nodemap = node->nodemap;
+    copy->collisions = node->collisions;
+    memcpy(copy->data, node->data, (PTR_LEN * n_nodes) + (map->esize * n_data));
+    _hamt_node_dispose(node, n_nodes);
+    return copy;
+}
+
+/**
+ * @brief 两个hash前缀相同的kv下沉到新的子树
+ *
+ * @param map
+ * @param entry 已有的kv
+ * @param hash1 已有kv的hash
+ * @param key
+ * @param value
+ * @param hash2 新key的hash
+ * @param shift
+ * @return 失败返回NULL
+ */
+static hamt_node *_hamt_node_pair(
+    const hamt *map,
+    u8 *entry, u64 hash1,
+    void *key, void *value, u64 hash2,
+    u32 shift)
+{
+    if (shift >= HAMT_MAX_SHIFT)
+    {
+        hamt_node *node = _hamt_node_alloc(map, 0, 2);
+        if (!node)
+        {
+            return NULL;
+        }
+        node->collisions = 2;
+        memcpy(_hamt_entry(map, node, 0, 0), entry, map->esize);
+        _hamt_put_key(map, _hamt_entry(map, node, 0, 1), key);
+        _hamt_put_value(map, _hamt_entry(map, node, 0, 1), value);
+        return node;
+    }
+
+    u32 f1 = _hamt_frag(hash1, shift);
+    u32 f2 = _hamt_frag(hash2, shift);
+    if (f1 == f2)
+    {
+        hamt_node *child = _hamt_node_pair(map, entry, hash1, key, value, hash2, shift + HAMT_BITS);
+        hamt_node *node = child ? _hamt_node_alloc(map, 1, 0) : NULL;
+        if (!node)
+        {
+            _hamt_node_release(child);
+            return NULL;
+        }
+        node->nodemap = 1u << f1;
+        _hamt_children(node)[0] = child;
+        return node;
+    }
+
+    hamt_node *node = _hamt_node_alloc(map, 0, 2);
+    if (!node)
+    {
+        return NULL;
+    }
+    node->datamap = (1u << f1) | (1u << f2);
+    u8 *e1 = _hamt_entry(map, node, 0, f1 < f2 ? 0 : 1);
+    u8 *e2 = _hamt_entry(map, node, 0, f1 < f2 ? 1 : 0);
+    memcpy(e1, entry, map->esize);
+    _hamt_put_key(map, e2, key);
+    _hamt_put_value(map, e2, value);
+    return node;
+}
+
+static hamt_node *_hamt_collision_set(hamt *map, hamt_node *node, void *key, void *value, b32 *added, int *err)
+{
+    u32 n = node->collisions;
+    for (u32 i = 0; i < n; i++)
+    {
+        if (_hamt_key_eq(map, _hamt_entry(map, node, 0, i), key))
+        {
+            hamt_node *owned = _hamt_node_own(map, node);
+            if (!owned)
+            {
+                *err = 1;
+                return node;
+            }
+            _hamt_put_value(map, _hamt_entry(map, owned, 0, i), value);
+            return owned;
+        }
+    }
+
+    hamt_node *grown = _hamt_node_alloc(map, 0, n + 1);
+    if (!grown)
+    {
+        *err = 1;
+        return node;
+    }
+    grown->collisions = n + 1;
+    memcpy(grown->data, node->data, map->esize * n);
+    _hamt_put_key(map, _hamt_entry(map, grown, 0, n), key);
+    _hamt_put_value(map, _hamt_entry(map, grown, 0, n), value);
+    _hamt_node_dispose(node, 0);
+    *added = 1;
+    return grown;
+}
+
+/**
+ * @brief 插入key val
+ *
+ * @param map
+ * @param node 接管一个引用
+ * @param hash
+ * @param shift
+ * @param key
+ * @param value
+ * @param added 新增key时置1
+ * @param err 内存分配失败时置1
+ * @return 插入后的节点, 失败时内容不变
+ */
+static hamt_node *_hamt_node_set(
+    hamt *map, hamt_node *node,
+    u64 hash, u32 shift,
+    void *key, void *value,
+    b32 *added, int *err)
+{
+    if (node->collisions)
+    {
+        return _hamt_collision_set(map, node, key, value, added, err);
+    }
+
+    u32 bit = 1u << _hamt_frag(hash, shift);
+    u32 n_nodes = _hamt_node_nodes(node);
+    u32 n_data = _hamt_node_datas(node);
+
+    if (node->nodemap & bit)
+    {
+        u32 ci = _hamt_index(node->nodemap, bit);
+        hamt_node *owned = _hamt_node_own(map, node);
+        if (!owned)
+        {
+            *err = 1;
+            return node;
+        }
+        hamt_node **children = _hamt_children(owned);
+        children[ci] = _hamt_node_set(map, children[ci], hash, shift + HAMT_BITS, key, value, added, err);
+        return owned;
+    }
+
+    u32 di = _hamt_index(node->datamap, bit);
+    if (node->datamap & bit)
+    {
+        u8 *entry = _hamt_entry(map, node, n_nodes, di);
+        if (_hamt_key_eq(map, entry, key))
+        {
+            hamt_node *owned = _hamt_node_own(map, node);
+            if (!owned)
+            {
+                *err = 1;
+                return node;
+            }
+            _hamt_put_value(map, _hamt_entry(map, owned, n_nodes, di), value);
+            return owned;
+        }
+
+        // 已有kv和新kv下沉到子节点
+        hamt_node *child = _hamt_node_pair(
+            map,
+            entry, _hamt_hash(map, hamt_key(map, entry)),
+            key, value, hash,
+            shift + HAMT_BITS);
+        hamt_node *moved = child ? _hamt_node_alloc(map, n_nodes + 1, n_data - 1) : NULL;
+        if (!moved)
+        {
+            _hamt_node_release(child);
+            *err = 1;
+            return node;
+        }
+
+        u32 ci = _hamt_index(node->nodemap, bit);
+        moved->datamap = node->datamap & ~bit;
+        moved->nodemap = node->nodemap | bit;
+        hamt_node **src_children = _hamt_children(node);
+        hamt_node **dst_children = _hamt_children(moved);
+        memcpy(dst_children, src_children, PTR_LEN * ci);
+        dst_children[ci] = child;
+        memcpy(dst_children + ci + 1, src_children + ci, PTR_LEN * (n_nodes - ci));
+        memcpy(_hamt_entry(map, moved, n_nodes + 1, 0), _hamt_entry(map, node, n_nodes, 0), map->esize * di);
+        memcpy(_hamt_entry(map, moved, n_nodes + 1, di), _hamt_entry(map, node, n_nodes, di + 1), map->esize * (n_data - di - 1));
+        _hamt_node_dispose(node, n_nodes);
+        *added = 1;
+        return moved;
+    }
+
+    hamt_node *grown = _hamt_node_alloc(map, n_nodes, n_data + 1);
+    if (!grown)
+    {
+        *err = 1;
+        return node;
+    }
+    grown->datamap = node->datamap | bit;
+    grown->nodemap = node->nodemap;
+    memcpy(grown->data, node->data, (PTR_LEN * n_nodes) + (map->esize * di));
+    memcpy(_hamt_entry(map, grown, n_nodes, di + 1), _hamt_entry(map, node, n_nodes, di), map->esize * (n_data - di));
+    _hamt_put_key(map, _hamt_entry(map, grown, n_nodes, di), key);
+    _hamt_put_value(map, _hamt_entry(map, grown, n_nodes, di), value);
+    _hamt_node_dispose(node, n_nodes);
+    *added = 1;
+    return grown;
+}
+
+/**
+ * @brief 移除一个kv, 返回新节点
+ *
+ * @param map
+ * @param node 接管一个引用
+ * @param n_nodes
+ * @param n_data
+ * @param di 要移除的kv下标
+ * @param bit 要移除的kv所在位, 冲突节点为0
+ * @return 节点为空时返回NULL, 失败时返回原节点并设置err
+ */
+static hamt_node *_hamt_node_without_entry(hamt *map, hamt_node *node, u32 n_nodes, u32 n_data, u32 di, u32 bit, int *err)
+{
+    if (n_nodes == 0 && n_data == 1)
+    {
+        _hamt_node_release(node);
+        return NULL;
+    }
+
+    hamt_node *shrunk = _hamt_node_alloc(map, n_nodes, n_data - 1);
+    if (!shrunk)
+    {
+        *err = 1;
+        return node;
+    }
+    shrunk->datamap = node->datamap & ~bit;
+    shrunk->nodemap = node->nodemap;
+    shrunk->collisions = node->collisions ? node->collisions - 1 : 0;
+    memcpy(shrunk->data, node->data, (PTR_LEN * n_nodes) + (map->esize * di));
+    memcpy(_hamt_entry(map, shrunk, n_nodes, di), _hamt_entry(map, node, n_nodes, di + 1), map->esize * (n_data - di - 1));
+    _hamt_node_dispose(node, n_nodes);
+    return shrunk;
+}
+
+/**
+ * @brief 移除key, 调用前需确认key存在
+ *
+ * @param map
+ * @param node 接管一个引用
+ * @param hash
+ * @param shift
+ * @param key
+ * @param err 内存分配失败时置1
+ * @return 移除后的节点, 节点为空时返回NULL
+ */
+static hamt_node *_hamt_node_remove(hamt *map, hamt_node *node, u64 hash, u32 shift, const void *key, int *err)
+{
+    if (node->collisions)
+    {
+        u32 i = 0;
+        while (!_hamt_key_eq(map, _hamt_entry(map, node, 0, i), key))
+        {
+            i++;
+        }
+        return _hamt_node_without_entry(map, node, 0, node->collisions, i, 0, err);
+    }
+
+    u32 bit = 1u << _hamt_frag(hash, shift);
+    u32 n_nodes = _hamt_node_nodes(node);
+    u32 n_data = _hamt_node_datas(node);
+
+    if (node->datamap & bit)
+    {
+        return _hamt_node_without_entry(map, node, n_nodes, n_data, _hamt_index(node->datamap, bit), bit, err);
+    }
+
+    u32 ci = _hamt_index(node->nodemap, bit);
+    hamt_node *owned = _hamt_node_own(map, node);
+    if (!owned)
+    {
+        *err = 1;
+        return node;
+    }
+
+    hamt_node **children = _hamt_children(owned);
+    hamt_node *child = _hamt_node_remove(map, children[ci], hash, shift + HAMT_BITS, key, err);
+    children[ci] = child;
+    if (child && (_hamt_node_nodes(child) > 0 || _hamt_node_datas(child) > 1))
+    {
+        return owned;
+    }
+
+    if (!child)
+    {
+        if (n_nodes == 1 && n_data == 0)
+        {
+            free(owned);
+            return NULL;
+        }
+
+        // 子节点为空, 原地删除子节点位, 节点内存略大于需要
+        memmove(children + ci, children + ci + 1, PTR_LEN * (n_nodes - ci - 1));
+        memmove(_hamt_entry(map, owned, n_nodes - 1, 0), _hamt_entry(map, owned, n_nodes, 0), map->esize * n_data);
+        owned->nodemap &= ~bit;
+        return owned;
+    }
+
+    // 子节点只剩一个kv, 上移到当前节点, 分配失败时保留子节点, 结构仍然有效
+    hamt_node *merged = _hamt_node_alloc(map, n_nodes - 1, n_data + 1);
+    if (!merged)
+    {
+        return owned;
+    }
+
+    u32 di = _hamt_index(owned->datamap, bit);
+    merged->nodemap = owned->nodemap & ~bit;
+    merged->datamap = owned->datamap | bit;
+    hamt_node **dst_children = _hamt_children(merged);
+    memcpy(dst_children, children, PTR_LEN * ci);
+    memcpy(dst_children + ci, children + ci + 1, PTR_LEN * (n_nodes - ci - 1));
+    memcpy(_hamt_entry(map, merged, n_nodes - 1, 0), _hamt_entry(map, owned, n_nodes, 0), map->esize * di);
+    memcpy(_hamt_entry(map, merged, n_nodes - 1, di), _hamt_entry(map, child, 0, 0), map->esize);
+    memcpy(_hamt_entry(map, merged, n_nodes - 1, di + 1), _hamt_entry(map, owned, n_nodes, di), map->esize * (n_data - di));
+    _hamt_node_release(child);
+    free(owned);
+    return merged;
+}
+
+hamt *hamt_new(
+    usize ksize,
+    usize vsize,
+    u64 seed,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    hamt *map = (hamt *)malloc(sizeof(hamt));
+    if (map == NULL)
+    {
+        return NULL;
+    }
+
+    map->root = NULL;
+    map->len = 0;
+    *(usize *)&map->ksize = ksize;
+    *(usize *)&map->vsize = vsize;
+    *(usize *)&map->kdsize = ksize ? ksize : PTR_LEN;
+    *(usize *)&map->vdsize = vsize ? vsize : PTR_LEN;
+    *(usize *)&map->voffset = align8(map->kdsize);
+    *(usize *)&map->foffset = map->voffset + map->vdsize;
+    *(usize *)&map->esize = align8(map->foffset + 1);
+    *(u64 *)&map->seed = seed;
+    map->hasher = (hasher) ? hasher : hashmap_siphash;
+    map->cmp = (cmp) ? cmp : memcmp;
+    return map;
+}
+
+void hamt_free(hamt *map)
+{
+    if (!map)
+    {
+        return;
+    }
+
+    _hamt_node_release(map->root);
+    free(map);
+}
+
+hamt *hamt_snapshot(hamt *map)
+{
+    if (!map)
+    {
+        return NULL;
+    }
+
+    hamt *snapshot = (hamt *)malloc(sizeof(hamt));
+    if (snapshot == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(snapshot, map, sizeof(hamt));
+    if (snapshot->root)
+    {
+        _hamt_node_retain(snapshot->root);
+    }
+    return snapshot;
+}
+
+int hamt_set(hamt *map, void *key, void *value)
+{
+    if (!map || !key)
+    {
+        return 1;
+    }
+
+    u64 hash = _hamt_hash(map, key);
+    if (!map->root)
+    {
+        hamt_node *root = _hamt_node_alloc(map, 0, 1);
+        if (!root)
+        {
+            return 1;
+        }
+        root->datamap = 1u << _hamt_frag(hash, 0);
+        _hamt_put_key(map, _hamt_entry(map, root, 0, 0), key);
+        _hamt_put_value(map, _hamt_entry(map, root, 0, 0), value);
+        map->root = root;
+        map->len = 1;
+        return 0;
+    }
+
+    b32 added = 0;
+    int err = 0;
+    map->root = _hamt_node_set(map, map->root, hash, 0, key, value, &added, &err);
+    map->len += added;
+    return err;
+}
+
+static u8 *_hamt_find(hamt *map, const void *key)
+{
+    if (!map || !key || !map->root)
+    {
+        return NULL;
+    }
+
+    u64 hash = _hamt_hash(map, key);
+    hamt_node *node = map->root;
+    for (u32 shift = 0;; shift += HAMT_BITS)
+    {
+        if (node->collisions)
+        {
+            for (u32 i = 0; i < node->collisions; i++)
+            {
+                u8 *entry = _hamt_entry(map, node, 0, i);
+                if (_hamt_key_eq(map, entry, key))
+                {
+                    return entry;
+                }
+            }
+            return NULL;
+        }
+
+        u32 bit = 1u << _hamt_frag(hash, shift);
+        if (node->datamap & bit)
+        {
+            u8 *entry = _hamt_entry(map, node, _hamt_node_nodes(node), _hamt_index(node->datamap, bit));
+            return _hamt_key_eq(map, entry, key) ? entry : NULL;
+        }
+
+        if (!(node->nodemap & bit))
+        {
+            return NULL;
+        }
+        node = _hamt_children(node)[_hamt_index(node->nodemap, bit)];
+    }
+}
+
+void *hamt_get(hamt *map, const void *key)
+{
+    u8 *entry = _hamt_find(map, key);
+    return entry ? hamt_value(map, entry) : NULL;
+}
+
+b32 hamt_exist(hamt *map, const void *key)
+{
+    return _hamt_find(map, key) != NULL;
+}
+
+int hamt_remove(hamt *map, const void *key)
+{
+    if (!map)
+    {
+        return 1;
+    }
+
+    if (!_hamt_find(map, key))
+    {
+        return 0;
+    }
+
+    int err = 0;
+    map->root = _hamt_node_remove(map, map->root, _hamt_hash(map, key), 0, key, &err);
+    if (!err)
+    {
+        map->len--;
+    }
+    return err;
+}
+
+size hamt_count(hamt *map)
+{
+    if (!map)
+    {
+        return 0;
+    }
+
+    return map->len;
+}
+
+static int _hamt_node_foreach(hamt *map, hamt_node *node, int (*func)(void *key, void *value, void *ctx), void *ctx)
+{
+    u32 n_nodes = _hamt_node_nodes(node);
+    u32 n_data = _hamt_node_datas(node);
+    for (u32 i = 0; i < n_data; i++)
+    {
+        u8 *entry = _hamt_entry(map, node, n_nodes, i);
+        if (func(hamt_key(map, entry), hamt_value(map, entry), ctx))
+        {
+            return 1;
+        }
+    }
+
+    for (u32 i = 0; i < n_nodes; i++)
+    {
+        if (_hamt_node_foreach(map, _hamt_children(node)[i], func, ctx))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void hamt_foreach(hamt *map, int (*func)(void *key, void *value, void *ctx), void *ctx)
+{
+    if (!map || !map->root || !func)
+    {
+        return;
+    }
+
+    _hamt_node_foreach(map, map->root, func, ctx);
+}
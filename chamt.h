@@ -0,0 +1,131 @@
+#ifndef __CHAMT_H
+#define __CHAMT_H
+
+#include "ctype.h"
+
+#define HAMT_BITS  5
+#define HAMT_WIDTH (1 << HAMT_BITS)
+
+// ============================================================================
+// hamt 持久化hash trie, 快照共享结构
+// ============================================================================
+
+typedef struct hamt_node
+{
+    // 引用计数, 为1时节点只属于一个hamt, 可以原地修改
+    usize refcount;
+    // 存放kv的位
+    u32 datamap;
+    // 存放子节点的位
+    u32 nodemap;
+    // hash用尽后的冲突节点中kv的个数
+    u32 collisions;
+    // 子节点指针, 然后是kv
+    _Alignas(8) u8 data[];
+} hamt_node;
+
+typedef struct hamt_header
+{
+    hamt_node *root;
+    usize len;
+    const usize ksize;
+    const usize vsize;
+    const usize kdsize;
+    const usize vdsize;
+    // kv中value和flag的偏移以及kv大小
+    const usize voffset;
+    const usize foffset;
+    const usize esize;
+    const u64 seed;
+    // 动态函数
+    u64 (*hasher)(const void *data, usize dsize, u64 seed);
+    int (*cmp)(const void *key1, const void *key2, usize ksize);
+} hamt;
+
+/**
+ * @brief 创建hamt, key和value按值拷贝, ksize或vsize为0时保存指针且不负责释放
+ *
+ * @param ksize key大小
+ * @param vsize value大小
+ * @param seed 随机种子
+ * @param hasher hash函数, NULL为hashmap_siphash
+ * @param cmp 比较函数, NULL为memcmp
+ * @return 返回新创建的hamt指针, 内存分配失败返回NULL
+ */
+hamt *hamt_new(
+    usize ksize,
+    usize vsize,
+    u64 seed,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize));
+
+/**
+ * @brief hamt释放, 只释放不被其他快照共享的节点
+ *
+ * @param map
+ */
+void hamt_free(hamt *map);
+
+/**
+ * @brief 创建快照, O(1), 快照与原hamt共享所有节点, 之后任一方的修改只复制修改路径上的节点
+ *
+ * @param map
+ * @return 成功返回hamt指针 失败返回NULL
+ */
+hamt *hamt_snapshot(hamt *map);
+
+/**
+ * @brief hamt插入key val, 不被共享的节点原地修改, 被共享的节点复制后修改
+ *
+ * @param map
+ * @param key 不能为NULL
+ * @param value
+ * @return 成功返回0 失败返回非0
+ */
+int hamt_set(hamt *map, void *key, void *value);
+
+/**
+ * @brief hamt查找key
+ *
+ * @param map
+ * @param key
+ * @return 查找到返回val所在指针 否则返回NULL
+ */
+void *hamt_get(hamt *map, const void *key);
+
+/**
+ * @brief hamt查找key是否存在
+ *
+ * @param map
+ * @param key
+ * @return 存在返回1 否则返回0
+ */
+b32 hamt_exist(hamt *map, const void *key);
+
+/**
+ * @brief hamt移除元素
+ *
+ * @param map
+ * @param key
+ * @return 成功返回0 失败返回非0
+ */
+int hamt_remove(hamt *map, const void *key);
+
+/**
+ * @brief hamt元素个数
+ *
+ * @param map
+ * @return 返回元素个数
+ */
+size hamt_count(hamt *map);
+
+/**
+ * @brief 遍历hamt, 顺序由hash决定
+ *
+ * @param map
+ * @param func 返回非0时停止遍历
+ * @param ctx
+ */
+void hamt_foreach(hamt *map, int (*func)(void *key, void *value, void *ctx), void *ctx);
+
+#endif // __CHAMT_H
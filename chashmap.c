@@ -2,6 +2,22 @@
 #include "cutils.h"
 #include <assert.h>
 #include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#ifndef CEXTLIB_AMALGAMATION
+extern inline b32 hashmap_is_success(int ret);
+extern inline size hashmap_count(hashmap *map);
+extern inline b32 hashmap_empty(hashmap *map);
+#endif
 
 #define HASHMAP_HASH_INIT 2166136261u
 #define PSL               1
@@ -60,6 +76,161 @@ static u64 fnv_1a_hash(const void *data, usize dsize, u64 seed)
     return hash ^ hash >> 32;
 }
 
+/**
+ * @brief 4字节整数key的乘法hash
+ *
+ * @param data 数据
+ * @param dsize 数据大小
+ * @param seed 随机种子
+ */
+static inline u64 int_u32_hash(const void *data, usize dsize, u64 seed)
+{
+    u32 key;
+    memcpy(&key, data, sizeof(u32));
+    u64 hash = ((u64)key ^ seed) * 0x9e3779b97f4a7c15;
+    return hash ^ hash >> 32;
+}
+
+/**
+ * @brief 8字节整数key的乘法hash
+ *
+ * @param data 数据
+ * @param dsize 数据大小
+ * @param seed 随机种子
+ */
+static inline u64 int_u64_hash(const void *data, usize dsize, u64 seed)
+{
+    u64 key;
+    memcpy(&key, data, sizeof(u64));
+    u64 hash = (key ^ seed) * 0x9e3779b97f4a7c15;
+    return hash ^ hash >> 32;
+}
+
+#define SIPROUND(v0, v1, v2, v3)                  \
+    {                                             \
+        v0 += v1;                                 \
+        v1 = (v1 << 13) | (v1 >> 51);             \
+        v1 ^= v0;                                 \
+        v0 = (v0 << 32) | (v0 >> 32);             \
+        v2 += v3;                                 \
+        v3 = (v3 << 16) | (v3 >> 48);             \
+        v3 ^= v2;                                 \
+        v0 += v3;                                 \
+        v3 = (v3 << 21) | (v3 >> 43);             \
+        v3 ^= v0;                                 \
+        v2 += v1;                                 \
+        v1 = (v1 << 17) | (v1 >> 47);             \
+        v1 ^= v2;                                 \
+        v2 = (v2 << 32) | (v2 >> 32);             \
+    }
+
+u64 hashmap_siphash(const void *data, usize dsize, u64 seed)
+{
+    const u8 *p = (const u8 *)data;
+    u64 k0 = seed;
+    u64 k1 = (seed ^ 0x9e3779b97f4a7c15) * 0xbf58476d1ce4e5b9;
+    u64 v0 = k0 ^ 0x736f6d6570736575ull;
+    u64 v1 = k1 ^ 0x646f72616e646f6dull;
+    u64 v2 = k0 ^ 0x6c7967656e657261ull;
+    u64 v3 = k1 ^ 0x7465646279746573ull;
+    u64 m;
+
+    usize nblocks = dsize / 8;
+    for (usize i = 0; i < nblocks; i++, p += 8)
+    {
+        memcpy(&m, p, 8);
+        v3 ^= m;
+        SIPROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    u64 last = (u64)dsize << 56;
+    switch (dsize % 8)
+    {
+    case 7:
+        last |= (u64)p[6] << 48; /* fallthrough */
+    case 6:
+        last |= (u64)p[5] << 40; /* fallthrough */
+    case 5:
+        last |= (u64)p[4] << 32; /* fallthrough */
+    case 4:
+        last |= (u64)p[3] << 24; /* fallthrough */
+    case 3:
+        last |= (u64)p[2] << 16; /* fallthrough */
+    case 2:
+        last |= (u64)p[1] << 8; /* fallthrough */
+    case 1:
+        last |= (u64)p[0];
+    }
+
+    v3 ^= last;
+    SIPROUND(v0, v1, v2, v3);
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+u64 hashmap_random_seed(void)
+{
+    u64 seed = 0;
+#ifndef _WIN32
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd >= 0)
+    {
+        ssize_t n = read(fd, &seed, sizeof(seed));
+        close(fd);
+        if (n == sizeof(seed))
+        {
+            return seed;
+        }
+    }
+#endif
+    // 没有系统随机源时使用时间和地址混合
+    static u64 counter = 0;
+    seed = (u64)time(NULL) ^ (u64)(uintptr_t)&seed ^ (u64)clock() << 32 ^ ++counter;
+    seed ^= seed >> 30;
+    seed *= 0xbf58476d1ce4e5b9;
+    seed ^= seed >> 27;
+    seed *= 0x94d049bb133111eb;
+    return seed ^ seed >> 31;
+}
+
+/**
+ * @brief 根据ksize和传入的hasher cmp确定key类型, 默认hasher和cmp的4/8字节key走整数快速路径
+ *
+ * @param ksize
+ * @param hasher 传入的hash函数, 默认的hash函数会被替换
+ * @param cmp
+ * @return HASHMAP_KEY_*
+ */
+static int _hashmap_key_kind(usize ksize, u64 (**hasher)(const void *, usize, u64), int (*cmp)(const void *, const void *, usize))
+{
+    int kind = HASHMAP_KEY_GENERIC;
+    if (cmp == NULL || cmp == memcmp)
+    {
+        if (ksize == sizeof(u32) && (*hasher == NULL || *hasher == int_u32_hash))
+        {
+            kind = HASHMAP_KEY_U32;
+            *hasher = int_u32_hash;
+        }
+        else if (ksize == sizeof(u64) && (*hasher == NULL || *hasher == int_u64_hash))
+        {
+            kind = HASHMAP_KEY_U64;
+            *hasher = int_u64_hash;
+        }
+    }
+
+    if (*hasher == NULL)
+    {
+        *hasher = fnv_1a_hash;
+    }
+    return kind;
+}
+
 /**
  * @brief 释放指针数组中的指针
  *
@@ -74,22 +245,152 @@ static inline void free_ptrs(void **ptrs, size len)
     }
 }
 
+static void _hashmap_unmap(hashmap *map);
+static void _filter_free(hashmap_filter *filter);
+
+#define ALLOC_BUCKETS      1
+#define ALLOC_KEYS         2
+#define ALLOC_VALUES       4
+#define ALLOC_VALUES_FLAGS 8
+#define MPOL_BIND_MODE       2
+#define MPOL_INTERLEAVE_MODE 3
+
+static inline usize _hashmap_alloc_round(usize bytes)
+{
+    return (bytes + HASHMAP_LARGE_ALLOC - 1) / HASHMAP_LARGE_ALLOC * HASHMAP_LARGE_ALLOC;
+}
+
+/**
+ * @brief 大数组使用mmap匿名页, 可选大页和numa策略, 其余使用malloc
+ *
+ * @param map
+ * @param bytes
+ * @param zero 是否需要清零, 匿名页本身为0
+ * @param mapped 数组为mmap分配时设置bit
+ * @param bit
+ * @return 成功返回指针 失败返回NULL
+ */
+static void *_hashmap_alloc(const hashmap *map, usize bytes, b32 zero, u8 *mapped, u8 bit)
+{
+#ifndef _WIN32
+    if (map->alloc_flags != HASHMAP_ALLOC_MALLOC && bytes >= HASHMAP_LARGE_ALLOC)
+    {
+        usize len = _hashmap_alloc_round(bytes);
+        void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        if (map->alloc_flags & HASHMAP_ALLOC_HUGETLB)
+        {
+            p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+#endif
+        if (p == MAP_FAILED)
+        {
+            p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if (p != MAP_FAILED && (map->alloc_flags & (HASHMAP_ALLOC_HUGEPAGE | HASHMAP_ALLOC_HUGETLB)))
+            {
+                madvise(p, len, MADV_HUGEPAGE);
+            }
+#endif
+        }
+
+        if (p != MAP_FAILED)
+        {
+#if defined(__linux__) && defined(SYS_mbind)
+            // 在第一次访问前设置策略, 失败时保持默认的本地分配
+            if (map->numa_nodes && (map->alloc_flags & (HASHMAP_ALLOC_NUMA_INTERLEAVE | HASHMAP_ALLOC_NUMA_BIND)))
+            {
+                unsigned long nodes = (unsigned long)map->numa_nodes;
+                int mode = (map->alloc_flags & HASHMAP_ALLOC_NUMA_INTERLEAVE) ? MPOL_INTERLEAVE_MODE : MPOL_BIND_MODE;
+                syscall(SYS_mbind, p, len, mode, &nodes, sizeof(nodes) * 8 + 1, 0);
+            }
+#endif
+            *mapped |= bit;
+            return p;
+        }
+    }
+#endif
+    return zero ? calloc(bytes, 1) : malloc(bytes);
+}
+
+static void _hashmap_dealloc(void *p, usize bytes, u8 mapped, u8 bit)
+{
+#ifndef _WIN32
+    if (p && (mapped & bit))
+    {
+        munmap(p, _hashmap_alloc_round(bytes));
+        return;
+    }
+#endif
+    free2(p);
+}
+
+static void _hashmap_free_arrays(
+    const hashmap *map,
+    bucket *buckets,
+    u8 *keys,
+    u8 *values,
+    u8 *values_flags,
+    usize cap,
+    u8 mapped)
+{
+    _hashmap_dealloc(buckets, sizeof(bucket) * cap, mapped, ALLOC_BUCKETS);
+    _hashmap_dealloc(keys, map->kdsize * cap, mapped, ALLOC_KEYS);
+    _hashmap_dealloc(values, map->vdsize * cap, mapped, ALLOC_VALUES);
+    _hashmap_dealloc(values_flags, cap, mapped, ALLOC_VALUES_FLAGS);
+}
+
+/**
+ * @brief 按map->cap分配buckets keys values values_flags
+ *
+ * @param map
+ * @return 成功返回0 失败返回非0, 失败时已分配的数组被释放
+ */
+static int _hashmap_alloc_arrays(hashmap *map)
+{
+    u8 mapped = 0;
+    map->buckets = (bucket *)_hashmap_alloc(map, sizeof(bucket) * map->cap, 1, &mapped, ALLOC_BUCKETS);
+    map->keys = (u8 *)_hashmap_alloc(map, map->kdsize * map->cap, 0, &mapped, ALLOC_KEYS);
+    map->values = (u8 *)_hashmap_alloc(map, map->vdsize * map->cap, 0, &mapped, ALLOC_VALUES);
+    map->values_flags = map->vsize > 0 ? (u8 *)_hashmap_alloc(map, map->cap, 1, &mapped, ALLOC_VALUES_FLAGS) : NULL;
+    if (!map->buckets || !map->keys || !map->values || (map->vsize > 0 && !map->values_flags))
+    {
+        _hashmap_free_arrays(map, map->buckets, map->keys, map->values, map->values_flags, map->cap, mapped);
+        map->buckets = NULL;
+        map->keys = NULL;
+        map->values = NULL;
+        map->values_flags = NULL;
+        map->alloc_mapped = 0;
+        return 1;
+    }
+
+    map->alloc_mapped = mapped;
+    return 0;
+}
+
 void hashmap_free(hashmap *map)
 {
     if (!map)
     {
         return;
     }
-    void *ptrs[7] = {
-        map->buckets,
-        map->keys,
-        map->values,
-        map->values_flags,
+    if (map->mmap_base)
+    {
+        // 数据在映射的文件中
+        _hashmap_unmap(map);
+        map->buckets = NULL;
+        map->keys = NULL;
+        map->values = NULL;
+        map->values_flags = NULL;
+    }
+    _hashmap_free_arrays(map, map->buckets, map->keys, map->values, map->values_flags, map->cap, map->alloc_mapped);
+    _filter_free(map->filter);
+    void *ptrs[3] = {
         map->keys_swap,
         map->values_swap,
         map,
     };
-    free_ptrs(ptrs, 7);
+    free_ptrs(ptrs, 3);
 }
 
 hashmap *hashmap_new_with_cap(
@@ -112,19 +413,36 @@ hashmap *hashmap_new_with_cap(
     *(usize *)&map->ksize = ksize;
     *(usize *)&map->vsize = vsize;
     *(usize *)&map->seed = seed;
-    map->hasher = (hasher) ? hasher : fnv_1a_hash;
+    map->key_kind = _hashmap_key_kind(ksize, &hasher, cmp);
+    map->hasher = hasher;
     map->cmp = (cmp) ? cmp : memcmp;
     map->kfree = NULL;
     map->vfree = NULL;
+    map->mmap_base = NULL;
+    map->mmap_size = 0;
+    map->mmap_readonly = 0;
+    map->reseed_psl = 0;
+    map->on_move = NULL;
+    map->udata = NULL;
+    map->alloc_flags = HASHMAP_ALLOC_MALLOC;
+    map->numa_nodes = 0;
+    map->alloc_mapped = 0;
+    map->keys_swap = NULL;
+    map->values_swap = NULL;
+    map->key_hasher = NULL;
+    map->key_cmp = NULL;
+    map->key_ctx = NULL;
+    map->filter = NULL;
 
     *(usize *)&map->kdsize = ksize ? ksize : PTR_LEN;
     *(usize *)&map->vdsize = vsize ? vsize : PTR_LEN;
-    CMALLOC_CHECK(map->buckets, map->cap, sizeof(bucket), hashmap_free(map));
-    MALLOC_CHECK(map->keys, map->kdsize * map->cap, hashmap_free(map));
-    MALLOC_CHECK(map->values, map->vdsize * map->cap, hashmap_free(map));
-    CMALLOC_CHECK_COND_NULL(map->values_flags, map->cap, sizeof(u8), hashmap_free(map), vsize == 0);
+    if (_hashmap_alloc_arrays(map))
+    {
+        hashmap_free(map);
+        return NULL;
+    }
     MALLOC_CHECK(map->keys_swap, map->kdsize * SWAP_CAP, hashmap_free(map));
-    MALLOC_CHECK(map->values_swap, map->kdsize * SWAP_CAP, hashmap_free(map));
+    MALLOC_CHECK(map->values_swap, map->vdsize * SWAP_CAP, hashmap_free(map));
     return map;
 }
 
@@ -148,6 +466,69 @@ void hashmap_set_vfree(hashmap *map, void (*vfree)(void *value))
     map->vfree = vfree;
 }
 
+hashmap *hashmap_new_keyed(
+    usize cap,
+    usize ksize,
+    usize vsize,
+    int cmp(const void *, const void *, usize))
+{
+    hashmap *map = hashmap_new_with_cap(cap, ksize, vsize, hashmap_random_seed(), hashmap_siphash, cmp);
+    if (map)
+    {
+        hashmap_set_reseed(map, HASHMAP_RESEED_PSL);
+    }
+    return map;
+}
+
+hashmap *hashmap_new_ctx(
+    usize cap,
+    usize ksize,
+    usize vsize,
+    u64 seed,
+    u64 hasher(const void *, void *, u64),
+    int cmp(const void *, const void *, void *),
+    void *ctx)
+{
+    if (ksize == 0 || !hasher || !cmp)
+    {
+        return NULL;
+    }
+
+    hashmap *map = hashmap_new_with_cap(cap, ksize, vsize, seed, NULL, NULL);
+    if (map)
+    {
+        map->key_kind = HASHMAP_KEY_CTX;
+        map->key_hasher = hasher;
+        map->key_cmp = cmp;
+        map->key_ctx = ctx;
+    }
+    return map;
+}
+
+void hashmap_set_reseed(hashmap *map, usize max_psl)
+{
+    map->reseed_psl = max_psl;
+}
+
+int hashmap_set_alloc(hashmap *map, int flags, u64 numa_nodes)
+{
+    if (!map || map->mmap_base)
+    {
+        return 1;
+    }
+
+    map->alloc_flags = flags;
+    map->numa_nodes = numa_nodes;
+    // 按新的方式重新分配, 容量不变
+    return hashmap_resize(map, map->cap);
+}
+
+void hashmap_set_move_hook(hashmap *map, void (*on_move)(hashmap *map, usize index), void *udata)
+{
+    map->on_move = on_move;
+    map->udata = udata;
+}
+
 static inline usize _hashmap_key_size(const hashmap *map)
 {
     return map->kdsize;
@@ -193,6 +574,189 @@ static inline usize hashmap_hash_index(hashmap *map, u64 hash)
     return hash % map->cap;
 }
 
+/**
+ * @brief 元素写入下标index后通知外部, 用于维护与下标对应的附加数据
+ *
+ * @param map
+ * @param index
+ */
+static inline void hashmap_moved(hashmap *map, usize index)
+{
+    if (map->on_move)
+    {
+        map->on_move(map, index);
+    }
+}
+
+static inline usize hashmap_next_index(hashmap *map, usize i)
+{
+    return ++i == map->cap ? 0 : i;
+}
+
+static inline u64 _hashmap_hash(const hashmap *map, const void *key)
+{
+    switch (map->key_kind)
+    {
+    case HASHMAP_KEY_U32:
+        return int_u32_hash(key, sizeof(u32), map->seed);
+    case HASHMAP_KEY_U64:
+        return int_u64_hash(key, sizeof(u64), map->seed);
+    case HASHMAP_KEY_CTX:
+        return map->key_hasher(key, map->key_ctx, map->seed);
+    default:
+        return map->hasher(key, _hashmap_key_size(map), map->seed);
+    }
+}
+
+#define FILTER_BLOCK_WORDS (HASHMAP_FILTER_BLOCK_BITS / 64)
+#define FILTER_ALIGN       64
+#define FILTER_MAX_K       16
+
+static void _filter_free(hashmap_filter *filter)
+{
+    if (filter)
+    {
+        free2(filter->raw);
+        free(filter);
+    }
+}
+
+/**
+ * @brief 创建过滤器
+ *
+ * @param expected 预计的key数量
+ * @param bits_per_key
+ * @param stats
+ * @return 成功返回过滤器 失败返回NULL
+ */
+static hashmap_filter *_filter_new(usize expected, u32 bits_per_key, b32 stats)
+{
+    if (bits_per_key == 0)
+    {
+        return NULL;
+    }
+
+    hashmap_filter *filter;
+    CMALLOC_CHECK(filter, 1, sizeof(hashmap_filter), );
+    usize bits = (expected ? expected : 1) * bits_per_key;
+    filter->nblocks = (bits + HASHMAP_FILTER_BLOCK_BITS - 1) / HASHMAP_FILTER_BLOCK_BITS;
+    filter->bits_per_key = bits_per_key;
+    // 最优位数为bits_per_key * ln2
+    filter->k = (u32)(bits_per_key * 0.69 + 0.5);
+    filter->k = filter->k < 1 ? 1 : (filter->k > FILTER_MAX_K ? FILTER_MAX_K : filter->k);
+    filter->stats = stats;
+
+    usize bytes = filter->nblocks * FILTER_BLOCK_WORDS * sizeof(u64);
+    CMALLOC_CHECK(filter->raw, 1, bytes + FILTER_ALIGN, _filter_free(filter));
+    filter->blocks = (u64 *)(((uintptr_t)filter->raw + FILTER_ALIGN - 1) & ~(uintptr_t)(FILTER_ALIGN - 1));
+    return filter;
+}
+
+/**
+ * @brief 由hash得到块和块内位的参数, 块由高32位决定, 块内位置由低18位决定
+ *
+ * @param filter
+ * @param hash
+ * @param a 第一个位置
+ * @param b 步长, 奇数保证k个位置不同
+ * @return 块的首地址
+ */
+static inline u64 *_filter_block(const hashmap_filter *filter, u64 hash, u32 *a, u32 *b)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccd;
+    hash ^= hash >> 33;
+    *a = (u32)hash & (HASHMAP_FILTER_BLOCK_BITS - 1);
+    *b = ((u32)(hash >> 9) & (HASHMAP_FILTER_BLOCK_BITS - 1)) | 1;
+    usize block = (usize)(((hash >> 32) * (u64)filter->nblocks) >> 32);
+    return filter->blocks + block * FILTER_BLOCK_WORDS;
+}
+
+static inline void _filter_add(hashmap_filter *filter, u64 hash)
+{
+    u32 a, b;
+    u64 *block = _filter_block(filter, hash, &a, &b);
+    for (u32 i = 0; i < filter->k; i++)
+    {
+        u32 bit = (a + i * b) & (HASHMAP_FILTER_BLOCK_BITS - 1);
+        block[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+/**
+ * @brief 判断key是否一定不存在
+ *
+ * @param filter
+ * @param hash
+ * @return 一定不存在返回1 可能存在返回0
+ */
+static inline b32 _filter_reject(hashmap_filter *filter, u64 hash)
+{
+    u32 a, b;
+    const u64 *block = _filter_block(filter, hash, &a, &b);
+    b32 reject = 0;
+    for (u32 i = 0; i < filter->k; i++)
+    {
+        u32 bit = (a + i * b) & (HASHMAP_FILTER_BLOCK_BITS - 1);
+        if (!(block[bit / 64] & (1ULL << (bit % 64))))
+        {
+            reject = 1;
+            break;
+        }
+    }
+
+    if (filter->stats)
+    {
+        __atomic_add_fetch(&filter->queries, 1, __ATOMIC_RELAXED);
+        if (reject)
+        {
+            __atomic_add_fetch(&filter->rejects, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return reject;
+}
+
+/**
+ * @brief 通过过滤器但key不存在时记录误判
+ *
+ * @param filter
+ */
+static inline void _filter_false_positive(hashmap_filter *filter)
+{
+    if (filter->stats)
+    {
+        __atomic_add_fetch(&filter->false_positives, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void _filter_clear(hashmap_filter *filter)
+{
+    memset(filter->blocks, 0, filter->nblocks * FILTER_BLOCK_WORDS * sizeof(u64));
+}
+
+/**
+ * @brief 拷贝key数据, 整数key按寄存器大小拷贝
+ *
+ * @param map
+ * @param kind key类型, 传入常量时编译器可以展开对应分支
+ * @param dst
+ * @param src
+ */
+static inline void _hashmap_copy_key(const hashmap *map, int kind, void *dst, const void *src)
+{
+    switch (kind)
+    {
+    case HASHMAP_KEY_U32:
+        memcpy(dst, src, sizeof(u32));
+        return;
+    case HASHMAP_KEY_U64:
+        memcpy(dst, src, sizeof(u64));
+        return;
+    default:
+        memcpy(dst, src, _hashmap_key_size(map));
+    }
+}
+
 static inline void *hashmap_key(const hashmap *map, usize index)
 {
     if (map->ksize == 0)
@@ -245,42 +809,59 @@ static void hashmap_free_old_kv(
 
 int hashmap_resize(hashmap *map, usize resize)
 {
+    if (map->mmap_readonly)
+    {
+        return 1;
+    }
+
     usize old_len = map->len;
     usize old_cap = map->cap;
     u8 *old_keys = map->keys;
     u8 *old_values = map->values;
     u8 *old_values_flags = map->values_flags;
     bucket *old_buckets = map->buckets;
+    u8 old_mapped = map->alloc_mapped;
 
     map->cap = resize;
-    map->keys = (u8 *)malloc(map->kdsize * map->cap);
-    map->values = (u8 *)malloc(map->vdsize * map->cap);
-    map->values_flags = map->vsize > 0 ? (u8 *)calloc(map->cap, sizeof(u8)) : NULL;
-    map->buckets = (bucket *)calloc(map->cap, sizeof(bucket));
-    if (!map->keys || !map->values || !map->buckets || (map->vsize > 0 && !map->values_flags))
-    {
-        free2(map->keys);
-        free2(map->values);
-        free2(map->values_flags);
-        free2(map->buckets);
+    if (_hashmap_alloc_arrays(map))
+    {
         map->cap = old_cap;
         map->keys = old_keys;
         map->values = old_values;
         map->values_flags = old_values_flags;
         map->buckets = old_buckets;
+        map->alloc_mapped = old_mapped;
         return 1;
     }
 
+    if (map->filter)
+    {
+        // 按新容量重建, 迁移时由hashmap_set重新加入
+        hashmap_filter *filter = _filter_new(map->cap * LOAD_FACTOR, map->filter->bits_per_key, map->filter->stats);
+        if (filter)
+        {
+            filter->queries = map->filter->queries;
+            filter->rejects = map->filter->rejects;
+            filter->false_positives = map->filter->false_positives;
+        }
+        _filter_free(map->filter);
+        map->filter = filter;
+    }
+
     usize i = 0;
+    usize reseed_psl = map->reseed_psl;
     map->len = 0;
     map->resize = (usize)(map->cap * LOAD_FACTOR);
+    map->reseed_psl = 0; // 迁移过程中不触发重新选择seed
     while (map->len < old_len && i < old_cap)
     {
         if (old_buckets[i].psl > 0)
         {
+            u8 *key = mem_get_val(old_keys, _hashmap_key_size(map), i);
+            u8 *value = mem_get_val(old_values, _hashmap_val_size(map), i);
             hashmap_set(map,
-                        mem_get_val(old_keys, _hashmap_key_size(map), i),
-                        mem_get_val(old_values, _hashmap_val_size(map), i));
+                        old_buckets[i].psl == NULL_KEY_PSL ? NULL : (map->ksize == 0 ? *(void **)key : key),
+                        map->vsize == 0 ? *(void **)value : (old_values_flags[i] ? value : NULL));
             if (map->len == map->resize)
             {
                 break;
@@ -288,6 +869,7 @@ int hashmap_resize(hashmap *map, usize resize)
         }
         i += 1;
     }
+    map->reseed_psl = reseed_psl;
 
     hashmap_free_old_kv(
         map,
@@ -298,10 +880,13 @@ int hashmap_resize(hashmap *map, usize resize)
         old_cap,
         old_len,
         old_cap);
-    free2(old_keys);
-    free2(old_values);
-    free2(old_values_flags);
-    free2(old_buckets);
+    if (map->mmap_base)
+    {
+        // 旧数据在映射的文件中, 迁移完成后解除映射
+        _hashmap_unmap(map);
+        return 0;
+    }
+    _hashmap_free_arrays(map, old_buckets, old_keys, old_values, old_values_flags, old_cap, old_mapped);
     return 0;
 }
 
@@ -320,7 +905,7 @@ static void _hashmap_put_null_key(hashmap *map, void *key, usize i)
 static void _hashmap_put_normal_key(hashmap *map, void *key, usize i)
 {
     u8 *ptr = hashmap_key_p(map, i);
-    memcpy(ptr, key, _hashmap_key_size(map));
+    _hashmap_copy_key(map, map->key_kind, ptr, key);
 }
 
 static void _hashmap_put_zero_value(hashmap *map, void *value, usize i)
@@ -365,8 +950,8 @@ static void *_hashmap_put_normal_key_by_swap(hashmap *map, void *key, usize i, u
 {
     u8 *ptr = hashmap_key_p(map, i);
     u8 *swap_k = hashmap_key_swap_p(map, swap_i);
-    memcpy(swap_k, ptr, _hashmap_key_size(map));
-    memcpy(ptr, key, _hashmap_key_size(map));
+    _hashmap_copy_key(map, map->key_kind, swap_k, ptr);
+    _hashmap_copy_key(map, map->key_kind, ptr, key);
     return swap_k;
 }
 
@@ -383,20 +968,23 @@ static void *_hashmap_put_null_value_by_swap(hashmap *map, void *value, usize i,
 {
     u8 *ptr = hashmap_value_p(map, i);
     u8 *swap_v = hashmap_value_swap_p(map, swap_i);
+    u8 flag = hashmap_value_flag(map, i);
     memcpy(swap_v, ptr, _hashmap_val_size(map));
     memset(ptr, 0, _hashmap_val_size(map));
     hashmap_put_value_flag(map, i, 0);
-    return swap_v;
+    // 被置换出的value为NULL时继续以NULL插入
+    return flag ? swap_v : NULL;
 }
 
 static void *_hashmap_put_normal_value_by_swap(hashmap *map, void *value, usize i, usize swap_i)
 {
     u8 *ptr = hashmap_value_p(map, i);
     u8 *swap_v = hashmap_value_swap_p(map, swap_i);
+    u8 flag = hashmap_value_flag(map, i);
     memcpy(swap_v, ptr, _hashmap_val_size(map));
     memcpy(ptr, value, _hashmap_val_size(map));
     hashmap_put_value_flag(map, i, 1);
-    return swap_v;
+    return flag ? swap_v : NULL;
 }
 
 static void _hashmap_put_key(hashmap *map, void *key, usize i)
@@ -467,6 +1055,7 @@ typedef struct
     void *value;
     usize swap_i;
     b32 is_exsit;
+    usize probe; // 查找时探测的长度
 } _hashmap_insert_t;
 
 static void _hashmap_displacement_instert(hashmap *map, _hashmap_insert_t *insert_info)
@@ -484,6 +1073,7 @@ static void _hashmap_displacement_instert(hashmap *map, _hashmap_insert_t *inser
             b->psl = insert_info->psl;
             insert_info->psl = 0;
             map->len++;
+            hashmap_moved(map, insert_info->i);
             return;
         }
 
@@ -494,26 +1084,55 @@ static void _hashmap_displacement_instert(hashmap *map, _hashmap_insert_t *inser
             insert_info->value = _hashmap_put_value_by_swap(map, insert_info->value, insert_info->i, swap_i);
 
             VALUE_SWAP(b->psl, insert_info->psl);
-            insert_info->i = hashmap_hash_index(map, insert_info->i + 1);
+            hashmap_moved(map, insert_info->i);
+            // 被置换出的元素从下一个位置继续探测
+            insert_info->psl++;
+            insert_info->i = hashmap_next_index(map, insert_info->i);
             insert_info->swap_i += 1;
             return;
         }
 
         insert_info->psl++;
-        insert_info->i = hashmap_hash_index(map, insert_info->i + 1);
+        insert_info->i = hashmap_next_index(map, insert_info->i);
     }
 }
 
-/**
- * @brief hashmap中存在相同key则更新val返回-1, 不存在则返回开始插入的位置
- *
- * @param map
+static inline b32 _hashmap_key_eq(hashmap *map, int kind, usize i, const void *key)
+{
+    switch (kind)
+    {
+    case HASHMAP_KEY_U32:
+    {
+        u32 k1, k2;
+        memcpy(&k1, hashmap_key_p(map, i), sizeof(u32));
+        memcpy(&k2, key, sizeof(u32));
+        return k1 == k2;
+    }
+    case HASHMAP_KEY_U64:
+    {
+        u64 k1, k2;
+        memcpy(&k1, hashmap_key_p(map, i), sizeof(u64));
+        memcpy(&k2, key, sizeof(u64));
+        return k1 == k2;
+    }
+    case HASHMAP_KEY_CTX:
+        return map->key_cmp(hashmap_key_p(map, i), key, map->key_ctx) == 0;
+    default:
+        return map->cmp(hashmap_key(map, i), key, _hashmap_key_size(map)) == 0;
+    }
+}
+
+/**
+ * @brief hashmap中存在相同key则更新val返回-1, 不存在则返回开始插入的位置
+ *
+ * @param map
  * @param key
  * @param value
  * @param i hash下标
+ * @param kind key类型, 传入常量时编译器可以展开对应分支
  * @return 开始查找插入位置的下标
  */
-_hashmap_insert_t hashmap_find_insert_index(hashmap *map, void *key, void *value, usize i)
+static inline _hashmap_insert_t _hashmap_find_insert_index(hashmap *map, void *key, void *value, usize i, int kind)
 {
     _hashmap_insert_t insert_info = {
         .psl = key ? PSL : NULL_KEY_PSL,
@@ -522,6 +1141,7 @@ _hashmap_insert_t hashmap_find_insert_index(hashmap *map, void *key, void *value
         .value = value,
         .swap_i = 0,
         .is_exsit = 0,
+        .probe = PSL,
     };
     usize psl = PSL;
 
@@ -548,7 +1168,7 @@ _hashmap_insert_t hashmap_find_insert_index(hashmap *map, void *key, void *value
 
         // b->psl == NULL_KEY_PSL, 即null key, 跳过比较
         psl++;
-        i = hashmap_hash_index(map, i + 1);
+        i = hashmap_next_index(map, i);
     }
 
     while (1)
@@ -563,18 +1183,44 @@ _hashmap_insert_t hashmap_find_insert_index(hashmap *map, void *key, void *value
 
         if (b.psl == 0)
         {
+            insert_info.probe = psl;
             return insert_info;
         }
 
-        if (map->cmp(hashmap_key(map, i), key, _hashmap_key_size(map)) == 0)
+        if (_hashmap_key_eq(map, kind, i, key))
         {
             insert_info.i = i;
             insert_info.is_exsit = 1;
+            insert_info.probe = psl;
             return insert_info;
         }
 
         psl++;
-        i = hashmap_hash_index(map, i + 1);
+        i = hashmap_next_index(map, i);
+    }
+}
+
+/**
+ * @brief 按key类型分派到特化的查找
+ *
+ * @param map
+ * @param key
+ * @param value
+ * @param i hash下标
+ * @return 开始查找插入位置的下标
+ */
+_hashmap_insert_t hashmap_find_insert_index(hashmap *map, void *key, void *value, usize i)
+{
+    switch (map->key_kind)
+    {
+    case HASHMAP_KEY_U32:
+        return _hashmap_find_insert_index(map, key, value, i, HASHMAP_KEY_U32);
+    case HASHMAP_KEY_U64:
+        return _hashmap_find_insert_index(map, key, value, i, HASHMAP_KEY_U64);
+    case HASHMAP_KEY_CTX:
+        return _hashmap_find_insert_index(map, key, value, i, HASHMAP_KEY_CTX);
+    default:
+        return _hashmap_find_insert_index(map, key, value, i, HASHMAP_KEY_GENERIC);
     }
 }
 
@@ -605,14 +1251,42 @@ void hashmap_insert(hashmap *map, void *key, void *value, usize i, usize psl)
     } while (insert_info.psl > 0);
 }
 
+/**
+ * @brief 使用新的随机seed重新hash, 仍然存在过长的探测时放宽阈值, 避免每次插入都重新hash
+ *
+ * @param map
+ * @return 成功返回0 失败返回非0
+ */
+static int _hashmap_reseed(hashmap *map)
+{
+    u64 old_seed = map->seed;
+    *(u64 *)&map->seed = hashmap_random_seed();
+    if (hashmap_resize(map, map->cap))
+    {
+        // 旧数组按旧seed排列, 恢复后仍可查找
+        *(u64 *)&map->seed = old_seed;
+        return 1;
+    }
+
+    for (usize i = 0; i < map->cap; i++)
+    {
+        if (map->buckets[i].psl != NULL_KEY_PSL && map->buckets[i].psl > map->reseed_psl)
+        {
+            map->reseed_psl *= 2;
+            break;
+        }
+    }
+    return 0;
+}
+
 int hashmap_set(hashmap *map, void *key, void *value)
 {
-    if (!map)
+    if (!map || map->mmap_readonly)
     {
         return 1;
     }
 
-    u64 hash = key ? map->hasher(key, _hashmap_key_size(map), map->seed) : NULL_KEY_HASH;
+    u64 hash = key ? _hashmap_hash(map, key) : NULL_KEY_HASH;
     usize hash_index = hashmap_hash_index(map, hash);
     _hashmap_insert_t insert_info = hashmap_find_insert_index(map, key, value, hash_index);
     if (insert_info.is_exsit)
@@ -631,6 +1305,15 @@ int hashmap_set(hashmap *map, void *key, void *value)
         insert_info.psl = key ? PSL : NULL_KEY_PSL;
     }
     hashmap_insert(map, key, value, insert_info.i, insert_info.psl);
+    if (map->filter && key)
+    {
+        _filter_add(map->filter, hash);
+    }
+    if (map->reseed_psl > 0 && insert_info.probe > map->reseed_psl)
+    {
+        // 探测过长, 可能是针对hash的攻击, 更换seed重新hash; 失败时保持原样, 插入已经成功
+        _hashmap_reseed(map);
+    }
     return 0;
 }
 
@@ -641,7 +1324,12 @@ void *hashmap_get(hashmap *map, const void *key)
         return NULL;
     }
 
-    u64 hash = key ? map->hasher(key, _hashmap_key_size(map), map->seed) : NULL_KEY_HASH;
+    u64 hash = key ? _hashmap_hash(map, key) : NULL_KEY_HASH;
+    if (map->filter && key && _filter_reject(map->filter, hash))
+    {
+        return NULL;
+    }
+
     usize hash_index = hashmap_hash_index(map, hash);
     _hashmap_insert_t insert_info = hashmap_find_insert_index(map, (void *)key, NULL, hash_index);
     if (insert_info.is_exsit)
@@ -649,6 +1337,10 @@ void *hashmap_get(hashmap *map, const void *key)
         return hashmap_value(map, insert_info.i);
     }
 
+    if (map->filter && key)
+    {
+        _filter_false_positive(map->filter);
+    }
     return NULL;
 }
 
@@ -666,6 +1358,76 @@ void *hashmap_get_clone(hashmap *map, const void *key)
     return ret_val;
 }
 
+/**
+ * @brief 从hash下标开始查找key, 不存在则插入值全为0的value
+ *
+ * @param map
+ * @param key
+ * @param hash_index
+ * @param inserted
+ * @return 返回value所在位置, 失败返回NULL
+ */
+static void *_hashmap_entry_at(hashmap *map, void *key, usize hash_index, b32 *inserted)
+{
+    _hashmap_insert_t insert_info = hashmap_find_insert_index(map, key, NULL, hash_index);
+    if (inserted)
+    {
+        *inserted = !insert_info.is_exsit;
+    }
+
+    if (!insert_info.is_exsit)
+    {
+        // 没有扩容和重新hash时, 新元素就在查找到的插入位置
+        b32 moved = 0;
+        if (map->len == map->resize)
+        {
+            if (hashmap_resize(map, map->cap * RESIZE_ZOOM))
+            {
+                return NULL;
+            }
+            insert_info.i = hashmap_hash_index(map, key ? _hashmap_hash(map, key) : NULL_KEY_HASH);
+            insert_info.psl = key ? PSL : NULL_KEY_PSL;
+            moved = 1;
+        }
+        hashmap_insert(map, key, NULL, insert_info.i, insert_info.psl);
+        if (map->filter && key)
+        {
+            _filter_add(map->filter, _hashmap_hash(map, key));
+        }
+        if (map->reseed_psl > 0 && insert_info.probe > map->reseed_psl)
+        {
+            // 失败时保持原样, 插入已经成功
+            if (_hashmap_reseed(map) == 0)
+            {
+                moved = 1;
+            }
+        }
+
+        if (moved)
+        {
+            u64 hash = key ? _hashmap_hash(map, key) : NULL_KEY_HASH;
+            insert_info = hashmap_find_insert_index(map, key, NULL, hashmap_hash_index(map, hash));
+        }
+    }
+
+    if (map->vsize > 0)
+    {
+        hashmap_put_value_flag(map, insert_info.i, 1);
+    }
+    return hashmap_value_p(map, insert_info.i);
+}
+
+void *hashmap_entry(hashmap *map, void *key, b32 *inserted)
+{
+    if (!map || map->mmap_readonly)
+    {
+        return NULL;
+    }
+
+    u64 hash = key ? _hashmap_hash(map, key) : NULL_KEY_HASH;
+    return _hashmap_entry_at(map, key, hashmap_hash_index(map, hash), inserted);
+}
+
 b32 hashmap_exist(hashmap *map, const void *key)
 {
     if (!map || map->len == 0)
@@ -673,7 +1435,12 @@ b32 hashmap_exist(hashmap *map, const void *key)
         return 0;
     }
 
-    u64 hash = key ? map->hasher(key, _hashmap_key_size(map), map->seed) : NULL_KEY_HASH;
+    u64 hash = key ? _hashmap_hash(map, key) : NULL_KEY_HASH;
+    if (map->filter && key && _filter_reject(map->filter, hash))
+    {
+        return 0;
+    }
+
     usize hash_index = hashmap_hash_index(map, hash);
     _hashmap_insert_t insert_info = hashmap_find_insert_index(map, (void *)key, NULL, hash_index);
     if (insert_info.is_exsit)
@@ -681,6 +1448,10 @@ b32 hashmap_exist(hashmap *map, const void *key)
         return 1;
     }
 
+    if (map->filter && key)
+    {
+        _filter_false_positive(map->filter);
+    }
     return 0;
 }
 
@@ -711,7 +1482,7 @@ static void hashmap_remove_i(hashmap *map, usize i)
     {
         i = (i + 1) % map->cap;
         b = &map->buckets[i];
-        if (b->psl <= 1)
+        if (b->psl <= 1 || b->psl == NULL_KEY_PSL)
         {
             // 标记删除
             pre_b->psl = 0;
@@ -719,21 +1490,75 @@ static void hashmap_remove_i(hashmap *map, usize i)
         }
         cur_k = hashmap_key_p(map, i);
         cur_v = hashmap_value_p(map, i);
-        memcpy(pre_k, cur_k, _hashmap_key_size(map));
+        _hashmap_copy_key(map, map->key_kind, pre_k, cur_k);
         memcpy(pre_v, cur_v, _hashmap_val_size(map));
+        if (map->vsize > 0)
+        {
+            hashmap_put_value_flag(map, pre_b - map->buckets, hashmap_value_flag(map, i));
+        }
         pre_k = cur_k;
         pre_v = cur_v;
 
         pre_b->psl = b->psl - 1;
+        hashmap_moved(map, pre_b - map->buckets);
         pre_b = b;
     };
 
     map->len--;
 }
 
+size hashmap_index_of(hashmap *map, const void *key)
+{
+    if (!map || map->len == 0)
+    {
+        return -1;
+    }
+
+    u64 hash = key ? _hashmap_hash(map, key) : NULL_KEY_HASH;
+    if (map->filter && key && _filter_reject(map->filter, hash))
+    {
+        return -1;
+    }
+
+    usize hash_index = hashmap_hash_index(map, hash);
+    _hashmap_insert_t insert_info = hashmap_find_insert_index(map, (void *)key, NULL, hash_index);
+    return insert_info.is_exsit ? (size)insert_info.i : -1;
+}
+
+void *hashmap_key_at(hashmap *map, usize index)
+{
+    if (!map || index >= map->cap || map->buckets[index].psl == 0)
+    {
+        return NULL;
+    }
+
+    return map->buckets[index].psl == NULL_KEY_PSL ? NULL : hashmap_key(map, index);
+}
+
+void *hashmap_value_at(hashmap *map, usize index)
+{
+    if (!map || index >= map->cap || map->buckets[index].psl == 0)
+    {
+        return NULL;
+    }
+
+    return hashmap_value(map, index);
+}
+
+int hashmap_remove_at(hashmap *map, usize index)
+{
+    if (!map || map->mmap_readonly || index >= map->cap || map->buckets[index].psl == 0)
+    {
+        return 1;
+    }
+
+    hashmap_remove_i(map, index);
+    return 0;
+}
+
 int hashmap_remove(hashmap *map, const void *key)
 {
-    if (!map)
+    if (!map || map->mmap_readonly)
     {
         return 1;
     }
@@ -743,7 +1568,7 @@ int hashmap_remove(hashmap *map, const void *key)
         return 0;
     }
 
-    u64 hash = key ? map->hasher(key, _hashmap_key_size(map), map->seed) : NULL_KEY_HASH;
+    u64 hash = key ? _hashmap_hash(map, key) : NULL_KEY_HASH;
     usize hash_index = hashmap_hash_index(map, hash);
 
     _hashmap_insert_t insert_info = hashmap_find_insert_index(map, (void *)key, NULL, hash_index);
@@ -756,19 +1581,9 @@ int hashmap_remove(hashmap *map, const void *key)
     return 0;
 }
 
-size hashmap_count(hashmap *map)
-{
-    if (!map)
-    {
-        return 0;
-    }
-
-    return map->len;
-}
-
 int hashmap_clear(hashmap *map)
 {
-    if (!map)
+    if (!map || map->mmap_readonly)
     {
         return 1;
     }
@@ -784,6 +1599,10 @@ int hashmap_clear(hashmap *map)
             hashmap_free_kv(map, i);
         }
     }
+    if (map->filter)
+    {
+        _filter_clear(map->filter);
+    }
     assert(map->len == 0 && "hashmap_clear error");
     return 0;
 }
@@ -810,6 +1629,29 @@ int hashmap_update(hashmap *dst, hashmap *src)
     return 0;
 }
 
+/**
+ * @brief 复制key的hash和比较方式、内存分配方式、过滤器和重新hash的阈值, 不复制元素
+ *
+ * @param dst
+ * @param src
+ */
+static void _hashmap_copy_config(hashmap *dst, const hashmap *src)
+{
+    dst->key_kind = src->key_kind;
+    dst->key_hasher = src->key_hasher;
+    dst->key_cmp = src->key_cmp;
+    dst->key_ctx = src->key_ctx;
+    dst->reseed_psl = src->reseed_psl;
+    if (src->alloc_flags != HASHMAP_ALLOC_MALLOC)
+    {
+        hashmap_set_alloc(dst, src->alloc_flags, src->numa_nodes);
+    }
+    if (src->filter)
+    {
+        hashmap_filter_enable(dst, src->filter->bits_per_key, src->filter->stats);
+    }
+}
+
 hashmap *hashmap_clone(hashmap *map)
 {
     if (!map)
@@ -824,16 +1666,16 @@ hashmap *hashmap_clone(hashmap *map)
         map->seed,
         map->hasher,
         map->cmp);
+    if (!new_map)
+    {
+        return NULL;
+    }
 
+    _hashmap_copy_config(new_map, map);
     hashmap_update(new_map, map);
     return new_map;
 }
 
-inline b32 hashmap_empty(hashmap *map)
-{
-    return map->len == 0;
-}
-
 hashmap_iterator hashmap_begin(hashmap *map)
 {
     hashmap_iterator iter = {
@@ -950,4 +1792,1208 @@ hashmap_iterator_kv hashmap_iter_kv(hashmap_iterator *iter)
     } while (!hashmap_iter_is_end(iter));
 
     return kv;
-}
\ No newline at end of file
+}
+
+size hashmap_for_each_range(hashmap *map, usize begin, usize end, void (*fn)(void *key, void *value, void *ctx), void *ctx)
+{
+    if (!map || !fn)
+    {
+        return 0;
+    }
+
+    end = end < map->cap ? end : map->cap;
+    size n = 0;
+    for (usize i = begin; i < end; i++)
+    {
+        if (map->buckets[i].psl > 0)
+        {
+            fn(hashmap_key(map, i), hashmap_value(map, i), ctx);
+            n++;
+        }
+    }
+    return n;
+}
+
+// ============================================================================
+//  hashmap_frozen
+// ============================================================================
+
+#define FROZEN_BUCKET_KEYS 5    // 平均每个桶的key数量, pilot为u16时约3.2 bits/key
+#define FROZEN_LOAD_FACTOR 0.99 // 位置空间略大于key数量, 多出的位置通过remap映射回[0, len)
+#define FROZEN_MAX_PILOT   UINT16_MAX
+#define FROZEN_MAX_SALT    8
+#define FROZEN_MAGIC       0x5a4f5246504d4843ull // "CHMPFROZ"
+#define FROZEN_VERSION     2
+
+static inline u64 mix64(u64 x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    x ^= x >> 31;
+    return x;
+}
+
+static inline usize _hashmap_frozen_bucket(const hashmap_frozen *frozen, u64 hash)
+{
+    return mix64(hash ^ frozen->salt) % frozen->nbuckets;
+}
+
+static inline usize _hashmap_frozen_position(const hashmap_frozen *frozen, u64 hash, u16 pilot)
+{
+    return mix64(hash ^ frozen->salt ^ mix64((u64)pilot + 0x9e3779b97f4a7c15)) % frozen->slots;
+}
+
+static inline usize _hashmap_frozen_index(const hashmap_frozen *frozen, u64 hash)
+{
+    usize p = _hashmap_frozen_position(frozen, hash, frozen->pilots[_hashmap_frozen_bucket(frozen, hash)]);
+    return p < frozen->len ? p : frozen->remap[p - frozen->len];
+}
+
+static inline void *hashmap_frozen_key_p(const hashmap_frozen *frozen, usize index)
+{
+    return frozen->keys + (frozen->kdsize * index);
+}
+
+static inline void *hashmap_frozen_key(const hashmap_frozen *frozen, usize index)
+{
+    if (frozen->ksize == 0)
+    {
+        return (void *)(*(uintptr_t *)hashmap_frozen_key_p(frozen, index));
+    }
+
+    return hashmap_frozen_key_p(frozen, index);
+}
+
+static inline void *hashmap_frozen_value_of(const hashmap_frozen *frozen, u8 *ptr, u8 flag)
+{
+    if (frozen->vsize == 0)
+    {
+        return (void *)(*(uintptr_t *)ptr);
+    }
+
+    return flag ? ptr : NULL;
+}
+
+void hashmap_frozen_free(hashmap_frozen *frozen)
+{
+    if (!frozen)
+    {
+        return;
+    }
+    _filter_free(frozen->filter);
+    void *ptrs[7] = {
+        frozen->keys,
+        frozen->values,
+        frozen->values_flags,
+        frozen->pilots,
+        frozen->remap,
+        frozen->null_value,
+        frozen,
+    };
+    free_ptrs(ptrs, 7);
+}
+
+static hashmap_frozen *_hashmap_frozen_alloc(
+    usize len, usize ksize, usize vsize, u64 seed,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    hashmap_frozen *frozen;
+    CMALLOC_CHECK(frozen, 1, sizeof(hashmap_frozen), );
+
+    frozen->len = len;
+    frozen->nbuckets = len / FROZEN_BUCKET_KEYS + 1;
+    frozen->slots = (usize)(len / FROZEN_LOAD_FACTOR) + 1;
+    *(usize *)&frozen->ksize = ksize;
+    *(usize *)&frozen->vsize = vsize;
+    *(usize *)&frozen->kdsize = ksize ? ksize : PTR_LEN;
+    *(usize *)&frozen->vdsize = vsize ? vsize : PTR_LEN;
+    *(u64 *)&frozen->seed = seed;
+    _hashmap_key_kind(ksize, &hasher, cmp);
+    frozen->hasher = hasher;
+    frozen->cmp = (cmp) ? cmp : memcmp;
+
+    MALLOC_CHECK(frozen->keys, frozen->kdsize * len + 1, hashmap_frozen_free(frozen));
+    MALLOC_CHECK(frozen->values, frozen->vdsize * len + 1, hashmap_frozen_free(frozen));
+    CMALLOC_CHECK_COND_NULL(frozen->values_flags, len + 1, sizeof(u8), hashmap_frozen_free(frozen), vsize == 0);
+    CMALLOC_CHECK(frozen->pilots, frozen->nbuckets, sizeof(u16), hashmap_frozen_free(frozen));
+    CMALLOC_CHECK(frozen->remap, frozen->slots - len, sizeof(u32), hashmap_frozen_free(frozen));
+    CMALLOC_CHECK(frozen->null_value, 1, frozen->vdsize, hashmap_frozen_free(frozen));
+    return frozen;
+}
+
+/**
+ * @brief 为每个桶寻找pilot, 使桶内所有key落到互不冲突的空闲位置, 大桶优先
+ *
+ * @param frozen
+ * @param hashes 每个key的hash
+ * @param positions 输出每个key的位置
+ * @return 成功返回0 失败返回非0
+ */
+static int _hashmap_frozen_search_pilots(hashmap_frozen *frozen, const u64 *hashes, usize *positions)
+{
+    usize n = frozen->len;
+    usize nbuckets = frozen->nbuckets;
+    int ret = 1;
+
+    usize *starts = (usize *)calloc(nbuckets + 1, sizeof(usize));
+    usize *order = (usize *)malloc(sizeof(usize) * (n + 1));
+    usize *buckets = (usize *)malloc(sizeof(usize) * nbuckets);
+    u8 *taken = (u8 *)calloc(frozen->slots, sizeof(u8));
+    usize max_bsize = 0;
+    if (!starts || !order || !buckets || !taken)
+    {
+        goto end;
+    }
+
+    // 按桶计数排序key
+    for (usize k = 0; k < n; k++)
+    {
+        starts[_hashmap_frozen_bucket(frozen, hashes[k]) + 1]++;
+    }
+    for (usize b = 0; b < nbuckets; b++)
+    {
+        if (starts[b + 1] > max_bsize)
+        {
+            max_bsize = starts[b + 1];
+        }
+        starts[b + 1] += starts[b];
+    }
+    for (usize k = 0; k < n; k++)
+    {
+        usize b = _hashmap_frozen_bucket(frozen, hashes[k]);
+        order[starts[b] + positions[k]] = k; // positions暂存桶内偏移
+    }
+
+    // 按桶大小从大到小处理
+    usize nb = 0;
+    for (usize s = max_bsize; s > 0; s--)
+    {
+        for (usize b = 0; b < nbuckets; b++)
+        {
+            if (starts[b + 1] - starts[b] == s)
+            {
+                buckets[nb++] = b;
+            }
+        }
+    }
+
+    for (usize bi = 0; bi < nb; bi++)
+    {
+        usize b = buckets[bi];
+        usize begin = starts[b], end = starts[b + 1];
+        u32 pilot = 0;
+        for (; pilot <= FROZEN_MAX_PILOT; pilot++)
+        {
+            usize j = begin;
+            for (; j < end; j++)
+            {
+                usize k = order[j];
+                usize p = _hashmap_frozen_position(frozen, hashes[k], (u16)pilot);
+                if (taken[p])
+                {
+                    break;
+                }
+                taken[p] = 1;
+                positions[k] = p;
+            }
+
+            if (j == end)
+            {
+                break;
+            }
+
+            // 回滚本次尝试
+            while (j-- > begin)
+            {
+                taken[positions[order[j]]] = 0;
+            }
+        }
+
+        if (pilot > FROZEN_MAX_PILOT)
+        {
+            goto end;
+        }
+        frozen->pilots[b] = (u16)pilot;
+    }
+
+    // [len, slots)中被占用的位置映射到[0, len)的空闲位置
+    usize free_p = 0;
+    for (usize p = n; p < frozen->slots; p++)
+    {
+        if (taken[p])
+        {
+            while (taken[free_p])
+            {
+                free_p++;
+            }
+            frozen->remap[p - n] = (u32)free_p++;
+        }
+    }
+    ret = 0;
+
+end:
+    free2(starts);
+    free2(order);
+    free2(buckets);
+    free2(taken);
+    return ret;
+}
+
+static int _hashmap_frozen_build(hashmap_frozen *frozen, const u64 *hashes, usize *positions)
+{
+    usize nbuckets = frozen->nbuckets;
+    usize *fill = (usize *)calloc(nbuckets, sizeof(usize));
+    if (!fill)
+    {
+        return 1;
+    }
+
+    for (usize k = 0; k < frozen->len; k++)
+    {
+        positions[k] = fill[_hashmap_frozen_bucket(frozen, hashes[k])]++;
+    }
+    free(fill);
+
+    memset(frozen->pilots, 0, nbuckets * sizeof(u16));
+    return _hashmap_frozen_search_pilots(frozen, hashes, positions);
+}
+
+hashmap_frozen *hashmap_freeze(hashmap *map)
+{
+    if (!map || map->key_kind == HASHMAP_KEY_CTX)
+    {
+        return NULL;
+    }
+
+    usize null_i = SIZE_MAX;
+    usize n = map->len;
+    for (usize i = 0, l = 0; i < map->cap && l < map->len; i++)
+    {
+        if (map->buckets[i].psl == NULL_KEY_PSL)
+        {
+            null_i = i;
+            n--;
+            break;
+        }
+        l += map->buckets[i].psl > 0;
+    }
+
+    if (n > UINT32_MAX)
+    {
+        return NULL;
+    }
+
+    hashmap_frozen *frozen = _hashmap_frozen_alloc(n, map->ksize, map->vsize, map->seed, map->hasher, map->cmp);
+    if (!frozen)
+    {
+        return NULL;
+    }
+
+    u64 *hashes = (u64 *)malloc(sizeof(u64) * (n + 1));
+    usize *slots = (usize *)malloc(sizeof(usize) * (n + 1));
+    usize *positions = (usize *)malloc(sizeof(usize) * (n + 1));
+    if (!hashes || !slots || !positions)
+    {
+        goto fail;
+    }
+
+    for (usize i = 0, k = 0; i < map->cap && k < n; i++)
+    {
+        if (map->buckets[i].psl > 0 && i != null_i)
+        {
+            slots[k] = i;
+            hashes[k] = _hashmap_hash(map, hashmap_key(map, i));
+            k++;
+        }
+    }
+
+    int built = 1;
+    for (u64 attempt = 0; attempt < FROZEN_MAX_SALT && built; attempt++)
+    {
+        frozen->salt = mix64(map->seed + attempt);
+        built = _hashmap_frozen_build(frozen, hashes, positions);
+    }
+    if (built)
+    {
+        goto fail;
+    }
+
+    for (usize k = 0; k < n; k++)
+    {
+        usize p = positions[k] < n ? positions[k] : frozen->remap[positions[k] - n];
+        memcpy(hashmap_frozen_key_p(frozen, p), hashmap_key_p(map, slots[k]), frozen->kdsize);
+        memcpy(frozen->values + (frozen->vdsize * p), hashmap_value_p(map, slots[k]), frozen->vdsize);
+        if (map->vsize > 0)
+        {
+            frozen->values_flags[p] = hashmap_value_flag(map, slots[k]);
+        }
+    }
+
+    if (null_i != SIZE_MAX)
+    {
+        frozen->has_null_key = 1;
+        memcpy(frozen->null_value, hashmap_value_p(map, null_i), frozen->vdsize);
+        frozen->null_value_flag = map->vsize > 0 ? hashmap_value_flag(map, null_i) : 1;
+    }
+
+    free(hashes);
+    free(slots);
+    free(positions);
+    if (map->filter)
+    {
+        hashmap_frozen_filter_enable(frozen, map->filter->bits_per_key, map->filter->stats);
+    }
+    return frozen;
+
+fail:
+    free2(hashes);
+    free2(slots);
+    free2(positions);
+    hashmap_frozen_free(frozen);
+    return NULL;
+}
+
+static b32 _hashmap_frozen_find(hashmap_frozen *frozen, const void *key, usize *index)
+{
+    if (frozen->len == 0)
+    {
+        return 0;
+    }
+
+    u64 hash = frozen->hasher(key, frozen->kdsize, frozen->seed);
+    if (frozen->filter && _filter_reject(frozen->filter, hash))
+    {
+        return 0;
+    }
+
+    usize i = _hashmap_frozen_index(frozen, hash);
+    if (frozen->cmp(hashmap_frozen_key(frozen, i), key, frozen->kdsize) != 0)
+    {
+        if (frozen->filter)
+        {
+            _filter_false_positive(frozen->filter);
+        }
+        return 0;
+    }
+
+    *index = i;
+    return 1;
+}
+
+void *hashmap_frozen_get(hashmap_frozen *frozen, const void *key)
+{
+    if (!frozen)
+    {
+        return NULL;
+    }
+
+    if (!key)
+    {
+        return frozen->has_null_key ? hashmap_frozen_value_of(frozen, frozen->null_value, frozen->null_value_flag) : NULL;
+    }
+
+    usize i;
+    if (!_hashmap_frozen_find(frozen, key, &i))
+    {
+        return NULL;
+    }
+
+    return hashmap_frozen_value_of(
+        frozen,
+        frozen->values + (frozen->vdsize * i),
+        frozen->vsize > 0 ? frozen->values_flags[i] : 1);
+}
+
+b32 hashmap_frozen_exist(hashmap_frozen *frozen, const void *key)
+{
+    if (!frozen)
+    {
+        return 0;
+    }
+
+    if (!key)
+    {
+        return frozen->has_null_key;
+    }
+
+    usize i;
+    return _hashmap_frozen_find(frozen, key, &i);
+}
+
+size hashmap_frozen_count(hashmap_frozen *frozen)
+{
+    if (!frozen)
+    {
+        return 0;
+    }
+
+    return frozen->len + (frozen->has_null_key ? 1 : 0);
+}
+
+/**
+ * @brief 计算hasher在固定输入和seed下的输出, 用于确认打开快照时使用的是同一个hasher和seed
+ *
+ * @param hasher
+ * @param ksize
+ * @param seed
+ * @return u64
+ */
+static u64 _snapshot_fingerprint(u64 hasher(const void *, usize, u64), usize ksize, u64 seed)
+{
+    u8 probe[256] = {0};
+    u8 *key = ksize <= sizeof(probe) ? probe : (u8 *)malloc(ksize);
+    if (!key)
+    {
+        return 0;
+    }
+
+    for (usize i = 0; i < ksize; i++)
+    {
+        key[i] = (u8)(i * 0x9d + 1);
+    }
+    u64 fingerprint = hasher(key, ksize, seed);
+    if (key != probe)
+    {
+        free(key);
+    }
+    return fingerprint;
+}
+
+typedef struct
+{
+    u64 magic;
+    u64 version;
+    u64 ksize;
+    u64 vsize;
+    u64 len;
+    u64 nbuckets;
+    u64 slots;
+    u64 salt;
+    u64 seed;
+    u64 has_null_key;
+    u64 null_value_flag;
+    u64 fingerprint;
+} _hashmap_frozen_file_header;
+
+int hashmap_frozen_save(hashmap_frozen *frozen, const char *path)
+{
+    if (!frozen || !path || frozen->ksize == 0 || frozen->vsize == 0)
+    {
+        return 1;
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+    {
+        return 1;
+    }
+
+    _hashmap_frozen_file_header h = {
+        .magic = FROZEN_MAGIC,
+        .version = FROZEN_VERSION,
+        .ksize = frozen->ksize,
+        .vsize = frozen->vsize,
+        .len = frozen->len,
+        .nbuckets = frozen->nbuckets,
+        .slots = frozen->slots,
+        .salt = frozen->salt,
+        .seed = frozen->seed,
+        .has_null_key = (u64)frozen->has_null_key,
+        .null_value_flag = frozen->null_value_flag,
+        .fingerprint = _snapshot_fingerprint(frozen->hasher, frozen->kdsize, frozen->seed),
+    };
+
+    usize n = frozen->len;
+    int ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+             fwrite(frozen->pilots, sizeof(u16), frozen->nbuckets, fp) == frozen->nbuckets &&
+             fwrite(frozen->remap, sizeof(u32), frozen->slots - n, fp) == frozen->slots - n &&
+             fwrite(frozen->keys, frozen->kdsize, n, fp) == n &&
+             fwrite(frozen->values, frozen->vdsize, n, fp) == n &&
+             fwrite(frozen->values_flags, sizeof(u8), n, fp) == n &&
+             fwrite(frozen->null_value, frozen->vdsize, 1, fp) == 1;
+
+    return (fclose(fp) != 0 || !ok) ? 1 : 0;
+}
+
+hashmap_frozen *hashmap_frozen_load(
+    const char *path,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    if (!path)
+    {
+        return NULL;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+    {
+        return NULL;
+    }
+
+    _hashmap_frozen_file_header h;
+    hashmap_frozen *frozen = NULL;
+    long file_size = -1;
+    if (fread(&h, sizeof(h), 1, fp) != 1 ||
+        h.magic != FROZEN_MAGIC ||
+        h.version != FROZEN_VERSION ||
+        h.ksize == 0 || h.vsize == 0 ||
+        h.len > UINT32_MAX ||
+        fseek(fp, 0, SEEK_END) != 0 ||
+        (file_size = ftell(fp)) < 0 ||
+        fseek(fp, sizeof(h), SEEK_SET) != 0)
+    {
+        goto fail;
+    }
+
+    // 文件内容不可信, 按文件大小限制ksize, vsize和len, 分配大小的乘法不会溢出
+    u64 fsize = (u64)file_size;
+    if (h.ksize > fsize || h.vsize > fsize || h.len > fsize / (h.ksize + h.vsize + 1))
+    {
+        goto fail;
+    }
+
+    frozen = _hashmap_frozen_alloc(h.len, h.ksize, h.vsize, h.seed, hasher, cmp);
+    if (!frozen || frozen->nbuckets != h.nbuckets || frozen->slots != h.slots ||
+        _snapshot_fingerprint(frozen->hasher, frozen->kdsize, frozen->seed) != h.fingerprint)
+    {
+        goto fail;
+    }
+    frozen->salt = h.salt;
+    frozen->has_null_key = (b32)h.has_null_key;
+    frozen->null_value_flag = (u8)h.null_value_flag;
+
+    usize n = frozen->len;
+    if (fread(frozen->pilots, sizeof(u16), frozen->nbuckets, fp) != frozen->nbuckets ||
+        fread(frozen->remap, sizeof(u32), frozen->slots - n, fp) != frozen->slots - n ||
+        fread(frozen->keys, frozen->kdsize, n, fp) != n ||
+        fread(frozen->values, frozen->vdsize, n, fp) != n ||
+        fread(frozen->values_flags, sizeof(u8), n, fp) != n ||
+        fread(frozen->null_value, frozen->vdsize, 1, fp) != 1)
+    {
+        goto fail;
+    }
+
+    // 多出的位置必须映射回[0, len), 否则查找时越界
+    for (usize i = 0; n > 0 && i < frozen->slots - n; i++)
+    {
+        if (frozen->remap[i] >= n)
+        {
+            goto fail;
+        }
+    }
+
+    fclose(fp);
+    return frozen;
+
+fail:
+    fclose(fp);
+    hashmap_frozen_free(frozen);
+    return NULL;
+}
+
+
+// ============================================================================
+//  hashmap_filter
+// ============================================================================
+
+int hashmap_filter_enable(hashmap *map, u32 bits_per_key, b32 stats)
+{
+    if (!map)
+    {
+        return 1;
+    }
+
+    hashmap_filter *filter = _filter_new(map->resize, bits_per_key, stats);
+    if (!filter)
+    {
+        return 1;
+    }
+
+    _filter_free(map->filter);
+    map->filter = filter;
+    return hashmap_filter_rebuild(map);
+}
+
+void hashmap_filter_disable(hashmap *map)
+{
+    if (map)
+    {
+        _filter_free(map->filter);
+        map->filter = NULL;
+    }
+}
+
+int hashmap_filter_rebuild(hashmap *map)
+{
+    if (!map || !map->filter)
+    {
+        return 1;
+    }
+
+    _filter_clear(map->filter);
+    for (usize i = 0; i < map->cap; i++)
+    {
+        usize psl = map->buckets[i].psl;
+        if (psl > 0 && psl != NULL_KEY_PSL)
+        {
+            _filter_add(map->filter, _hashmap_hash(map, hashmap_key(map, i)));
+        }
+    }
+    return 0;
+}
+
+int hashmap_frozen_filter_enable(hashmap_frozen *frozen, u32 bits_per_key, b32 stats)
+{
+    if (!frozen)
+    {
+        return 1;
+    }
+
+    hashmap_filter *filter = _filter_new(frozen->len, bits_per_key, stats);
+    if (!filter)
+    {
+        return 1;
+    }
+
+    for (usize i = 0; i < frozen->len; i++)
+    {
+        _filter_add(filter, frozen->hasher(hashmap_frozen_key(frozen, i), frozen->kdsize, frozen->seed));
+    }
+    _filter_free(frozen->filter);
+    frozen->filter = filter;
+    return 0;
+}
+
+hashmap_filter_stats hashmap_filter_get_stats(const hashmap_filter *filter)
+{
+    hashmap_filter_stats stats = {0};
+    if (!filter)
+    {
+        return stats;
+    }
+
+    stats.queries = __atomic_load_n(&filter->queries, __ATOMIC_RELAXED);
+    stats.rejects = __atomic_load_n(&filter->rejects, __ATOMIC_RELAXED);
+    stats.false_positives = __atomic_load_n(&filter->false_positives, __ATOMIC_RELAXED);
+    u64 negatives = stats.rejects + stats.false_positives;
+    stats.fpr = negatives ? (double)stats.false_positives / negatives : 0;
+    stats.bytes = filter->nblocks * FILTER_BLOCK_WORDS * sizeof(u64);
+    return stats;
+}
+
+// ============================================================================
+//  hashmap计数器
+// ============================================================================
+
+typedef struct
+{
+    i64 count;
+    usize index;
+} _counter_item;
+
+static inline i64 _counter_value(const hashmap *counter, usize index)
+{
+    i64 count;
+    memcpy(&count, hashmap_value_p(counter, index), sizeof(i64));
+    return count;
+}
+
+hashmap *hashmap_counter_new(
+    usize cap,
+    usize ksize,
+    u64 seed,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    return hashmap_new_with_cap(cap, ksize, sizeof(i64), seed, hasher, cmp);
+}
+
+hashmap *hashmap_counter_like(hashmap *counter)
+{
+    if (!counter)
+    {
+        return NULL;
+    }
+
+    hashmap *map = hashmap_new_with_cap(counter->cap, counter->ksize, sizeof(i64), counter->seed, counter->hasher, counter->cmp);
+    if (map)
+    {
+        _hashmap_copy_config(map, counter);
+    }
+    return map;
+}
+
+int hashmap_counter_add(hashmap *counter, void *key, i64 delta)
+{
+    u8 *value = (u8 *)hashmap_entry(counter, key, NULL);
+    if (!value)
+    {
+        return 1;
+    }
+
+    i64 count;
+    memcpy(&count, value, sizeof(i64));
+    count += delta;
+    memcpy(value, &count, sizeof(i64));
+    return 0;
+}
+
+i64 hashmap_counter_get(hashmap *counter, const void *key)
+{
+    i64 count = 0;
+    void *value = hashmap_get(counter, key);
+    if (value)
+    {
+        memcpy(&count, value, sizeof(i64));
+    }
+    return count;
+}
+
+static inline b32 _hashmap_same_shape(const hashmap *dst, const hashmap *src)
+{
+    return dst->cap == src->cap && dst->seed == src->seed && dst->hasher == src->hasher &&
+           dst->key_kind == src->key_kind;
+}
+
+int hashmap_counter_merge(hashmap *dst, hashmap *src)
+{
+    if (!dst || !src || dst->mmap_readonly || dst->ksize != src->ksize ||
+        dst->vsize != sizeof(i64) || src->vsize != sizeof(i64))
+    {
+        return 1;
+    }
+
+    for (usize i = 0; i < src->cap; i++)
+    {
+        usize psl = src->buckets[i].psl;
+        if (psl == 0)
+        {
+            continue;
+        }
+
+        void *key = psl == NULL_KEY_PSL ? NULL : hashmap_key(src, i);
+        u8 *value;
+        if (key && _hashmap_same_shape(dst, src))
+        {
+            // 同样的容量和hash, 下标减去探测长度就是hash下标
+            usize hash_index = (i + src->cap - (psl - PSL) % src->cap) % src->cap;
+            value = (u8 *)_hashmap_entry_at(dst, key, hash_index, NULL);
+        }
+        else
+        {
+            value = (u8 *)hashmap_entry(dst, key, NULL);
+        }
+
+        if (!value)
+        {
+            return 1;
+        }
+
+        i64 count;
+        memcpy(&count, value, sizeof(i64));
+        count += _counter_value(src, i);
+        memcpy(value, &count, sizeof(i64));
+    }
+    return 0;
+}
+
+static void _counter_sift_down(_counter_item *heap, usize len, usize i)
+{
+    while (1)
+    {
+        usize min = i;
+        usize left = i * 2 + 1;
+        usize right = left + 1;
+        if (left < len && heap[left].count < heap[min].count)
+        {
+            min = left;
+        }
+
+        if (right < len && heap[right].count < heap[min].count)
+        {
+            min = right;
+        }
+
+        if (min == i)
+        {
+            return;
+        }
+
+        VALUE_SWAP(heap[i], heap[min]);
+        i = min;
+    }
+}
+
+static void _counter_sift_up(_counter_item *heap, usize i)
+{
+    while (i > 0)
+    {
+        usize parent = (i - 1) / 2;
+        if (heap[parent].count <= heap[i].count)
+        {
+            return;
+        }
+
+        VALUE_SWAP(heap[i], heap[parent]);
+        i = parent;
+    }
+}
+
+usize hashmap_counter_top(hashmap *counter, usize k, void **keys, i64 *counts)
+{
+    if (!counter || counter->vsize != sizeof(i64) || k == 0 || counter->len == 0)
+    {
+        return 0;
+    }
+
+    if (k > counter->len)
+    {
+        k = counter->len;
+    }
+
+    _counter_item *heap = (_counter_item *)malloc(sizeof(_counter_item) * k);
+    if (!heap)
+    {
+        return 0;
+    }
+
+    // 小顶堆保留最大的k个
+    usize len = 0;
+    for (usize i = 0; i < counter->cap; i++)
+    {
+        if (counter->buckets[i].psl == 0)
+        {
+            continue;
+        }
+
+        _counter_item item = {_counter_value(counter, i), i};
+        if (len < k)
+        {
+            heap[len] = item;
+            _counter_sift_up(heap, len++);
+        }
+        else if (item.count > heap[0].count)
+        {
+            heap[0] = item;
+            _counter_sift_down(heap, len, 0);
+        }
+    }
+
+    // 依次取出最小值, 从后往前写入即为从大到小
+    for (usize n = len; n > 0; n--)
+    {
+        usize i = heap[0].index;
+        keys[n - 1] = counter->buckets[i].psl == NULL_KEY_PSL ? NULL : hashmap_key(counter, i);
+        if (counts)
+        {
+            counts[n - 1] = heap[0].count;
+        }
+        heap[0] = heap[n - 1];
+        _counter_sift_down(heap, n - 1, 0);
+    }
+
+    free(heap);
+    return len;
+}
+
+// ============================================================================
+//  hashmap快照
+// ============================================================================
+
+#define SNAPSHOT_MAGIC   0x50414e5350414d48ull // "HMAPSNAP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_ALIGN   64
+
+typedef struct
+{
+    u64 magic;
+    u64 version;
+    u64 bucket_size;
+    u64 ksize;
+    u64 vsize;
+    u64 cap;
+    u64 len;
+    u64 seed;
+    u64 fingerprint;
+    u64 checksum;
+    u64 buckets_off;
+    u64 keys_off;
+    u64 values_off;
+    u64 flags_off;
+    u64 file_size;
+} _hashmap_file_header;
+
+static inline u64 _snapshot_align(u64 off)
+{
+    return (off + SNAPSHOT_ALIGN - 1) & ~(u64)(SNAPSHOT_ALIGN - 1);
+}
+
+/**
+ * @brief 累加计算数据的checksum
+ *
+ * @param data
+ * @param dsize
+ * @param h 上一段数据的checksum
+ * @return u64
+ */
+static u64 _snapshot_checksum(const void *data, usize dsize, u64 h)
+{
+    const u8 *p = (const u8 *)data;
+    u64 word;
+    for (; dsize >= 8; dsize -= 8, p += 8)
+    {
+        memcpy(&word, p, 8);
+        h = (h ^ word) * 0x100000001b3ull;
+        h ^= h >> 29;
+    }
+    for (; dsize > 0; dsize--, p++)
+    {
+        h = (h ^ *p) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+static u64 _snapshot_payload_checksum(const hashmap *map)
+{
+    u64 h = SNAPSHOT_MAGIC;
+    h = _snapshot_checksum(map->buckets, sizeof(bucket) * map->cap, h);
+    h = _snapshot_checksum(map->keys, map->kdsize * map->cap, h);
+    h = _snapshot_checksum(map->values, map->vdsize * map->cap, h);
+    h = _snapshot_checksum(map->values_flags, map->cap, h);
+    return h;
+}
+
+static int _snapshot_write_at(FILE *fp, u64 *pos, u64 off, const void *data, usize dsize)
+{
+    static const u8 zeros[SNAPSHOT_ALIGN] = {0};
+    while (*pos < off)
+    {
+        if (fwrite(zeros, 1, 1, fp) != 1)
+        {
+            return 1;
+        }
+        *pos += 1;
+    }
+
+    if (dsize > 0 && fwrite(data, 1, dsize, fp) != dsize)
+    {
+        return 1;
+    }
+    *pos += dsize;
+    return 0;
+}
+
+int hashmap_save(hashmap *map, const char *path)
+{
+    if (!map || !path || map->ksize == 0 || map->vsize == 0 || map->key_kind == HASHMAP_KEY_CTX)
+    {
+        return 1;
+    }
+
+    _hashmap_file_header h = {
+        .magic = SNAPSHOT_MAGIC,
+        .version = SNAPSHOT_VERSION,
+        .bucket_size = sizeof(bucket),
+        .ksize = map->ksize,
+        .vsize = map->vsize,
+        .cap = map->cap,
+        .len = map->len,
+        .seed = map->seed,
+        .fingerprint = _snapshot_fingerprint(map->hasher, map->kdsize, map->seed),
+        .checksum = _snapshot_payload_checksum(map),
+    };
+    h.buckets_off = _snapshot_align(sizeof(h));
+    h.keys_off = _snapshot_align(h.buckets_off + sizeof(bucket) * map->cap);
+    h.values_off = _snapshot_align(h.keys_off + map->kdsize * map->cap);
+    h.flags_off = _snapshot_align(h.values_off + map->vdsize * map->cap);
+    h.file_size = h.flags_off + map->cap;
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+    {
+        return 1;
+    }
+
+    u64 pos = 0;
+    int ret = _snapshot_write_at(fp, &pos, 0, &h, sizeof(h)) ||
+              _snapshot_write_at(fp, &pos, h.buckets_off, map->buckets, sizeof(bucket) * map->cap) ||
+              _snapshot_write_at(fp, &pos, h.keys_off, map->keys, map->kdsize * map->cap) ||
+              _snapshot_write_at(fp, &pos, h.values_off, map->values, map->vdsize * map->cap) ||
+              _snapshot_write_at(fp, &pos, h.flags_off, map->values_flags, map->cap);
+
+    return (fclose(fp) != 0 || ret) ? 1 : 0;
+}
+
+#ifndef _WIN32
+
+static void _hashmap_unmap(hashmap *map)
+{
+    munmap(map->mmap_base, map->mmap_size);
+    map->mmap_base = NULL;
+    map->mmap_size = 0;
+    map->mmap_readonly = 0;
+}
+
+static b32 _snapshot_header_valid(const _hashmap_file_header *h, u64 file_size)
+{
+    if (h->magic != SNAPSHOT_MAGIC ||
+        h->version != SNAPSHOT_VERSION ||
+        h->bucket_size != sizeof(bucket) ||
+        h->ksize == 0 || h->vsize == 0 ||
+        h->cap == 0 || h->len > h->cap ||
+        h->file_size != file_size)
+    {
+        return 0;
+    }
+
+    // 文件内容不可信, 先按文件大小限制cap和偏移, 之后的乘法和加法不会溢出
+    if (h->ksize > file_size || h->vsize > file_size ||
+        h->cap > file_size / (sizeof(bucket) + h->ksize + h->vsize + 1) ||
+        h->buckets_off > file_size || h->keys_off > file_size ||
+        h->values_off > file_size || h->flags_off > file_size)
+    {
+        return 0;
+    }
+
+    return h->buckets_off >= sizeof(*h) &&
+           h->keys_off >= h->buckets_off + sizeof(bucket) * h->cap &&
+           h->values_off >= h->keys_off + h->ksize * h->cap &&
+           h->flags_off >= h->values_off + h->vsize * h->cap &&
+           h->file_size >= h->flags_off + h->cap;
+}
+
+/**
+ * @brief 检查桶数组, 不校验checksum时也要保证查找会结束:
+ * 非空桶个数与len一致且不超过扩容阈值(至少有一个空桶), psl不超过cap, 最多一个null key
+ *
+ * @param h
+ * @param buckets
+ * @return b32
+ */
+static b32 _snapshot_buckets_valid(const _hashmap_file_header *h, const bucket *buckets)
+{
+    if (h->len > (usize)(h->cap * LOAD_FACTOR))
+    {
+        return 0;
+    }
+
+    usize used = 0, nulls = 0;
+    for (usize i = 0; i < h->cap; i++)
+    {
+        usize psl = buckets[i].psl;
+        if (psl == 0)
+        {
+            continue;
+        }
+        used++;
+        if (psl == NULL_KEY_PSL)
+        {
+            nulls++;
+        }
+        else if (psl > h->cap)
+        {
+            return 0;
+        }
+    }
+    return used == h->len && nulls <= 1;
+}
+
+hashmap *hashmap_open_mmap(
+    const char *path,
+    int flags,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    if (!path)
+    {
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (u64)st.st_size < sizeof(_hashmap_file_header))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    b32 private = (flags & HASHMAP_MMAP_PRIVATE) != 0;
+    u8 *base = (u8 *)mmap(
+        NULL,
+        (usize)st.st_size,
+        private ? PROT_READ | PROT_WRITE : PROT_READ,
+        private ? MAP_PRIVATE : MAP_SHARED,
+        fd,
+        0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    const _hashmap_file_header *h = (const _hashmap_file_header *)base;
+    if (!_snapshot_header_valid(h, (u64)st.st_size) ||
+        !_snapshot_buckets_valid(h, (const bucket *)(base + h->buckets_off)))
+    {
+        munmap(base, (usize)st.st_size);
+        return NULL;
+    }
+
+    hashmap *map = hashmap_new_with_cap(1, h->ksize, h->vsize, h->seed, hasher, cmp);
+    if (!map || _snapshot_fingerprint(map->hasher, map->kdsize, map->seed) != h->fingerprint)
+    {
+        hashmap_free(map);
+        munmap(base, (usize)st.st_size);
+        return NULL;
+    }
+
+    _hashmap_free_arrays(map, map->buckets, map->keys, map->values, map->values_flags, map->cap, map->alloc_mapped);
+    map->alloc_mapped = 0;
+    map->cap = h->cap;
+    map->len = h->len;
+    map->resize = (usize)(map->cap * LOAD_FACTOR);
+    map->buckets = (bucket *)(base + h->buckets_off);
+    map->keys = base + h->keys_off;
+    map->values = base + h->values_off;
+    map->values_flags = base + h->flags_off;
+    map->mmap_base = base;
+    map->mmap_size = (usize)st.st_size;
+    map->mmap_readonly = !private;
+
+    if ((flags & HASHMAP_MMAP_VERIFY) && _snapshot_payload_checksum(map) != h->checksum)
+    {
+        hashmap_free(map);
+        return NULL;
+    }
+
+    return map;
+}
+
+#else
+
+static void _hashmap_unmap(hashmap *map)
+{
+    map->mmap_base = NULL;
+    map->mmap_size = 0;
+    map->mmap_readonly = 0;
+}
+
+hashmap *hashmap_open_mmap(
+    const char *path,
+    int flags,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    return NULL;
+}
+
+#endif
\ No newline at end of file
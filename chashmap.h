@@ -7,17 +7,69 @@
 #define LOAD_FACTOR     0.8
 #define RESIZE_ZOOM     1.5
 
+// 探测长度超过该值时更换seed重新hash
+#define HASHMAP_RESEED_PSL 64
+
+// 大表的分配方式, 数组不小于HASHMAP_LARGE_ALLOC字节时生效, 其余仍使用malloc
+#define HASHMAP_ALLOC_MALLOC          0 // malloc/calloc
+#define HASHMAP_ALLOC_HUGEPAGE        1 // mmap匿名页并MADV_HUGEPAGE使用透明大页
+#define HASHMAP_ALLOC_HUGETLB         2 // mmap MAP_HUGETLB使用预留的大页, 失败时退回HUGEPAGE
+#define HASHMAP_ALLOC_NUMA_INTERLEAVE 4 // 页在numa_nodes中交错分配
+#define HASHMAP_ALLOC_NUMA_BIND       8 // 页只在numa_nodes中分配
+#define HASHMAP_LARGE_ALLOC           (2 * 1024 * 1024)
+
+// key类型, 使用默认hasher和cmp的4/8字节key走整数快速路径
+#define HASHMAP_KEY_GENERIC 0
+#define HASHMAP_KEY_U32     1
+#define HASHMAP_KEY_U64     2
+#define HASHMAP_KEY_CTX     3 // hash和比较函数带上下文, 见hashmap_new_ctx
+
 /**
  * @brief 检查hashmap操作是否成功
  *
  * @param ret
  * @return b32
  */
-inline b32 hashmap_is_success(int ret)
+CEXTLIB_INLINE_HOT b32 hashmap_is_success(int ret)
 {
     return ret == 0;
 }
 
+// ============================================================================
+// hashmap_filter 分块Bloom过滤器, 每个key只访问一个cache line
+// ============================================================================
+
+#define HASHMAP_FILTER_BLOCK_BITS 512
+
+typedef struct hashmap_filter_header
+{
+    // 按64字节对齐的块, raw为分配的原始指针
+    u64 *blocks;
+    void *raw;
+    usize nblocks;
+    // 每个key设置的位数
+    u32 k;
+    u32 bits_per_key;
+    // 统计, stats为0时不记录
+    b32 stats;
+    u64 queries;
+    u64 rejects;
+    u64 false_positives;
+} hashmap_filter;
+
+typedef struct
+{
+    // 经过过滤器的查找次数
+    u64 queries;
+    // 被过滤器排除的次数
+    u64 rejects;
+    // 通过过滤器但key不存在的次数
+    u64 false_positives;
+    // false_positives / (rejects + false_positives)
+    double fpr;
+    usize bytes;
+} hashmap_filter_stats;
+
 // ============================================================================
 // hashmap
 // ============================================================================
@@ -48,11 +100,31 @@ typedef struct hashmap_header
     const usize kdsize;
     const usize vdsize;
     const u64 seed;
+    int key_kind;
     // 动态函数
     u64 (*hasher)(const void *data, usize dsize, u64 seed);
     int (*cmp)(const void *key1, const void *key2, usize ksize);
+    // HASHMAP_KEY_CTX使用的hash和比较函数
+    u64 (*key_hasher)(const void *key, void *ctx, u64 seed);
+    int (*key_cmp)(const void *key1, const void *key2, void *ctx);
+    void *key_ctx;
     void (*kfree)(void *key);
     void (*vfree)(void *value);
+    // hashmap_open_mmap映射的文件, 非NULL时buckets keys values values_flags指向映射内存
+    void *mmap_base;
+    usize mmap_size;
+    b32 mmap_readonly;
+    // 插入时探测长度超过该值则更换随机seed重新hash, 0为关闭
+    usize reseed_psl;
+    // 分配方式, numa_nodes为numa节点位图, alloc_mapped记录哪些数组是mmap分配的
+    int alloc_flags;
+    u64 numa_nodes;
+    u8 alloc_mapped;
+    // 不存在的key在探测前被过滤, NULL为不使用
+    hashmap_filter *filter;
+    // 元素写入新下标(插入、置换、删除时前移)后调用, 用于维护按下标存放的附加数据
+    void (*on_move)(struct hashmap_header *map, usize index);
+    void *udata;
 } hashmap;
 
 /**
@@ -98,6 +170,86 @@ hashmap *hashmap_new(
     u64 hasher(const void *, usize, u64),
     int cmp(const void *, const void *, usize));
 
+/**
+ * @brief SipHash-1-3, 以seed派生128位key, 攻击者无法在不知道seed时构造冲突
+ *
+ * @param data 数据
+ * @param dsize 数据大小
+ * @param seed 随机种子
+ * @return u64
+ */
+u64 hashmap_siphash(const void *data, usize dsize, u64 seed);
+
+/**
+ * @brief 从系统随机源获取随机seed
+ *
+ * @return u64
+ */
+u64 hashmap_random_seed(void);
+
+/**
+ * @brief 创建使用hashmap_siphash和随机seed的hashmap, 并开启探测过长时重新hash, 用于key可能来自攻击者的场景
+ *
+ * @param cap 初始容量
+ * @param ksize key大小
+ * @param vsize value大小
+ * @param cmp 比较函数
+ * @return 返回新创建的hashmap指针，如果内存分配失败或参数检查失败则返回NULL
+ */
+hashmap *hashmap_new_keyed(
+    usize cap,
+    usize ksize,
+    usize vsize,
+    int cmp(const void *, const void *, usize));
+
+/**
+ * @brief 创建hash和比较函数带上下文的hashmap, 用于key需要借助外部数据解释的场景, 例如key为外部数组的下标
+ *
+ * @param cap 初始容量
+ * @param ksize key大小, 不能为0
+ * @param vsize value大小
+ * @param seed 随机种子
+ * @param hasher hash函数
+ * @param cmp 比较函数, 相等返回0
+ * @param ctx 传给hasher和cmp的上下文
+ * @return 返回新创建的hashmap指针，如果内存分配失败或参数检查失败则返回NULL
+ */
+hashmap *hashmap_new_ctx(
+    usize cap,
+    usize ksize,
+    usize vsize,
+    u64 seed,
+    u64 hasher(const void *, void *, u64),
+    int cmp(const void *, const void *, void *),
+    void *ctx);
+
+/**
+ * @brief 设置探测长度阈值, 插入时探测长度超过阈值则更换随机seed重新hash, 只对使用seed的hasher有效
+ *
+ * @param map
+ * @param max_psl 阈值, 0为关闭
+ */
+void hashmap_set_reseed(hashmap *map, usize max_psl);
+
+/**
+ * @brief 设置大表的分配方式并按新方式重新分配当前的数组, mmap分配的页由内核清零, 不需要memset
+ *
+ * @param map
+ * @param flags HASHMAP_ALLOC_*的组合
+ * @param numa_nodes numa节点位图, 第n位为节点n, 只用于NUMA标志
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_set_alloc(hashmap *map, int flags, u64 numa_nodes);
+
+/**
+ * @brief 设置元素移动回调, 元素写入新下标后调用, 下标在插入、Robin Hood置换和删除前移时变化
+ *
+ * @param map
+ * @param on_move
+ * @param udata 回调可以通过map->udata获取
+ */
+void hashmap_set_move_hook(hashmap *map, void (*on_move)(hashmap *map, usize index), void *udata);
+
 /**
  * @brief 设置hashmap key释放函数
  *
@@ -151,6 +303,16 @@ void *hashmap_get(hashmap *map, const void *key);
  */
 void *hashmap_get_clone(hashmap *map, const void *key);
 
+/**
+ * @brief 查找key, 不存在则插入值全为0的value, 只查找一次
+ *
+ * @param map
+ * @param key
+ * @param inserted 非NULL时写入是否新插入
+ * @return 返回value所在位置, vsize为0时为存放指针的位置, 失败返回NULL. 位置在下次修改前有效
+ */
+void *hashmap_entry(hashmap *map, void *key, b32 *inserted);
+
 /**
  * @brief hashmap查找key是否存在
  *
@@ -169,13 +331,57 @@ b32 hashmap_exist(hashmap *map, const void *key);
  */
 int hashmap_remove(hashmap *map, const void *key);
 
+/**
+ * @brief 查找key所在的下标
+ *
+ * @param map
+ * @param key
+ * @return 查找到返回下标 否则返回-1
+ */
+size hashmap_index_of(hashmap *map, const void *key);
+
+/**
+ * @brief 获取下标处元素的key
+ *
+ * @param map
+ * @param index
+ * @return 下标处有元素返回key, null key或没有元素返回NULL
+ */
+void *hashmap_key_at(hashmap *map, usize index);
+
+/**
+ * @brief 获取下标处元素的value
+ *
+ * @param map
+ * @param index
+ * @return 下标处有元素返回val所在指针 否则返回NULL
+ */
+void *hashmap_value_at(hashmap *map, usize index);
+
+/**
+ * @brief hashmap移除下标处的元素
+ *
+ * @param map
+ * @param index
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_remove_at(hashmap *map, usize index);
+
 /**
  * @brief hashmap元素个数
  *
  * @param map
  * @return 返回hashmap元素个数
  */
-size hashmap_count(hashmap *map);
+CEXTLIB_INLINE_HOT size hashmap_count(hashmap *map)
+{
+    if (!map)
+    {
+        return 0;
+    }
+
+    return map->len;
+}
 
 /**
  * @brief hashmap清空
@@ -208,7 +414,43 @@ hashmap *hashmap_clone(hashmap *map);
  * @param map
  * @return 1为空 0不为空
  */
-b32 hashmap_empty(hashmap *map);
+CEXTLIB_INLINE_HOT b32 hashmap_empty(hashmap *map)
+{
+    return map->len == 0;
+}
+
+// ============================================================================
+//  hashmap快照
+// ============================================================================
+
+#define HASHMAP_MMAP_READONLY 0 // 只读映射, 多进程共享page cache, 修改操作返回失败
+#define HASHMAP_MMAP_PRIVATE  1 // 写时复制映射, 修改不会写回文件
+#define HASHMAP_MMAP_VERIFY   2 // 打开时校验数据checksum, 需要读取整个文件
+
+/**
+ * @brief hashmap写入快照文件, 文件带版本、checksum和hasher指纹, 仅支持ksize和vsize都不为0的表
+ *
+ * @param map
+ * @param path
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_save(hashmap *map, const char *path);
+
+/**
+ * @brief 映射快照文件为hashmap, 查找直接读取映射的内存, 不需要逐个插入;
+ * 打开时检查桶数组的psl, 文件损坏时查找也不会无限探测
+ *
+ * @param path
+ * @param flags HASHMAP_MMAP_READONLY或HASHMAP_MMAP_PRIVATE, 可以或上HASHMAP_MMAP_VERIFY
+ * @param hasher hash函数, 需要与保存时一致, NULL为默认
+ * @param cmp 比较函数, NULL为默认
+ * @return 成功返回hashmap指针 文件无效、hasher或seed不一致则返回NULL
+ */
+hashmap *hashmap_open_mmap(
+    const char *path,
+    int flags,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize));
 
 // ============================================================================
 //  hashmap迭代器
@@ -278,4 +520,230 @@ typedef struct
  */
 hashmap_iterator_kv hashmap_iter_kv(hashmap_iterator *iter);
 
+/**
+ * @brief 遍历桶下标[begin, end)中的元素, 遍历期间没有修改时多个线程可以同时遍历不同区间
+ *
+ * @param map
+ * @param begin
+ * @param end 超过cap时为cap
+ * @param fn
+ * @param ctx
+ * @return size 遍历的元素个数
+ */
+size hashmap_for_each_range(hashmap *map, usize begin, usize end, void (*fn)(void *key, void *value, void *ctx), void *ctx);
+
+// ============================================================================
+//  hashmap_frozen 只读最小完美哈希表
+// ============================================================================
+
+typedef struct hashmap_frozen_header
+{
+    // 数据, 按最小完美哈希的位置紧凑存放, 共len个
+    u8 *keys;
+    u8 *values;
+    u8 *values_flags;
+    // 每个桶的pilot
+    u16 *pilots;
+    // 落在[len, slots)的位置重映射到空闲位置
+    u32 *remap;
+    usize len;
+    usize nbuckets;
+    usize slots;
+    u64 salt;
+    // null key
+    b32 has_null_key;
+    u8 *null_value;
+    u8 null_value_flag;
+    const usize ksize;
+    const usize vsize;
+    const usize kdsize;
+    const usize vdsize;
+    const u64 seed;
+    // 不存在的key在查找前被过滤, NULL为不使用
+    hashmap_filter *filter;
+    // 动态函数
+    u64 (*hasher)(const void *data, usize dsize, u64 seed);
+    int (*cmp)(const void *key1, const void *key2, usize ksize);
+} hashmap_frozen;
+
+/**
+ * @brief 由hashmap构建只读的最小完美哈希表, 查找只需一次探测和一次key比较
+ *
+ * @param map
+ * @return 成功返回hashmap_frozen指针 失败返回NULL(内存不足或存在hash完全相同的不同key)
+ */
+hashmap_frozen *hashmap_freeze(hashmap *map);
+
+/**
+ * @brief hashmap_frozen释放
+ *
+ * @param frozen
+ */
+void hashmap_frozen_free(hashmap_frozen *frozen);
+
+/**
+ * @brief hashmap_frozen查找key
+ *
+ * @param frozen
+ * @param key
+ * @return 查找到返回val所在指针 否则返回NULL
+ */
+void *hashmap_frozen_get(hashmap_frozen *frozen, const void *key);
+
+/**
+ * @brief hashmap_frozen查找key是否存在
+ *
+ * @param frozen
+ * @param key
+ * @return 存在返回1 否则返回0
+ */
+b32 hashmap_frozen_exist(hashmap_frozen *frozen, const void *key);
+
+/**
+ * @brief hashmap_frozen元素个数
+ *
+ * @param frozen
+ * @return 返回元素个数
+ */
+size hashmap_frozen_count(hashmap_frozen *frozen);
+
+/**
+ * @brief hashmap_frozen写入文件, 仅支持ksize和vsize都不为0的表
+ *
+ * @param frozen
+ * @param path
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_frozen_save(hashmap_frozen *frozen, const char *path);
+
+/**
+ * @brief 从文件读取hashmap_frozen, hasher和cmp需要与保存时一致, hasher不一致或文件内容损坏时失败
+ *
+ * @param path
+ * @param hasher hash函数, NULL为默认
+ * @param cmp 比较函数, NULL为默认
+ * @return 成功返回hashmap_frozen指针 失败返回NULL
+ */
+hashmap_frozen *hashmap_frozen_load(
+    const char *path,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize));
+
+// ============================================================================
+//  hashmap_filter
+// ============================================================================
+
+/**
+ * @brief 为hashmap开启Bloom过滤器, 查找不存在的key时大多只访问过滤器的一个cache line
+ *
+ * 过滤器在插入时维护, 删除不会清除位, 大量删除后可以调用hashmap_filter_rebuild, 扩容时自动重建
+ *
+ * @param map
+ * @param bits_per_key 每个key占用的位数, 10位时误判率约1%
+ * @param stats 是否记录统计
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_filter_enable(hashmap *map, u32 bits_per_key, b32 stats);
+
+/**
+ * @brief 关闭hashmap的过滤器
+ *
+ * @param map
+ */
+void hashmap_filter_disable(hashmap *map);
+
+/**
+ * @brief 按当前的key重建过滤器, 去掉已删除key留下的位
+ *
+ * @param map
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_filter_rebuild(hashmap *map);
+
+/**
+ * @brief 为hashmap_frozen开启Bloom过滤器, hashmap_freeze时源hashmap有过滤器则自动开启
+ *
+ * @param frozen
+ * @param bits_per_key 每个key占用的位数
+ * @param stats 是否记录统计
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_frozen_filter_enable(hashmap_frozen *frozen, u32 bits_per_key, b32 stats);
+
+/**
+ * @brief 获取过滤器统计
+ *
+ * @param filter map->filter或frozen->filter
+ * @return 统计, filter为NULL时全为0
+ */
+hashmap_filter_stats hashmap_filter_get_stats(const hashmap_filter *filter);
+
+// ============================================================================
+//  hashmap计数器, value为i64
+// ============================================================================
+
+/**
+ * @brief 创建计数器
+ *
+ * @param cap 初始容量, 合并到同一个全局计数器的局部计数器应使用相同的容量
+ * @param ksize key大小
+ * @param seed 随机种子
+ * @param hasher hash函数
+ * @param cmp 比较函数
+ * @return 返回新创建的hashmap指针, 内存分配失败返回NULL
+ */
+hashmap *hashmap_counter_new(
+    usize cap,
+    usize ksize,
+    u64 seed,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize));
+
+/**
+ * @brief 创建与counter容量、seed、hash函数、过滤器和重新hash阈值都相同的空计数器, 用作线程局部计数器
+ *
+ * @param counter
+ * @return 返回新创建的hashmap指针, 内存分配失败返回NULL
+ */
+hashmap *hashmap_counter_like(hashmap *counter);
+
+/**
+ * @brief key的计数加上delta, key不存在时从0开始, 只查找一次并原地相加
+ *
+ * @param counter
+ * @param key
+ * @param delta
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_counter_add(hashmap *counter, void *key, i64 delta);
+
+/**
+ * @brief 获取key的计数
+ *
+ * @param counter
+ * @param key
+ * @return 返回计数, key不存在返回0
+ */
+i64 hashmap_counter_get(hashmap *counter, const void *key);
+
+/**
+ * @brief 把src的计数加到dst, 两者容量、seed和hash函数相同时按下标推算hash下标, 不重新计算hash
+ *
+ * @param dst
+ * @param src
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_counter_merge(hashmap *dst, hashmap *src);
+
+/**
+ * @brief 取计数最大的k个key, 使用大小为k的堆, 不排序整个表
+ *
+ * @param counter
+ * @param k
+ * @param keys 输出key指针, 按计数从大到小, 在counter修改前有效, null key输出NULL
+ * @param counts 输出计数, 可以为NULL
+ * @return 返回输出的个数
+ */
+usize hashmap_counter_top(hashmap *counter, usize k, void **keys, i64 *counts);
+
 #endif // __CHASHMAP_H
\ No newline at end of file
@@ -0,0 +1,29 @@
+#include "chashmap_parallel.h"
+
+// hashmap_parallel_for_each每个任务至少遍历的桶个数
+#define HASHMAP_PARALLEL_GRAIN 4096
+
+typedef struct hashmap_for_each_ctx
+{
+    hashmap *map;
+    void (*fn)(void *key, void *value, void *ctx);
+    void *ctx;
+} hashmap_for_each_ctx;
+
+static void hashmap_for_each_chunk(usize begin, usize end, void *arg)
+{
+    hashmap_for_each_ctx *c = (hashmap_for_each_ctx *)arg;
+    hashmap_for_each_range(c->map, begin, end, c->fn, c->ctx);
+}
+
+void hashmap_parallel_for_each(hashmap *map, cpool *pool, void (*fn)(void *key, void *value, void *ctx), void *ctx)
+{
+    if (!map || !fn || map->len == 0)
+    {
+        return;
+    }
+
+    hashmap_for_each_ctx c = {map, fn, ctx};
+    usize grain = map->cap / (cpool_threads(pool) * CPOOL_GRAIN_SPLIT);
+    cpool_parallel_for(pool, 0, map->cap, grain > HASHMAP_PARALLEL_GRAIN ? grain : HASHMAP_PARALLEL_GRAIN, hashmap_for_each_chunk, &c);
+}
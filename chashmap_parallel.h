@@ -0,0 +1,22 @@
+#ifndef __CHASHMAP_PARALLEL_H
+#define __CHASHMAP_PARALLEL_H
+
+#include "chashmap.h"
+#include "cpool.h"
+#include "ctype.h"
+
+// ============================================================================
+// hashmap 并行遍历, 依赖cpool, 需要链接cpool.c和-pthread
+// ============================================================================
+
+/**
+ * @brief 并行遍历全部元素, 桶数组按区间分给线程池, fn需要线程安全, 遍历期间不能修改hashmap
+ *
+ * @param map
+ * @param pool 为NULL时为cpool_global
+ * @param fn
+ * @param ctx
+ */
+void hashmap_parallel_for_each(hashmap *map, cpool *pool, void (*fn)(void *key, void *value, void *ctx), void *ctx);
+
+#endif // __CHASHMAP_PARALLEL_H
@@ -0,0 +1,610 @@
+#include "chll.h"
+#include "chashmap.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define HLL_EXACT_SLOTS (HLL_EXACT_MAX * 2)
+#define HLL_ALIGN       64
+#define HLL_RANK_BITS   6
+#define HLL_RANK_MASK   ((1u << HLL_RANK_BITS) - 1)
+// 稀疏表示每攒够这么多新项排序后合并一次, 避免每次插入都移动有序数组
+#define HLL_SPARSE_BATCH 256
+
+/**
+ * @brief hash高p位为寄存器下标, 其余位的前导0个数加1为rank
+ */
+static inline u8 _hll_rank(u64 hash, u8 p)
+{
+    u64 w = hash << p;
+    return (u8)(w ? __builtin_clzll(w) + 1 : 64 - p + 1);
+}
+
+static inline u32 _hll_sparse_encode(u64 hash)
+{
+    u32 index = (u32)(hash >> (64 - HLL_SPARSE_PRECISION));
+    return (index << HLL_RANK_BITS) | _hll_rank(hash, HLL_SPARSE_PRECISION);
+}
+
+/**
+ * @brief 稀疏表示的编码转为精度p的下标和rank
+ */
+static inline void _hll_sparse_decode(u32 e, u8 p, usize *index, u8 *rank)
+{
+    u32 sparse_index = e >> HLL_RANK_BITS;
+    u32 shift = HLL_SPARSE_PRECISION - p;
+    u32 bits = sparse_index & ((1u << shift) - 1);
+    *index = sparse_index >> shift;
+    // 下标之后的shift位中有1时由它们决定rank, 否则延续稀疏表示的rank
+    *rank = bits ? (u8)(shift - (32 - __builtin_clz(bits)) + 1) : (u8)(shift + (e & HLL_RANK_MASK));
+}
+
+static void _hll_free_rep(hll *h)
+{
+    free2(h->exact);
+    free2(h->sparse);
+    free2(h->raw);
+    h->exact = NULL;
+    h->sparse = NULL;
+    h->raw = NULL;
+    h->registers = NULL;
+    h->exact_len = 0;
+    h->exact_zero = 0;
+    h->sparse_len = 0;
+    h->sparse_pending = 0;
+    h->sparse_cap = 0;
+}
+
+hll *hll_new(u8 p, usize ksize, u64 seed, u64 hasher(const void *, usize, u64))
+{
+    if (p < HLL_MIN_PRECISION || p > HLL_MAX_PRECISION)
+    {
+        return NULL;
+    }
+
+    hll *h = calloc(1, sizeof(hll));
+    if (h == NULL)
+    {
+        return NULL;
+    }
+
+    h->mode = HLL_EXACT;
+    *(u8 *)&h->p = p;
+    *(usize *)&h->m = (usize)1 << p;
+    *(usize *)&h->ksize = ksize;
+    *(u64 *)&h->seed = seed;
+    h->hasher = hasher ? hasher : hashmap_siphash;
+    return h;
+}
+
+hll *hll_like(const hll *h)
+{
+    return hll_new(h->p, h->ksize, h->seed, h->hasher);
+}
+
+void hll_free(hll *h)
+{
+    if (h == NULL)
+    {
+        return;
+    }
+
+    _hll_free_rep(h);
+    free(h);
+}
+
+void hll_clear(hll *h)
+{
+    _hll_free_rep(h);
+    h->mode = HLL_EXACT;
+}
+
+// ============================================================================
+//  稠密表示
+// ============================================================================
+
+static int _hll_alloc_registers(hll *h)
+{
+    h->raw = calloc(1, h->m + HLL_ALIGN);
+    if (h->raw == NULL)
+    {
+        return 1;
+    }
+
+    h->registers = (u8 *)(((uintptr_t)h->raw + HLL_ALIGN - 1) & ~(uintptr_t)(HLL_ALIGN - 1));
+    return 0;
+}
+
+static inline void _hll_dense_update(hll *h, usize index, u8 rank)
+{
+    if (h->registers[index] < rank)
+    {
+        h->registers[index] = rank;
+    }
+}
+
+/**
+ * @brief 按字节取最大值, m至少为16
+ */
+static void _hll_dense_merge(u8 *dst, const u8 *src, usize m)
+{
+    usize i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= m; i += 16)
+    {
+        __m128i a = _mm_load_si128((const __m128i *)(dst + i));
+        __m128i b = _mm_load_si128((const __m128i *)(src + i));
+        _mm_store_si128((__m128i *)(dst + i), _mm_max_epu8(a, b));
+    }
+#endif
+    for (; i < m; i++)
+    {
+        dst[i] = dst[i] < src[i] ? src[i] : dst[i];
+    }
+}
+
+static int _hll_sparse_to_dense(hll *h)
+{
+    if (_hll_alloc_registers(h))
+    {
+        return 1;
+    }
+
+    // 未合并的新项同样按最大rank更新
+    for (usize i = 0; i < h->sparse_len + h->sparse_pending; i++)
+    {
+        usize index;
+        u8 rank;
+        _hll_sparse_decode(h->sparse[i], h->p, &index, &rank);
+        _hll_dense_update(h, index, rank);
+    }
+
+    free2(h->sparse);
+    h->sparse = NULL;
+    h->sparse_len = 0;
+    h->sparse_pending = 0;
+    h->sparse_cap = 0;
+    h->mode = HLL_DENSE;
+    return 0;
+}
+
+// ============================================================================
+//  稀疏表示
+// ============================================================================
+
+static int _hll_u32_cmp(const void *a, const void *b)
+{
+    u32 x = *(const u32 *)a;
+    u32 y = *(const u32 *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief 有序项中第一个下标不小于index的位置
+ */
+static usize _hll_sparse_lower(const u32 *sparse, usize n, u32 index)
+{
+    usize lo = 0;
+    usize hi = n;
+    while (lo < hi)
+    {
+        usize mid = lo + (hi - lo) / 2;
+        if ((sparse[mid] >> HLL_RANK_BITS) < index)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief 排序并去重新项, 每个下标保留最大的rank
+ *
+ * @return 去重后的个数
+ */
+static usize _hll_sparse_sort_unique(u32 *items, usize n)
+{
+    qsort(items, n, sizeof(u32), _hll_u32_cmp);
+    usize u = 0;
+    for (usize i = 0; i < n; i++)
+    {
+        // 下标相同时rank大的排在后面
+        if (u > 0 && (items[u - 1] >> HLL_RANK_BITS) == (items[i] >> HLL_RANK_BITS))
+        {
+            items[u - 1] = items[i];
+        }
+        else
+        {
+            items[u++] = items[i];
+        }
+    }
+    return u;
+}
+
+/**
+ * @brief 新项排序去重后与有序部分从后向前合并, 超过稠密表示的大小后转换
+ */
+static int _hll_sparse_flush(hll *h)
+{
+    u32 batch[HLL_SPARSE_BATCH];
+    usize n = h->sparse_len;
+    usize k = _hll_sparse_sort_unique(h->sparse + n, h->sparse_pending);
+    memcpy(batch, h->sparse + n, sizeof(u32) * k);
+
+    // 写入位置不小于a + b, 不会覆盖未读的有序项
+    usize a = n, b = k, out = n + k;
+    while (b > 0)
+    {
+        u32 x = batch[b - 1];
+        u32 y = a > 0 ? h->sparse[a - 1] : 0;
+        if (a > 0 && (y >> HLL_RANK_BITS) >= (x >> HLL_RANK_BITS))
+        {
+            if ((y >> HLL_RANK_BITS) == (x >> HLL_RANK_BITS))
+            {
+                x = y > x ? y : x;
+                b--;
+            }
+            h->sparse[--out] = y > x ? y : x;
+            a--;
+            continue;
+        }
+        h->sparse[--out] = x;
+        b--;
+    }
+
+    // 有重复下标时合并结果前面留有空隙
+    if (out > a)
+    {
+        memmove(h->sparse + a, h->sparse + out, sizeof(u32) * (n + k - out));
+    }
+    h->sparse_len = n + k - (out - a);
+    h->sparse_pending = 0;
+
+    // 稀疏表示每项4字节, 超过稠密表示的大小后转换
+    if (h->sparse_len * sizeof(u32) > h->m)
+    {
+        return _hll_sparse_to_dense(h);
+    }
+
+    return 0;
+}
+
+static int _hll_sparse_insert(hll *h, u32 e)
+{
+    if (h->sparse_len + h->sparse_pending == h->sparse_cap)
+    {
+        usize cap = h->sparse_cap ? h->sparse_cap * 2 : HLL_EXACT_MAX * 2;
+        u32 *sparse = realloc(h->sparse, sizeof(u32) * cap);
+        if (sparse == NULL)
+        {
+            return 1;
+        }
+        h->sparse = sparse;
+        h->sparse_cap = cap;
+    }
+
+    h->sparse[h->sparse_len + h->sparse_pending++] = e;
+    // 攒够一批, 或加上新项可能超过稠密表示的大小时合并
+    if (h->sparse_pending < HLL_SPARSE_BATCH && (h->sparse_len + h->sparse_pending) * sizeof(u32) <= h->m)
+    {
+        return 0;
+    }
+
+    return _hll_sparse_flush(h);
+}
+
+/**
+ * @brief 稀疏表示中不同下标的个数, 新项在副本中排序, 不修改h
+ */
+static usize _hll_sparse_distinct(const hll *h)
+{
+    usize n = h->sparse_len;
+    if (h->sparse_pending == 0)
+    {
+        return n;
+    }
+
+    u32 batch[HLL_SPARSE_BATCH];
+    memcpy(batch, h->sparse + n, sizeof(u32) * h->sparse_pending);
+    usize k = _hll_sparse_sort_unique(batch, h->sparse_pending);
+    usize distinct = n;
+    for (usize i = 0; i < k; i++)
+    {
+        u32 index = batch[i] >> HLL_RANK_BITS;
+        usize lo = _hll_sparse_lower(h->sparse, n, index);
+        distinct += lo == n || (h->sparse[lo] >> HLL_RANK_BITS) != index;
+    }
+    return distinct;
+}
+
+// ============================================================================
+//  精确计数
+// ============================================================================
+
+static int _hll_add(hll *h, u64 hash);
+
+static int _hll_exact_to_sparse(hll *h)
+{
+    u64 *exact = h->exact;
+    b32 zero = h->exact_zero;
+    h->exact = NULL;
+    h->exact_len = 0;
+    h->exact_zero = 0;
+    h->mode = HLL_SPARSE;
+
+    // 精度较低时可能直接转为稠密表示
+    int ret = zero ? _hll_add(h, 0) : 0;
+    for (usize i = 0; exact && i < HLL_EXACT_SLOTS && ret == 0; i++)
+    {
+        if (exact[i])
+        {
+            ret = _hll_add(h, exact[i]);
+        }
+    }
+
+    free2(exact);
+    return ret;
+}
+
+/**
+ * @brief 精确计数的表中插入hash
+ *
+ * @return 插入或已存在返回0, 表已满返回-1, 内存分配失败返回1
+ */
+static int _hll_exact_insert(hll *h, u64 hash)
+{
+    if (hash == 0)
+    {
+        if (!h->exact_zero && h->exact_len == HLL_EXACT_MAX)
+        {
+            return -1;
+        }
+        h->exact_len += !h->exact_zero;
+        h->exact_zero = 1;
+        return 0;
+    }
+
+    if (h->exact == NULL)
+    {
+        h->exact = calloc(HLL_EXACT_SLOTS, sizeof(u64));
+        if (h->exact == NULL)
+        {
+            return 1;
+        }
+    }
+
+    usize i = hash & (HLL_EXACT_SLOTS - 1);
+    while (h->exact[i])
+    {
+        if (h->exact[i] == hash)
+        {
+            return 0;
+        }
+        i = (i + 1) & (HLL_EXACT_SLOTS - 1);
+    }
+
+    if (h->exact_len == HLL_EXACT_MAX)
+    {
+        return -1;
+    }
+
+    h->exact[i] = hash;
+    h->exact_len++;
+    return 0;
+}
+
+static int _hll_add(hll *h, u64 hash)
+{
+    switch (h->mode)
+    {
+    case HLL_EXACT:
+    {
+        int ret = _hll_exact_insert(h, hash);
+        if (ret >= 0)
+        {
+            return ret;
+        }
+
+        if (_hll_exact_to_sparse(h))
+        {
+            return 1;
+        }
+        return _hll_add(h, hash);
+    }
+    case HLL_SPARSE:
+        return _hll_sparse_insert(h, _hll_sparse_encode(hash));
+    default:
+        _hll_dense_update(h, (usize)(hash >> (64 - h->p)), _hll_rank(hash, h->p));
+        return 0;
+    }
+}
+
+int hll_add(hll *h, const void *key)
+{
+    return _hll_add(h, h->hasher(key, h->ksize, h->seed));
+}
+
+int hll_add_data(hll *h, const void *data, usize dsize)
+{
+    return _hll_add(h, h->hasher(data, dsize, h->seed));
+}
+
+int hll_add_hash(hll *h, u64 hash)
+{
+    return _hll_add(h, hash);
+}
+
+// ============================================================================
+//  估计
+// ============================================================================
+
+static double _hll_sigma(double x)
+{
+    if (x == 1.0)
+    {
+        return INFINITY;
+    }
+
+    double y = 1.0;
+    double z = x;
+    double last;
+    do
+    {
+        x *= x;
+        last = z;
+        z += x * y;
+        y += y;
+    } while (z != last);
+
+    return z;
+}
+
+static double _hll_tau(double x)
+{
+    if (x == 0.0 || x == 1.0)
+    {
+        return 0.0;
+    }
+
+    double y = 1.0;
+    double z = 1.0 - x;
+    double last;
+    do
+    {
+        x = sqrt(x);
+        last = z;
+        y *= 0.5;
+        z -= (1.0 - x) * (1.0 - x) * y;
+    } while (z != last);
+
+    return z / 3.0;
+}
+
+/**
+ * @brief Ertl改进的估计, 由寄存器值的直方图计算, 小基数时不需要线性计数和偏差修正表
+ */
+static double _hll_dense_count(const hll *h)
+{
+    usize q = 64 - h->p;
+    usize hist[64 + 2] = {0};
+    for (usize i = 0; i < h->m; i++)
+    {
+        hist[h->registers[i]]++;
+    }
+
+    double m = (double)h->m;
+    double z = m * _hll_tau(1.0 - (double)hist[q + 1] / m);
+    for (usize k = q; k >= 1; k--)
+    {
+        z = 0.5 * (z + (double)hist[k]);
+    }
+    z += m * _hll_sigma((double)hist[0] / m);
+
+    return (m * m) / (2.0 * log(2.0) * z);
+}
+
+double hll_count(const hll *h)
+{
+    switch (h->mode)
+    {
+    case HLL_EXACT:
+        return (double)h->exact_len;
+    case HLL_SPARSE:
+    {
+        // 高精度下的线性计数
+        double m = (double)(1u << HLL_SPARSE_PRECISION);
+        return m * log(m / (m - (double)_hll_sparse_distinct(h)));
+    }
+    default:
+        return _hll_dense_count(h);
+    }
+}
+
+// ============================================================================
+//  合并
+// ============================================================================
+
+static int _hll_to_dense(hll *h)
+{
+    if (h->mode == HLL_EXACT && _hll_exact_to_sparse(h))
+    {
+        return 1;
+    }
+
+    if (h->mode == HLL_SPARSE)
+    {
+        return _hll_sparse_to_dense(h);
+    }
+
+    return 0;
+}
+
+int hll_merge(hll *dst, const hll *src)
+{
+    if (dst->p != src->p || dst->seed != src->seed || dst->hasher != src->hasher)
+    {
+        return 1;
+    }
+
+    switch (src->mode)
+    {
+    case HLL_EXACT:
+    {
+        if (src->exact_zero && _hll_add(dst, 0))
+        {
+            return 1;
+        }
+
+        for (usize i = 0; src->exact && i < HLL_EXACT_SLOTS; i++)
+        {
+            if (src->exact[i] && _hll_add(dst, src->exact[i]))
+            {
+                return 1;
+            }
+        }
+        return 0;
+    }
+    case HLL_SPARSE:
+    {
+        // 稀疏表示的项不是完整的hash, 不能放入精确计数
+        if (dst->mode == HLL_EXACT && _hll_exact_to_sparse(dst))
+        {
+            return 1;
+        }
+
+        for (usize i = 0; i < src->sparse_len + src->sparse_pending; i++)
+        {
+            if (dst->mode == HLL_SPARSE)
+            {
+                if (_hll_sparse_insert(dst, src->sparse[i]))
+                {
+                    return 1;
+                }
+                continue;
+            }
+
+            usize index;
+            u8 rank;
+            _hll_sparse_decode(src->sparse[i], dst->p, &index, &rank);
+            _hll_dense_update(dst, index, rank);
+        }
+        return 0;
+    }
+    default:
+        if (_hll_to_dense(dst))
+        {
+            return 1;
+        }
+
+        _hll_dense_merge(dst->registers, src->registers, dst->m);
+        return 0;
+    }
+}
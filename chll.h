@@ -0,0 +1,125 @@
+#ifndef __CHLL_H
+#define __CHLL_H
+
+#include "ctype.h"
+
+#define HLL_MIN_PRECISION 4
+#define HLL_MAX_PRECISION 18
+// 稀疏表示使用的精度
+#define HLL_SPARSE_PRECISION 25
+// 精确计数的最大元素个数
+#define HLL_EXACT_MAX 64
+
+// 表示方式, 随元素增多依次升级
+#define HLL_EXACT  0
+#define HLL_SPARSE 1
+#define HLL_DENSE  2
+
+// ============================================================================
+// hll HyperLogLog基数估计
+// ============================================================================
+
+typedef struct hll_header
+{
+    int mode;
+    // 精度, 寄存器个数m = 1 << p
+    const u8 p;
+    const usize m;
+    const usize ksize;
+    const u64 seed;
+    // 精确计数, 保存hash的开放寻址表, hash为0时单独记录
+    u64 *exact;
+    usize exact_len;
+    b32 exact_zero;
+    // 稀疏表示, (HLL_SPARSE_PRECISION位下标 << 6) | rank, [0, sparse_len)按下标升序,
+    // 之后是sparse_pending个未排序的新项, 攒够一批后排序合并
+    u32 *sparse;
+    usize sparse_len;
+    usize sparse_pending;
+    usize sparse_cap;
+    // 稠密表示, 每个寄存器一个字节, 按64字节对齐, raw为分配的原始指针
+    u8 *registers;
+    void *raw;
+    // 动态函数
+    u64 (*hasher)(const void *data, usize dsize, u64 seed);
+} hll;
+
+/**
+ * @brief 创建hll, 从精确计数开始, 超过HLL_EXACT_MAX个元素后转为稀疏表示, 稀疏表示大于稠密表示时转为稠密表示
+ *
+ * @param p 精度, HLL_MIN_PRECISION到HLL_MAX_PRECISION, 标准误差约为1.04 / sqrt(1 << p)
+ * @param ksize key大小, hll_add按ksize计算hash
+ * @param seed 随机种子
+ * @param hasher hash函数, NULL为hashmap_siphash
+ * @return 返回新创建的hll指针, 内存分配失败或参数检查失败则返回NULL
+ */
+hll *hll_new(u8 p, usize ksize, u64 seed, u64 hasher(const void *, usize, u64));
+
+/**
+ * @brief 创建参数相同的空hll, 用于每个线程单独计数后合并
+ *
+ * @param h
+ * @return 返回新创建的hll指针, 内存分配失败返回NULL
+ */
+hll *hll_like(const hll *h);
+
+/**
+ * @brief hll释放
+ *
+ * @param h
+ */
+void hll_free(hll *h);
+
+/**
+ * @brief 添加key
+ *
+ * @param h
+ * @param key
+ * @return 成功返回0 失败返回非0
+ */
+int hll_add(hll *h, const void *key);
+
+/**
+ * @brief 添加任意长度的数据
+ *
+ * @param h
+ * @param data
+ * @param dsize
+ * @return 成功返回0 失败返回非0
+ */
+int hll_add_data(hll *h, const void *data, usize dsize);
+
+/**
+ * @brief 添加已经计算好的hash
+ *
+ * @param h
+ * @param hash
+ * @return 成功返回0 失败返回非0
+ */
+int hll_add_hash(hll *h, u64 hash);
+
+/**
+ * @brief 估计不同元素的个数, 精确计数时返回准确值
+ *
+ * @param h
+ * @return 估计值
+ */
+double hll_count(const hll *h);
+
+/**
+ * @brief 将src合并到dst, 结果为两者并集的估计, src不变
+ *
+ * @param dst
+ * @param src 精度、seed和hasher需要与dst相同
+ * @return 成功返回0 参数不一致或内存分配失败返回非0
+ */
+int hll_merge(hll *dst, const hll *src);
+
+/**
+ * @brief 清空, 回到精确计数
+ *
+ * @param h
+ */
+void hll_clear(hll *h);
+
+#endif // __CHLL_H
@@ -0,0 +1,355 @@
+#include "clru.h"
+#include "cutils.h"
+#include <string.h>
+
+#define PTR_LEN          sizeof(uintptr_t)
+#define LRU_FLAG_OFFSET  4 // value是否为NULL
+#define LRU_VALUE_OFFSET 8 // 节点编号和flag之后是value
+
+static inline u32 _lru_node_of(const u8 *internal)
+{
+    u32 id;
+    memcpy(&id, internal, sizeof(u32));
+    return id;
+}
+
+static inline void *_lru_user_value(const hashmap_lru *lru, u8 *internal)
+{
+    if (lru->vsize == 0)
+    {
+        return (void *)(*(uintptr_t *)(internal + LRU_VALUE_OFFSET));
+    }
+
+    return internal[LRU_FLAG_OFFSET] ? internal + LRU_VALUE_OFFSET : NULL;
+}
+
+static void _lru_put_user_value(const hashmap_lru *lru, u8 *internal, const void *value)
+{
+    if (lru->vsize == 0)
+    {
+        *(uintptr_t *)(internal + LRU_VALUE_OFFSET) = (uintptr_t)value;
+        return;
+    }
+
+    if (!value)
+    {
+        memset(internal + LRU_VALUE_OFFSET, 0, lru->vdsize);
+        internal[LRU_FLAG_OFFSET] = 0;
+        return;
+    }
+
+    memcpy(internal + LRU_VALUE_OFFSET, value, lru->vdsize);
+    internal[LRU_FLAG_OFFSET] = 1;
+}
+
+/**
+ * @brief hashmap元素移动后更新节点记录的下标
+ *
+ * @param map
+ * @param index
+ */
+static void _lru_on_move(hashmap *map, usize index)
+{
+    hashmap_lru *lru = (hashmap_lru *)map->udata;
+    lru->slots[_lru_node_of(hashmap_value_at(map, index))] = index;
+}
+
+static void _lru_unlink(hashmap_lru *lru, u32 id)
+{
+    u32 prev = lru->prev[id];
+    u32 next = lru->next[id];
+
+    if (prev == LRU_NIL)
+    {
+        lru->head = next;
+    }
+    else
+    {
+        lru->next[prev] = next;
+    }
+
+    if (next == LRU_NIL)
+    {
+        lru->tail = prev;
+    }
+    else
+    {
+        lru->prev[next] = prev;
+    }
+}
+
+static void _lru_push_front(hashmap_lru *lru, u32 id)
+{
+    lru->prev[id] = LRU_NIL;
+    lru->next[id] = lru->head;
+    if (lru->head == LRU_NIL)
+    {
+        lru->tail = id;
+    }
+    else
+    {
+        lru->prev[lru->head] = id;
+    }
+    lru->head = id;
+}
+
+static void _lru_touch(hashmap_lru *lru, u32 id)
+{
+    if (lru->head != id)
+    {
+        _lru_unlink(lru, id);
+        _lru_push_front(lru, id);
+    }
+}
+
+/**
+ * @brief 移除节点对应的元素并回收节点
+ *
+ * @param lru
+ * @param id
+ * @param evicted 是否由淘汰触发
+ */
+static void _lru_drop(hashmap_lru *lru, u32 id, b32 evicted)
+{
+    usize slot = lru->slots[id];
+    void *key = hashmap_key_at(lru->map, slot);
+    void *value = _lru_user_value(lru, hashmap_value_at(lru->map, slot));
+
+    if (evicted && lru->evict)
+    {
+        lru->evict(key, value, lru->evict_ctx);
+    }
+
+    if (lru->kfree)
+    {
+        lru->kfree(key);
+    }
+
+    if (lru->vfree)
+    {
+        lru->vfree(value);
+    }
+
+    lru->bytes -= lru->charges[id];
+    _lru_unlink(lru, id);
+    lru->next[id] = lru->free_head;
+    lru->free_head = id;
+    hashmap_remove_at(lru->map, slot);
+}
+
+void hashmap_lru_free(hashmap_lru *lru)
+{
+    if (!lru)
+    {
+        return;
+    }
+
+    if (lru->map && lru->slots)
+    {
+        for (u32 id = lru->head; id != LRU_NIL; id = lru->next[id])
+        {
+            usize slot = lru->slots[id];
+            if (lru->kfree)
+            {
+                lru->kfree(hashmap_key_at(lru->map, slot));
+            }
+
+            if (lru->vfree)
+            {
+                lru->vfree(_lru_user_value(lru, hashmap_value_at(lru->map, slot)));
+            }
+        }
+    }
+
+    hashmap_free(lru->map);
+    free2(lru->prev);
+    free2(lru->next);
+    free2(lru->slots);
+    free2(lru->charges);
+    free2(lru->scratch);
+    free(lru);
+}
+
+hashmap_lru *hashmap_lru_new(
+    usize max_entries,
+    usize max_bytes,
+    usize ksize,
+    usize vsize,
+    u64 seed,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    if (max_entries == 0 || max_entries >= LRU_NIL)
+    {
+        return NULL;
+    }
+
+    hashmap_lru *lru;
+    CMALLOC_CHECK(lru, 1, sizeof(hashmap_lru), );
+    lru->head = LRU_NIL;
+    lru->tail = LRU_NIL;
+    lru->free_head = 0;
+    lru->max_entries = max_entries;
+    lru->max_bytes = max_bytes;
+    *(usize *)&lru->vsize = vsize;
+    *(usize *)&lru->vdsize = vsize ? vsize : PTR_LEN;
+
+    // 预留足够容量, 元素个数达到上限也不会扩容
+    usize cap = (usize)(max_entries / LOAD_FACTOR) + 2;
+    lru->map = hashmap_new_with_cap(cap, ksize, LRU_VALUE_OFFSET + lru->vdsize, seed, hasher, cmp);
+    if (!lru->map)
+    {
+        hashmap_lru_free(lru);
+        return NULL;
+    }
+    hashmap_set_move_hook(lru->map, _lru_on_move, lru);
+
+    MALLOC_CHECK(lru->prev, sizeof(u32) * max_entries, hashmap_lru_free(lru));
+    MALLOC_CHECK(lru->next, sizeof(u32) * max_entries, hashmap_lru_free(lru));
+    MALLOC_CHECK(lru->slots, sizeof(usize) * max_entries, hashmap_lru_free(lru));
+    CMALLOC_CHECK(lru->charges, max_entries, sizeof(usize), hashmap_lru_free(lru));
+    CMALLOC_CHECK(lru->scratch, 1, LRU_VALUE_OFFSET + lru->vdsize, hashmap_lru_free(lru));
+    for (usize i = 0; i < max_entries; i++)
+    {
+        lru->next[i] = (u32)(i + 1 < max_entries ? i + 1 : LRU_NIL);
+    }
+    return lru;
+}
+
+void hashmap_lru_set_evict(hashmap_lru *lru, void (*evict)(void *key, void *value, void *ctx), void *ctx)
+{
+    lru->evict = evict;
+    lru->evict_ctx = ctx;
+}
+
+void hashmap_lru_set_kfree(hashmap_lru *lru, void (*kfree)(void *key))
+{
+    lru->kfree = kfree;
+}
+
+void hashmap_lru_set_vfree(hashmap_lru *lru, void (*vfree)(void *value))
+{
+    lru->vfree = vfree;
+}
+
+b32 hashmap_lru_evict(hashmap_lru *lru)
+{
+    if (!lru || lru->tail == LRU_NIL)
+    {
+        return 0;
+    }
+
+    _lru_drop(lru, lru->tail, 1);
+    return 1;
+}
+
+/**
+ * @brief 超出字节上限时淘汰, 不淘汰刚写入的元素
+ *
+ * @param lru
+ * @param keep
+ */
+static void _lru_trim_bytes(hashmap_lru *lru, u32 keep)
+{
+    while (lru->max_bytes > 0 && lru->bytes > lru->max_bytes && lru->tail != keep)
+    {
+        _lru_drop(lru, lru->tail, 1);
+    }
+}
+
+int hashmap_lru_set(hashmap_lru *lru, void *key, void *value, usize charge)
+{
+    if (!lru)
+    {
+        return 1;
+    }
+
+    u8 *internal = (u8 *)hashmap_get(lru->map, key);
+    if (internal)
+    {
+        u32 id = _lru_node_of(internal);
+        if (lru->vfree)
+        {
+            lru->vfree(_lru_user_value(lru, internal));
+        }
+        _lru_put_user_value(lru, internal, value);
+        lru->bytes = lru->bytes - lru->charges[id] + charge;
+        lru->charges[id] = charge;
+        _lru_touch(lru, id);
+        _lru_trim_bytes(lru, id);
+        return 0;
+    }
+
+    if (hashmap_count(lru->map) >= (size)lru->max_entries)
+    {
+        hashmap_lru_evict(lru);
+    }
+
+    u32 id = lru->free_head;
+    memcpy(lru->scratch, &id, sizeof(u32));
+    _lru_put_user_value(lru, lru->scratch, value);
+    if (hashmap_set(lru->map, key, lru->scratch))
+    {
+        return 1;
+    }
+
+    lru->free_head = lru->next[id];
+    lru->charges[id] = charge;
+    lru->bytes += charge;
+    _lru_push_front(lru, id);
+    _lru_trim_bytes(lru, id);
+    return 0;
+}
+
+void *hashmap_lru_get(hashmap_lru *lru, const void *key)
+{
+    if (!lru)
+    {
+        return NULL;
+    }
+
+    u8 *internal = (u8 *)hashmap_get(lru->map, key);
+    if (!internal)
+    {
+        return NULL;
+    }
+
+    _lru_touch(lru, _lru_node_of(internal));
+    return _lru_user_value(lru, internal);
+}
+
+void *hashmap_lru_peek(hashmap_lru *lru, const void *key)
+{
+    if (!lru)
+    {
+        return NULL;
+    }
+
+    u8 *internal = (u8 *)hashmap_get(lru->map, key);
+    return internal ? _lru_user_value(lru, internal) : NULL;
+}
+
+b32 hashmap_lru_exist(hashmap_lru *lru, const void *key)
+{
+    return lru ? hashmap_exist(lru->map, key) : 0;
+}
+
+int hashmap_lru_remove(hashmap_lru *lru, const void *key)
+{
+    if (!lru)
+    {
+        return 1;
+    }
+
+    u8 *internal = (u8 *)hashmap_get(lru->map, key);
+    if (internal)
+    {
+        _lru_drop(lru, _lru_node_of(internal), 0);
+    }
+    return 0;
+}
+
+size hashmap_lru_count(hashmap_lru *lru)
+{
+    return lru ? hashmap_count(lru->map) : 0;
+}
@@ -0,0 +1,156 @@
+#ifndef __CLRU_H
+#define __CLRU_H
+
+#include "chashmap.h"
+
+#define LRU_NIL UINT32_MAX
+
+// ============================================================================
+// hashmap_lru 有容量上限的LRU缓存
+// ============================================================================
+
+typedef struct hashmap_lru_header
+{
+    // value前存放节点编号, 节点记录元素所在的下标
+    hashmap *map;
+    // 节点数据, 按节点编号存放, 一次分配
+    u32 *prev;
+    u32 *next;
+    usize *slots;
+    usize *charges;
+    // head为最近使用, tail为最久未使用
+    u32 head;
+    u32 tail;
+    u32 free_head;
+    // 插入时拼接节点编号和value
+    u8 *scratch;
+    // 容量
+    usize max_entries;
+    usize max_bytes;
+    usize bytes;
+    const usize vsize;
+    const usize vdsize;
+    // 动态函数
+    void (*evict)(void *key, void *value, void *ctx);
+    void *evict_ctx;
+    void (*kfree)(void *key);
+    void (*vfree)(void *value);
+} hashmap_lru;
+
+/**
+ * @brief 创建LRU缓存
+ *
+ * @param max_entries 最大元素个数, 不能为0
+ * @param max_bytes 最大字节数, 按hashmap_lru_set传入的charge累计, 0为不限制
+ * @param ksize key大小
+ * @param vsize value大小
+ * @param seed 随机种子
+ * @param hasher hash函数
+ * @param cmp 比较函数
+ * @return 返回新创建的hashmap_lru指针, 内存分配失败或参数检查失败则返回NULL
+ */
+hashmap_lru *hashmap_lru_new(
+    usize max_entries,
+    usize max_bytes,
+    usize ksize,
+    usize vsize,
+    u64 seed,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize));
+
+/**
+ * @brief hashmap_lru释放, 剩余元素调用kfree和vfree
+ *
+ * @param lru
+ */
+void hashmap_lru_free(hashmap_lru *lru);
+
+/**
+ * @brief 设置淘汰回调, 在kfree和vfree之前调用
+ *
+ * @param lru
+ * @param evict
+ * @param ctx
+ */
+void hashmap_lru_set_evict(hashmap_lru *lru, void (*evict)(void *key, void *value, void *ctx), void *ctx);
+
+/**
+ * @brief 设置key释放函数, 元素被淘汰或移除时调用
+ *
+ * @param lru
+ * @param kfree
+ */
+void hashmap_lru_set_kfree(hashmap_lru *lru, void (*kfree)(void *key));
+
+/**
+ * @brief 设置value释放函数, 元素被淘汰、移除或覆盖时调用
+ *
+ * @param lru
+ * @param vfree
+ */
+void hashmap_lru_set_vfree(hashmap_lru *lru, void (*vfree)(void *value));
+
+/**
+ * @brief 插入或更新key val并设为最近使用, 超出容量时淘汰最久未使用的元素
+ *
+ * @param lru
+ * @param key
+ * @param value
+ * @param charge 元素占用的字节数, 用于max_bytes
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_lru_set(hashmap_lru *lru, void *key, void *value, usize charge);
+
+/**
+ * @brief 查找key并设为最近使用
+ *
+ * @param lru
+ * @param key
+ * @return 查找到返回val所在指针 否则返回NULL
+ */
+void *hashmap_lru_get(hashmap_lru *lru, const void *key);
+
+/**
+ * @brief 查找key, 不改变使用顺序
+ *
+ * @param lru
+ * @param key
+ * @return 查找到返回val所在指针 否则返回NULL
+ */
+void *hashmap_lru_peek(hashmap_lru *lru, const void *key);
+
+/**
+ * @brief 查找key是否存在, 不改变使用顺序
+ *
+ * @param lru
+ * @param key
+ * @return 存在返回1 否则返回0
+ */
+b32 hashmap_lru_exist(hashmap_lru *lru, const void *key);
+
+/**
+ * @brief 移除元素
+ *
+ * @param lru
+ * @param key
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_lru_remove(hashmap_lru *lru, const void *key);
+
+/**
+ * @brief 淘汰最久未使用的元素
+ *
+ * @param lru
+ * @return 淘汰了元素返回1 为空返回0
+ */
+b32 hashmap_lru_evict(hashmap_lru *lru);
+
+/**
+ * @brief 元素个数
+ *
+ * @param lru
+ * @return 返回元素个数
+ */
+size hashmap_lru_count(hashmap_lru *lru);
+
+#endif // __CLRU_H
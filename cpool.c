@@ -0,0 +1,555 @@
+#include "cpool.h"
+#include <stdlib.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#define CPOOL_DEQUE_MASK (CPOOL_DEQUE_CAP - 1)
+#define CPOOL_CACHE_LINE 64
+
+typedef struct cpool_loop
+{
+    usize grain;
+    void (*fn)(usize begin, usize end, void *ctx);
+    void *ctx;
+} cpool_loop;
+
+typedef struct cpool_task
+{
+    void (*fn)(void *arg);
+    void *arg;
+    cpool_group *group;
+    // 全局队列中的下一个任务
+    struct cpool_task *next;
+    // cpool_parallel_for拆分出的区间, loop为NULL时是普通任务
+    const cpool_loop *loop;
+    usize begin;
+    usize end;
+} cpool_task;
+
+#ifndef _WIN32
+
+typedef struct cpool_worker
+{
+    // top由窃取者修改, bottom由自己修改, 放在不同的缓存行
+    i64 top;
+    u8 pad0[CPOOL_CACHE_LINE - sizeof(i64)];
+    i64 bottom;
+    u8 pad1[CPOOL_CACHE_LINE - sizeof(i64)];
+    cpool_task *buf[CPOOL_DEQUE_CAP];
+    cpool *pool;
+    pthread_t tid;
+    b32 started;
+} cpool_worker;
+
+struct cpool_header
+{
+    usize threads;
+    usize nworkers;
+    cpool_worker *workers;
+    // 非工作线程提交的任务
+    cpool_task *inject_head;
+    cpool_task *inject_tail;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    // 已提交未被领取的任务数
+    usize queued;
+    // 在cond上休眠的线程数
+    usize sleepers;
+    int stop;
+};
+
+static _Thread_local cpool_worker *cpool_self;
+static _Thread_local u64 cpool_rng;
+
+static cpool *cpool_shared;
+static pthread_once_t cpool_shared_once = PTHREAD_ONCE_INIT;
+
+// ============================================================================
+// Chase-Lev deque
+// ============================================================================
+
+/**
+ * @brief 从底部压入, 只由所属线程调用
+ *
+ * @return int 成功 0，已满 1
+ */
+static int cpool_deque_push(cpool_worker *w, cpool_task *task)
+{
+    i64 b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED);
+    i64 t = __atomic_load_n(&w->top, __ATOMIC_ACQUIRE);
+    if (b - t >= CPOOL_DEQUE_CAP)
+    {
+        return 1;
+    }
+
+    __atomic_store_n(&w->buf[b & CPOOL_DEQUE_MASK], task, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/**
+ * @brief 从底部取出, 只由所属线程调用
+ */
+static cpool_task *cpool_deque_pop(cpool_worker *w)
+{
+    i64 b = __atomic_load_n(&w->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&w->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    i64 t = __atomic_load_n(&w->top, __ATOMIC_RELAXED);
+
+    cpool_task *task = NULL;
+    if (t <= b)
+    {
+        task = __atomic_load_n(&w->buf[b & CPOOL_DEQUE_MASK], __ATOMIC_RELAXED);
+        if (t != b)
+        {
+            return task;
+        }
+        // 最后一个任务, 与窃取者竞争top
+        if (!__atomic_compare_exchange_n(&w->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        {
+            task = NULL;
+        }
+    }
+    __atomic_store_n(&w->bottom, b + 1, __ATOMIC_RELAXED);
+    return task;
+}
+
+/**
+ * @brief 从顶部窃取, 任意线程调用
+ *
+ * @return cpool_task* 为空或竞争失败返回NULL
+ */
+static cpool_task *cpool_deque_steal(cpool_worker *w)
+{
+    i64 t = __atomic_load_n(&w->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    i64 b = __atomic_load_n(&w->bottom, __ATOMIC_ACQUIRE);
+    if (t >= b)
+    {
+        return NULL;
+    }
+
+    cpool_task *task = __atomic_load_n(&w->buf[t & CPOOL_DEQUE_MASK], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&w->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+    {
+        return NULL;
+    }
+    return task;
+}
+
+// ============================================================================
+// 调度
+// ============================================================================
+
+static inline cpool_worker *cpool_self_of(cpool *pool)
+{
+    return cpool_self && cpool_self->pool == pool ? cpool_self : NULL;
+}
+
+static inline u64 cpool_next_rng(void)
+{
+    if (!cpool_rng)
+    {
+        cpool_rng = (u64)(usize)&cpool_rng | 1;
+    }
+    cpool_rng ^= cpool_rng << 13;
+    cpool_rng ^= cpool_rng >> 7;
+    cpool_rng ^= cpool_rng << 17;
+    return cpool_rng;
+}
+
+static void cpool_wake(cpool *pool, b32 all)
+{
+    if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) == 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (all)
+    {
+        pthread_cond_broadcast(&pool->cond);
+    }
+    else
+    {
+        pthread_cond_signal(&pool->cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief 依次从自己的deque, 其他线程的deque(从随机位置开始), 全局队列领取任务
+ */
+static cpool_task *cpool_find(cpool *pool, cpool_worker *self)
+{
+    cpool_task *task = self ? cpool_deque_pop(self) : NULL;
+
+    usize n = pool->nworkers;
+    if (!task && n)
+    {
+        usize start = (usize)(cpool_next_rng() % n);
+        for (usize i = 0; i < n && !task; i++)
+        {
+            cpool_worker *victim = pool->workers + (start + i) % n;
+            if (victim != self)
+            {
+                task = cpool_deque_steal(victim);
+            }
+        }
+    }
+
+    if (!task && __atomic_load_n(&pool->inject_head, __ATOMIC_ACQUIRE))
+    {
+        pthread_mutex_lock(&pool->lock);
+        task = pool->inject_head;
+        if (task)
+        {
+            __atomic_store_n(&pool->inject_head, task->next, __ATOMIC_RELAXED);
+            if (!pool->inject_head)
+            {
+                pool->inject_tail = NULL;
+            }
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    if (task)
+    {
+        __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+    }
+    return task;
+}
+
+/**
+ * @brief 领取任务, 找不到时让出CPU后重试
+ */
+static cpool_task *cpool_find_spin(cpool *pool, cpool_worker *self)
+{
+    for (int i = 0; i < CPOOL_SPIN; i++)
+    {
+        cpool_task *task = cpool_find(pool, self);
+        if (task || __atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0)
+        {
+            return task;
+        }
+        // 有任务但竞争失败或还没有放入队列
+        sched_yield();
+    }
+    return NULL;
+}
+
+/**
+ * @brief 没有待领取的任务时休眠, pending不为NULL时还需要*pending不为0
+ */
+static void cpool_sleep(cpool *pool, const usize *pending)
+{
+    pthread_mutex_lock(&pool->lock);
+    __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+    while (!pool->stop &&
+           __atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0 &&
+           (!pending || __atomic_load_n(pending, __ATOMIC_SEQ_CST)))
+    {
+        pthread_cond_wait(&pool->cond, &pool->lock);
+    }
+    __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void cpool_range_run(cpool_group *g, const cpool_loop *loop, usize begin, usize end);
+
+static void cpool_exec(cpool_task *task)
+{
+    cpool_group *g = task->group;
+    cpool *pool = g->pool;
+    if (task->loop)
+    {
+        cpool_range_run(g, task->loop, task->begin, task->end);
+    }
+    else
+    {
+        task->fn(task->arg);
+    }
+    free(task);
+
+    // 计数为0后g可能已经失效
+    if (__atomic_sub_fetch(&g->pending, 1, __ATOMIC_SEQ_CST) == 0)
+    {
+        cpool_wake(pool, 1);
+    }
+}
+
+/**
+ * @brief 提交已经计入g->pending的任务
+ */
+static void cpool_submit(cpool *pool, cpool_task *task)
+{
+    cpool_worker *self = cpool_self_of(pool);
+    __atomic_add_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+    if (self)
+    {
+        if (cpool_deque_push(self, task))
+        {
+            __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+            cpool_exec(task);
+            return;
+        }
+    }
+    else
+    {
+        task->next = NULL;
+        pthread_mutex_lock(&pool->lock);
+        if (pool->inject_tail)
+        {
+            pool->inject_tail->next = task;
+        }
+        else
+        {
+            __atomic_store_n(&pool->inject_head, task, __ATOMIC_RELEASE);
+        }
+        pool->inject_tail = task;
+        pthread_mutex_unlock(&pool->lock);
+    }
+    cpool_wake(pool, 0);
+}
+
+static void *cpool_worker_main(void *arg)
+{
+    cpool_worker *w = (cpool_worker *)arg;
+    cpool *pool = w->pool;
+    cpool_self = w;
+    for (;;)
+    {
+        cpool_task *task = cpool_find_spin(pool, w);
+        if (task)
+        {
+            cpool_exec(task);
+            continue;
+        }
+        if (__atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE))
+        {
+            break;
+        }
+        cpool_sleep(pool, NULL);
+    }
+    return NULL;
+}
+
+cpool *cpool_new(usize threads)
+{
+    if (threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (usize)cpus : 1;
+    }
+
+    cpool *pool = (cpool *)calloc(1, sizeof(cpool));
+    if (!pool)
+    {
+        return NULL;
+    }
+    pool->threads = threads;
+    pool->nworkers = threads - 1;
+    if (pool->nworkers)
+    {
+        pool->workers = (cpool_worker *)calloc(pool->nworkers, sizeof(cpool_worker));
+        if (!pool->workers)
+        {
+            free(pool);
+            return NULL;
+        }
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+
+    // 创建失败的工作线程deque一直为空, 不影响窃取
+    for (usize i = 0; i < pool->nworkers; i++)
+    {
+        cpool_worker *w = pool->workers + i;
+        w->pool = pool;
+        w->started = pthread_create(&w->tid, NULL, cpool_worker_main, w) == 0;
+    }
+    return pool;
+}
+
+void cpool_free(cpool *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    __atomic_store_n(&pool->stop, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (usize i = 0; i < pool->nworkers; i++)
+    {
+        if (pool->workers[i].started)
+        {
+            pthread_join(pool->workers[i].tid, NULL);
+        }
+    }
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    free2(pool->workers);
+    free(pool);
+}
+
+static void cpool_shared_init(void)
+{
+    cpool_shared = cpool_new(0);
+}
+
+cpool *cpool_global(void)
+{
+    pthread_once(&cpool_shared_once, cpool_shared_init);
+    return cpool_shared;
+}
+
+void cpool_wait(cpool_group *g)
+{
+    cpool *pool = g->pool;
+    if (!pool)
+    {
+        return;
+    }
+
+    cpool_worker *self = cpool_self_of(pool);
+    while (__atomic_load_n(&g->pending, __ATOMIC_SEQ_CST))
+    {
+        cpool_task *task = cpool_find_spin(pool, self);
+        if (task)
+        {
+            cpool_exec(task);
+            continue;
+        }
+        cpool_sleep(pool, &g->pending);
+    }
+}
+
+#else
+
+struct cpool_header
+{
+    usize threads;
+};
+
+cpool *cpool_new(usize threads)
+{
+    (void)threads;
+    cpool *pool = (cpool *)calloc(1, sizeof(cpool));
+    if (pool)
+    {
+        pool->threads = 1;
+    }
+    return pool;
+}
+
+void cpool_free(cpool *pool)
+{
+    free2(pool);
+}
+
+cpool *cpool_global(void)
+{
+    static struct cpool_header shared = {1};
+    return &shared;
+}
+
+void cpool_wait(cpool_group *g)
+{
+    (void)g;
+}
+
+#endif
+
+// ============================================================================
+// 任务组
+// ============================================================================
+
+usize cpool_threads(cpool *pool)
+{
+    if (!pool)
+    {
+        pool = cpool_global();
+    }
+    return pool ? pool->threads : 1;
+}
+
+void cpool_group_init(cpool_group *g, cpool *pool)
+{
+    g->pool = pool ? pool : cpool_global();
+    g->pending = 0;
+}
+
+void cpool_spawn(cpool_group *g, void (*fn)(void *arg), void *arg)
+{
+#ifndef _WIN32
+    cpool_task *task = g->pool ? (cpool_task *)malloc(sizeof(cpool_task)) : NULL;
+    if (task)
+    {
+        *task = (cpool_task){fn, arg, g, NULL, NULL, 0, 0};
+        __atomic_add_fetch(&g->pending, 1, __ATOMIC_SEQ_CST);
+        cpool_submit(g->pool, task);
+        return;
+    }
+#endif
+    fn(arg);
+}
+
+/**
+ * @brief 不断把后一半交给其他线程, 自己处理前一半
+ */
+static void cpool_range_run(cpool_group *g, const cpool_loop *loop, usize begin, usize end)
+{
+#ifndef _WIN32
+    while (g->pool && end - begin > loop->grain)
+    {
+        usize mid = begin + (end - begin) / 2;
+        cpool_task *task = (cpool_task *)malloc(sizeof(cpool_task));
+        if (!task)
+        {
+            break;
+        }
+        *task = (cpool_task){NULL, NULL, g, NULL, loop, mid, end};
+        __atomic_add_fetch(&g->pending, 1, __ATOMIC_SEQ_CST);
+        cpool_submit(g->pool, task);
+        end = mid;
+    }
+#else
+    (void)g;
+#endif
+    loop->fn(begin, end, loop->ctx);
+}
+
+void cpool_parallel_for(cpool *pool, usize begin, usize end, usize grain, void (*fn)(usize begin, usize end, void *ctx), void *ctx)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    cpool_group g;
+    cpool_group_init(&g, pool);
+    usize threads = cpool_threads(g.pool);
+    if (grain == 0)
+    {
+        grain = (end - begin) / (threads * CPOOL_GRAIN_SPLIT);
+        grain = grain ? grain : 1;
+    }
+    // 单线程时不拆分
+    if (threads < 2)
+    {
+        grain = end - begin;
+    }
+
+    cpool_loop loop = {grain, fn, ctx};
+    cpool_range_run(&g, &loop, begin, end);
+    cpool_wait(&g);
+}
@@ -0,0 +1,97 @@
+#ifndef __CPOOL_H
+#define __CPOOL_H
+
+#include "ctype.h"
+
+// 每个工作线程deque的容量, 满时新任务直接在提交的线程上执行
+#define CPOOL_DEQUE_CAP 1024
+// 找不到任务时让出CPU的次数, 之后休眠
+#define CPOOL_SPIN 32
+// cpool_parallel_for的grain为0时, 每个线程大约分到的块数
+#define CPOOL_GRAIN_SPLIT 8
+
+// ============================================================================
+// cpool 工作窃取线程池
+//
+// 每个工作线程有一个Chase-Lev deque, 自己从底部压入和取出, 其他线程从顶部窃取;
+// 非工作线程提交的任务放入全局队列. 等待任务组的线程会帮忙执行任务,
+// 任务中可以再提交任务并等待(fork/join)
+// ============================================================================
+
+typedef struct cpool_header cpool;
+
+typedef struct cpool_group
+{
+    cpool *pool;
+    // 已提交未完成的任务数
+    usize pending;
+} cpool_group;
+
+/**
+ * @brief 创建线程池
+ *
+ * @param threads 执行任务的线程数, 包括等待任务组的线程, 创建threads - 1个工作线程; 为0时使用CPU核数
+ * @return 返回新创建的cpool指针, 内存分配失败返回NULL; 工作线程创建失败时由已有线程执行任务
+ */
+cpool *cpool_new(usize threads);
+
+/**
+ * @brief 释放线程池, 需要已经等待所有任务组
+ *
+ * @param pool
+ */
+void cpool_free(cpool *pool);
+
+/**
+ * @brief 进程共享的线程池, 第一次调用时按CPU核数创建, 不需要释放
+ *
+ * @return cpool* 创建失败返回NULL
+ */
+cpool *cpool_global(void);
+
+/**
+ * @brief 执行任务的线程数
+ *
+ * @param pool 为NULL时为cpool_global
+ * @return usize
+ */
+usize cpool_threads(cpool *pool);
+
+/**
+ * @brief 初始化任务组
+ *
+ * @param g
+ * @param pool 为NULL时为cpool_global
+ */
+void cpool_group_init(cpool_group *g, cpool *pool);
+
+/**
+ * @brief 提交任务到任务组, 内存分配失败或deque已满时直接执行
+ *
+ * @param g
+ * @param fn
+ * @param arg
+ */
+void cpool_spawn(cpool_group *g, void (*fn)(void *arg), void *arg);
+
+/**
+ * @brief 等待任务组的任务全部完成, 等待期间执行线程池中的任务
+ *
+ * @param g
+ */
+void cpool_wait(cpool_group *g);
+
+/**
+ * @brief 并行执行[begin, end), 区间不断对半拆分, 后一半交给其他线程窃取, 直到不超过grain,
+ * 返回时所有区间都已执行
+ *
+ * @param pool 为NULL时为cpool_global
+ * @param begin
+ * @param end
+ * @param grain 每次调用fn的最大区间长度, 为0时按线程数自动选择
+ * @param fn 处理[begin, end)
+ * @param ctx
+ */
+void cpool_parallel_for(cpool *pool, usize begin, usize end, usize grain, void (*fn)(usize begin, usize end, void *ctx), void *ctx);
+
+#endif // __CPOOL_H
@@ -1,7 +1,10 @@
 #include "cstring.h"
 
-void copy(u8 *dst, u8 *src, size len);
-inline void copy(u8 *dst, u8 *src, size len)
+#ifndef CEXTLIB_AMALGAMATION
+extern inline void string_push_char(string *s, char c);
+#endif
+
+static inline void copy(u8 *dst, u8 *src, size len)
 {
     if (len == 0)
     {
@@ -13,9 +16,7 @@ inline void copy(u8 *dst, u8 *src, size len)
     memcpy(dst, src, len);
 }
 
-b32 u8s_eq(u8 *u1, u8 *u2, size len);
-
-inline b32 u8s_eq(u8 *u1, u8 *u2, size len)
+static inline b32 u8s_eq(u8 *u1, u8 *u2, size len)
 {
     for (size i = 0; i < len; i++)
     {
@@ -167,25 +168,14 @@ void string_push(string *s, u8 *data, size len)
     size new_len = s->len + len;
     if (s->cap <= new_len)
     {
-        string_cap_expansion(s, new_len - s->cap + 1);
+        size grow = s->cap > 16 ? s->cap : 16;
+        string_cap_expansion(s, grow > new_len - s->cap + 1 ? grow : new_len - s->cap + 1);
     }
     copy(s->buf + s->len, data, len);
     s->buf[new_len] = '\0';
     s->len = new_len;
 }
 
-void string_push_char(string *s, char c)
-{
-    size new_len = s->len + 1;
-    if (s->cap <= new_len)
-    {
-        string_cap_expansion(s, new_len - s->cap + 1);
-    }
-    s->buf[s->len] = c;
-    s->buf[new_len] = '\0';
-    s->len = new_len;
-}
-
 void string_push_i64(string *s, i64 value)
 {
     size new_len = s->len + I64STR_SIZE;
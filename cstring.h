@@ -74,7 +74,19 @@ void string_push(string *s, u8 *data, size len);
  * @param string*
  * @param char
  */
-void string_push_char(string *s, char c);
+CEXTLIB_INLINE_HOT void string_push_char(string *s, char c)
+{
+    size new_len = s->len + 1;
+    if (s->cap <= new_len)
+    {
+        // 按容量倍增, 避免逐字符追加时每次都重新分配
+        size grow = s->cap > 16 ? s->cap : 16;
+        string_cap_expansion(s, grow > new_len - s->cap + 1 ? grow : new_len - s->cap + 1);
+    }
+    s->buf[s->len] = c;
+    s->buf[new_len] = '\0';
+    s->len = new_len;
+}
 
 /*
  * @brief 向字符串末尾追加i64
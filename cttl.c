@@ -0,0 +1,519 @@
+#include "cttl.h"
+#include "cutils.h"
+#include <string.h>
+
+#define PTR_LEN          sizeof(uintptr_t)
+#define TTL_FLAG_OFFSET  4 // value是否为NULL
+#define TTL_VALUE_OFFSET 8 // 节点编号和flag之后是value
+#define TTL_NODES_CAP    16
+#define TTL_OVERFLOW     (TTL_WHEEL_LEVELS * TTL_WHEEL_SLOTS)
+#define TTL_SLOT_MASK    ((u64)TTL_WHEEL_SLOTS - 1)
+
+static inline u32 _ttl_node_of(const u8 *internal)
+{
+    u32 id;
+    memcpy(&id, internal, sizeof(u32));
+    return id;
+}
+
+static inline void *_ttl_user_value(const hashmap_ttl *ttl, u8 *internal)
+{
+    if (ttl->vsize == 0)
+    {
+        return (void *)(*(uintptr_t *)(internal + TTL_VALUE_OFFSET));
+    }
+
+    return internal[TTL_FLAG_OFFSET] ? internal + TTL_VALUE_OFFSET : NULL;
+}
+
+static void _ttl_put_user_value(const hashmap_ttl *ttl, u8 *internal, const void *value)
+{
+    if (ttl->vsize == 0)
+    {
+        *(uintptr_t *)(internal + TTL_VALUE_OFFSET) = (uintptr_t)value;
+        return;
+    }
+
+    if (!value)
+    {
+        memset(internal + TTL_VALUE_OFFSET, 0, ttl->vdsize);
+        internal[TTL_FLAG_OFFSET] = 0;
+        return;
+    }
+
+    memcpy(internal + TTL_VALUE_OFFSET, value, ttl->vdsize);
+    internal[TTL_FLAG_OFFSET] = 1;
+}
+
+/**
+ * @brief hashmap元素移动后更新节点记录的下标
+ *
+ * @param map
+ * @param index
+ */
+static void _ttl_on_move(hashmap *map, usize index)
+{
+    hashmap_ttl *ttl = (hashmap_ttl *)map->udata;
+    ttl->slots[_ttl_node_of(hashmap_value_at(map, index))] = index;
+}
+
+/**
+ * @brief 节点数组倍增, 新节点加入空闲链表
+ *
+ * @param ttl
+ * @return 成功返回0 失败返回非0
+ */
+static int _ttl_grow_nodes(hashmap_ttl *ttl)
+{
+    if (ttl->nodes_cap >= TTL_NIL / 2)
+    {
+        return 1;
+    }
+
+    u32 cap = ttl->nodes_cap ? ttl->nodes_cap * 2 : TTL_NODES_CAP;
+    u32 *prev = (u32 *)realloc(ttl->prev, sizeof(u32) * cap);
+    if (!prev)
+    {
+        return 1;
+    }
+    ttl->prev = prev;
+
+    u32 *next = (u32 *)realloc(ttl->next, sizeof(u32) * cap);
+    if (!next)
+    {
+        return 1;
+    }
+    ttl->next = next;
+
+    usize *slots = (usize *)realloc(ttl->slots, sizeof(usize) * cap);
+    if (!slots)
+    {
+        return 1;
+    }
+    ttl->slots = slots;
+
+    u64 *expires = (u64 *)realloc(ttl->expires, sizeof(u64) * cap);
+    if (!expires)
+    {
+        return 1;
+    }
+    ttl->expires = expires;
+
+    u16 *wheels = (u16 *)realloc(ttl->wheels, sizeof(u16) * cap);
+    if (!wheels)
+    {
+        return 1;
+    }
+    ttl->wheels = wheels;
+
+    for (u32 id = ttl->nodes_cap; id < cap; id++)
+    {
+        ttl->next[id] = id + 1 < cap ? id + 1 : ttl->free_head;
+    }
+    ttl->free_head = ttl->nodes_cap;
+    ttl->nodes_cap = cap;
+    return 0;
+}
+
+static void _ttl_list_push(hashmap_ttl *ttl, usize list, u32 id)
+{
+    u32 head = ttl->heads[list];
+    ttl->prev[id] = TTL_NIL;
+    ttl->next[id] = head;
+    if (head != TTL_NIL)
+    {
+        ttl->prev[head] = id;
+    }
+    ttl->heads[list] = id;
+    ttl->wheels[id] = (u16)list;
+    if (list < TTL_OVERFLOW)
+    {
+        ttl->occupied[list / TTL_WHEEL_SLOTS] |= 1ULL << (list % TTL_WHEEL_SLOTS);
+    }
+}
+
+static void _ttl_list_unlink(hashmap_ttl *ttl, u32 id)
+{
+    usize list = ttl->wheels[id];
+    u32 prev = ttl->prev[id];
+    u32 next = ttl->next[id];
+
+    if (prev == TTL_NIL)
+    {
+        ttl->heads[list] = next;
+        if (next == TTL_NIL && list < TTL_OVERFLOW)
+        {
+            ttl->occupied[list / TTL_WHEEL_SLOTS] &= ~(1ULL << (list % TTL_WHEEL_SLOTS));
+        }
+    }
+    else
+    {
+        ttl->next[prev] = next;
+    }
+
+    if (next != TTL_NIL)
+    {
+        ttl->prev[next] = prev;
+    }
+}
+
+/**
+ * @brief 按过期时间把节点放入时间轮
+ *
+ * 放在过期时间与current高位相同的最低一层, 层号越高粒度越粗,
+ * current到达该槽的起点时再下放到更低的层
+ *
+ * @param ttl
+ * @param id
+ */
+static void _ttl_place(hashmap_ttl *ttl, u32 id)
+{
+    u64 expire = ttl->expires[id] < ttl->current ? ttl->current : ttl->expires[id];
+    for (usize level = 0; level < TTL_WHEEL_LEVELS; level++)
+    {
+        usize shift = TTL_WHEEL_BITS * (level + 1);
+        if ((expire >> shift) == (ttl->current >> shift))
+        {
+            usize slot = (expire >> (TTL_WHEEL_BITS * level)) & TTL_SLOT_MASK;
+            _ttl_list_push(ttl, level * TTL_WHEEL_SLOTS + slot, id);
+            return;
+        }
+    }
+
+    _ttl_list_push(ttl, TTL_OVERFLOW, id);
+}
+
+/**
+ * @brief 把链表中的节点按current重新放入时间轮
+ *
+ * @param ttl
+ * @param list
+ */
+static void _ttl_cascade(hashmap_ttl *ttl, usize list)
+{
+    u32 id = ttl->heads[list];
+    ttl->heads[list] = TTL_NIL;
+    if (list < TTL_OVERFLOW)
+    {
+        ttl->occupied[list / TTL_WHEEL_SLOTS] &= ~(1ULL << (list % TTL_WHEEL_SLOTS));
+    }
+
+    while (id != TTL_NIL)
+    {
+        u32 next = ttl->next[id];
+        _ttl_place(ttl, id);
+        id = next;
+    }
+}
+
+/**
+ * @brief current到达高层槽的起点时, 把该槽的节点下放
+ *
+ * @param ttl
+ */
+static void _ttl_advance(hashmap_ttl *ttl)
+{
+    u64 t = ttl->current;
+    if ((t & ((1ULL << (TTL_WHEEL_BITS * TTL_WHEEL_LEVELS)) - 1)) == 0)
+    {
+        _ttl_cascade(ttl, TTL_OVERFLOW);
+    }
+
+    for (usize level = TTL_WHEEL_LEVELS - 1; level > 0; level--)
+    {
+        usize shift = TTL_WHEEL_BITS * level;
+        if ((t & ((1ULL << shift) - 1)) == 0)
+        {
+            _ttl_cascade(ttl, level * TTL_WHEEL_SLOTS + ((t >> shift) & TTL_SLOT_MASK));
+        }
+    }
+}
+
+/**
+ * @brief 移除节点对应的元素并回收节点
+ *
+ * @param ttl
+ * @param id
+ * @param expired 是否由过期触发
+ */
+static void _ttl_drop(hashmap_ttl *ttl, u32 id, b32 expired)
+{
+    usize slot = ttl->slots[id];
+    void *key = hashmap_key_at(ttl->map, slot);
+    void *value = _ttl_user_value(ttl, hashmap_value_at(ttl->map, slot));
+
+    if (expired && ttl->expire)
+    {
+        ttl->expire(key, value, ttl->expire_ctx);
+    }
+
+    if (ttl->kfree)
+    {
+        ttl->kfree(key);
+    }
+
+    if (ttl->vfree)
+    {
+        ttl->vfree(value);
+    }
+
+    _ttl_list_unlink(ttl, id);
+    ttl->next[id] = ttl->free_head;
+    ttl->free_head = id;
+    hashmap_remove_at(ttl->map, slot);
+}
+
+void hashmap_ttl_free(hashmap_ttl *ttl)
+{
+    if (!ttl)
+    {
+        return;
+    }
+
+    if (ttl->map && (ttl->kfree || ttl->vfree))
+    {
+        for (usize i = 0; i < ttl->map->cap; i++)
+        {
+            u8 *internal = hashmap_value_at(ttl->map, i);
+            if (!internal)
+            {
+                continue;
+            }
+
+            if (ttl->kfree)
+            {
+                ttl->kfree(hashmap_key_at(ttl->map, i));
+            }
+
+            if (ttl->vfree)
+            {
+                ttl->vfree(_ttl_user_value(ttl, internal));
+            }
+        }
+    }
+
+    hashmap_free(ttl->map);
+    free2(ttl->prev);
+    free2(ttl->next);
+    free2(ttl->slots);
+    free2(ttl->expires);
+    free2(ttl->wheels);
+    free2(ttl->scratch);
+    free(ttl);
+}
+
+hashmap_ttl *hashmap_ttl_new(
+    usize ksize,
+    usize vsize,
+    u64 now,
+    u64 seed,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    hashmap_ttl *ttl;
+    CMALLOC_CHECK(ttl, 1, sizeof(hashmap_ttl), );
+    ttl->free_head = TTL_NIL;
+    ttl->current = now;
+    memset(ttl->heads, 0xff, sizeof(ttl->heads));
+    *(usize *)&ttl->vsize = vsize;
+    *(usize *)&ttl->vdsize = vsize ? vsize : PTR_LEN;
+
+    ttl->map = hashmap_new(ksize, TTL_VALUE_OFFSET + ttl->vdsize, seed, hasher, cmp);
+    if (!ttl->map)
+    {
+        hashmap_ttl_free(ttl);
+        return NULL;
+    }
+    hashmap_set_move_hook(ttl->map, _ttl_on_move, ttl);
+
+    CMALLOC_CHECK(ttl->scratch, 1, TTL_VALUE_OFFSET + ttl->vdsize, hashmap_ttl_free(ttl));
+    if (_ttl_grow_nodes(ttl))
+    {
+        hashmap_ttl_free(ttl);
+        return NULL;
+    }
+    return ttl;
+}
+
+void hashmap_ttl_set_expire(hashmap_ttl *ttl, void (*expire)(void *key, void *value, void *ctx), void *ctx)
+{
+    ttl->expire = expire;
+    ttl->expire_ctx = ctx;
+}
+
+void hashmap_ttl_set_kfree(hashmap_ttl *ttl, void (*kfree)(void *key))
+{
+    ttl->kfree = kfree;
+}
+
+void hashmap_ttl_set_vfree(hashmap_ttl *ttl, void (*vfree)(void *value))
+{
+    ttl->vfree = vfree;
+}
+
+int hashmap_ttl_set(hashmap_ttl *ttl, void *key, void *value, u64 expire_at)
+{
+    if (!ttl)
+    {
+        return 1;
+    }
+
+    u8 *internal = (u8 *)hashmap_get(ttl->map, key);
+    if (internal)
+    {
+        u32 id = _ttl_node_of(internal);
+        if (ttl->vfree)
+        {
+            ttl->vfree(_ttl_user_value(ttl, internal));
+        }
+        _ttl_put_user_value(ttl, internal, value);
+        _ttl_list_unlink(ttl, id);
+        ttl->expires[id] = expire_at;
+        _ttl_place(ttl, id);
+        return 0;
+    }
+
+    if (ttl->free_head == TTL_NIL && _ttl_grow_nodes(ttl))
+    {
+        return 1;
+    }
+
+    u32 id = ttl->free_head;
+    memcpy(ttl->scratch, &id, sizeof(u32));
+    _ttl_put_user_value(ttl, ttl->scratch, value);
+    if (hashmap_set(ttl->map, key, ttl->scratch))
+    {
+        return 1;
+    }
+
+    ttl->free_head = ttl->next[id];
+    ttl->expires[id] = expire_at;
+    _ttl_place(ttl, id);
+    return 0;
+}
+
+int hashmap_ttl_touch(hashmap_ttl *ttl, const void *key, u64 expire_at)
+{
+    if (!ttl)
+    {
+        return 1;
+    }
+
+    u8 *internal = (u8 *)hashmap_get(ttl->map, key);
+    if (!internal)
+    {
+        return 1;
+    }
+
+    u32 id = _ttl_node_of(internal);
+    _ttl_list_unlink(ttl, id);
+    ttl->expires[id] = expire_at;
+    _ttl_place(ttl, id);
+    return 0;
+}
+
+/**
+ * @brief 查找未过期的元素, 已过期的元素直接移除
+ *
+ * @param ttl
+ * @param key
+ * @param now
+ * @return 返回hashmap中的value, 不存在或已过期返回NULL
+ */
+static u8 *_ttl_lookup(hashmap_ttl *ttl, const void *key, u64 now)
+{
+    if (!ttl)
+    {
+        return NULL;
+    }
+
+    u8 *internal = (u8 *)hashmap_get(ttl->map, key);
+    if (!internal)
+    {
+        return NULL;
+    }
+
+    // 过期时间早于已处理的时间时, 插入时被放进current所在的槽, 同样视为已过期
+    u32 id = _ttl_node_of(internal);
+    if (ttl->expires[id] <= now || ttl->expires[id] < ttl->current)
+    {
+        _ttl_drop(ttl, id, 1);
+        return NULL;
+    }
+    return internal;
+}
+
+void *hashmap_ttl_get(hashmap_ttl *ttl, const void *key, u64 now)
+{
+    u8 *internal = _ttl_lookup(ttl, key, now);
+    return internal ? _ttl_user_value(ttl, internal) : NULL;
+}
+
+b32 hashmap_ttl_exist(hashmap_ttl *ttl, const void *key, u64 now)
+{
+    return _ttl_lookup(ttl, key, now) != NULL;
+}
+
+int hashmap_ttl_remove(hashmap_ttl *ttl, const void *key)
+{
+    if (!ttl)
+    {
+        return 1;
+    }
+
+    u8 *internal = (u8 *)hashmap_get(ttl->map, key);
+    if (internal)
+    {
+        _ttl_drop(ttl, _ttl_node_of(internal), 0);
+    }
+    return 0;
+}
+
+usize hashmap_ttl_expire_until(hashmap_ttl *ttl, u64 now)
+{
+    usize expired = 0;
+    if (!ttl)
+    {
+        return expired;
+    }
+
+    while (ttl->current <= now)
+    {
+        if (hashmap_count(ttl->map) == 0)
+        {
+            // 时间轮为空, 直接跳到now之后
+            ttl->current = now + 1;
+            break;
+        }
+
+        u64 t = ttl->current;
+        if ((t & TTL_SLOT_MASK) == 0)
+        {
+            _ttl_advance(ttl);
+        }
+
+        // 第0层的槽中过期时间都等于t
+        usize slot = t & TTL_SLOT_MASK;
+        while (ttl->heads[slot] != TTL_NIL)
+        {
+            _ttl_drop(ttl, ttl->heads[slot], 1);
+            expired++;
+        }
+
+        // 跳过第0层的空槽, 最远到下一个高层槽的起点
+        u64 later = ttl->occupied[0] & ~((2ULL << slot) - 1);
+        u64 next = later ? (t & ~TTL_SLOT_MASK) + __builtin_ctzll(later) : (t | TTL_SLOT_MASK) + 1;
+        if (next > now)
+        {
+            ttl->current = now + 1;
+            break;
+        }
+        ttl->current = next;
+    }
+    return expired;
+}
+
+size hashmap_ttl_count(hashmap_ttl *ttl)
+{
+    return ttl ? hashmap_count(ttl->map) : 0;
+}
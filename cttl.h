@@ -0,0 +1,162 @@
+#ifndef __CTTL_H
+#define __CTTL_H
+
+#include "chashmap.h"
+
+#define TTL_NIL          UINT32_MAX
+#define TTL_WHEEL_BITS   6
+#define TTL_WHEEL_SLOTS  (1 << TTL_WHEEL_BITS)
+#define TTL_WHEEL_LEVELS 4
+
+// ============================================================================
+// hashmap_ttl 按过期时间淘汰的hashmap, 时间轮管理过期时间
+// ============================================================================
+
+typedef struct hashmap_ttl_header
+{
+    // value前存放节点编号, 节点记录元素所在的下标
+    hashmap *map;
+    // 节点数据, 按节点编号存放, 容量不足时倍增
+    u32 *prev;
+    u32 *next;
+    usize *slots;
+    u64 *expires;
+    // 节点所在的时间轮链表
+    u16 *wheels;
+    u32 nodes_cap;
+    u32 free_head;
+    // 插入时拼接节点编号和value
+    u8 *scratch;
+    // 分层时间轮, 每层64个槽, 超出最高层范围的节点放在overflow
+    u32 heads[TTL_WHEEL_LEVELS * TTL_WHEEL_SLOTS + 1];
+    u64 occupied[TTL_WHEEL_LEVELS];
+    // 下一个未处理的时间
+    u64 current;
+    const usize vsize;
+    const usize vdsize;
+    // 动态函数
+    void (*expire)(void *key, void *value, void *ctx);
+    void *expire_ctx;
+    void (*kfree)(void *key);
+    void (*vfree)(void *value);
+} hashmap_ttl;
+
+/**
+ * @brief 创建ttl hashmap
+ *
+ * @param ksize key大小
+ * @param vsize value大小
+ * @param now 当前时间, 时间单位由调用方决定
+ * @param seed 随机种子
+ * @param hasher hash函数
+ * @param cmp 比较函数
+ * @return 返回新创建的hashmap_ttl指针, 内存分配失败返回NULL
+ */
+hashmap_ttl *hashmap_ttl_new(
+    usize ksize,
+    usize vsize,
+    u64 now,
+    u64 seed,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize));
+
+/**
+ * @brief hashmap_ttl释放, 剩余元素调用kfree和vfree
+ *
+ * @param ttl
+ */
+void hashmap_ttl_free(hashmap_ttl *ttl);
+
+/**
+ * @brief 设置过期回调, 在kfree和vfree之前调用
+ *
+ * @param ttl
+ * @param expire
+ * @param ctx
+ */
+void hashmap_ttl_set_expire(hashmap_ttl *ttl, void (*expire)(void *key, void *value, void *ctx), void *ctx);
+
+/**
+ * @brief 设置key释放函数, 元素过期或移除时调用
+ *
+ * @param ttl
+ * @param kfree
+ */
+void hashmap_ttl_set_kfree(hashmap_ttl *ttl, void (*kfree)(void *key));
+
+/**
+ * @brief 设置value释放函数, 元素过期、移除或覆盖时调用
+ *
+ * @param ttl
+ * @param vfree
+ */
+void hashmap_ttl_set_vfree(hashmap_ttl *ttl, void (*vfree)(void *value));
+
+/**
+ * @brief 插入或更新key val, 时间到达expire_at时过期
+ *
+ * @param ttl
+ * @param key
+ * @param value
+ * @param expire_at 过期时间
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_ttl_set(hashmap_ttl *ttl, void *key, void *value, u64 expire_at);
+
+/**
+ * @brief 修改key的过期时间
+ *
+ * @param ttl
+ * @param key
+ * @param expire_at 过期时间
+ * @return 成功返回0 key不存在返回非0
+ */
+int hashmap_ttl_touch(hashmap_ttl *ttl, const void *key, u64 expire_at);
+
+/**
+ * @brief 查找key, 已过期(不晚于now, 或早于hashmap_ttl_expire_until已处理的时间)的元素视为不存在并移除
+ *
+ * @param ttl
+ * @param key
+ * @param now 当前时间
+ * @return 查找到返回val所在指针 否则返回NULL
+ */
+void *hashmap_ttl_get(hashmap_ttl *ttl, const void *key, u64 now);
+
+/**
+ * @brief 查找key是否存在, 已过期(不晚于now, 或早于hashmap_ttl_expire_until已处理的时间)的元素视为不存在并移除
+ *
+ * @param ttl
+ * @param key
+ * @param now 当前时间
+ * @return 存在返回1 否则返回0
+ */
+b32 hashmap_ttl_exist(hashmap_ttl *ttl, const void *key, u64 now);
+
+/**
+ * @brief 移除元素, 不调用过期回调
+ *
+ * @param ttl
+ * @param key
+ * @return 成功返回0 失败返回非0
+ */
+int hashmap_ttl_remove(hashmap_ttl *ttl, const void *key);
+
+/**
+ * @brief 移除过期时间不大于now的元素, 开销与过期元素个数成正比, 与容量无关
+ *
+ * @param ttl
+ * @param now 当前时间, 小于上次调用的时间时不处理
+ * @return 返回移除的元素个数
+ */
+usize hashmap_ttl_expire_until(hashmap_ttl *ttl, u64 now);
+
+/**
+ * @brief 元素个数, 包含已过期但还未移除的元素
+ *
+ * @param ttl
+ * @return 返回元素个数
+ */
+size hashmap_ttl_count(hashmap_ttl *ttl);
+
+#endif // __CTTL_H
@@ -32,4 +32,13 @@ typedef int32_t b32;
     if (ptr)       \
     free(ptr)
 
+// 热路径函数定义在头文件中以便跨文件内联
+// 默认为C99 inline定义, 外部定义由对应的.c文件用extern inline声明提供
+// 通过cextlib.h单头文件构建时为static inline
+#ifdef CEXTLIB_AMALGAMATION
+#define CEXTLIB_INLINE_HOT static inline
+#else
+#define CEXTLIB_INLINE_HOT inline
+#endif
+
 #endif // __CTYPE_H
\ No newline at end of file
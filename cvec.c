@@ -1,5 +1,25 @@
 #include "cvec.h"
-u32 vec_min_non_zero_cap(u32 vsize)
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(SYS_mremap)
+#define VEC_USE_MREMAP
+#ifndef MREMAP_MAYMOVE
+#define MREMAP_MAYMOVE 1
+#endif
+#define VEC_PAGE_SIZE 4096
+#endif
+
+#ifndef CEXTLIB_AMALGAMATION
+extern inline size vec_push(vec *h, void *v);
+extern inline void *vec_get(vec *h, size i);
+extern inline void vec_clear(vec *h);
+#endif
+
+usize vec_min_non_zero_cap(usize vsize)
 {
     if (vsize == 1)
     {
@@ -15,25 +35,31 @@ u32 vec_min_non_zero_cap(u32 vsize)
     }
 }
 
-vec *vec_create(u32 vsize, u32 len, u32 cap, void *bind_pp, void *memory)
+vec *vec_create(usize vsize, usize len, usize cap, void *bind_pp, void *memory)
 {
     vec *h = (vec *)malloc(sizeof(vec));
+    if (!h)
+    {
+        return NULL;
+    }
     h->len = len;
     h->cap = cap;
     // stackoverflow.com/questions/9691404/how-to-initialize-const-in-a-struct-in-c-with-malloc
-    *(u32 *)&h->vsize = vsize;
-    *(u32 *)&h->min_non_zero_cap = vec_min_non_zero_cap(vsize);
+    *(usize *)&h->vsize = vsize;
+    *(usize *)&h->min_non_zero_cap = vec_min_non_zero_cap(vsize);
     h->bind_pp = bind_pp;
     h->mem = memory;
+    *(usize *)&h->inline_cap = 0;
+    h->mem_kind = VEC_MEM_HEAP;
     return h;
 }
 
-vec *vec_new(u32 vsize)
+vec *vec_new(usize vsize)
 {
     return vec_create(vsize, 0, 0, NULL, NULL);
 }
 
-vec *vec_bind_new(u32 vsize, void *bind_pp)
+vec *vec_bind_new(usize vsize, void *bind_pp)
 {
     return vec_create(vsize, 0, 0, bind_pp, NULL);
 }
@@ -43,9 +69,7 @@ vec *vec_bind_new(u32 vsize, void *bind_pp)
  *
  * @param h
  */
-void vec_bind_pp_bind_mem(vec *h);
-
-inline void vec_bind_pp_bind_mem(vec *h)
+static inline void vec_bind_pp_bind_mem(vec *h)
 {
     if (h->bind_pp)
     {
@@ -59,67 +83,177 @@ void vec_set_bind_pp(vec *h, void *bind_pp)
     vec_bind_pp_bind_mem(h);
 }
 
-/**
- * @brief 替换为新内存并替换，然后返回旧内存
- *
- * @param h
- * @param cap
- * @return void*
- */
-void *vec_cap_replace_mem(vec *h, size cap);
-
-inline void *vec_cap_replace_mem(vec *h, size cap)
+vec *vec_small_bind_new(usize vsize, usize n, void *bind_pp)
 {
-    void *old_mem = h->mem;
+    if (vsize && n > ((usize)PTRDIFF_MAX - sizeof(vec)) / vsize)
+    {
+        return NULL;
+    }
 
-    h->cap = cap;
-    h->mem = malloc(h->vsize * h->cap);
+    // 头部和内联内存一次分配
+    vec *h = (vec *)malloc(sizeof(vec) + vsize * n);
+    if (!h)
+    {
+        return NULL;
+    }
+    h->len = 0;
+    h->cap = n;
+    *(usize *)&h->vsize = vsize;
+    *(usize *)&h->min_non_zero_cap = vec_min_non_zero_cap(vsize);
+    h->bind_pp = bind_pp;
+    h->mem = n ? h->inline_mem : NULL;
+    *(usize *)&h->inline_cap = n;
+    h->mem_kind = n ? VEC_MEM_INLINE : VEC_MEM_HEAP;
     vec_bind_pp_bind_mem(h);
-    return old_mem;
+    return h;
 }
 
-int vec_cap_expansion(vec *h, size cap)
+vec *vec_small_new(usize vsize, usize n)
+{
+    return vec_small_bind_new(vsize, n, NULL);
+}
+
+#ifdef VEC_USE_MREMAP
+static inline usize vec_page_round(usize bytes)
+{
+    return (bytes + VEC_PAGE_SIZE - 1) & ~(usize)(VEC_PAGE_SIZE - 1);
+}
+#endif
+
+/**
+ * @brief 释放数据区
+ *
+ * @param h
+ */
+static void vec_release_mem(vec *h)
 {
-    void *old_mem = vec_cap_replace_mem(h, cap);
-    if (!h->mem)
+    if (h->mem_kind == VEC_MEM_INLINE)
     {
-        h->mem = old_mem;
-        return 1;
+        h->mem = NULL;
+        h->mem_kind = VEC_MEM_HEAP;
+        return;
     }
-
-    // 检查旧内存是否有效
-    if (old_mem)
+#ifdef VEC_USE_MREMAP
+    if (h->mem && h->mem_kind == VEC_MEM_MAPPED)
     {
-        memcpy((u8 *)h->mem, (u8 *)old_mem, h->vsize * h->len);
-        // 释放旧内存
-        free(old_mem);
+        munmap(h->mem, vec_page_round(h->vsize * h->cap));
+        h->mem = NULL;
+        h->mem_kind = VEC_MEM_HEAP;
+        return;
     }
-
-    return 0;
+#endif
+    free2(h->mem);
+    h->mem = NULL;
 }
 
-int vec_cap_scaling(vec *h, size cap)
+/**
+ * @brief 重新分配数据区并重新绑定, 保留前min(len, cap)个元素
+ * 小数组使用realloc, 可以原地扩展; 超过VEC_MMAP_THRESHOLD后改用mmap匿名页,
+ * 之后的扩容和缩容通过mremap由内核重新映射页面, 不复制数据, 峰值内存约为1倍;
+ * 有内联内存时, cap不超过内联容量则使用内联内存, cap为内联容量
+ *
+ * @param h
+ * @param cap
+ * @return int 成功 0，失败 1
+ */
+static int vec_realloc_mem(vec *h, size cap)
 {
-    void *old_mem = vec_cap_replace_mem(h, cap);
-    if (!h->mem)
+    // 数据区字节数需要能用size表示, 下标计算不会溢出
+    if (cap < 0 || (h->vsize && (usize)cap > (usize)PTRDIFF_MAX / h->vsize))
     {
-        h->mem = old_mem;
         return 1;
     }
 
-    if (old_mem)
+    usize bytes = h->vsize * (usize)cap;
+    usize keep = h->len < (usize)cap ? h->len : (usize)cap;
+    void *mem = NULL;
+
+    if (h->inline_cap && (usize)cap <= h->inline_cap)
+    {
+        if (h->mem_kind != VEC_MEM_INLINE)
+        {
+            if (keep)
+            {
+                memcpy(h->inline_mem, h->mem, h->vsize * keep);
+            }
+            vec_release_mem(h);
+            h->mem = h->inline_mem;
+            h->mem_kind = VEC_MEM_INLINE;
+        }
+        cap = h->inline_cap;
+    }
+    else if (bytes == 0)
     {
-        memcpy((u8 *)h->mem, (u8 *)old_mem, h->vsize * h->cap);
-        // 释放旧内存
-        free(old_mem);
+        vec_release_mem(h);
+    }
+    else
+    {
+#ifdef VEC_USE_MREMAP
+        if (h->mem && h->mem_kind == VEC_MEM_MAPPED)
+        {
+            mem = (void *)syscall(SYS_mremap, h->mem, vec_page_round(h->vsize * h->cap), vec_page_round(bytes), MREMAP_MAYMOVE);
+            if (mem == MAP_FAILED)
+            {
+                return 1;
+            }
+        }
+        else if (bytes >= VEC_MMAP_THRESHOLD)
+        {
+            // 从堆内存转为匿名页只复制一次, 此时旧数据小于阈值, mmap失败时退回realloc
+            void *m = mmap(NULL, vec_page_round(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (m != MAP_FAILED)
+            {
+                if (h->mem)
+                {
+                    memcpy(m, h->mem, h->vsize * keep);
+                    vec_release_mem(h);
+                }
+                mem = m;
+                h->mem_kind = VEC_MEM_MAPPED;
+            }
+        }
+#endif
+        if (!mem && h->mem_kind == VEC_MEM_INLINE)
+        {
+            // 内联内存溢出, 转移到堆上
+            mem = malloc(bytes);
+            if (!mem)
+            {
+                return 1;
+            }
+            memcpy(mem, h->mem, h->vsize * keep);
+            h->mem_kind = VEC_MEM_HEAP;
+        }
+        else if (!mem)
+        {
+            mem = realloc(h->mem, bytes);
+            if (!mem)
+            {
+                return 1;
+            }
+        }
+        h->mem = mem;
     }
 
+    h->cap = cap;
+    h->len = keep;
+    vec_bind_pp_bind_mem(h);
     return 0;
 }
 
+int vec_cap_expansion(vec *h, size cap)
+{
+    return vec_realloc_mem(h, cap);
+}
+
+int vec_cap_scaling(vec *h, size cap)
+{
+    return vec_realloc_mem(h, cap);
+}
+
 int vec_resize(vec *h, size cap)
 {
-    if (cap < h->cap)
+    if (cap >= 0 && (usize)cap < h->cap)
     {
         return vec_cap_scaling(h, cap);
     }
@@ -127,17 +261,13 @@ int vec_resize(vec *h, size cap)
     return vec_cap_expansion(h, cap);
 }
 
-/**
- * @brief 计算新的cap
- *
- * @param new_len
- * @param cap
- * @param min_non_zero_cap
- * @return size
- */
 size vec_new_cap(size new_len, size cap, size min_non_zero_cap)
 {
     size new_cap = (new_len > min_non_zero_cap ? new_len : min_non_zero_cap);
+    if (cap > PTRDIFF_MAX / 2)
+    {
+        return PTRDIFF_MAX;
+    }
     if ((2 * cap) > new_cap)
     {
         new_cap = 2 * cap;
@@ -145,31 +275,14 @@ size vec_new_cap(size new_len, size cap, size min_non_zero_cap)
     return new_cap;
 }
 
-size vec_push(vec *h, void *v)
-{
-    size new_len = h->len + 1;
-    if (new_len > h->cap)
-    {
-        size new_cap = vec_new_cap(new_len, h->cap, h->min_non_zero_cap);
-        if (vec_resize(h, new_cap))
-        {
-            return -1;
-        };
-    }
-    memcpy((u8 *)h->mem + (h->vsize * h->len), v, h->vsize);
-    h->len = new_len;
-
-    return new_len - 1;
-}
-
 int vec_put(vec *h, void *v, size i)
 {
-    if (i > h->len)
+    if (i > (size)h->len)
     {
         return 1;
     }
 
-    size ri = i >= 0 ? i : h->len + i;
+    size ri = i >= 0 ? i : (size)h->len + i;
     if (ri < 0)
     {
         return 1;
@@ -181,57 +294,58 @@ int vec_put(vec *h, void *v, size i)
 
 int vec_insert(vec *h, void *v, size i)
 {
-    if (i > h->len)
+    if (i > (size)h->len)
     {
         return 1;
     }
 
-    if (i == h->len)
+    if (i == (size)h->len)
     {
-        vec_push(h, v);
-        return 0;
+        return vec_push(h, v) < 0;
     }
 
-    size ri = i >= 0 ? i : h->len + i;
+    size ri = i >= 0 ? i : (size)h->len + i;
     if (ri < 0)
     {
         return 1;
     }
 
-    size new_len = h->len + 1;
-    if (new_len > h->cap)
+    size new_len = (size)h->len + 1;
+    if ((usize)new_len > h->cap)
     {
         size new_cap = vec_new_cap(new_len, h->cap, h->min_non_zero_cap);
-        void *old_mem = vec_cap_replace_mem(h, new_cap - h->cap);
-        memcpy((u8 *)h->mem, (u8 *)old_mem, h->vsize * ri);
-        memcpy((u8 *)h->mem + (h->vsize * (ri + 1)), (u8 *)old_mem + (h->vsize * ri), h->vsize * (h->len - ri));
-        memcpy((u8 *)h->mem + (h->vsize * ri), v, h->vsize);
-        free((u8 *)old_mem);
-    }
-    else
-    {
-        memmove(
-            (u8 *)h->mem + ((ri + 1) * h->vsize),
-            (u8 *)h->mem + (ri * h->vsize),
-            (h->len - ri) * h->vsize);
-        memcpy((u8 *)h->mem + (ri * h->vsize), v, h->vsize);
+        if (vec_cap_expansion(h, new_cap))
+        {
+            return 1;
+        }
     }
 
+    memmove(
+        (u8 *)h->mem + ((ri + 1) * h->vsize),
+        (u8 *)h->mem + (ri * h->vsize),
+        (h->len - ri) * h->vsize);
+    memcpy((u8 *)h->mem + (ri * h->vsize), v, h->vsize);
+
     h->len = new_len;
     return 0;
 }
 
-vec *vec_from(u32 vsize, void *src, u32 len)
+vec *vec_from(usize vsize, void *src, usize len)
 {
-    if (!src)
+    if (!src || (vsize && len > (usize)PTRDIFF_MAX / vsize))
     {
         return NULL;
     }
 
     vec *h = vec_new(vsize);
+    if (!h)
+    {
+        return NULL;
+    }
     size new_cap = vec_new_cap(len, h->cap, h->min_non_zero_cap);
     if (vec_resize(h, new_cap))
     {
+        free(h);
         return NULL;
     }
 
@@ -241,22 +355,6 @@ vec *vec_from(u32 vsize, void *src, u32 len)
     return h;
 }
 
-void *vec_get(vec *h, size i)
-{
-    if (i > h->len)
-    {
-        return NULL;
-    }
-
-    size ri = i >= 0 ? i : h->len + i;
-    if (ri < 0)
-    {
-        return NULL;
-    }
-
-    return (u8 *)h->mem + (ri * h->vsize);
-}
-
 void vec_pop(vec *h)
 {
     if (h->len == 0)
@@ -270,12 +368,12 @@ void vec_pop(vec *h)
 
 int vec_remove(vec *h, size i)
 {
-    if (i >= h->len)
+    if (i >= (size)h->len)
     {
         return 1;
     }
 
-    size ri = i >= 0 ? i : h->len + i;
+    size ri = i >= 0 ? i : (size)h->len + i;
     if (ri < 0)
     {
         return 1;
@@ -289,11 +387,160 @@ int vec_remove(vec *h, size i)
     return 0;
 }
 
-inline void vec_clear(vec *h)
+int vec_swap_remove(vec *h, size i)
 {
-    if (!h)
-        return;
-    h->len = 0;
+    if (i >= (size)h->len)
+    {
+        return 1;
+    }
+
+    size ri = i >= 0 ? i : (size)h->len + i;
+    if (ri < 0)
+    {
+        return 1;
+    }
+
+    h->len--;
+    if ((usize)ri != h->len)
+    {
+        memcpy(
+            (u8 *)h->mem + (ri * h->vsize),
+            (u8 *)h->mem + (h->len * h->vsize),
+            h->vsize);
+    }
+    return 0;
+}
+
+int vec_remove_range(vec *h, usize start, usize end)
+{
+    if (start > end || end > h->len)
+    {
+        return 1;
+    }
+    if (start == end)
+    {
+        return 0;
+    }
+
+    memmove(
+        (u8 *)h->mem + (start * h->vsize),
+        (u8 *)h->mem + (end * h->vsize),
+        (h->len - end) * h->vsize);
+    h->len -= end - start;
+    return 0;
+}
+
+int vec_reserve(vec *h, usize additional)
+{
+    if (additional > (usize)PTRDIFF_MAX - h->len)
+    {
+        return 1;
+    }
+
+    size new_len = (size)(h->len + additional);
+    if ((usize)new_len <= h->cap)
+    {
+        return 0;
+    }
+
+    size new_cap = vec_new_cap(new_len, h->cap, h->min_non_zero_cap);
+    return vec_resize(h, new_cap);
+}
+
+/**
+ * @brief src是否指向h的元素
+ *
+ * @param h
+ * @param src
+ * @param off src的元素下标
+ * @return b32
+ */
+static b32 vec_src_offset(vec *h, const void *src, usize *off)
+{
+    const u8 *p = (const u8 *)src;
+    const u8 *mem = (const u8 *)h->mem;
+    if (!mem || p < mem || p >= mem + h->len * h->vsize)
+    {
+        return 0;
+    }
+
+    *off = (usize)(p - mem) / h->vsize;
+    return 1;
+}
+
+int vec_extend(vec *h, const void *src, usize n)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    if (!src)
+    {
+        return 1;
+    }
+
+    // 扩容后src失效, 先记下下标
+    usize off = 0;
+    b32 self = vec_src_offset(h, src, &off);
+    if (vec_reserve(h, n))
+    {
+        return 1;
+    }
+    if (self)
+    {
+        src = (u8 *)h->mem + off * h->vsize;
+    }
+
+    memcpy((u8 *)h->mem + (h->len * h->vsize), src, n * h->vsize);
+    h->len += n;
+    return 0;
+}
+
+int vec_insert_n(vec *h, size i, const void *src, usize n)
+{
+    if (i > (size)h->len)
+    {
+        return 1;
+    }
+
+    size ri = i >= 0 ? i : (size)h->len + i;
+    if (ri < 0)
+    {
+        return 1;
+    }
+    if (n == 0)
+    {
+        return 0;
+    }
+    if (!src)
+    {
+        return 1;
+    }
+
+    usize off = 0;
+    b32 self = vec_src_offset(h, src, &off);
+    if (vec_reserve(h, n))
+    {
+        return 1;
+    }
+
+    usize w = h->vsize;
+    u8 *mem = (u8 *)h->mem;
+    memmove(mem + ((ri + n) * w), mem + (ri * w), (h->len - ri) * w);
+    if (!self)
+    {
+        memcpy(mem + (ri * w), src, n * w);
+    }
+    else
+    {
+        // src在ri之前的部分没有移动, 之后的部分向后移动了n个元素
+        usize k = off < (usize)ri ? (usize)ri - off : 0;
+        k = k < n ? k : n;
+        memcpy(mem + (ri * w), mem + (off * w), k * w);
+        memcpy(mem + ((ri + k) * w), mem + ((off + k + n) * w), (n - k) * w);
+    }
+    h->len += n;
+    return 0;
 }
 
 void vec_free(vec *h)
@@ -302,7 +549,7 @@ void vec_free(vec *h)
     {
         *(u8 **)h->bind_pp = NULL;
     }
-    free(h->mem);
+    vec_release_mem(h);
     free(h);
     h = NULL;
 }
@@ -324,12 +571,21 @@ vec *vec_slice(vec *h, usize start, usize end)
         end++;
     }
 
-    size len = end - start;
-    size cap = len > h->min_non_zero_cap ? len : h->min_non_zero_cap;
+    usize len = end - start;
+    usize cap = len > h->min_non_zero_cap ? len : h->min_non_zero_cap;
     void *m = malloc(h->vsize * cap);
+    if (!m)
+    {
+        return NULL;
+    }
     memcpy(m, (u8 *)h->mem + (start * h->vsize), h->vsize * len);
 
-    return vec_create(h->vsize, len, cap, NULL, m);
+    vec *s = vec_create(h->vsize, len, cap, NULL, m);
+    if (!s)
+    {
+        free(m);
+    }
+    return s;
 }
 
 vec *vec_clone(vec *h)
@@ -339,8 +595,21 @@ vec *vec_clone(vec *h)
         return NULL;
     }
     void *m = malloc(h->vsize * h->cap);
-    memcpy(m, h->mem, h->vsize * h->len);
-    return vec_create(h->vsize, h->len, h->cap, NULL, m);
+    if (!m && h->cap)
+    {
+        return NULL;
+    }
+    if (h->len)
+    {
+        memcpy(m, h->mem, h->vsize * h->len);
+    }
+
+    vec *c = vec_create(h->vsize, h->len, h->cap, NULL, m);
+    if (!c)
+    {
+        free2(m);
+    }
+    return c;
 }
 
 size vec_find(vec *h, void *v, b32 (*func)(void *, void *))
@@ -350,9 +619,10 @@ size vec_find(vec *h, void *v, b32 (*func)(void *, void *))
         return -1;
     }
 
-    for (size i = 0; i < h->len; i++)
+    u8 *data = (u8 *)h->mem;
+    for (usize i = 0; i < h->len; i++)
     {
-        if (func(vec_get(h, i), v))
+        if (func(data + i * h->vsize, v))
         {
             return i;
         }
@@ -368,11 +638,12 @@ size vec_find_last(vec *h, void *v, b32 (*func)(void *, void *))
         return -1;
     }
 
-    for (size i = (h->len - 1); i > 0; i--)
+    u8 *data = (u8 *)h->mem;
+    for (usize i = h->len; i > 0; i--)
     {
-        if (func(vec_get(h, i), v))
+        if (func(data + (i - 1) * h->vsize, v))
         {
-            return i;
+            return i - 1;
         }
     }
 
@@ -386,49 +657,381 @@ b32 default_comparison(void *a, void *b, size vsize)
         return 0;
     }
 
-    for (int i = 0; i < vsize; i++)
+    return memcmp(a, b, vsize) == 0;
+}
+
+// ============================================================================
+// 元素查找, vsize为1/2/4/8/16时按16字节(SSE2)或32字节(AVX2, 运行时检测)一块比较
+// ============================================================================
+
+#define VEC_SCAN_FIRST 0
+#define VEC_SCAN_LAST  1
+#define VEC_SCAN_COUNT 2
+#define VEC_SCAN_ALL   3
+
+static inline b32 vec_elem_eq(const u8 *a, const u8 *b, usize vsize)
+{
+    switch (vsize)
+    {
+    case 1:
+        return *a == *b;
+    case 2:
+    {
+        u16 x, y;
+        memcpy(&x, a, 2);
+        memcpy(&y, b, 2);
+        return x == y;
+    }
+    case 4:
+    {
+        u32 x, y;
+        memcpy(&x, a, 4);
+        memcpy(&y, b, 4);
+        return x == y;
+    }
+    case 8:
+    {
+        u64 x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        return x == y;
+    }
+    default:
+        return memcmp(a, b, vsize) == 0;
+    }
+}
+
+/**
+ * @brief 逐个比较[start, end)中的元素
+ *
+ * @param data
+ * @param start
+ * @param end
+ * @param vsize
+ * @param v
+ * @param mode VEC_SCAN_*
+ * @param bitmap VEC_SCAN_ALL时设置相等元素对应的位
+ * @return size VEC_SCAN_FIRST/VEC_SCAN_LAST返回下标, 没有返回-1; 其余返回相等的个数
+ */
+static size vec_scan_scalar(const u8 *data, usize start, usize end, usize vsize, const u8 *v, int mode, u64 *bitmap)
+{
+    if (mode == VEC_SCAN_LAST)
     {
-        if (*((u8 *)a + i) != *((u8 *)b + i))
+        for (usize i = end; i > start; i--)
         {
-            return 0;
+            if (vec_elem_eq(data + (i - 1) * vsize, v, vsize))
+            {
+                return i - 1;
+            }
         }
+        return -1;
     }
 
-    return 1;
+    size count = 0;
+    for (usize i = start; i < end; i++)
+    {
+        if (!vec_elem_eq(data + i * vsize, v, vsize))
+        {
+            continue;
+        }
+        if (mode == VEC_SCAN_FIRST)
+        {
+            return i;
+        }
+        if (bitmap)
+        {
+            bitmap[i >> 6] |= (u64)1 << (i & 63);
+        }
+        count++;
+    }
+
+    return mode == VEC_SCAN_FIRST ? -1 : count;
 }
 
-size vec_find_default(vec *h, void *v)
+#if defined(__x86_64__) && defined(__GNUC__)
+#define VEC_SCAN_X86
+#include <immintrin.h>
+
+/**
+ * @brief 字节相等掩码转为元素相等掩码, 只保留每个元素第一个字节的位, 元素的所有字节都相等时为1,
+ * 比较指令的宽度小于vsize时需要合并
+ *
+ * @param m
+ * @param vsize 1/2/4/8/16
+ * @return u32
+ */
+static inline u32 vec_scan_fold(u32 m, usize vsize)
 {
-    if (!h || !v)
+    for (usize s = 1; s < vsize; s <<= 1)
     {
+        m &= m >> s;
+    }
+
+    switch (vsize)
+    {
+    case 2:
+        return m & 0x55555555u;
+    case 4:
+        return m & 0x11111111u;
+    case 8:
+        return m & 0x01010101u;
+    case 16:
+        return m & 0x00010001u;
+    default:
+        return m;
+    }
+}
+
+static inline __m128i vec_scan_cmp_sse2(__m128i x, __m128i needle, usize vsize)
+{
+    switch (vsize)
+    {
+    case 1:
+        return _mm_cmpeq_epi8(x, needle);
+    case 2:
+        return _mm_cmpeq_epi16(x, needle);
+    default:
+        return _mm_cmpeq_epi32(x, needle);
+    }
+}
+
+__attribute__((target("avx2"))) static inline __m256i vec_scan_cmp_avx2(__m256i x, __m256i needle, usize vsize)
+{
+    switch (vsize)
+    {
+    case 1:
+        return _mm256_cmpeq_epi8(x, needle);
+    case 2:
+        return _mm256_cmpeq_epi16(x, needle);
+    case 4:
+        return _mm256_cmpeq_epi32(x, needle);
+    default:
+        return _mm256_cmpeq_epi64(x, needle);
+    }
+}
+
+/**
+ * @brief 统计块内相等的元素, VEC_SCAN_ALL时同时设置bitmap
+ *
+ * @param m 元素相等掩码
+ * @param off 块的字节偏移
+ * @param vsize
+ * @param bitmap
+ * @return size
+ */
+static inline size vec_scan_bits(u32 m, usize off, usize vsize, u64 *bitmap)
+{
+    size count = __builtin_popcount(m);
+    while (bitmap && m)
+    {
+        usize i = (off + __builtin_ctz(m)) / vsize;
+        bitmap[i >> 6] |= (u64)1 << (i & 63);
+        m &= m - 1;
+    }
+    return count;
+}
+
+static size vec_scan_sse2(const u8 *data, usize len, usize vsize, const u8 *v, int mode, u64 *bitmap)
+{
+    u8 pattern[16];
+    for (usize i = 0; i < 16; i += vsize)
+    {
+        memcpy(pattern + i, v, vsize);
+    }
+    __m128i needle = _mm_loadu_si128((const __m128i *)pattern);
+    usize blocks = len * vsize / 16 * 16;
+
+    if (mode == VEC_SCAN_LAST)
+    {
+        size r = vec_scan_scalar(data, blocks / vsize, len, vsize, v, mode, NULL);
+        if (r >= 0)
+        {
+            return r;
+        }
+        for (usize off = blocks; off > 0; off -= 16)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(data + off - 16));
+            u32 m = vec_scan_fold((u32)_mm_movemask_epi8(vec_scan_cmp_sse2(x, needle, vsize)), vsize);
+            if (m)
+            {
+                return (off - 16 + 31 - __builtin_clz(m)) / vsize;
+            }
+        }
         return -1;
     }
 
-    for (size i = (h->len - 1); i > 0; i--)
+    size count = 0;
+    for (usize off = 0; off < blocks; off += 16)
     {
-        if (default_comparison(vec_get(h, i), v, h->vsize))
+        __m128i x = _mm_loadu_si128((const __m128i *)(data + off));
+        u32 m = vec_scan_fold((u32)_mm_movemask_epi8(vec_scan_cmp_sse2(x, needle, vsize)), vsize);
+        if (!m)
         {
-            return i;
+            continue;
         }
+        if (mode == VEC_SCAN_FIRST)
+        {
+            return (off + __builtin_ctz(m)) / vsize;
+        }
+        count += vec_scan_bits(m, off, vsize, bitmap);
     }
 
-    return -1;
+    size r = vec_scan_scalar(data, blocks / vsize, len, vsize, v, mode, bitmap);
+    return mode == VEC_SCAN_FIRST ? r : count + r;
 }
 
-size vec_find_default_last(vec *h, void *v)
+__attribute__((target("avx2"))) static size vec_scan_avx2(const u8 *data, usize len, usize vsize, const u8 *v, int mode, u64 *bitmap)
 {
-    if (!h || !v)
+    u8 pattern[32];
+    for (usize i = 0; i < 32; i += vsize)
+    {
+        memcpy(pattern + i, v, vsize);
+    }
+    __m256i needle = _mm256_loadu_si256((const __m256i *)pattern);
+    usize blocks = len * vsize / 32 * 32;
+
+    if (mode == VEC_SCAN_LAST)
     {
+        size r = vec_scan_scalar(data, blocks / vsize, len, vsize, v, mode, NULL);
+        if (r >= 0)
+        {
+            return r;
+        }
+        for (usize off = blocks; off > 0; off -= 32)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(data + off - 32));
+            u32 m = vec_scan_fold((u32)_mm256_movemask_epi8(vec_scan_cmp_avx2(x, needle, vsize)), vsize);
+            if (m)
+            {
+                return (off - 32 + 31 - __builtin_clz(m)) / vsize;
+            }
+        }
         return -1;
     }
 
-    for (size i = (h->len - 1); i > 0; i--)
+    size count = 0;
+    usize off = 0;
+    // 没有相等元素的块占多数, 每次检查4块
+    for (; off + 128 <= blocks; off += 128)
     {
-        if (default_comparison(vec_get(h, i), v, h->vsize))
+        __m256i e0 = vec_scan_cmp_avx2(_mm256_loadu_si256((const __m256i *)(data + off)), needle, vsize);
+        __m256i e1 = vec_scan_cmp_avx2(_mm256_loadu_si256((const __m256i *)(data + off + 32)), needle, vsize);
+        __m256i e2 = vec_scan_cmp_avx2(_mm256_loadu_si256((const __m256i *)(data + off + 64)), needle, vsize);
+        __m256i e3 = vec_scan_cmp_avx2(_mm256_loadu_si256((const __m256i *)(data + off + 96)), needle, vsize);
+        if (!_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(e0, e1), _mm256_or_si256(e2, e3))))
         {
-            return i;
+            continue;
+        }
+        u32 m[4] = {
+            vec_scan_fold((u32)_mm256_movemask_epi8(e0), vsize),
+            vec_scan_fold((u32)_mm256_movemask_epi8(e1), vsize),
+            vec_scan_fold((u32)_mm256_movemask_epi8(e2), vsize),
+            vec_scan_fold((u32)_mm256_movemask_epi8(e3), vsize),
+        };
+        for (int j = 0; j < 4; j++)
+        {
+            if (!m[j])
+            {
+                continue;
+            }
+            if (mode == VEC_SCAN_FIRST)
+            {
+                return (off + 32 * j + __builtin_ctz(m[j])) / vsize;
+            }
+            count += vec_scan_bits(m[j], off + 32 * j, vsize, bitmap);
         }
     }
+    for (; off < blocks; off += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(data + off));
+        u32 m = vec_scan_fold((u32)_mm256_movemask_epi8(vec_scan_cmp_avx2(x, needle, vsize)), vsize);
+        if (!m)
+        {
+            continue;
+        }
+        if (mode == VEC_SCAN_FIRST)
+        {
+            return (off + __builtin_ctz(m)) / vsize;
+        }
+        count += vec_scan_bits(m, off, vsize, bitmap);
+    }
 
-    return -1;
+    size r = vec_scan_scalar(data, blocks / vsize, len, vsize, v, mode, bitmap);
+    return mode == VEC_SCAN_FIRST ? r : count + r;
+}
+
+static inline b32 vec_cpu_avx2(void)
+{
+#if defined(__AVX2__)
+    return 1;
+#else
+    static int avx2 = -1;
+    if (avx2 < 0)
+    {
+        avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return avx2;
+#endif
+}
+#endif
+
+static size vec_find_scan(vec *h, const void *v, int mode, u64 *bitmap)
+{
+    if (h->len == 0)
+    {
+        return mode == VEC_SCAN_FIRST || mode == VEC_SCAN_LAST ? -1 : 0;
+    }
+
+#ifdef VEC_SCAN_X86
+    if (h->vsize <= 16 && (h->vsize & (h->vsize - 1)) == 0)
+    {
+        if (vec_cpu_avx2())
+        {
+            return vec_scan_avx2((const u8 *)h->mem, h->len, h->vsize, (const u8 *)v, mode, bitmap);
+        }
+        return vec_scan_sse2((const u8 *)h->mem, h->len, h->vsize, (const u8 *)v, mode, bitmap);
+    }
+#endif
+    return vec_scan_scalar((const u8 *)h->mem, 0, h->len, h->vsize, (const u8 *)v, mode, bitmap);
+}
+
+size vec_find_default(vec *h, void *v)
+{
+    if (!h || !v || h->vsize == 0)
+    {
+        return -1;
+    }
+
+    return vec_find_scan(h, v, VEC_SCAN_FIRST, NULL);
+}
+
+size vec_find_default_last(vec *h, void *v)
+{
+    if (!h || !v || h->vsize == 0)
+    {
+        return -1;
+    }
+
+    return vec_find_scan(h, v, VEC_SCAN_LAST, NULL);
+}
+
+size vec_count_eq(vec *h, void *v)
+{
+    if (!h || !v || h->vsize == 0)
+    {
+        return 0;
+    }
+
+    return vec_find_scan(h, v, VEC_SCAN_COUNT, NULL);
+}
+
+size vec_find_all(vec *h, void *v, u64 *bitmap)
+{
+    if (!h || !v || !bitmap || h->vsize == 0)
+    {
+        return 0;
+    }
+
+    memset(bitmap, 0, (h->len + 63) / 64 * sizeof(u64));
+    return vec_find_scan(h, v, VEC_SCAN_ALL, bitmap);
 }
@@ -27,15 +27,37 @@
     __typeof__(v) temp = (v);       \
     vec_find_default(h, &temp);     \
 })
+#define vec_find_default_last_v(h, v) ({ \
+    __typeof__(v) temp = (v);            \
+    vec_find_default_last(h, &temp);     \
+})
+#define vec_count_eq_v(h, v) ({ \
+    __typeof__(v) temp = (v);   \
+    vec_count_eq(h, &temp);     \
+})
+#define vec_small_new_bind(bind_p, n) vec_small_bind_new(sizeof(*bind_p), n, (void *)&bind_p)
+
+// 数据区超过该字节数时使用mmap匿名页, 之后通过mremap扩容, 不复制数据
+#define VEC_MMAP_THRESHOLD (1 << 20)
+
+// 数据区的分配方式
+#define VEC_MEM_HEAP   0
+#define VEC_MEM_MAPPED 1
+// 与头部一起分配的内联内存
+#define VEC_MEM_INLINE 2
 
 typedef struct vec_header
 {
-    u32 len;
-    u32 cap;
-    const u32 vsize;
-    const u32 min_non_zero_cap;
+    usize len;
+    usize cap;
+    const usize vsize;
+    const usize min_non_zero_cap;
     void *bind_pp;
     void *mem;
+    // 内联容量, vec_small_new创建时不为0
+    const usize inline_cap;
+    u8 mem_kind;
+    _Alignas(16) u8 inline_mem[];
 } vec;
 
 /**
@@ -43,7 +65,7 @@ typedef struct vec_header
  *
  * @param vsize
  */
-u32 vec_min_non_zero_cap(u32 vsize);
+usize vec_min_non_zero_cap(usize vsize);
 
 /**
  * @brief 创建一个空的 vec
@@ -52,10 +74,10 @@ u32 vec_min_non_zero_cap(u32 vsize);
  * @param len
  * @param cap
  * @param bind_pp 绑定数据区的指针的指针
- * @param memory 内存指针
+ * @param memory 内存指针, 需要由malloc分配
  * @return vec*
  */
-vec *vec_create(u32 vsize, u32 len, u32 cap, void *bind_pp, void *memory);
+vec *vec_create(usize vsize, usize len, usize cap, void *bind_pp, void *memory);
 
 /**
  * @brief 创建一个空的 vec
@@ -63,7 +85,7 @@ vec *vec_create(u32 vsize, u32 len, u32 cap, void *bind_pp, void *memory);
  * @param vsize 元素大小
  * @return vec*
  */
-vec *vec_new(u32 vsize);
+vec *vec_new(usize vsize);
 
 /**
  * @brief 创建一个空的 vec
@@ -72,7 +94,27 @@ vec *vec_new(u32 vsize);
  * @param bind_pp 绑定数据区的指针的指针
  * @return vec*
  */
-vec *vec_bind_new(u32 vsize, void *bind_pp);
+vec *vec_bind_new(usize vsize, void *bind_pp);
+
+/**
+ * @brief 创建带内联内存的 vec, 头部与n个元素一次分配, 超出n个元素后转移到堆上,
+ * 缩容到n个元素以内时回到内联内存
+ *
+ * @param vsize 元素大小
+ * @param n 内联容量
+ * @return vec*
+ */
+vec *vec_small_new(usize vsize, usize n);
+
+/**
+ * @brief 创建带内联内存的 vec, 并绑定数据区到指针
+ *
+ * @param vsize 元素大小
+ * @param n 内联容量
+ * @param bind_pp 绑定数据区的指针的指针
+ * @return vec*
+ */
+vec *vec_small_bind_new(usize vsize, usize n, void *bind_pp);
 
 /**
  * @brief 设置绑定 vec 内存到指针
@@ -87,12 +129,12 @@ void vec_set_bind_pp(vec *h, void *bind_pp);
  *
  * @param h
  * @param cap
- * @return int 成功 0，失败 1
+ * @return int 成功 0，失败 1, vsize * cap超出PTRDIFF_MAX时失败
  */
 int vec_cap_expansion(vec *h, size cap);
 
 /**
- * @brief 缩容
+ * @brief 缩容, len大于cap时截断
  *
  * @param h
  * @param cap
@@ -109,6 +151,16 @@ int vec_cap_scaling(vec *h, size cap);
  */
 int vec_resize(vec *h, size cap);
 
+/**
+ * @brief 计算新的cap, 翻倍溢出时为PTRDIFF_MAX, 由vec_resize检查
+ *
+ * @param new_len
+ * @param cap
+ * @param min_non_zero_cap
+ * @return size
+ */
+size vec_new_cap(size new_len, size cap, size min_non_zero_cap);
+
 /**
  * @brief 插入元素
  *
@@ -116,7 +168,22 @@ int vec_resize(vec *h, size cap);
  * @param v
  * @return usize 返回插入位置, 失败返回-1
  */
-size vec_push(vec *h, void *v);
+CEXTLIB_INLINE_HOT size vec_push(vec *h, void *v)
+{
+    size new_len = (size)h->len + 1;
+    if ((usize)new_len > h->cap)
+    {
+        size new_cap = vec_new_cap(new_len, h->cap, h->min_non_zero_cap);
+        if (vec_resize(h, new_cap))
+        {
+            return -1;
+        };
+    }
+    memcpy((u8 *)h->mem + (h->vsize * h->len), v, h->vsize);
+    h->len = new_len;
+
+    return new_len - 1;
+}
 
 /**
  * @brief 修改对应位置元素
@@ -146,7 +213,7 @@ int vec_insert(vec *h, void *v, size i);
  * @param len
  * @return vec*
  */
-vec *vec_from(u32 vsize, void *src, u32 len);
+vec *vec_from(usize vsize, void *src, usize len);
 
 /**
  * @brief 获取对应位置元素
@@ -155,7 +222,21 @@ vec *vec_from(u32 vsize, void *src, u32 len);
  * @param i
  * @return void*
  */
-void *vec_get(vec *h, size i);
+CEXTLIB_INLINE_HOT void *vec_get(vec *h, size i)
+{
+    if (i > (size)h->len)
+    {
+        return NULL;
+    }
+
+    size ri = i >= 0 ? i : (size)h->len + i;
+    if (ri < 0)
+    {
+        return NULL;
+    }
+
+    return (u8 *)h->mem + (ri * h->vsize);
+}
 
 /**
  * @brief 删除最后一个元素
@@ -173,13 +254,67 @@ void vec_pop(vec *h);
  */
 int vec_remove(vec *h, size i);
 
+/**
+ * @brief 删除对应位置元素, 用最后一个元素填补, 不保持顺序, O(1)
+ *
+ * @param h
+ * @param i
+ * @return int 成功0 失败1
+ */
+int vec_swap_remove(vec *h, size i);
+
+/**
+ * @brief 删除[start, end)的元素, 只移动一次后面的元素
+ *
+ * @param h
+ * @param start
+ * @param end
+ * @return int 成功0 失败1
+ */
+int vec_remove_range(vec *h, usize start, usize end);
+
+/**
+ * @brief 保证还能添加additional个元素而不重新分配, 按vec_new_cap的策略扩容
+ *
+ * @param h
+ * @param additional
+ * @return int 成功0 失败1
+ */
+int vec_reserve(vec *h, usize additional);
+
+/**
+ * @brief 在末尾添加n个元素, 最多重新分配一次
+ *
+ * @param h
+ * @param src n个元素, 可以指向h自身的元素
+ * @param n
+ * @return int 成功0 失败1
+ */
+int vec_extend(vec *h, const void *src, usize n);
+
+/**
+ * @brief 在i处插入n个元素, 最多重新分配一次, 后面的元素只移动一次
+ *
+ * @param h
+ * @param i 可以为负数, 为len时添加到末尾
+ * @param src n个元素, 可以指向h自身的元素
+ * @param n
+ * @return int 成功0 失败1
+ */
+int vec_insert_n(vec *h, size i, const void *src, usize n);
+
 /**
  * @brief 清空数组
  *
  * @param h
  * @return int
  */
-void vec_clear(vec *h);
+CEXTLIB_INLINE_HOT void vec_clear(vec *h)
+{
+    if (!h)
+        return;
+    h->len = 0;
+}
 
 /**
  * @brief 释放内存
@@ -237,11 +372,11 @@ size vec_find_last(vec *h, void *v, b32 (*func)(void *, void *));
 b32 default_comparison(void *a, void *b, size vsize);
 
 /**
- * @brief 默认查找函数
+ * @brief 默认查找函数, 按字节比较, vsize为1/2/4/8/16时使用SIMD
  *
  * @param h
  * @param v
- * @return size
+ * @return size 第一个相等元素的下标, 没有返回-1
  */
 size vec_find_default(vec *h, void *v);
 
@@ -250,8 +385,129 @@ size vec_find_default(vec *h, void *v);
  *
  * @param h
  * @param v
- * @return size
+ * @return size 最后一个相等元素的下标, 没有返回-1
  */
 size vec_find_default_last(vec *h, void *v);
 
+/**
+ * @brief 统计与v相等的元素个数
+ *
+ * @param h
+ * @param v
+ * @return size
+ */
+size vec_count_eq(vec *h, void *v);
+
+/**
+ * @brief 查找所有与v相等的元素
+ *
+ * @param h
+ * @param v
+ * @param bitmap 至少(len + 63) / 64个u64, 第i个元素相等时第i位为1
+ * @return size 相等的元素个数
+ */
+size vec_find_all(vec *h, void *v, u64 *bitmap);
+
+// ============================================================================
+// 类型化的 vec, 与 vec 共用同一个头部, 按T直接读写元素, 可以与通用函数混用
+//
+//     VEC_DEFINE(vec_int, int)
+//     vec *v = vec_int_new();
+//     vec_int_push(v, 1);
+//     int x = vec_int_at(v, 0);
+//
+// name_get/name_put/name_insert/name_remove/name_swap_remove的下标可以为负数, 越界时返回NULL或1,
+// name_at和name_pop不检查下标
+// ============================================================================
+
+#define VEC_DEFINE(name, T)                                                                                \
+    static inline vec *name##_new(void)                                                                    \
+    {                                                                                                      \
+        return vec_new(sizeof(T));                                                                         \
+    }                                                                                                      \
+    static inline vec *name##_small_new(usize n)                                                           \
+    {                                                                                                      \
+        return vec_small_new(sizeof(T), n);                                                                \
+    }                                                                                                      \
+    static inline T *name##_data(vec *h)                                                                   \
+    {                                                                                                      \
+        return (T *)h->mem;                                                                                \
+    }                                                                                                      \
+    static inline size name##_push(vec *h, T v)                                                            \
+    {                                                                                                      \
+        if (h->len == h->cap && vec_resize(h, vec_new_cap((size)h->len + 1, h->cap, h->min_non_zero_cap))) \
+        {                                                                                                  \
+            return -1;                                                                                     \
+        }                                                                                                  \
+        ((T *)h->mem)[h->len] = v;                                                                         \
+        return (size)h->len++;                                                                             \
+    }                                                                                                      \
+    static inline T *name##_get(vec *h, size i)                                                            \
+    {                                                                                                      \
+        usize ri = i >= 0 ? (usize)i : h->len + (usize)i;                                                  \
+        return ri < h->len ? (T *)h->mem + ri : NULL;                                                      \
+    }                                                                                                      \
+    static inline T name##_at(vec *h, usize i)                                                             \
+    {                                                                                                      \
+        return ((T *)h->mem)[i];                                                                           \
+    }                                                                                                      \
+    static inline int name##_put(vec *h, T v, size i)                                                      \
+    {                                                                                                      \
+        T *p = name##_get(h, i);                                                                           \
+        if (!p)                                                                                            \
+        {                                                                                                  \
+            return 1;                                                                                      \
+        }                                                                                                  \
+        *p = v;                                                                                            \
+        return 0;                                                                                          \
+    }                                                                                                      \
+    static inline T name##_pop(vec *h)                                                                     \
+    {                                                                                                      \
+        return ((T *)h->mem)[--h->len];                                                                    \
+    }                                                                                                      \
+    static inline int name##_insert(vec *h, T v, size i)                                                   \
+    {                                                                                                      \
+        usize ri = i >= 0 ? (usize)i : h->len + (usize)i;                                                  \
+        if (ri > h->len)                                                                                   \
+        {                                                                                                  \
+            return 1;                                                                                      \
+        }                                                                                                  \
+        if (h->len == h->cap && vec_resize(h, vec_new_cap((size)h->len + 1, h->cap, h->min_non_zero_cap))) \
+        {                                                                                                  \
+            return 1;                                                                                      \
+        }                                                                                                  \
+        T *data = (T *)h->mem;                                                                             \
+        memmove(data + ri + 1, data + ri, (h->len - ri) * sizeof(T));                                      \
+        data[ri] = v;                                                                                      \
+        h->len++;                                                                                          \
+        return 0;                                                                                          \
+    }                                                                                                      \
+    static inline int name##_remove(vec *h, size i)                                                        \
+    {                                                                                                      \
+        usize ri = i >= 0 ? (usize)i : h->len + (usize)i;                                                  \
+        if (ri >= h->len)                                                                                  \
+        {                                                                                                  \
+            return 1;                                                                                      \
+        }                                                                                                  \
+        T *data = (T *)h->mem;                                                                             \
+        h->len--;                                                                                          \
+        memmove(data + ri, data + ri + 1, (h->len - ri) * sizeof(T));                                      \
+        return 0;                                                                                          \
+    }                                                                                                      \
+    static inline int name##_swap_remove(vec *h, size i)                                                   \
+    {                                                                                                      \
+        usize ri = i >= 0 ? (usize)i : h->len + (usize)i;                                                  \
+        if (ri >= h->len)                                                                                  \
+        {                                                                                                  \
+            return 1;                                                                                      \
+        }                                                                                                  \
+        T *data = (T *)h->mem;                                                                             \
+        data[ri] = data[--h->len];                                                                         \
+        return 0;                                                                                          \
+    }                                                                                                      \
+    static inline int name##_extend(vec *h, const T *src, usize n)                                         \
+    {                                                                                                      \
+        return vec_extend(h, src, n);                                                                      \
+    }
+
 #endif // __CVEC_H
\ No newline at end of file
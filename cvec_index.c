@@ -0,0 +1,383 @@
+#include "cvec_index.h"
+#include "cutils.h"
+
+#define VEC_INDEX_VSIZE sizeof(u32) // value为key相同的元素个数
+
+/**
+ * @brief 取出元素下标对应的key, VEC_INDEX_PROBE为查找中的key
+ *
+ * @param idx
+ * @param ref
+ * @return key指针
+ */
+static inline const void *_vec_index_key(const vec_index *idx, u32 ref)
+{
+    if (ref == VEC_INDEX_PROBE)
+    {
+        return idx->probe;
+    }
+
+    const u8 *elem = (const u8 *)idx->v->mem + (usize)ref * idx->v->vsize;
+    return idx->key_of ? idx->key_of(elem, idx->key_ctx) : elem + idx->koffset;
+}
+
+static u64 _vec_index_hash(const void *key, void *ctx, u64 seed)
+{
+    const vec_index *idx = (const vec_index *)ctx;
+    u32 ref;
+    memcpy(&ref, key, sizeof(u32));
+    return idx->hasher(_vec_index_key(idx, ref), idx->ksize, seed);
+}
+
+static int _vec_index_cmp(const void *key1, const void *key2, void *ctx)
+{
+    const vec_index *idx = (const vec_index *)ctx;
+    u32 ref1, ref2;
+    memcpy(&ref1, key1, sizeof(u32));
+    memcpy(&ref2, key2, sizeof(u32));
+    return idx->cmp(_vec_index_key(idx, ref1), _vec_index_key(idx, ref2), idx->ksize);
+}
+
+/**
+ * @brief 下标放入8字节的对象再传给hashmap; 单头文件构建时hashmap按key类型分派的
+ * u64分支会被内联, 编译器会认为可能按8字节读取key
+ *
+ * @param ref
+ * @return 前4字节为ref的u64
+ */
+static inline u64 _vec_index_ref_key(u32 ref)
+{
+    u64 key = 0;
+    memcpy(&key, &ref, sizeof(u32));
+    return key;
+}
+
+/**
+ * @brief 元素加入索引, key重复时改为指向该元素, 并增加key相同的元素个数
+ *
+ * @param idx
+ * @param ref
+ * @return 成功返回0 失败返回非0
+ */
+static int _vec_index_add(vec_index *idx, u32 ref)
+{
+    b32 inserted;
+    u64 key = _vec_index_ref_key(ref);
+    u8 *value = (u8 *)hashmap_entry(idx->map, &key, &inserted);
+    if (!value)
+    {
+        return 1;
+    }
+
+    u32 count;
+    memcpy(&count, value, sizeof(u32));
+    count++;
+    memcpy(value, &count, sizeof(u32));
+    if (!inserted)
+    {
+        // key相同则hash相同, 直接改写保存的下标
+        size slot = hashmap_index_of(idx->map, &key);
+        memcpy(hashmap_key_at(idx->map, slot), &ref, sizeof(u32));
+    }
+    return 0;
+}
+
+/**
+ * @brief 元素移出索引, 还有key相同的元素时只减少个数,
+ * 索引指向的正是该元素时改为指向剩余元素中下标最大的一个
+ *
+ * @param idx
+ * @param ref
+ */
+static void _vec_index_del(vec_index *idx, u32 ref)
+{
+    u64 ref_key = _vec_index_ref_key(ref);
+    size slot = hashmap_index_of(idx->map, &ref_key);
+    if (slot < 0)
+    {
+        return;
+    }
+
+    u8 *value = (u8 *)hashmap_value_at(idx->map, slot);
+    u32 count;
+    memcpy(&count, value, sizeof(u32));
+    if (count <= 1)
+    {
+        hashmap_remove_at(idx->map, slot);
+        return;
+    }
+
+    count--;
+    memcpy(value, &count, sizeof(u32));
+    u8 *stored_key = hashmap_key_at(idx->map, slot);
+    u32 stored;
+    memcpy(&stored, stored_key, sizeof(u32));
+    if (stored != ref)
+    {
+        return;
+    }
+
+    // 只有删除重复key中被索引的元素时才需要扫描
+    const void *key = _vec_index_key(idx, ref);
+    for (u32 j = (u32)idx->v->len; j-- > 0;)
+    {
+        if (j != ref && idx->cmp(_vec_index_key(idx, j), key, idx->ksize) == 0)
+        {
+            memcpy(stored_key, &j, sizeof(u32));
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 不小于from的下标加上delta, key不变所以hash不变, 原地修改
+ *
+ * @param idx
+ * @param from
+ * @param delta
+ */
+static void _vec_index_shift(vec_index *idx, u32 from, int delta)
+{
+    hashmap *map = idx->map;
+    for (usize i = 0; i < map->cap; i++)
+    {
+        u8 *key = hashmap_key_at(map, i);
+        if (!key)
+        {
+            continue;
+        }
+
+        u32 ref;
+        memcpy(&ref, key, sizeof(u32));
+        if (ref >= from)
+        {
+            ref += delta;
+            memcpy(key, &ref, sizeof(u32));
+        }
+    }
+}
+
+void vec_index_free(vec_index *idx)
+{
+    if (!idx)
+    {
+        return;
+    }
+
+    hashmap_free(idx->map);
+    free(idx);
+}
+
+static vec_index *_vec_index_create(
+    vec *v,
+    u32 koffset,
+    u32 ksize,
+    const void *key_of(const void *, void *),
+    void *ctx,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    if (!v || ksize == 0 || v->len >= VEC_INDEX_PROBE)
+    {
+        return NULL;
+    }
+
+    vec_index *idx;
+    CMALLOC_CHECK(idx, 1, sizeof(vec_index), );
+    idx->v = v;
+    *(u32 *)&idx->koffset = koffset;
+    *(u32 *)&idx->ksize = ksize;
+    idx->key_of = key_of;
+    idx->key_ctx = ctx;
+    idx->hasher = hasher ? hasher : hashmap_siphash;
+    idx->cmp = cmp ? cmp : memcmp;
+    idx->map = hashmap_new_ctx(
+        INITIAL_BUCKETS, sizeof(u32), VEC_INDEX_VSIZE, hashmap_random_seed(), _vec_index_hash, _vec_index_cmp, idx);
+    if (!idx->map || vec_index_rebuild(idx))
+    {
+        vec_index_free(idx);
+        return NULL;
+    }
+    return idx;
+}
+
+vec_index *vec_index_new(
+    vec *v,
+    u32 koffset,
+    u32 ksize,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    if (!v || (usize)koffset + ksize > v->vsize)
+    {
+        return NULL;
+    }
+
+    return _vec_index_create(v, koffset, ksize, NULL, NULL, hasher, cmp);
+}
+
+vec_index *vec_index_new_with(
+    vec *v,
+    u32 ksize,
+    const void *key_of(const void *, void *),
+    void *ctx,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize))
+{
+    if (!key_of)
+    {
+        return NULL;
+    }
+
+    return _vec_index_create(v, 0, ksize, key_of, ctx, hasher, cmp);
+}
+
+int vec_index_rebuild(vec_index *idx)
+{
+    if (!idx || hashmap_clear(idx->map))
+    {
+        return 1;
+    }
+
+    for (u32 i = 0; i < idx->v->len; i++)
+    {
+        if (_vec_index_add(idx, i))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+size vec_index_push(vec_index *idx, void *v)
+{
+    if (!idx || idx->v->len >= VEC_INDEX_PROBE - 1)
+    {
+        return -1;
+    }
+
+    size i = vec_push(idx->v, v);
+    if (i < 0)
+    {
+        return -1;
+    }
+
+    if (_vec_index_add(idx, (u32)i))
+    {
+        vec_pop(idx->v);
+        return -1;
+    }
+    return i;
+}
+
+int vec_index_insert(vec_index *idx, void *v, size i)
+{
+    if (!idx)
+    {
+        return 1;
+    }
+
+    size ri = i >= 0 ? i : idx->v->len + i;
+    if (ri < 0 || ri > idx->v->len)
+    {
+        return 1;
+    }
+
+    if (ri == idx->v->len)
+    {
+        return vec_index_push(idx, v) < 0;
+    }
+
+    if (idx->v->len >= VEC_INDEX_PROBE - 1)
+    {
+        return 1;
+    }
+
+    _vec_index_shift(idx, (u32)ri, 1);
+    if (vec_insert(idx->v, v, ri))
+    {
+        _vec_index_shift(idx, (u32)ri + 1, -1);
+        return 1;
+    }
+    return _vec_index_add(idx, (u32)ri);
+}
+
+int vec_index_put(vec_index *idx, void *v, size i)
+{
+    if (!idx)
+    {
+        return 1;
+    }
+
+    size ri = i >= 0 ? i : idx->v->len + i;
+    if (ri < 0 || ri >= idx->v->len)
+    {
+        return 1;
+    }
+
+    // 修改前按旧key移出索引
+    _vec_index_del(idx, (u32)ri);
+    if (vec_put(idx->v, v, ri))
+    {
+        return 1;
+    }
+    return _vec_index_add(idx, (u32)ri);
+}
+
+int vec_index_remove(vec_index *idx, size i)
+{
+    if (!idx)
+    {
+        return 1;
+    }
+
+    size ri = i >= 0 ? i : idx->v->len + i;
+    if (ri < 0 || ri >= idx->v->len)
+    {
+        return 1;
+    }
+
+    _vec_index_del(idx, (u32)ri);
+    if (vec_remove(idx->v, ri))
+    {
+        return 1;
+    }
+
+    if (ri < idx->v->len)
+    {
+        _vec_index_shift(idx, (u32)ri + 1, -1);
+    }
+    return 0;
+}
+
+size vec_index_find(vec_index *idx, const void *key)
+{
+    if (!idx || !key)
+    {
+        return -1;
+    }
+
+    u32 ref = VEC_INDEX_PROBE;
+    u64 probe_key = _vec_index_ref_key(ref);
+    idx->probe = key;
+    size slot = hashmap_index_of(idx->map, &probe_key);
+    idx->probe = NULL;
+    if (slot < 0)
+    {
+        return -1;
+    }
+
+    memcpy(&ref, hashmap_key_at(idx->map, slot), sizeof(u32));
+    return ref;
+}
+
+void *vec_index_get(vec_index *idx, const void *key)
+{
+    size i = vec_index_find(idx, key);
+    return i < 0 ? NULL : vec_get(idx->v, i);
+}
+
+size vec_index_count(vec_index *idx)
+{
+    return idx ? hashmap_count(idx->map) : 0;
+}
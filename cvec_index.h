@@ -0,0 +1,147 @@
+#ifndef __CVEC_INDEX_H
+#define __CVEC_INDEX_H
+
+#include "chashmap.h"
+#include "cvec.h"
+
+// 查找时代表待查找key的元素下标
+#define VEC_INDEX_PROBE UINT32_MAX
+
+// ============================================================================
+// vec_index vec的二级索引, hashmap中只保存元素下标
+// ============================================================================
+
+typedef struct vec_index_header
+{
+    vec *v;
+    // key为u32元素下标, hash和比较时从元素中取出key
+    hashmap *map;
+    // key在元素中的偏移和大小
+    const u32 koffset;
+    const u32 ksize;
+    // 查找中的key, 对应下标VEC_INDEX_PROBE
+    const void *probe;
+    // 动态函数
+    const void *(*key_of)(const void *elem, void *ctx);
+    void *key_ctx;
+    u64 (*hasher)(const void *data, usize dsize, u64 seed);
+    int (*cmp)(const void *key1, const void *key2, usize ksize);
+} vec_index;
+
+/**
+ * @brief 创建索引, key为元素中[koffset, koffset + ksize)的字节, 并索引vec中已有的元素
+ *
+ * @param v 被索引的vec, 不负责释放
+ * @param koffset key在元素中的偏移
+ * @param ksize key大小
+ * @param hasher hash函数, NULL为默认
+ * @param cmp 比较函数, NULL为memcmp
+ * @return 返回新创建的vec_index指针, 内存分配失败或参数检查失败则返回NULL
+ */
+vec_index *vec_index_new(
+    vec *v,
+    u32 koffset,
+    u32 ksize,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize));
+
+/**
+ * @brief 创建索引, key由key_of从元素中取出
+ *
+ * @param v 被索引的vec, 不负责释放
+ * @param ksize key_of返回的key大小
+ * @param key_of 返回元素的key
+ * @param ctx 传给key_of的上下文
+ * @param hasher hash函数, NULL为默认
+ * @param cmp 比较函数, NULL为memcmp
+ * @return 返回新创建的vec_index指针, 内存分配失败或参数检查失败则返回NULL
+ */
+vec_index *vec_index_new_with(
+    vec *v,
+    u32 ksize,
+    const void *key_of(const void *, void *),
+    void *ctx,
+    u64 hasher(const void *, usize, u64),
+    int cmp(const void *, const void *, usize));
+
+/**
+ * @brief 释放索引, 不释放vec
+ *
+ * @param idx
+ */
+void vec_index_free(vec_index *idx);
+
+/**
+ * @brief 重新索引vec中的所有元素, 用于绕过索引直接修改vec之后
+ *
+ * @param idx
+ * @return 成功返回0 失败返回非0
+ */
+int vec_index_rebuild(vec_index *idx);
+
+/**
+ * @brief 插入元素到尾部并加入索引, key重复时索引指向新元素
+ *
+ * @param idx
+ * @param v
+ * @return 返回插入位置, 失败返回-1
+ */
+size vec_index_push(vec_index *idx, void *v);
+
+/**
+ * @brief 插入元素到指定位置, 之后元素在索引中的下标加1
+ *
+ * @param idx
+ * @param v
+ * @param i
+ * @return 成功0 失败1
+ */
+int vec_index_insert(vec_index *idx, void *v, size i);
+
+/**
+ * @brief 修改对应位置元素并更新索引, 旧key还有其他元素时索引指向其中下标最大的一个
+ *
+ * @param idx
+ * @param v
+ * @param i
+ * @return 成功0 失败1
+ */
+int vec_index_put(vec_index *idx, void *v, size i);
+
+/**
+ * @brief 删除对应位置元素, 之后元素在索引中的下标减1;
+ * 还有key相同的元素时索引指向其中下标最大的一个
+ *
+ * @param idx
+ * @param i
+ * @return 成功0 失败1
+ */
+int vec_index_remove(vec_index *idx, size i);
+
+/**
+ * @brief 按key查找元素下标
+ *
+ * @param idx
+ * @param key
+ * @return 查找到返回下标 否则返回-1
+ */
+size vec_index_find(vec_index *idx, const void *key);
+
+/**
+ * @brief 按key查找元素
+ *
+ * @param idx
+ * @param key
+ * @return 查找到返回元素指针 否则返回NULL
+ */
+void *vec_index_get(vec_index *idx, const void *key);
+
+/**
+ * @brief 索引中不同key的个数
+ *
+ * @param idx
+ * @return 返回元素个数
+ */
+size vec_index_count(vec_index *idx);
+
+#endif // __CVEC_INDEX_H
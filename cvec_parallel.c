@@ -0,0 +1,610 @@
+#include "cvec_parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define VEC_PARALLEL_LINE 64
+// vec_filter的位图每块占整数个缓存行
+#define VEC_FILTER_UNIT (VEC_PARALLEL_LINE * 8)
+
+#define VEC_OP_SUM 0
+#define VEC_OP_MIN 1
+#define VEC_OP_MAX 2
+
+// ============================================================================
+// 内置运算
+// ============================================================================
+
+// 归约使用4个累加器, 求和时额外的累加器从0开始, min/max从acc开始
+#define VEC_OP_DEFINE(NAME, T)                                                 \
+    void vec_op_sum_##NAME(void *acc, const void *x, void *ctx)                \
+    {                                                                          \
+        (void)ctx;                                                             \
+        *(T *)acc += *(const T *)x;                                            \
+    }                                                                          \
+    void vec_op_min_##NAME(void *acc, const void *x, void *ctx)                \
+    {                                                                          \
+        (void)ctx;                                                             \
+        if (*(const T *)x < *(T *)acc)                                         \
+        {                                                                      \
+            *(T *)acc = *(const T *)x;                                         \
+        }                                                                      \
+    }                                                                          \
+    void vec_op_max_##NAME(void *acc, const void *x, void *ctx)                \
+    {                                                                          \
+        (void)ctx;                                                             \
+        if (*(T *)acc < *(const T *)x)                                         \
+        {                                                                      \
+            *(T *)acc = *(const T *)x;                                         \
+        }                                                                      \
+    }                                                                          \
+    static void vec_reduce_##NAME(int kind, const void *in, usize n, void *acc) \
+    {                                                                          \
+        const T *p = (const T *)in;                                            \
+        T a0 = *(T *)acc;                                                      \
+        T a1 = kind == VEC_OP_SUM ? (T)0 : a0;                                 \
+        T a2 = a1, a3 = a1;                                                    \
+        usize i = 0;                                                           \
+        switch (kind)                                                          \
+        {                                                                      \
+        case VEC_OP_SUM:                                                       \
+            for (; i + 4 <= n; i += 4)                                         \
+            {                                                                  \
+                a0 += p[i];                                                    \
+                a1 += p[i + 1];                                                \
+                a2 += p[i + 2];                                                \
+                a3 += p[i + 3];                                                \
+            }                                                                  \
+            for (; i < n; i++)                                                 \
+            {                                                                  \
+                a0 += p[i];                                                    \
+            }                                                                  \
+            *(T *)acc = (a0 + a1) + (a2 + a3);                                 \
+            return;                                                            \
+        case VEC_OP_MIN:                                                       \
+            for (; i + 4 <= n; i += 4)                                         \
+            {                                                                  \
+                a0 = p[i] < a0 ? p[i] : a0;                                    \
+                a1 = p[i + 1] < a1 ? p[i + 1] : a1;                            \
+                a2 = p[i + 2] < a2 ? p[i + 2] : a2;                            \
+                a3 = p[i + 3] < a3 ? p[i + 3] : a3;                            \
+            }                                                                  \
+            for (; i < n; i++)                                                 \
+            {                                                                  \
+                a0 = p[i] < a0 ? p[i] : a0;                                    \
+            }                                                                  \
+            a0 = a1 < a0 ? a1 : a0;                                            \
+            a2 = a3 < a2 ? a3 : a2;                                            \
+            *(T *)acc = a2 < a0 ? a2 : a0;                                     \
+            return;                                                            \
+        default:                                                               \
+            for (; i + 4 <= n; i += 4)                                         \
+            {                                                                  \
+                a0 = a0 < p[i] ? p[i] : a0;                                    \
+                a1 = a1 < p[i + 1] ? p[i + 1] : a1;                            \
+                a2 = a2 < p[i + 2] ? p[i + 2] : a2;                            \
+                a3 = a3 < p[i + 3] ? p[i + 3] : a3;                            \
+            }                                                                  \
+            for (; i < n; i++)                                                 \
+            {                                                                  \
+                a0 = a0 < p[i] ? p[i] : a0;                                    \
+            }                                                                  \
+            a0 = a0 < a1 ? a1 : a0;                                            \
+            a2 = a2 < a3 ? a3 : a2;                                            \
+            *(T *)acc = a0 < a2 ? a2 : a0;                                     \
+        }                                                                      \
+    }                                                                          \
+    static void vec_scan_##NAME(int kind, const void *in, void *out, usize n, void *acc) \
+    {                                                                          \
+        const T *p = (const T *)in;                                            \
+        T *q = (T *)out;                                                       \
+        T a = *(T *)acc;                                                       \
+        switch (kind)                                                          \
+        {                                                                      \
+        case VEC_OP_SUM:                                                       \
+            for (usize i = 0; i < n; i++)                                      \
+            {                                                                  \
+                a += p[i];                                                     \
+                q[i] = a;                                                      \
+            }                                                                  \
+            break;                                                             \
+        case VEC_OP_MIN:                                                       \
+            for (usize i = 0; i < n; i++)                                      \
+            {                                                                  \
+                a = p[i] < a ? p[i] : a;                                       \
+                q[i] = a;                                                      \
+            }                                                                  \
+            break;                                                             \
+        default:                                                               \
+            for (usize i = 0; i < n; i++)                                      \
+            {                                                                  \
+                a = a < p[i] ? p[i] : a;                                       \
+                q[i] = a;                                                      \
+            }                                                                  \
+        }                                                                      \
+        *(T *)acc = a;                                                         \
+    }
+
+VEC_OP_DEFINE(i32, i32)
+VEC_OP_DEFINE(i64, i64)
+VEC_OP_DEFINE(u32, u32)
+VEC_OP_DEFINE(u64, u64)
+VEC_OP_DEFINE(f32, float)
+VEC_OP_DEFINE(f64, double)
+
+typedef struct vec_op_kernel
+{
+    vec_op op;
+    usize vsize;
+    int kind;
+    void (*reduce)(int kind, const void *in, usize n, void *acc);
+    void (*scan)(int kind, const void *in, void *out, usize n, void *acc);
+} vec_op_kernel;
+
+#define VEC_OP_KERNELS(NAME, T)                                                    \
+    {vec_op_sum_##NAME, sizeof(T), VEC_OP_SUM, vec_reduce_##NAME, vec_scan_##NAME}, \
+    {vec_op_min_##NAME, sizeof(T), VEC_OP_MIN, vec_reduce_##NAME, vec_scan_##NAME}, \
+    {vec_op_max_##NAME, sizeof(T), VEC_OP_MAX, vec_reduce_##NAME, vec_scan_##NAME},
+
+static const vec_op_kernel vec_op_kernels[] = {
+    VEC_OP_KERNELS(i32, i32)
+    VEC_OP_KERNELS(i64, i64)
+    VEC_OP_KERNELS(u32, u32)
+    VEC_OP_KERNELS(u64, u64)
+    VEC_OP_KERNELS(f32, float)
+    VEC_OP_KERNELS(f64, double)
+};
+
+static const vec_op_kernel *vec_op_kernel_of(vec_op op)
+{
+    for (usize i = 0; i < countof(vec_op_kernels); i++)
+    {
+        if (vec_op_kernels[i].op == op)
+        {
+            return vec_op_kernels + i;
+        }
+    }
+    return NULL;
+}
+
+// ============================================================================
+// 分块
+// ============================================================================
+
+typedef struct vec_chunks
+{
+    usize n;
+    usize count;
+    // 块的边界是unit个元素的倍数
+    usize unit;
+} vec_chunks;
+
+/**
+ * @brief 使unit个元素是64字节的倍数的最小unit
+ */
+static usize vec_line_unit(usize vsize)
+{
+    usize unit = 1;
+    while ((unit * vsize) % VEC_PARALLEL_LINE)
+    {
+        unit <<= 1;
+    }
+    return unit;
+}
+
+static void vec_chunks_init(vec_chunks *c, usize n, usize vsize, usize unit, cpool *pool)
+{
+    usize threads = cpool_threads(pool);
+    usize by_size = n / (VEC_PARALLEL_MIN_BYTES / vsize + 1);
+    usize by_unit = n / unit;
+    usize count = threads < 2 ? 1 : threads * CPOOL_GRAIN_SPLIT;
+    count = count < by_size ? count : by_size;
+    count = count < by_unit ? count : by_unit;
+
+    c->n = n;
+    c->count = count > 1 ? count : 1;
+    c->unit = unit;
+}
+
+static inline usize vec_chunk_bound(const vec_chunks *c, usize i)
+{
+    if (i >= c->count)
+    {
+        return c->n;
+    }
+    usize b = c->n / c->count * i + c->n % c->count * i / c->count;
+    return b / c->unit * c->unit;
+}
+
+/**
+ * @brief 每块一个缓存行对齐的部分结果
+ */
+typedef struct vec_partials
+{
+    u8 *slots;
+    usize stride;
+    void *raw;
+} vec_partials;
+
+static int vec_partials_new(vec_partials *p, usize count, usize vsize)
+{
+    p->stride = (vsize + VEC_PARALLEL_LINE - 1) / VEC_PARALLEL_LINE * VEC_PARALLEL_LINE;
+    p->raw = malloc(count * p->stride + VEC_PARALLEL_LINE);
+    if (!p->raw)
+    {
+        return 1;
+    }
+    p->slots = (u8 *)(((uptr)p->raw + VEC_PARALLEL_LINE - 1) & ~(uptr)(VEC_PARALLEL_LINE - 1));
+    return 0;
+}
+
+static inline u8 *vec_partial(const vec_partials *p, usize i)
+{
+    return p->slots + i * p->stride;
+}
+
+typedef struct vec_par_job
+{
+    vec_chunks chunks;
+    const u8 *in;
+    u8 *out;
+    usize w;
+    usize ow;
+    // map
+    void (*fn)(const void *in, void *out, usize n, void *ctx);
+    // filter
+    b32 (*pred)(const void *elem, void *ctx);
+    u64 *bitmap;
+    // reduce/scan
+    const void *identity;
+    vec_op op;
+    const vec_op_kernel *kernel;
+    void *ctx;
+    vec_partials partials;
+} vec_par_job;
+
+static void vec_par_run(vec_par_job *job, void (*fn)(usize begin, usize end, void *ctx), cpool *pool)
+{
+    if (job->chunks.n == 0)
+    {
+        return;
+    }
+    if (job->chunks.count == 1)
+    {
+        fn(0, 1, job);
+        return;
+    }
+    cpool_parallel_for(pool, 0, job->chunks.count, 1, fn, job);
+}
+
+/**
+ * @brief 保证dst能容纳n个元素
+ */
+static int vec_par_reserve(vec *dst, usize n)
+{
+    if (dst->cap >= n)
+    {
+        return 0;
+    }
+    return vec_resize(dst, (size)n);
+}
+
+// ============================================================================
+// map
+// ============================================================================
+
+static void vec_map_chunk(usize begin, usize end, void *arg)
+{
+    vec_par_job *job = (vec_par_job *)arg;
+    for (usize ci = begin; ci < end; ci++)
+    {
+        usize lo = vec_chunk_bound(&job->chunks, ci);
+        usize hi = vec_chunk_bound(&job->chunks, ci + 1);
+        if (hi > lo)
+        {
+            job->fn(job->in + lo * job->w, job->out + lo * job->ow, hi - lo, job->ctx);
+        }
+    }
+}
+
+int vec_map(vec *dst, vec *src, void (*fn)(const void *in, void *out, usize n, void *ctx), void *ctx, cpool *pool)
+{
+    if (!dst || !src || !fn || src->vsize == 0 || dst->vsize == 0 || (dst == src && dst->vsize != src->vsize))
+    {
+        return 1;
+    }
+
+    usize n = src->len;
+    if (vec_par_reserve(dst, n))
+    {
+        return 1;
+    }
+
+    vec_par_job job = {0};
+    usize unit = vec_line_unit(src->vsize);
+    usize ounit = vec_line_unit(dst->vsize);
+    vec_chunks_init(&job.chunks, n, src->vsize > dst->vsize ? src->vsize : dst->vsize, unit > ounit ? unit : ounit, pool);
+    job.in = (const u8 *)src->mem;
+    job.out = (u8 *)dst->mem;
+    job.w = src->vsize;
+    job.ow = dst->vsize;
+    job.fn = fn;
+    job.ctx = ctx;
+    vec_par_run(&job, vec_map_chunk, pool);
+
+    dst->len = n;
+    return 0;
+}
+
+// ============================================================================
+// filter
+// ============================================================================
+
+static void vec_filter_mark(usize begin, usize end, void *arg)
+{
+    vec_par_job *job = (vec_par_job *)arg;
+    for (usize ci = begin; ci < end; ci++)
+    {
+        usize lo = vec_chunk_bound(&job->chunks, ci);
+        usize hi = vec_chunk_bound(&job->chunks, ci + 1);
+        usize cnt = 0;
+        // lo是64的倍数, 按位图的字累加, 不按pred的结果分支
+        for (usize word = lo; word < hi; word += 64)
+        {
+            usize stop = hi - word < 64 ? hi - word : 64;
+            u64 bits = 0;
+            for (usize k = 0; k < stop; k++)
+            {
+                u64 keep = job->pred(job->in + (word + k) * job->w, job->ctx) != 0;
+                bits |= keep << k;
+                cnt += keep;
+            }
+            job->bitmap[word / 64] = bits;
+        }
+        *(usize *)vec_partial(&job->partials, ci) = cnt;
+    }
+}
+
+static void vec_filter_copy(usize begin, usize end, void *arg)
+{
+    vec_par_job *job = (vec_par_job *)arg;
+    usize w = job->w;
+    for (usize ci = begin; ci < end; ci++)
+    {
+        usize lo = vec_chunk_bound(&job->chunks, ci);
+        usize hi = vec_chunk_bound(&job->chunks, ci + 1);
+        u8 *out = job->out + *(usize *)vec_partial(&job->partials, ci) * w;
+        for (usize word = lo / 64; word * 64 < hi; word++)
+        {
+            u64 bits = job->bitmap[word];
+            const u8 *base = job->in + word * 64 * w;
+            // 常见的元素大小用定长复制, 编译为单条读写指令
+            switch (w)
+            {
+            case 4:
+                for (; bits; bits &= bits - 1, out += 4)
+                {
+                    memcpy(out, base + __builtin_ctzll(bits) * 4, 4);
+                }
+                break;
+            case 8:
+                for (; bits; bits &= bits - 1, out += 8)
+                {
+                    memcpy(out, base + __builtin_ctzll(bits) * 8, 8);
+                }
+                break;
+            default:
+                for (; bits; bits &= bits - 1, out += w)
+                {
+                    const u8 *p = base + __builtin_ctzll(bits) * w;
+                    if (p != out)
+                    {
+                        memcpy(out, p, w);
+                    }
+                }
+                break;
+            }
+        }
+    }
+}
+
+int vec_filter(vec *dst, vec *src, b32 (*pred)(const void *elem, void *ctx), void *ctx, cpool *pool)
+{
+    if (!dst || !src || !pred || src->vsize == 0 || dst->vsize != src->vsize)
+    {
+        return 1;
+    }
+
+    usize n = src->len;
+    vec_par_job job = {0};
+    vec_chunks_init(&job.chunks, n, src->vsize, VEC_FILTER_UNIT, pool);
+    job.in = (const u8 *)src->mem;
+    job.w = src->vsize;
+    job.pred = pred;
+    job.ctx = ctx;
+    job.bitmap = (u64 *)calloc(n / 64 + 1, sizeof(u64));
+    if (!job.bitmap || vec_partials_new(&job.partials, job.chunks.count, sizeof(usize)))
+    {
+        free2(job.bitmap);
+        return 1;
+    }
+    for (usize ci = 0; ci < job.chunks.count; ci++)
+    {
+        *(usize *)vec_partial(&job.partials, ci) = 0;
+    }
+
+    vec_par_run(&job, vec_filter_mark, pool);
+
+    // 每块的个数转为写入位置
+    usize total = 0;
+    for (usize ci = 0; ci < job.chunks.count; ci++)
+    {
+        usize *slot = (usize *)vec_partial(&job.partials, ci);
+        usize cnt = *slot;
+        *slot = total;
+        total += cnt;
+    }
+
+    int ret = 1;
+    if (vec_par_reserve(dst, total) == 0)
+    {
+        // src的内存可能随dst扩容变化
+        job.in = (const u8 *)src->mem;
+        job.out = (u8 *)dst->mem;
+        if (dst == src)
+        {
+            // 原地写入的位置不超过读取的位置, 按顺序执行
+            vec_filter_copy(0, job.chunks.count, &job);
+        }
+        else
+        {
+            vec_par_run(&job, vec_filter_copy, pool);
+        }
+        dst->len = total;
+        ret = 0;
+    }
+
+    free(job.bitmap);
+    free(job.partials.raw);
+    return ret;
+}
+
+// ============================================================================
+// reduce/scan
+// ============================================================================
+
+static void vec_reduce_range(const vec_par_job *job, const u8 *in, usize n, void *acc)
+{
+    if (job->kernel)
+    {
+        job->kernel->reduce(job->kernel->kind, in, n, acc);
+        return;
+    }
+    for (usize i = 0; i < n; i++)
+    {
+        job->op(acc, in + i * job->w, job->ctx);
+    }
+}
+
+static void vec_reduce_chunk(usize begin, usize end, void *arg)
+{
+    vec_par_job *job = (vec_par_job *)arg;
+    for (usize ci = begin; ci < end; ci++)
+    {
+        usize lo = vec_chunk_bound(&job->chunks, ci);
+        usize hi = vec_chunk_bound(&job->chunks, ci + 1);
+        vec_reduce_range(job, job->in + lo * job->w, hi - lo, vec_partial(&job->partials, ci));
+    }
+}
+
+/**
+ * @brief 每块从部分结果开始扫描
+ */
+static void vec_scan_chunk(usize begin, usize end, void *arg)
+{
+    vec_par_job *job = (vec_par_job *)arg;
+    usize w = job->w;
+    for (usize ci = begin; ci < end; ci++)
+    {
+        usize lo = vec_chunk_bound(&job->chunks, ci);
+        usize hi = vec_chunk_bound(&job->chunks, ci + 1);
+        u8 *acc = vec_partial(&job->partials, ci);
+        if (job->kernel)
+        {
+            job->kernel->scan(job->kernel->kind, job->in + lo * w, job->out + lo * w, hi - lo, acc);
+            continue;
+        }
+        for (usize i = lo; i < hi; i++)
+        {
+            job->op(acc, job->in + i * w, job->ctx);
+            memcpy(job->out + i * w, acc, w);
+        }
+    }
+}
+
+/**
+ * @brief 检查参数并分块, 部分结果初始化为identity, 多分配2个用于累加
+ */
+static int vec_reduce_job(vec_par_job *job, vec *h, const void *identity, vec_op op, void *ctx, cpool *pool)
+{
+    if (!h || !identity || !op || h->vsize == 0)
+    {
+        return 1;
+    }
+
+    job->kernel = vec_op_kernel_of(op);
+    if (job->kernel && job->kernel->vsize != h->vsize)
+    {
+        return 1;
+    }
+    vec_chunks_init(&job->chunks, h->len, h->vsize, vec_line_unit(h->vsize), pool);
+    job->in = (const u8 *)h->mem;
+    job->w = h->vsize;
+    job->identity = identity;
+    job->op = op;
+    job->ctx = ctx;
+    if (vec_partials_new(&job->partials, job->chunks.count + 2, h->vsize))
+    {
+        return 1;
+    }
+    for (usize ci = 0; ci < job->chunks.count; ci++)
+    {
+        memcpy(vec_partial(&job->partials, ci), identity, h->vsize);
+    }
+    return 0;
+}
+
+int vec_reduce(vec *h, void *out, const void *identity, vec_op op, void *ctx, cpool *pool)
+{
+    vec_par_job job = {0};
+    if (!out || vec_reduce_job(&job, h, identity, op, ctx, pool))
+    {
+        return 1;
+    }
+
+    vec_par_run(&job, vec_reduce_chunk, pool);
+    // 按块的顺序合并
+    u8 *acc = vec_partial(&job.partials, job.chunks.count);
+    memcpy(acc, identity, job.w);
+    for (usize ci = 0; ci < job.chunks.count; ci++)
+    {
+        job.op(acc, vec_partial(&job.partials, ci), ctx);
+    }
+    memcpy(out, acc, job.w);
+
+    free(job.partials.raw);
+    return 0;
+}
+
+int vec_scan(vec *dst, vec *src, const void *identity, vec_op op, void *ctx, cpool *pool)
+{
+    vec_par_job job = {0};
+    if (!dst || !src || dst->vsize != src->vsize || vec_par_reserve(dst, src->len) ||
+        vec_reduce_job(&job, src, identity, op, ctx, pool))
+    {
+        return 1;
+    }
+    job.in = (const u8 *)src->mem;
+    job.out = (u8 *)dst->mem;
+
+    usize count = job.chunks.count;
+    if (count > 1)
+    {
+        vec_par_run(&job, vec_reduce_chunk, pool);
+        // 部分结果转为前面所有块的结果
+        u8 *carry = vec_partial(&job.partials, count);
+        u8 *tmp = vec_partial(&job.partials, count + 1);
+        memcpy(carry, identity, job.w);
+        for (usize ci = 0; ci < count; ci++)
+        {
+            u8 *slot = vec_partial(&job.partials, ci);
+            memcpy(tmp, slot, job.w);
+            memcpy(slot, carry, job.w);
+            job.op(carry, tmp, ctx);
+        }
+    }
+    vec_par_run(&job, vec_scan_chunk, pool);
+
+    dst->len = src->len;
+    free(job.partials.raw);
+    return 0;
+}
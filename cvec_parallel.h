@@ -0,0 +1,89 @@
+#ifndef __CVEC_PARALLEL_H
+#define __CVEC_PARALLEL_H
+
+#include "cpool.h"
+#include "ctype.h"
+#include "cvec.h"
+
+// 每块至少处理的字节数, 元素总字节数不足两块时单线程
+#define VEC_PARALLEL_MIN_BYTES (64 * 1024)
+
+// ============================================================================
+// vec 并行 map/filter/reduce/scan
+//
+// 元素按块分给线程池, 块的边界在相对mem偏移64字节对齐的位置(mmap分配的大vec
+// 按页对齐), 不同线程的输出不共享缓存行; 每块的部分结果放在单独的缓存行.
+// pool为NULL时使用cpool_global
+// ============================================================================
+
+/**
+ * @brief reduce/scan的运算, acc = acc op x, 需要满足结合律
+ */
+typedef void (*vec_op)(void *acc, const void *x, void *ctx);
+
+// 内置的数值运算, 传给vec_reduce/vec_scan时使用类型化的循环, 不经过函数指针;
+// 浮点数求和的结果与按顺序相加可能有舍入差异
+#define VEC_OP_DECLARE(NAME, T)                              \
+    void vec_op_sum_##NAME(void *acc, const void *x, void *ctx); \
+    void vec_op_min_##NAME(void *acc, const void *x, void *ctx); \
+    void vec_op_max_##NAME(void *acc, const void *x, void *ctx);
+
+VEC_OP_DECLARE(i32, i32)
+VEC_OP_DECLARE(i64, i64)
+VEC_OP_DECLARE(u32, u32)
+VEC_OP_DECLARE(u64, u64)
+VEC_OP_DECLARE(f32, float)
+VEC_OP_DECLARE(f64, double)
+
+/**
+ * @brief dst[i] = fn(src[i]), fn每次处理连续的一段元素
+ *
+ * @param dst 长度设置为src的长度, vsize可以与src不同, 可以是src本身
+ * @param src
+ * @param fn 处理in开始的n个元素, 结果写到out
+ * @param ctx
+ * @param pool
+ * @return int 成功 0，失败 1
+ */
+int vec_map(vec *dst, vec *src, void (*fn)(const void *in, void *out, usize n, void *ctx), void *ctx, cpool *pool);
+
+/**
+ * @brief 保留pred为真的元素, 保持顺序; 每块先记录位图和个数, 前缀和得到写入位置后再复制
+ *
+ * @param dst vsize与src相同, 可以是src本身(复制阶段单线程)
+ * @param src
+ * @param pred
+ * @param ctx
+ * @param pool
+ * @return int 成功 0，失败 1
+ */
+int vec_filter(vec *dst, vec *src, b32 (*pred)(const void *elem, void *ctx), void *ctx, cpool *pool);
+
+/**
+ * @brief 归约, out = identity op h[0] op h[1] ...
+ *
+ * @param h
+ * @param out vsize字节
+ * @param identity op的单位元, 如求和时为0
+ * @param op 为vec_op_*时使用类型化的循环
+ * @param ctx
+ * @param pool
+ * @return int 成功 0，失败 1
+ */
+int vec_reduce(vec *h, void *out, const void *identity, vec_op op, void *ctx, cpool *pool);
+
+/**
+ * @brief 包含前缀, dst[i] = identity op src[0] op ... op src[i];
+ * 先归约每块, 按顺序累加块的结果, 再带着前面块的结果扫描每块
+ *
+ * @param dst vsize与src相同, 可以是src本身
+ * @param src
+ * @param identity
+ * @param op 为vec_op_*时使用类型化的循环
+ * @param ctx
+ * @param pool
+ * @return int 成功 0，失败 1
+ */
+int vec_scan(vec *dst, vec *src, const void *identity, vec_op op, void *ctx, cpool *pool);
+
+#endif // __CVEC_PARALLEL_H
@@ -0,0 +1,1352 @@
+#include "cvec_sort.h"
+#include "cpool.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 小于该长度使用插入排序
+#define VEC_SORT_INSERTION 24
+// 大于该长度使用ninther选择pivot
+#define VEC_SORT_NINTHER 128
+// partial insertion sort最多移动的元素个数
+#define VEC_SORT_PARTIAL_LIMIT 8
+// 不超过该大小的元素使用栈上的临时空间
+#define VEC_SORT_STACK_TMP 256
+// 交集中较大的一边超过较小一边的该倍数时使用倍增查找
+#define VEC_GALLOP_RATIO 32
+
+#define VEC_SORT_GENERIC 0
+#define VEC_SORT_U8      1
+#define VEC_SORT_U16     2
+#define VEC_SORT_U32     3
+#define VEC_SORT_U64     4
+
+typedef struct vec_sorter
+{
+    int kind;
+    usize w;
+    int (*cmp)(const void *a, const void *b);
+    // 保存pivot或插入排序中的元素
+    u8 *tmp;
+} vec_sorter;
+
+static inline b32 vec_sorter_generic_less(const vec_sorter *s, const u8 *a, const u8 *b)
+{
+    return s->cmp ? s->cmp(a, b) < 0 : memcmp(a, b, s->w) < 0;
+}
+
+static inline void vec_sort_swap_bytes(u8 *a, u8 *b, usize w)
+{
+    switch (w)
+    {
+    case 4:
+    {
+        u32 x, y;
+        memcpy(&x, a, 4);
+        memcpy(&y, b, 4);
+        memcpy(a, &y, 4);
+        memcpy(b, &x, 4);
+        return;
+    }
+    case 8:
+    {
+        u64 x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        memcpy(a, &y, 8);
+        memcpy(b, &x, 8);
+        return;
+    }
+    default:
+        for (; w >= 8; w -= 8, a += 8, b += 8)
+        {
+            u64 x, y;
+            memcpy(&x, a, 8);
+            memcpy(&y, b, 8);
+            memcpy(a, &y, 8);
+            memcpy(b, &x, 8);
+        }
+        for (; w > 0; w--, a++, b++)
+        {
+            u8 t = *a;
+            *a = *b;
+            *b = t;
+        }
+    }
+}
+
+// 类型化的元素操作, 按T直接比较和赋值
+#define VEC_SORT_T_AT(p, k)     ((p) + (k))
+#define VEC_SORT_T_BK(p, k)     ((p) - (k))
+#define VEC_SORT_T_DIST(a, b)   ((usize)((a) - (b)))
+#define VEC_SORT_T_LT(a, b)     (*(a) < *(b))
+#define VEC_SORT_T_MOVE(d, src) (*(d) = *(src))
+#define VEC_SORT_T_SWAP(a, b)          \
+    do                                 \
+    {                                  \
+        __typeof__(*(a)) _t = *(a);    \
+        *(a) = *(b);                   \
+        *(b) = _t;                     \
+    } while (0)
+#define VEC_SORT_T_TMP(T) \
+    T tmp_v;              \
+    T *tmp = &tmp_v
+
+// 通用的元素操作, 元素大小为s->w, 使用比较函数
+#define VEC_SORT_G_AT(p, k)     ((p) + (k) * s->w)
+#define VEC_SORT_G_BK(p, k)     ((p) - (k) * s->w)
+#define VEC_SORT_G_DIST(a, b)   ((usize)((a) - (b)) / s->w)
+#define VEC_SORT_G_LT(a, b)     vec_sorter_generic_less(s, a, b)
+#define VEC_SORT_G_MOVE(d, src) memcpy(d, src, s->w)
+#define VEC_SORT_G_SWAP(a, b)   vec_sort_swap_bytes(a, b, s->w)
+#define VEC_SORT_G_TMP(T) T *tmp = (T *)s->tmp
+
+// ============================================================================
+// pattern-defeating quicksort (Orson Peters), 以及归并用的merge path切分和归并
+// ============================================================================
+
+#define VEC_PDQSORT_DEFINE(NAME, T, AT, BK, DIST, LT, MOVE, SWAP, TMP_DECL)                                          \
+    static void NAME##_insertion(const vec_sorter *s, T *begin, T *end, b32 guarded)                                 \
+    {                                                                                                                \
+        TMP_DECL(T);                                                                                                 \
+        if (begin == end)                                                                                            \
+        {                                                                                                            \
+            return;                                                                                                  \
+        }                                                                                                            \
+        for (T *cur = AT(begin, 1); cur < end; cur = AT(cur, 1))                                                     \
+        {                                                                                                            \
+            T *sift = cur;                                                                                           \
+            T *sift_1 = BK(cur, 1);                                                                                  \
+            if (LT(sift, sift_1))                                                                                    \
+            {                                                                                                        \
+                MOVE(tmp, sift);                                                                                     \
+                do                                                                                                   \
+                {                                                                                                    \
+                    MOVE(sift, sift_1);                                                                              \
+                    sift = sift_1;                                                                                   \
+                } while ((!guarded || sift != begin) && (sift_1 = BK(sift, 1), LT(tmp, sift_1)));                    \
+                MOVE(sift, tmp);                                                                                     \
+            }                                                                                                        \
+        }                                                                                                            \
+    }                                                                                                                \
+                                                                                                                     \
+    static b32 NAME##_partial_insertion(const vec_sorter *s, T *begin, T *end)                                       \
+    {                                                                                                                \
+        TMP_DECL(T);                                                                                                 \
+        if (begin == end)                                                                                            \
+        {                                                                                                            \
+            return 1;                                                                                                \
+        }                                                                                                            \
+        usize limit = 0;                                                                                             \
+        for (T *cur = AT(begin, 1); cur < end; cur = AT(cur, 1))                                                     \
+        {                                                                                                            \
+            T *sift = cur;                                                                                           \
+            T *sift_1 = BK(cur, 1);                                                                                  \
+            if (LT(sift, sift_1))                                                                                    \
+            {                                                                                                        \
+                MOVE(tmp, sift);                                                                                     \
+                do                                                                                                   \
+                {                                                                                                    \
+                    MOVE(sift, sift_1);                                                                              \
+                    sift = sift_1;                                                                                   \
+                } while (sift != begin && (sift_1 = BK(sift, 1), LT(tmp, sift_1)));                                  \
+                MOVE(sift, tmp);                                                                                     \
+                limit += DIST(cur, sift);                                                                            \
+            }                                                                                                        \
+            if (limit > VEC_SORT_PARTIAL_LIMIT)                                                                      \
+            {                                                                                                        \
+                return 0;                                                                                            \
+            }                                                                                                        \
+        }                                                                                                            \
+        return 1;                                                                                                    \
+    }                                                                                                                \
+                                                                                                                     \
+    static inline void NAME##_sort2(const vec_sorter *s, T *a, T *b)                                                 \
+    {                                                                                                                \
+        if (LT(b, a))                                                                                                \
+        {                                                                                                            \
+            SWAP(a, b);                                                                                              \
+        }                                                                                                            \
+    }                                                                                                                \
+                                                                                                                     \
+    static inline void NAME##_sort3(const vec_sorter *s, T *a, T *b, T *c)                                           \
+    {                                                                                                                \
+        NAME##_sort2(s, a, b);                                                                                       \
+        NAME##_sort2(s, b, c);                                                                                       \
+        NAME##_sort2(s, a, b);                                                                                       \
+    }                                                                                                                \
+                                                                                                                     \
+    static void NAME##_sift_down(const vec_sorter *s, T *base, usize n, usize i)                                     \
+    {                                                                                                                \
+        TMP_DECL(T);                                                                                                 \
+        MOVE(tmp, AT(base, i));                                                                                      \
+        for (;;)                                                                                                     \
+        {                                                                                                            \
+            usize c = 2 * i + 1;                                                                                     \
+            if (c >= n)                                                                                              \
+            {                                                                                                        \
+                break;                                                                                               \
+            }                                                                                                        \
+            if (c + 1 < n && LT(AT(base, c), AT(base, c + 1)))                                                       \
+            {                                                                                                        \
+                c++;                                                                                                 \
+            }                                                                                                        \
+            if (!LT(tmp, AT(base, c)))                                                                               \
+            {                                                                                                        \
+                break;                                                                                               \
+            }                                                                                                        \
+            MOVE(AT(base, i), AT(base, c));                                                                          \
+            i = c;                                                                                                   \
+        }                                                                                                            \
+        MOVE(AT(base, i), tmp);                                                                                      \
+    }                                                                                                                \
+                                                                                                                     \
+    static void NAME##_heapsort(const vec_sorter *s, T *begin, T *end)                                               \
+    {                                                                                                                \
+        usize n = DIST(end, begin);                                                                                  \
+        for (usize i = n / 2; i-- > 0;)                                                                              \
+        {                                                                                                            \
+            NAME##_sift_down(s, begin, n, i);                                                                        \
+        }                                                                                                            \
+        for (usize m = n; m-- > 1;)                                                                                  \
+        {                                                                                                            \
+            SWAP(begin, AT(begin, m));                                                                               \
+            NAME##_sift_down(s, begin, m, 0);                                                                        \
+        }                                                                                                            \
+    }                                                                                                                \
+                                                                                                                     \
+    /* pivot为*begin, 小于pivot的在左边, 返回pivot的位置, already为本来就已经分区 */                                 \
+    static T *NAME##_partition_right(const vec_sorter *s, T *begin, T *end, b32 *already)                            \
+    {                                                                                                                \
+        TMP_DECL(T);                                                                                                 \
+        MOVE(tmp, begin);                                                                                            \
+        T *first = begin;                                                                                            \
+        T *last = end;                                                                                               \
+        do                                                                                                           \
+        {                                                                                                            \
+            first = AT(first, 1);                                                                                    \
+        } while (LT(first, tmp));                                                                                    \
+        if (BK(first, 1) == begin)                                                                                   \
+        {                                                                                                            \
+            while (first < last && (last = BK(last, 1), !LT(last, tmp)))                                            \
+                ;                                                                                                    \
+        }                                                                                                            \
+        else                                                                                                         \
+        {                                                                                                            \
+            do                                                                                                       \
+            {                                                                                                        \
+                last = BK(last, 1);                                                                                  \
+            } while (!LT(last, tmp));                                                                                \
+        }                                                                                                            \
+        *already = first >= last;                                                                                    \
+        while (first < last)                                                                                         \
+        {                                                                                                            \
+            SWAP(first, last);                                                                                       \
+            do                                                                                                       \
+            {                                                                                                        \
+                first = AT(first, 1);                                                                                \
+            } while (LT(first, tmp));                                                                                \
+            do                                                                                                       \
+            {                                                                                                        \
+                last = BK(last, 1);                                                                                  \
+            } while (!LT(last, tmp));                                                                                \
+        }                                                                                                            \
+        T *pivot_pos = BK(first, 1);                                                                                 \
+        MOVE(begin, pivot_pos);                                                                                      \
+        MOVE(pivot_pos, tmp);                                                                                        \
+        return pivot_pos;                                                                                            \
+    }                                                                                                                \
+                                                                                                                     \
+    /* 与partition_right相反, 等于pivot的在左边, 用于大量重复元素 */                                                 \
+    static T *NAME##_partition_left(const vec_sorter *s, T *begin, T *end)                                           \
+    {                                                                                                                \
+        TMP_DECL(T);                                                                                                 \
+        MOVE(tmp, begin);                                                                                            \
+        T *first = begin;                                                                                            \
+        T *last = end;                                                                                               \
+        do                                                                                                           \
+        {                                                                                                            \
+            last = BK(last, 1);                                                                                      \
+        } while (LT(tmp, last));                                                                                     \
+        if (AT(last, 1) == end)                                                                                      \
+        {                                                                                                            \
+            while (first < last && (first = AT(first, 1), !LT(tmp, first)))                                         \
+                ;                                                                                                    \
+        }                                                                                                            \
+        else                                                                                                         \
+        {                                                                                                            \
+            do                                                                                                       \
+            {                                                                                                        \
+                first = AT(first, 1);                                                                                \
+            } while (!LT(tmp, first));                                                                               \
+        }                                                                                                            \
+        while (first < last)                                                                                         \
+        {                                                                                                            \
+            SWAP(first, last);                                                                                       \
+            do                                                                                                       \
+            {                                                                                                        \
+                last = BK(last, 1);                                                                                  \
+            } while (LT(tmp, last));                                                                                 \
+            do                                                                                                       \
+            {                                                                                                        \
+                first = AT(first, 1);                                                                                \
+            } while (!LT(tmp, first));                                                                               \
+        }                                                                                                            \
+        MOVE(begin, last);                                                                                           \
+        MOVE(last, tmp);                                                                                             \
+        return last;                                                                                                 \
+    }                                                                                                                \
+                                                                                                                     \
+    static void NAME##_loop(const vec_sorter *s, T *begin, T *end, int bad_allowed, b32 leftmost)                    \
+    {                                                                                                                \
+        for (;;)                                                                                                     \
+        {                                                                                                            \
+            usize n = DIST(end, begin);                                                                              \
+            if (n < VEC_SORT_INSERTION)                                                                              \
+            {                                                                                                        \
+                NAME##_insertion(s, begin, end, leftmost);                                                           \
+                return;                                                                                              \
+            }                                                                                                        \
+                                                                                                                     \
+            usize half = n / 2;                                                                                      \
+            if (n > VEC_SORT_NINTHER)                                                                                \
+            {                                                                                                        \
+                NAME##_sort3(s, begin, AT(begin, half), BK(end, 1));                                                 \
+                NAME##_sort3(s, AT(begin, 1), AT(begin, half - 1), BK(end, 2));                                      \
+                NAME##_sort3(s, AT(begin, 2), AT(begin, half + 1), BK(end, 3));                                      \
+                NAME##_sort3(s, AT(begin, half - 1), AT(begin, half), AT(begin, half + 1));                          \
+                SWAP(begin, AT(begin, half));                                                                        \
+            }                                                                                                        \
+            else                                                                                                     \
+            {                                                                                                        \
+                NAME##_sort3(s, AT(begin, half), begin, BK(end, 1));                                                 \
+            }                                                                                                        \
+                                                                                                                     \
+            /* 前一个元素是上一层的pivot, 与pivot相等时所有元素都不小于pivot */                                      \
+            if (!leftmost && !LT(BK(begin, 1), begin))                                                               \
+            {                                                                                                        \
+                begin = AT(NAME##_partition_left(s, begin, end), 1);                                                 \
+                continue;                                                                                            \
+            }                                                                                                        \
+                                                                                                                     \
+            b32 already;                                                                                             \
+            T *pivot_pos = NAME##_partition_right(s, begin, end, &already);                                          \
+            usize l = DIST(pivot_pos, begin);                                                                        \
+            usize r = DIST(end, AT(pivot_pos, 1));                                                                   \
+            if (l < n / 8 || r < n / 8)                                                                              \
+            {                                                                                                        \
+                /* 分区不平衡次数过多时改用堆排序, 否则打乱元素破坏输入的模式 */                                     \
+                if (--bad_allowed == 0)                                                                              \
+                {                                                                                                    \
+                    NAME##_heapsort(s, begin, end);                                                                  \
+                    return;                                                                                          \
+                }                                                                                                    \
+                if (l >= VEC_SORT_INSERTION)                                                                         \
+                {                                                                                                    \
+                    SWAP(begin, AT(begin, l / 4));                                                                   \
+                    SWAP(BK(pivot_pos, 1), BK(pivot_pos, l / 4));                                                    \
+                    if (l > VEC_SORT_NINTHER)                                                                        \
+                    {                                                                                                \
+                        SWAP(AT(begin, 1), AT(begin, l / 4 + 1));                                                    \
+                        SWAP(AT(begin, 2), AT(begin, l / 4 + 2));                                                    \
+                        SWAP(BK(pivot_pos, 2), BK(pivot_pos, l / 4 + 1));                                            \
+                        SWAP(BK(pivot_pos, 3), BK(pivot_pos, l / 4 + 2));                                            \
+                    }                                                                                                \
+                }                                                                                                    \
+                if (r >= VEC_SORT_INSERTION)                                                                         \
+                {                                                                                                    \
+                    SWAP(AT(pivot_pos, 1), AT(pivot_pos, 1 + r / 4));                                                \
+                    SWAP(BK(end, 1), BK(end, r / 4));                                                                \
+                    if (r > VEC_SORT_NINTHER)                                                                        \
+                    {                                                                                                \
+                        SWAP(AT(pivot_pos, 2), AT(pivot_pos, 2 + r / 4));                                            \
+                        SWAP(AT(pivot_pos, 3), AT(pivot_pos, 3 + r / 4));                                            \
+                        SWAP(BK(end, 2), BK(end, 1 + r / 4));                                                        \
+                        SWAP(BK(end, 3), BK(end, 2 + r / 4));                                                        \
+                    }                                                                                                \
+                }                                                                                                    \
+            }                                                                                                        \
+            else if (already && NAME##_partial_insertion(s, begin, pivot_pos) &&                                     \
+                     NAME##_partial_insertion(s, AT(pivot_pos, 1), end))                                             \
+            {                                                                                                        \
+                /* 已经分区且两边接近有序 */                                                                         \
+                return;                                                                                              \
+            }                                                                                                        \
+                                                                                                                     \
+            NAME##_loop(s, begin, pivot_pos, bad_allowed, leftmost);                                                 \
+            begin = AT(pivot_pos, 1);                                                                                \
+            leftmost = 0;                                                                                            \
+        }                                                                                                            \
+    }                                                                                                                \
+                                                                                                                     \
+    static void NAME##_sort(const vec_sorter *s, T *begin, usize n)                                                  \
+    {                                                                                                                \
+        int bad_allowed = 1;                                                                                         \
+        for (usize m = n; m > 1; m >>= 1)                                                                            \
+        {                                                                                                            \
+            bad_allowed++;                                                                                           \
+        }                                                                                                            \
+        NAME##_loop(s, begin, AT(begin, n), bad_allowed, 1);                                                         \
+    }                                                                                                                \
+                                                                                                                     \
+    /* 合并结果的前k个元素中来自a的个数 */                                                                           \
+    static usize NAME##_split(const vec_sorter *s, T *a, usize na, T *b, usize nb, usize k)                          \
+    {                                                                                                                \
+        usize lo = k > nb ? k - nb : 0;                                                                              \
+        usize hi = k < na ? k : na;                                                                                  \
+        while (lo < hi)                                                                                              \
+        {                                                                                                            \
+            usize mid = lo + (hi - lo) / 2;                                                                          \
+            if (LT(AT(b, k - mid - 1), AT(a, mid)))                                                                  \
+            {                                                                                                        \
+                hi = mid;                                                                                            \
+            }                                                                                                        \
+            else                                                                                                     \
+            {                                                                                                        \
+                lo = mid + 1;                                                                                        \
+            }                                                                                                        \
+        }                                                                                                            \
+        return lo;                                                                                                   \
+    }                                                                                                                \
+                                                                                                                     \
+    static void NAME##_merge(const vec_sorter *s, T *a, T *a_end, T *b, T *b_end, T *out)                            \
+    {                                                                                                                \
+        while (a < a_end && b < b_end)                                                                               \
+        {                                                                                                            \
+            if (LT(b, a))                                                                                            \
+            {                                                                                                        \
+                MOVE(out, b);                                                                                        \
+                b = AT(b, 1);                                                                                        \
+            }                                                                                                        \
+            else                                                                                                     \
+            {                                                                                                        \
+                MOVE(out, a);                                                                                        \
+                a = AT(a, 1);                                                                                        \
+            }                                                                                                        \
+            out = AT(out, 1);                                                                                        \
+        }                                                                                                            \
+        if (a < a_end)                                                                                               \
+        {                                                                                                            \
+            memcpy(out, a, (u8 *)a_end - (u8 *)a);                                                                   \
+        }                                                                                                            \
+        if (b < b_end)                                                                                               \
+        {                                                                                                            \
+            memcpy(out, b, (u8 *)b_end - (u8 *)b);                                                                   \
+        }                                                                                                            \
+    }
+
+VEC_PDQSORT_DEFINE(vec_pdq_u8, u8, VEC_SORT_T_AT, VEC_SORT_T_BK, VEC_SORT_T_DIST, VEC_SORT_T_LT, VEC_SORT_T_MOVE, VEC_SORT_T_SWAP, VEC_SORT_T_TMP)
+VEC_PDQSORT_DEFINE(vec_pdq_u16, u16, VEC_SORT_T_AT, VEC_SORT_T_BK, VEC_SORT_T_DIST, VEC_SORT_T_LT, VEC_SORT_T_MOVE, VEC_SORT_T_SWAP, VEC_SORT_T_TMP)
+VEC_PDQSORT_DEFINE(vec_pdq_u32, u32, VEC_SORT_T_AT, VEC_SORT_T_BK, VEC_SORT_T_DIST, VEC_SORT_T_LT, VEC_SORT_T_MOVE, VEC_SORT_T_SWAP, VEC_SORT_T_TMP)
+VEC_PDQSORT_DEFINE(vec_pdq_u64, u64, VEC_SORT_T_AT, VEC_SORT_T_BK, VEC_SORT_T_DIST, VEC_SORT_T_LT, VEC_SORT_T_MOVE, VEC_SORT_T_SWAP, VEC_SORT_T_TMP)
+VEC_PDQSORT_DEFINE(vec_pdq_generic, u8, VEC_SORT_G_AT, VEC_SORT_G_BK, VEC_SORT_G_DIST, VEC_SORT_G_LT, VEC_SORT_G_MOVE, VEC_SORT_G_SWAP, VEC_SORT_G_TMP)
+
+/**
+ * @brief 根据vsize和cmp选择类型化或通用的实现, 通用实现需要vsize字节的临时空间
+ *
+ * @param s
+ * @param w
+ * @param cmp
+ * @param stack 栈上的临时空间, VEC_SORT_STACK_TMP字节
+ * @return int 成功 0，失败 1
+ */
+static void vec_sorter_setup(vec_sorter *s, usize w, int (*cmp)(const void *, const void *))
+{
+    s->w = w;
+    s->cmp = cmp;
+    s->tmp = NULL;
+    s->kind = VEC_SORT_GENERIC;
+    if (!cmp)
+    {
+        switch (w)
+        {
+        case 1:
+            s->kind = VEC_SORT_U8;
+            break;
+        case 2:
+            s->kind = VEC_SORT_U16;
+            break;
+        case 4:
+            s->kind = VEC_SORT_U32;
+            break;
+        case 8:
+            s->kind = VEC_SORT_U64;
+            break;
+        }
+    }
+}
+
+static int vec_sorter_init(vec_sorter *s, usize w, int (*cmp)(const void *, const void *), u8 *stack)
+{
+    vec_sorter_setup(s, w, cmp);
+    if (s->kind != VEC_SORT_GENERIC)
+    {
+        return 0;
+    }
+
+    s->tmp = w <= VEC_SORT_STACK_TMP ? stack : (u8 *)malloc(w);
+    return s->tmp ? 0 : 1;
+}
+
+static void vec_sorter_release(vec_sorter *s, u8 *stack)
+{
+    if (s->tmp != stack)
+    {
+        free2(s->tmp);
+    }
+}
+
+static void vec_sorter_sort(const vec_sorter *s, u8 *base, usize n)
+{
+    if (n < 2)
+    {
+        return;
+    }
+
+    switch (s->kind)
+    {
+    case VEC_SORT_U8:
+        vec_pdq_u8_sort(s, base, n);
+        break;
+    case VEC_SORT_U16:
+        vec_pdq_u16_sort(s, (u16 *)base, n);
+        break;
+    case VEC_SORT_U32:
+        vec_pdq_u32_sort(s, (u32 *)base, n);
+        break;
+    case VEC_SORT_U64:
+        vec_pdq_u64_sort(s, (u64 *)base, n);
+        break;
+    default:
+        vec_pdq_generic_sort(s, base, n);
+    }
+}
+
+/**
+ * @brief 归并a和b, 只输出合并结果的[k0, k1)
+ */
+static void vec_sorter_merge(const vec_sorter *s, u8 *a, usize na, u8 *b, usize nb, u8 *out, usize k0, usize k1)
+{
+    usize i0, i1;
+    switch (s->kind)
+    {
+    case VEC_SORT_U8:
+        i0 = vec_pdq_u8_split(s, a, na, b, nb, k0);
+        i1 = vec_pdq_u8_split(s, a, na, b, nb, k1);
+        vec_pdq_u8_merge(s, a + i0, a + i1, b + (k0 - i0), b + (k1 - i1), out + k0);
+        break;
+    case VEC_SORT_U16:
+        i0 = vec_pdq_u16_split(s, (u16 *)a, na, (u16 *)b, nb, k0);
+        i1 = vec_pdq_u16_split(s, (u16 *)a, na, (u16 *)b, nb, k1);
+        vec_pdq_u16_merge(s, (u16 *)a + i0, (u16 *)a + i1, (u16 *)b + (k0 - i0), (u16 *)b + (k1 - i1), (u16 *)out + k0);
+        break;
+    case VEC_SORT_U32:
+        i0 = vec_pdq_u32_split(s, (u32 *)a, na, (u32 *)b, nb, k0);
+        i1 = vec_pdq_u32_split(s, (u32 *)a, na, (u32 *)b, nb, k1);
+        vec_pdq_u32_merge(s, (u32 *)a + i0, (u32 *)a + i1, (u32 *)b + (k0 - i0), (u32 *)b + (k1 - i1), (u32 *)out + k0);
+        break;
+    case VEC_SORT_U64:
+        i0 = vec_pdq_u64_split(s, (u64 *)a, na, (u64 *)b, nb, k0);
+        i1 = vec_pdq_u64_split(s, (u64 *)a, na, (u64 *)b, nb, k1);
+        vec_pdq_u64_merge(s, (u64 *)a + i0, (u64 *)a + i1, (u64 *)b + (k0 - i0), (u64 *)b + (k1 - i1), (u64 *)out + k0);
+        break;
+    default:
+        i0 = vec_pdq_generic_split(s, a, na, b, nb, k0);
+        i1 = vec_pdq_generic_split(s, a, na, b, nb, k1);
+        vec_pdq_generic_merge(s, a + i0 * s->w, a + i1 * s->w, b + (k0 - i0) * s->w, b + (k1 - i1) * s->w, out + k0 * s->w);
+    }
+}
+
+int vec_sort(vec *h, int (*cmp)(const void *a, const void *b))
+{
+    if (!h || h->vsize == 0)
+    {
+        return 1;
+    }
+    if (h->len < 2)
+    {
+        return 0;
+    }
+
+    vec_sorter s;
+    u8 stack[VEC_SORT_STACK_TMP];
+    if (vec_sorter_init(&s, h->vsize, cmp, stack))
+    {
+        return 1;
+    }
+    vec_sorter_sort(&s, (u8 *)h->mem, h->len);
+    vec_sorter_release(&s, stack);
+    return 0;
+}
+
+// ============================================================================
+// 基数排序
+// ============================================================================
+
+static inline u64 vec_radix_key(const u8 *e, usize w, u64 (*key)(const void *elem))
+{
+    if (key)
+    {
+        return key(e);
+    }
+
+    switch (w)
+    {
+    case 1:
+        return *e;
+    case 2:
+    {
+        u16 x;
+        memcpy(&x, e, 2);
+        return x;
+    }
+    case 4:
+    {
+        u32 x;
+        memcpy(&x, e, 4);
+        return x;
+    }
+    default:
+    {
+        u64 x;
+        memcpy(&x, e, 8);
+        return x;
+    }
+    }
+}
+
+int vec_sort_radix(vec *h, u64 (*key)(const void *elem))
+{
+    if (!h || h->vsize == 0)
+    {
+        return 1;
+    }
+
+    usize n = h->len;
+    usize w = h->vsize;
+    if (!key && w != 1 && w != 2 && w != 4 && w != 8)
+    {
+        return 1;
+    }
+    if (n < 2)
+    {
+        return 0;
+    }
+
+    usize key_bytes = key ? 8 : w;
+    u8 *buf = (u8 *)malloc(n * w);
+    usize *counts = (usize *)calloc(key_bytes * 256, sizeof(usize));
+    if (!buf || !counts)
+    {
+        free2(buf);
+        free2(counts);
+        return 1;
+    }
+
+    // 一次遍历统计所有字节
+    u8 *src = (u8 *)h->mem;
+    for (usize i = 0; i < n; i++)
+    {
+        u64 k = vec_radix_key(src + i * w, w, key);
+        for (usize b = 0; b < key_bytes; b++)
+        {
+            counts[b * 256 + ((k >> (8 * b)) & 0xff)]++;
+        }
+    }
+
+    u8 *dst = buf;
+    u64 first = vec_radix_key(src, w, key);
+    for (usize b = 0; b < key_bytes; b++)
+    {
+        usize *count = counts + b * 256;
+        if (count[(first >> (8 * b)) & 0xff] == n)
+        {
+            continue;
+        }
+
+        usize off = 0;
+        for (int d = 0; d < 256; d++)
+        {
+            usize c = count[d];
+            count[d] = off;
+            off += c;
+        }
+
+        for (usize i = 0; i < n; i++)
+        {
+            u8 *e = src + i * w;
+            usize o = count[(vec_radix_key(e, w, key) >> (8 * b)) & 0xff]++;
+            switch (w)
+            {
+            case 4:
+                memcpy(dst + o * 4, e, 4);
+                break;
+            case 8:
+                memcpy(dst + o * 8, e, 8);
+                break;
+            default:
+                memcpy(dst + o * w, e, w);
+            }
+        }
+
+        u8 *t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != h->mem)
+    {
+        memcpy(h->mem, src, n * w);
+    }
+    free(buf);
+    free(counts);
+    return 0;
+}
+
+// ============================================================================
+// 多线程排序
+// ============================================================================
+
+#define VEC_SORT_TASK_SORT  0
+#define VEC_SORT_TASK_MERGE 1
+#define VEC_SORT_TASK_COPY  2
+
+typedef struct vec_sort_task
+{
+    int op;
+    // SORT: a开始的na个元素; MERGE: 归并a和b的[k0, k1)到out; COPY: a的na个元素复制到out
+    u8 *a;
+    usize na;
+    u8 *b;
+    usize nb;
+    u8 *out;
+    usize k0;
+    usize k1;
+} vec_sort_task;
+
+typedef struct vec_sort_job
+{
+    const vec_sorter *proto;
+    vec_sort_task *tasks;
+    usize ntasks;
+    int err;
+} vec_sort_job;
+
+static void vec_sort_exec(usize begin, usize end, void *ctx)
+{
+    vec_sort_job *job = (vec_sort_job *)ctx;
+    vec_sorter s = *job->proto;
+    u8 stack[VEC_SORT_STACK_TMP];
+    if (s.tmp)
+    {
+        // 每个线程单独的临时空间
+        s.tmp = s.w <= VEC_SORT_STACK_TMP ? stack : (u8 *)malloc(s.w);
+        if (!s.tmp)
+        {
+            __atomic_store_n(&job->err, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+
+    for (usize i = begin; i < end; i++)
+    {
+        vec_sort_task *t = job->tasks + i;
+        switch (t->op)
+        {
+        case VEC_SORT_TASK_SORT:
+            vec_sorter_sort(&s, t->a, t->na);
+            break;
+        case VEC_SORT_TASK_MERGE:
+            vec_sorter_merge(&s, t->a, t->na, t->b, t->nb, t->out, t->k0, t->k1);
+            break;
+        default:
+            memcpy(t->out, t->a, t->na * s.w);
+        }
+    }
+
+    vec_sorter_release(&s, stack);
+}
+
+/**
+ * @brief 线程池中每个任务单独执行
+ *
+ * @param job
+ * @param pool
+ * @return int 成功 0，失败 1
+ */
+static int vec_sort_run(vec_sort_job *job, cpool *pool)
+{
+    cpool_parallel_for(pool, 0, job->ntasks, 1, vec_sort_exec, job);
+    return job->err;
+}
+
+int vec_sort_pool(vec *h, int (*cmp)(const void *a, const void *b), cpool *pool)
+{
+    if (!h || h->vsize == 0)
+    {
+        return 1;
+    }
+
+    usize n = h->len;
+    usize w = h->vsize;
+    usize threads = cpool_threads(pool);
+    // 每块至少VEC_SORT_PARALLEL_MIN / 2个元素
+    if (threads > n / (VEC_SORT_PARALLEL_MIN / 2))
+    {
+        threads = n / (VEC_SORT_PARALLEL_MIN / 2);
+    }
+    if (n < VEC_SORT_PARALLEL_MIN || threads < 2)
+    {
+        return vec_sort(h, cmp);
+    }
+
+    vec_sorter s;
+    u8 stack[VEC_SORT_STACK_TMP];
+    if (vec_sorter_init(&s, w, cmp, stack))
+    {
+        return 1;
+    }
+    u8 *buf = (u8 *)malloc(n * w);
+    // 每轮的任务不超过threads + 1个, 每个run的边界threads + 1个
+    vec_sort_task *tasks = (vec_sort_task *)malloc((threads + 1) * sizeof(vec_sort_task));
+    usize *bounds = (usize *)malloc((threads + 1) * sizeof(usize));
+    int ret = 1;
+    if (!buf || !tasks || !bounds)
+    {
+        goto end;
+    }
+
+    vec_sort_job job = {&s, tasks, threads, 0};
+    u8 *src = (u8 *)h->mem;
+    for (usize i = 0; i <= threads; i++)
+    {
+        bounds[i] = n * i / threads;
+    }
+    for (usize i = 0; i < threads; i++)
+    {
+        tasks[i] = (vec_sort_task){VEC_SORT_TASK_SORT, src + bounds[i] * w, bounds[i + 1] - bounds[i], NULL, 0, NULL, 0, 0};
+    }
+    if (vec_sort_run(&job, pool))
+    {
+        goto end;
+    }
+
+    // 两两归并, 每对按merge path切分给多个线程
+    u8 *dst = buf;
+    usize runs = threads;
+    while (runs > 1)
+    {
+        usize pairs = runs / 2;
+        usize parts = threads / pairs > 1 ? threads / pairs : 1;
+        job.ntasks = 0;
+        for (usize p = 0; p < pairs; p++)
+        {
+            usize lo = bounds[2 * p], mid = bounds[2 * p + 1], hi = bounds[2 * p + 2];
+            for (usize q = 0; q < parts; q++)
+            {
+                tasks[job.ntasks++] = (vec_sort_task){
+                    VEC_SORT_TASK_MERGE,
+                    src + lo * w, mid - lo,
+                    src + mid * w, hi - mid,
+                    dst + lo * w,
+                    (hi - lo) * q / parts, (hi - lo) * (q + 1) / parts};
+            }
+        }
+        if (runs & 1)
+        {
+            usize lo = bounds[runs - 1];
+            tasks[job.ntasks++] = (vec_sort_task){VEC_SORT_TASK_COPY, src + lo * w, n - lo, NULL, 0, dst + lo * w, 0, 0};
+        }
+        if (vec_sort_run(&job, pool))
+        {
+            break;
+        }
+
+        for (usize p = 0; p <= pairs; p++)
+        {
+            bounds[p] = bounds[2 * p < runs ? 2 * p : runs];
+        }
+        runs = pairs + (runs & 1);
+        bounds[runs] = n;
+
+        u8 *t = src;
+        src = dst;
+        dst = t;
+    }
+
+    // 失败时src是上一轮完整的结果
+    if (src != h->mem)
+    {
+        memcpy(h->mem, src, n * w);
+    }
+    ret = runs > 1;
+
+end:
+    free2(buf);
+    free2(tasks);
+    free2(bounds);
+    vec_sorter_release(&s, stack);
+    return ret;
+}
+
+int vec_sort_parallel(vec *h, int (*cmp)(const void *a, const void *b), usize threads)
+{
+    if (!h || h->vsize == 0)
+    {
+        return 1;
+    }
+    if (threads == 0)
+    {
+        return vec_sort_pool(h, cmp, NULL);
+    }
+    if (threads > h->len / (VEC_SORT_PARALLEL_MIN / 2))
+    {
+        threads = h->len / (VEC_SORT_PARALLEL_MIN / 2);
+    }
+    if (threads < 2 || h->len < VEC_SORT_PARALLEL_MIN)
+    {
+        return vec_sort(h, cmp);
+    }
+
+    cpool *pool = cpool_new(threads);
+    if (!pool)
+    {
+        return vec_sort(h, cmp);
+    }
+    int ret = vec_sort_pool(h, cmp, pool);
+    cpool_free(pool);
+    return ret;
+}
+
+// ============================================================================
+// 有序 vec 操作
+// ============================================================================
+
+static inline b32 vec_sorter_less(const vec_sorter *s, const u8 *a, const u8 *b)
+{
+    switch (s->kind)
+    {
+    case VEC_SORT_U8:
+        return *a < *b;
+    case VEC_SORT_U16:
+    {
+        u16 x, y;
+        memcpy(&x, a, 2);
+        memcpy(&y, b, 2);
+        return x < y;
+    }
+    case VEC_SORT_U32:
+    {
+        u32 x, y;
+        memcpy(&x, a, 4);
+        memcpy(&y, b, 4);
+        return x < y;
+    }
+    case VEC_SORT_U64:
+    {
+        u64 x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        return x < y;
+    }
+    default:
+        return vec_sorter_generic_less(s, a, b);
+    }
+}
+
+// 无分支二分查找, 每次把范围缩小一半, 比较结果用于选择而不是跳转,
+// 同时预取下一轮两个可能的中点, 弥补没有分支预测时的访存等待
+#define VEC_BOUND_DEFINE(NAME, T)                                             \
+    static usize NAME##_bound(const T *base, usize n, T x, b32 upper)        \
+    {                                                                         \
+        const T *p = base;                                                    \
+        if (n == 0)                                                           \
+        {                                                                     \
+            return 0;                                                         \
+        }                                                                     \
+        if (upper)                                                            \
+        {                                                                     \
+            while (n > 1)                                                     \
+            {                                                                 \
+                usize half = n / 2;                                           \
+                __builtin_prefetch(p + (n - half) / 2);                       \
+                __builtin_prefetch(p + half + (n - half) / 2);                \
+                p = p[half] <= x ? p + half : p;                              \
+                n -= half;                                                    \
+            }                                                                 \
+            return (usize)(p - base) + (*p <= x);                             \
+        }                                                                     \
+        while (n > 1)                                                         \
+        {                                                                     \
+            usize half = n / 2;                                               \
+            __builtin_prefetch(p + (n - half) / 2);                           \
+            __builtin_prefetch(p + half + (n - half) / 2);                    \
+            p = p[half] < x ? p + half : p;                                   \
+            n -= half;                                                        \
+        }                                                                     \
+        return (usize)(p - base) + (*p < x);                                  \
+    }
+
+VEC_BOUND_DEFINE(vec_sorted_u8, u8)
+VEC_BOUND_DEFINE(vec_sorted_u16, u16)
+VEC_BOUND_DEFINE(vec_sorted_u32, u32)
+VEC_BOUND_DEFINE(vec_sorted_u64, u64)
+
+/**
+ * @brief 在base开始的n个元素中查找
+ *
+ * @param s
+ * @param base
+ * @param n
+ * @param x
+ * @param upper 为0时第一个不小于x的下标, 否则第一个大于x的下标
+ * @return usize
+ */
+static usize vec_sorted_bound(const vec_sorter *s, const u8 *base, usize n, const u8 *x, b32 upper)
+{
+    switch (s->kind)
+    {
+    case VEC_SORT_U8:
+        return vec_sorted_u8_bound(base, n, *x, upper);
+    case VEC_SORT_U16:
+    {
+        u16 k;
+        memcpy(&k, x, 2);
+        return vec_sorted_u16_bound((const u16 *)base, n, k, upper);
+    }
+    case VEC_SORT_U32:
+    {
+        u32 k;
+        memcpy(&k, x, 4);
+        return vec_sorted_u32_bound((const u32 *)base, n, k, upper);
+    }
+    case VEC_SORT_U64:
+    {
+        u64 k;
+        memcpy(&k, x, 8);
+        return vec_sorted_u64_bound((const u64 *)base, n, k, upper);
+    }
+    }
+
+    const u8 *p = base;
+    if (n == 0)
+    {
+        return 0;
+    }
+    while (n > 1)
+    {
+        usize half = n / 2;
+        const u8 *m = p + half * s->w;
+        p = (upper ? !vec_sorter_generic_less(s, x, m) : vec_sorter_generic_less(s, m, x)) ? m : p;
+        n -= half;
+    }
+    return (usize)(p - base) / s->w + (upper ? !vec_sorter_generic_less(s, x, p) : vec_sorter_generic_less(s, p, x));
+}
+
+size vec_lower_bound(vec *h, const void *v, int (*cmp)(const void *a, const void *b))
+{
+    if (!h || !v || h->vsize == 0)
+    {
+        return -1;
+    }
+
+    vec_sorter s;
+    vec_sorter_setup(&s, h->vsize, cmp);
+    return vec_sorted_bound(&s, (const u8 *)h->mem, h->len, (const u8 *)v, 0);
+}
+
+size vec_upper_bound(vec *h, const void *v, int (*cmp)(const void *a, const void *b))
+{
+    if (!h || !v || h->vsize == 0)
+    {
+        return -1;
+    }
+
+    vec_sorter s;
+    vec_sorter_setup(&s, h->vsize, cmp);
+    return vec_sorted_bound(&s, (const u8 *)h->mem, h->len, (const u8 *)v, 1);
+}
+
+b32 vec_contains_sorted(vec *h, const void *v, int (*cmp)(const void *a, const void *b))
+{
+    if (!h || !v || h->vsize == 0)
+    {
+        return 0;
+    }
+
+    vec_sorter s;
+    vec_sorter_setup(&s, h->vsize, cmp);
+    usize i = vec_sorted_bound(&s, (const u8 *)h->mem, h->len, (const u8 *)v, 0);
+    return i < h->len && !vec_sorter_less(&s, (const u8 *)v, (const u8 *)h->mem + i * h->vsize);
+}
+
+size vec_dedup_sorted(vec *h, int (*cmp)(const void *a, const void *b))
+{
+    if (!h || h->vsize == 0)
+    {
+        return 0;
+    }
+    if (h->len < 2)
+    {
+        return h->len;
+    }
+
+    vec_sorter s;
+    vec_sorter_setup(&s, h->vsize, cmp);
+    usize w = h->vsize;
+    u8 *data = (u8 *)h->mem;
+    usize keep = 1;
+    for (usize i = 1; i < h->len; i++)
+    {
+        // 有序, 不小于前一个保留的元素时相等
+        if (vec_sorter_less(&s, data + (keep - 1) * w, data + i * w))
+        {
+            if (keep != i)
+            {
+                memcpy(data + keep * w, data + i * w, w);
+            }
+            keep++;
+        }
+    }
+    h->len = keep;
+    return keep;
+}
+
+/**
+ * @brief 创建结果vec
+ *
+ * @param a
+ * @param b
+ * @param cap
+ * @return vec* vsize不同或内存分配失败返回NULL
+ */
+static vec *vec_sorted_out(vec *a, vec *b, usize cap)
+{
+    if (!a || !b || a->vsize != b->vsize || a->vsize == 0)
+    {
+        return NULL;
+    }
+
+    vec *o = vec_new(a->vsize);
+    if (o && cap && vec_resize(o, cap))
+    {
+        vec_free(o);
+        return NULL;
+    }
+    return o;
+}
+
+vec *vec_merge(vec *a, vec *b, int (*cmp)(const void *a, const void *b))
+{
+    vec *o = vec_sorted_out(a, b, a && b ? a->len + b->len : 0);
+    if (!o)
+    {
+        return NULL;
+    }
+
+    vec_sorter s;
+    vec_sorter_setup(&s, a->vsize, cmp);
+    usize n = a->len + b->len;
+    if (n)
+    {
+        vec_sorter_merge(&s, (u8 *)a->mem, a->len, (u8 *)b->mem, b->len, (u8 *)o->mem, 0, n);
+    }
+    o->len = n;
+    return o;
+}
+
+/**
+ * @brief small中的每个元素从上一次的位置开始在large中倍增查找, O(m log(n / m))
+ *
+ * @return usize 交集元素个数
+ */
+static usize vec_intersect_gallop(const vec_sorter *s, const u8 *small, usize ns, const u8 *large, usize nl, u8 *out)
+{
+    usize w = s->w;
+    usize j = 0;
+    usize n = 0;
+    for (usize i = 0; i < ns && j < nl; i++)
+    {
+        const u8 *x = small + i * w;
+        // large[j, hi)都小于x后倍增hi, 直到large[hi]不小于x
+        usize hi = j;
+        usize step = 1;
+        while (hi < nl && vec_sorter_less(s, large + hi * w, x))
+        {
+            j = hi + 1;
+            hi += step;
+            step <<= 1;
+        }
+        usize end = hi < nl ? hi : nl;
+        j += vec_sorted_bound(s, large + j * w, end - j, x, 0);
+        if (j < nl && !vec_sorter_less(s, x, large + j * w))
+        {
+            memcpy(out + n * w, x, w);
+            n++;
+            j++;
+        }
+    }
+    return n;
+}
+
+static usize vec_intersect_scalar(const vec_sorter *s, const u8 *a, usize na, const u8 *b, usize nb, u8 *out)
+{
+    usize w = s->w;
+    usize i = 0, j = 0, n = 0;
+    while (i < na && j < nb)
+    {
+        const u8 *x = a + i * w;
+        const u8 *y = b + j * w;
+        if (vec_sorter_less(s, x, y))
+        {
+            i++;
+        }
+        else if (vec_sorter_less(s, y, x))
+        {
+            j++;
+        }
+        else
+        {
+            memcpy(out + n * w, x, w);
+            n++;
+            i++;
+            j++;
+        }
+    }
+    return n;
+}
+
+#if defined(__SSE2__)
+/**
+ * @brief u32交集, a的4个元素与b的4个元素两两比较, 最大值较小的一边前进
+ *
+ * @return usize 交集元素个数
+ */
+static usize vec_intersect_u32_sse2(const u32 *a, usize na, const u32 *b, usize nb, u32 *out)
+{
+    usize i = 0, j = 0, n = 0;
+    while (i + 4 <= na && j + 4 <= nb)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + j));
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(va, vb), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39))),
+            _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4e)), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93))));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        while (mask)
+        {
+            out[n++] = a[i + __builtin_ctz(mask)];
+            mask &= mask - 1;
+        }
+
+        u32 amax = a[i + 3], bmax = b[j + 3];
+        i += amax <= bmax ? 4 : 0;
+        j += bmax <= amax ? 4 : 0;
+    }
+
+    while (i < na && j < nb)
+    {
+        if (a[i] < b[j])
+        {
+            i++;
+        }
+        else if (b[j] < a[i])
+        {
+            j++;
+        }
+        else
+        {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    return n;
+}
+#endif
+
+vec *vec_intersect_sorted(vec *a, vec *b, int (*cmp)(const void *a, const void *b))
+{
+    vec *o = vec_sorted_out(a, b, a && b ? (a->len < b->len ? a->len : b->len) : 0);
+    if (!o)
+    {
+        return NULL;
+    }
+    if (a->len > b->len)
+    {
+        vec *t = a;
+        a = b;
+        b = t;
+    }
+    if (a->len == 0)
+    {
+        return o;
+    }
+
+    vec_sorter s;
+    vec_sorter_setup(&s, a->vsize, cmp);
+    if (a->len * VEC_GALLOP_RATIO < b->len)
+    {
+        o->len = vec_intersect_gallop(&s, (const u8 *)a->mem, a->len, (const u8 *)b->mem, b->len, (u8 *)o->mem);
+    }
+#if defined(__SSE2__)
+    else if (s.kind == VEC_SORT_U32)
+    {
+        o->len = vec_intersect_u32_sse2((const u32 *)a->mem, a->len, (const u32 *)b->mem, b->len, (u32 *)o->mem);
+    }
+#endif
+    else
+    {
+        o->len = vec_intersect_scalar(&s, (const u8 *)a->mem, a->len, (const u8 *)b->mem, b->len, (u8 *)o->mem);
+    }
+    return o;
+}
+
+vec *vec_union_sorted(vec *a, vec *b, int (*cmp)(const void *a, const void *b))
+{
+    vec *o = vec_sorted_out(a, b, a && b ? a->len + b->len : 0);
+    if (!o)
+    {
+        return NULL;
+    }
+
+    vec_sorter s;
+    vec_sorter_setup(&s, a->vsize, cmp);
+    usize w = s.w;
+    const u8 *x = (const u8 *)a->mem, *x_end = x + a->len * w;
+    const u8 *y = (const u8 *)b->mem, *y_end = y + b->len * w;
+    u8 *out = (u8 *)o->mem;
+    while (x < x_end && y < y_end)
+    {
+        if (vec_sorter_less(&s, y, x))
+        {
+            memcpy(out, y, w);
+            y += w;
+        }
+        else
+        {
+            // 相等时两边都前进
+            if (!vec_sorter_less(&s, x, y))
+            {
+                y += w;
+            }
+            memcpy(out, x, w);
+            x += w;
+        }
+        out += w;
+    }
+    if (x < x_end)
+    {
+        memcpy(out, x, x_end - x);
+        out += x_end - x;
+    }
+    if (y < y_end)
+    {
+        memcpy(out, y, y_end - y);
+        out += y_end - y;
+    }
+    o->len = (usize)(out - (u8 *)o->mem) / w;
+    return o;
+}
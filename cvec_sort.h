@@ -0,0 +1,134 @@
+#ifndef __CVEC_SORT_H
+#define __CVEC_SORT_H
+
+#include "cpool.h"
+#include "ctype.h"
+#include "cvec.h"
+
+// 元素个数小于该值时不使用多线程
+#define VEC_SORT_PARALLEL_MIN 65536
+
+// ============================================================================
+// vec 排序
+//
+// cmp为NULL时, vsize为1/2/4/8按无符号整数升序, 使用类型化的比较和交换,
+// 其他vsize按memcmp字节序
+// ============================================================================
+
+/**
+ * @brief 排序, pattern-defeating quicksort, 不稳定, 最坏O(nlogn)
+ *
+ * @param h
+ * @param cmp 比较函数, 返回负数、0、正数表示a小于、等于、大于b, 为NULL时见上
+ * @return int 成功 0，失败 1
+ */
+int vec_sort(vec *h, int (*cmp)(const void *a, const void *b));
+
+/**
+ * @brief LSD基数排序, 稳定, 每次处理一个字节, 所有元素该字节都相同时跳过,
+ * 需要额外的len * vsize字节
+ *
+ * @param h
+ * @param key 取出元素的无符号整数key, 为NULL时元素本身是无符号整数, vsize需要为1/2/4/8;
+ *            有符号整数可以返回key ^ (1ull << 63)
+ * @return int 成功 0，失败 1
+ */
+int vec_sort_radix(vec *h, u64 (*key)(const void *elem));
+
+/**
+ * @brief 多线程排序, 分块后每个线程排序一块, 然后按merge path切分, 多线程两两归并,
+ * 需要额外的len * vsize字节
+ *
+ * @param h
+ * @param cmp 同vec_sort
+ * @param threads 线程数, 为0时使用cpool_global, 否则临时创建线程池
+ * @return int 成功 0，失败 1
+ */
+int vec_sort_parallel(vec *h, int (*cmp)(const void *a, const void *b), usize threads);
+
+/**
+ * @brief 在线程池中排序, 分块数为cpool_threads(pool), 同vec_sort_parallel
+ *
+ * @param h
+ * @param cmp 同vec_sort
+ * @param pool 为NULL时为cpool_global
+ * @return int 成功 0，失败 1
+ */
+int vec_sort_pool(vec *h, int (*cmp)(const void *a, const void *b), cpool *pool);
+
+// ============================================================================
+// 有序 vec 操作, cmp与vec_sort相同, 需要按同一个cmp排好序
+// 集合运算(交集, 并集)的输入需要已经去重
+// ============================================================================
+
+/**
+ * @brief 第一个不小于v的元素下标, 无分支二分查找
+ *
+ * @param h
+ * @param v
+ * @param cmp
+ * @return size 所有元素都小于v时返回len
+ */
+size vec_lower_bound(vec *h, const void *v, int (*cmp)(const void *a, const void *b));
+
+/**
+ * @brief 第一个大于v的元素下标, 无分支二分查找
+ *
+ * @param h
+ * @param v
+ * @param cmp
+ * @return size 所有元素都不大于v时返回len
+ */
+size vec_upper_bound(vec *h, const void *v, int (*cmp)(const void *a, const void *b));
+
+/**
+ * @brief 是否存在与v相等的元素
+ *
+ * @param h
+ * @param v
+ * @param cmp
+ * @return b32
+ */
+b32 vec_contains_sorted(vec *h, const void *v, int (*cmp)(const void *a, const void *b));
+
+/**
+ * @brief 删除相邻的重复元素, 保留第一个
+ *
+ * @param h
+ * @param cmp
+ * @return size 去重后的元素个数
+ */
+size vec_dedup_sorted(vec *h, int (*cmp)(const void *a, const void *b));
+
+/**
+ * @brief 归并两个有序vec, 保留重复元素
+ *
+ * @param a
+ * @param b
+ * @param cmp
+ * @return vec* 新的有序vec, vsize不同或内存分配失败返回NULL
+ */
+vec *vec_merge(vec *a, vec *b, int (*cmp)(const void *a, const void *b));
+
+/**
+ * @brief 交集, 元素个数相差很大时在较大的vec中倍增查找,
+ * cmp为NULL且vsize为4时每次比较4x4个元素(SSE2)
+ *
+ * @param a
+ * @param b
+ * @param cmp
+ * @return vec* 新的有序vec, vsize不同或内存分配失败返回NULL
+ */
+vec *vec_intersect_sorted(vec *a, vec *b, int (*cmp)(const void *a, const void *b));
+
+/**
+ * @brief 并集, 两边相等的元素只保留一个
+ *
+ * @param a
+ * @param b
+ * @param cmp
+ * @return vec* 新的有序vec, vsize不同或内存分配失败返回NULL
+ */
+vec *vec_union_sorted(vec *a, vec *b, int (*cmp)(const void *a, const void *b));
+
+#endif // __CVEC_SORT_H
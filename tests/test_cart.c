@@ -0,0 +1,237 @@
+#include "../cart.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define KEYS 20000
+
+typedef struct walk_ctx
+{
+    u8 prev[64];
+    usize prev_len;
+    int n;
+    int limit;
+} walk_ctx;
+
+int key_cmp(const u8 *k1, usize l1, const u8 *k2, usize l2)
+{
+    int r = memcmp(k1, k2, l1 < l2 ? l1 : l2);
+    return r ? r : (l1 > l2) - (l1 < l2);
+}
+
+int check_order(const u8 *key, usize len, void *value, void *ctx)
+{
+    walk_ctx *w = (walk_ctx *)ctx;
+    assert(w->n == 0 || key_cmp(w->prev, w->prev_len, key, len) < 0);
+    memcpy(w->prev, key, len);
+    w->prev_len = len;
+    w->n++;
+    return w->limit && w->n >= w->limit;
+}
+
+usize make_key(u8 *buf, int i)
+{
+    // 不同长度且互为前缀的key, 覆盖长压缩路径
+    switch (i % 4)
+    {
+    case 0:
+        return (usize)sprintf((char *)buf, "%d", i);
+    case 1:
+        return (usize)sprintf((char *)buf, "/api/v1/users/%d", i);
+    case 2:
+        return (usize)sprintf((char *)buf, "/api/v1/users/%d/profile/settings", i - 1);
+    default:
+        buf[0] = (u8)(i >> 8);
+        buf[1] = 0;
+        buf[2] = (u8)i;
+        return 3;
+    }
+}
+
+void test_set_and_get()
+{
+    printf("============== test_set_and_get ===========\n");
+    art *tree = art_new(sizeof(int));
+    u8 buf[64];
+    assert(art_get(tree, (const u8 *)"a", 1) == NULL);
+
+    for (int i = 0; i < KEYS; i++)
+    {
+        usize len = make_key(buf, i);
+        assert(art_set(tree, buf, len, &i) == 0);
+    }
+    assert(art_count(tree) == KEYS);
+
+    for (int i = 0; i < KEYS; i++)
+    {
+        usize len = make_key(buf, i);
+        assert(*(int *)art_get(tree, buf, len) == i);
+    }
+    assert(!art_exist(tree, (const u8 *)"/api/v1/users", 13));
+    assert(!art_exist(tree, (const u8 *)"/api/v1/users/1/profile/setting", 31));
+
+    // 空key和更新
+    art_set(tree, (const u8 *)"", 0, &(int){-1});
+    assert(*(int *)art_get(tree, (const u8 *)"", 0) == -1);
+    art_set(tree, (const u8 *)"1", 1, &(int){-2});
+    assert(*(int *)art_get(tree, (const u8 *)"1", 1) == -2);
+    art_set(tree, (const u8 *)"1", 1, NULL);
+    assert(art_exist(tree, (const u8 *)"1", 1));
+    assert(art_get(tree, (const u8 *)"1", 1) == NULL);
+    assert(art_count(tree) == KEYS + 2);
+
+    walk_ctx w = {0};
+    art_foreach(tree, check_order, &w);
+    assert(w.n == KEYS + 2);
+    art_free(tree);
+}
+
+void test_remove()
+{
+    printf("============== test_remove ===========\n");
+    art *tree = art_new(sizeof(int));
+    u8 *present = calloc(KEYS, 1);
+    u8 buf[64];
+    srand(1);
+
+    for (int round = 0; round < 4 * KEYS; round++)
+    {
+        int i = rand() % KEYS;
+        usize len = make_key(buf, i);
+        if (rand() % 3)
+        {
+            art_set(tree, buf, len, &i);
+            present[i] = 1;
+        }
+        else
+        {
+            assert(art_remove(tree, buf, len) == 0);
+            present[i] = 0;
+        }
+    }
+
+    int alive = 0;
+    for (int i = 0; i < KEYS; i++)
+    {
+        usize len = make_key(buf, i);
+        assert(art_exist(tree, buf, len) == present[i]);
+        alive += present[i];
+    }
+    assert(art_count(tree) == alive);
+
+    walk_ctx w = {0};
+    art_foreach(tree, check_order, &w);
+    assert(w.n == alive);
+
+    for (int i = 0; i < KEYS; i++)
+    {
+        usize len = make_key(buf, i);
+        art_remove(tree, buf, len);
+    }
+    assert(art_count(tree) == 0);
+    assert(tree->root == NULL);
+    free(present);
+    art_free(tree);
+}
+
+void test_prefix()
+{
+    printf("============== test_prefix ===========\n");
+    art *tree = art_new(0);
+    const char *routes[] = {"/", "/api", "/api/v1", "/api/v1/users", "/api/v2", "/static", "/static/js/app.js"};
+    for (int i = 0; i < 7; i++)
+    {
+        art_set(tree, (const u8 *)routes[i], strlen(routes[i]), (void *)routes[i]);
+    }
+
+    void *value = NULL;
+    const char *path = "/api/v1/users/42";
+    assert(art_longest_prefix(tree, (const u8 *)path, strlen(path), &value) == 13);
+    assert(value == routes[3]);
+    path = "/api/v1x";
+    assert(art_longest_prefix(tree, (const u8 *)path, strlen(path), &value) == 7);
+    path = "/apix";
+    assert(art_longest_prefix(tree, (const u8 *)path, strlen(path), &value) == 4);
+    path = "/static/js/app.jsx";
+    assert(art_longest_prefix(tree, (const u8 *)path, strlen(path), &value) == 17);
+    path = "/static/j";
+    assert(art_longest_prefix(tree, (const u8 *)path, strlen(path), &value) == 7);
+    path = "x/";
+    assert(art_longest_prefix(tree, (const u8 *)path, strlen(path), NULL) == -1);
+
+    walk_ctx w = {0};
+    art_prefix_foreach(tree, (const u8 *)"/api", 4, check_order, &w);
+    assert(w.n == 4);
+    w = (walk_ctx){0};
+    art_prefix_foreach(tree, (const u8 *)"/api/v", 6, check_order, &w);
+    assert(w.n == 3);
+    w = (walk_ctx){0};
+    // 在压缩路径中间结束
+    art_prefix_foreach(tree, (const u8 *)"/static/j", 9, check_order, &w);
+    assert(w.n == 1 && w.prev_len == 17);
+    w = (walk_ctx){0};
+    art_prefix_foreach(tree, (const u8 *)"/b", 2, check_order, &w);
+    assert(w.n == 0);
+    w = (walk_ctx){{0}, 0, 0, 2};
+    art_prefix_foreach(tree, (const u8 *)"", 0, check_order, &w);
+    assert(w.n == 2);
+
+    // IP前缀, 按位展开的key
+    art *ip = art_new(sizeof(int));
+    u8 net[4] = {10, 0, 0, 0};
+    art_set(ip, net, 1, &(int){8});
+    art_set(ip, net, 2, &(int){16});
+    net[2] = 7;
+    art_set(ip, net, 3, &(int){24});
+    u8 addr[4] = {10, 0, 7, 9};
+    assert(art_longest_prefix(ip, addr, 4, &value) == 3 && *(int *)value == 24);
+    addr[2] = 8;
+    assert(art_longest_prefix(ip, addr, 4, &value) == 2 && *(int *)value == 16);
+    addr[1] = 1;
+    assert(art_longest_prefix(ip, addr, 4, &value) == 1 && *(int *)value == 8);
+    art_free(ip);
+    art_free(tree);
+}
+
+void test_string_keys()
+{
+    printf("============== test_string_keys ===========\n");
+    art *tree = art_new(0);
+    art_set_vfree(tree, free);
+    string *s = string_new(16);
+    for (int i = 0; i < 1000; i++)
+    {
+        s->len = 0;
+        string_push(s, (u8 *)"user:", 5);
+        string_push_i64(s, i);
+        int *value = malloc(sizeof(int));
+        *value = i;
+        assert(art_set_string(tree, s, value) == 0);
+    }
+    assert(art_count(tree) == 1000);
+
+    string *key = string_from_char("user:512");
+    assert(*(int *)art_get_string(tree, key) == 512);
+    art_remove_string(tree, key);
+    assert(art_get_string(tree, key) == NULL);
+    assert(art_count(tree) == 999);
+
+    walk_ctx w = {0};
+    art_prefix_foreach(tree, (const u8 *)"user:51", 7, check_order, &w);
+    assert(w.n == 10);
+
+    string_free(key);
+    string_free(s);
+    art_free(tree);
+}
+
+int main()
+{
+    printf("============== START ===========\n");
+    test_set_and_get();
+    test_remove();
+    test_prefix();
+    test_string_keys();
+    printf("============== DONE ===========\n");
+    return 0;
+}
@@ -0,0 +1,311 @@
+#include "../cbtree.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEYS 100000
+
+int cmp_u64(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a;
+    u64 y = *(const u64 *)b;
+    return (x > y) - (x < y);
+}
+
+int str_cmp(const void *key1, const void *key2, usize ksize)
+{
+    return strcmp((const char *)key1, (const char *)key2);
+}
+
+typedef struct range_ctx
+{
+    u64 prev;
+    int n;
+    int limit;
+} range_ctx;
+
+int check_range(void *key, void *value, void *ctx)
+{
+    range_ctx *r = (range_ctx *)ctx;
+    u64 k = *(u64 *)key;
+    assert(r->n == 0 || k > r->prev);
+    assert(*(u64 *)value == k * 2);
+    r->prev = k;
+    r->n++;
+    return r->limit && r->n >= r->limit;
+}
+
+void test_set_and_get()
+{
+    printf("============== test_set_and_get ===========\n");
+    btree *tree = btree_new(sizeof(u64), sizeof(u64), NULL);
+    assert(tree->key_kind == BTREE_KEY_U64);
+    assert(btree_count(tree) == 0);
+    assert(btree_get(tree, &(u64){1}) == NULL);
+    btree_iterator empty = btree_begin(tree);
+    assert(!btree_iter_valid(&empty));
+
+    // 乱序插入, 跨越多层节点
+    for (u64 i = 0; i < KEYS; i++)
+    {
+        u64 key = (i * 7919) % KEYS;
+        assert(btree_set(tree, &key, &(u64){key * 2}) == 0);
+    }
+    assert(btree_count(tree) == KEYS);
+    assert(!tree->root->leaf);
+
+    for (u64 key = 0; key < KEYS; key++)
+    {
+        assert(*(u64 *)btree_get(tree, &key) == key * 2);
+    }
+    assert(!btree_exist(tree, &(u64){KEYS}));
+
+    btree_set(tree, &(u64){5}, &(u64){6});
+    assert(*(u64 *)btree_get(tree, &(u64){5}) == 6);
+    btree_set(tree, &(u64){5}, NULL);
+    assert(btree_exist(tree, &(u64){5}));
+    assert(btree_get(tree, &(u64){5}) == NULL);
+    assert(btree_count(tree) == KEYS);
+
+    // 有序遍历
+    u64 expect = 0;
+    for (btree_iterator iter = btree_begin(tree); btree_iter_valid(&iter); btree_iter_next(&iter))
+    {
+        assert(*(u64 *)btree_iter_key(&iter) == expect++);
+    }
+    assert(expect == KEYS);
+
+    for (btree_iterator iter = btree_last(tree); btree_iter_valid(&iter); btree_iter_prev(&iter))
+    {
+        assert(*(u64 *)btree_iter_key(&iter) == --expect);
+    }
+    assert(expect == 0);
+    btree_free(tree);
+}
+
+void test_floor_ceil()
+{
+    printf("============== test_floor_ceil ===========\n");
+    btree *tree = btree_new(sizeof(u64), sizeof(u64), NULL);
+    // 只有10的倍数, 包含最大值
+    for (u64 key = 10; key <= 10000; key += 10)
+    {
+        btree_set(tree, &key, &(u64){key * 2});
+    }
+    btree_set(tree, &(u64){UINT64_MAX}, &(u64){UINT64_MAX * 2});
+
+    for (u64 key = 0; key < 10020; key++)
+    {
+        u64 ceil = key <= 10000 ? (key + 9) / 10 * 10 : UINT64_MAX;
+        ceil = ceil ? ceil : 10;
+        btree_iterator iter = btree_seek(tree, &key);
+        assert(*(u64 *)btree_iter_key(&iter) == ceil);
+
+        u64 upper = key < 10000 ? key / 10 * 10 + 10 : UINT64_MAX;
+        iter = btree_upper(tree, &key);
+        assert(*(u64 *)btree_iter_key(&iter) == upper);
+
+        iter = btree_floor(tree, &key);
+        if (key < 10)
+        {
+            assert(!btree_iter_valid(&iter));
+        }
+        else
+        {
+            u64 floor = key <= 10000 ? key / 10 * 10 : 10000;
+            assert(*(u64 *)btree_iter_key(&iter) == floor);
+        }
+    }
+
+    btree_iterator iter = btree_upper(tree, &(u64){UINT64_MAX});
+    assert(!btree_iter_valid(&iter));
+    iter = btree_floor(tree, &(u64){UINT64_MAX});
+    assert(*(u64 *)btree_iter_key(&iter) == UINT64_MAX);
+
+    // [lo, hi)
+    range_ctx r = {0, 0, 0};
+    btree_range(tree, &(u64){95}, &(u64){200}, check_range, &r);
+    assert(r.n == 10 && r.prev == 190);
+    r = (range_ctx){0, 0, 0};
+    btree_range(tree, NULL, NULL, check_range, &r);
+    assert(r.n == 1001);
+    r = (range_ctx){0, 0, 5};
+    btree_range(tree, &(u64){1000}, NULL, check_range, &r);
+    assert(r.n == 5 && r.prev == 1040);
+    btree_free(tree);
+}
+
+void test_remove()
+{
+    printf("============== test_remove ===========\n");
+    btree *tree = btree_new(sizeof(u32), sizeof(u32), NULL);
+    assert(tree->key_kind == BTREE_KEY_U32);
+    u8 *present = calloc(KEYS, 1);
+    srand(1);
+
+    for (int round = 0; round < 4 * KEYS; round++)
+    {
+        u32 key = (u32)(rand() % KEYS);
+        if (rand() % 3)
+        {
+            btree_set(tree, &key, &key);
+            present[key] = 1;
+        }
+        else
+        {
+            assert(btree_remove(tree, &key) == 0);
+            present[key] = 0;
+        }
+    }
+
+    usize alive = 0;
+    for (u32 key = 0; key < KEYS; key++)
+    {
+        assert(btree_exist(tree, &key) == present[key]);
+        alive += present[key];
+    }
+    assert(btree_count(tree) == (size)alive);
+
+    u32 prev = 0;
+    usize n = 0;
+    for (btree_iterator iter = btree_begin(tree); btree_iter_valid(&iter); btree_iter_next(&iter))
+    {
+        u32 key = *(u32 *)btree_iter_key(&iter);
+        assert(n == 0 || key > prev);
+        assert(*(u32 *)btree_iter_value(&iter) == key);
+        prev = key;
+        n++;
+    }
+    assert(n == alive);
+
+    for (u32 key = 0; key < KEYS; key++)
+    {
+        btree_remove(tree, &key);
+    }
+    assert(btree_count(tree) == 0);
+    assert(tree->root == NULL);
+    btree_iterator empty = btree_last(tree);
+    assert(!btree_iter_valid(&empty));
+    free(present);
+    btree_free(tree);
+}
+
+void test_load_sorted()
+{
+    printf("============== test_load_sorted ===========\n");
+    for (usize n = 0; n < 3000; n += 37)
+    {
+        u64 *keys = malloc(sizeof(u64) * (n + 1));
+        u64 *values = malloc(sizeof(u64) * (n + 1));
+        for (usize i = 0; i < n; i++)
+        {
+            keys[i] = i * 3;
+            values[i] = i * 6;
+        }
+
+        btree *tree = btree_new(sizeof(u64), sizeof(u64), NULL);
+        assert(btree_load_sorted(tree, keys, values, n) == 0);
+        assert(btree_count(tree) == (size)n);
+
+        range_ctx r = {0, 0, 0};
+        btree_range(tree, NULL, NULL, check_range, &r);
+        assert(r.n == (int)n);
+
+        // 构建后仍可修改
+        for (usize i = 0; i < n; i += 2)
+        {
+            btree_remove(tree, &keys[i]);
+            btree_set(tree, &(u64){keys[i] + 1}, &(u64){keys[i] * 2 + 2});
+        }
+        for (usize i = 0; i < n; i++)
+        {
+            assert(btree_exist(tree, &keys[i]) == (b32)(i % 2));
+        }
+        r = (range_ctx){0, 0, 0};
+        btree_range(tree, NULL, NULL, check_range, &r);
+        assert(r.n == (int)n);
+
+        assert(btree_load_sorted(tree, keys, values, n) == (n != 0));
+        btree_free(tree);
+
+        if (n > 1)
+        {
+            // 非严格升序时失败
+            keys[n - 1] = keys[n - 2];
+            tree = btree_new(sizeof(u64), sizeof(u64), NULL);
+            assert(btree_load_sorted(tree, keys, NULL, n) != 0);
+            assert(btree_count(tree) == 0);
+            btree_free(tree);
+        }
+        free(keys);
+        free(values);
+    }
+}
+
+void test_generic_keys()
+{
+    printf("============== test_generic_keys ===========\n");
+    // 指针key, 自定义比较函数
+    btree *tree = btree_new(0, sizeof(int), str_cmp);
+    assert(tree->key_kind == BTREE_KEY_GENERIC);
+    btree_set_kfree(tree, free);
+
+    char buf[32];
+    for (int i = 0; i < 5000; i++)
+    {
+        sprintf(buf, "key%05d", (i * 31) % 5000);
+        btree_set(tree, strdup(buf), &i);
+    }
+    assert(btree_count(tree) == 5000);
+    btree_iterator iter = btree_begin(tree);
+    assert(strcmp(btree_iter_key(&iter), "key00000") == 0);
+    iter = btree_last(tree);
+    assert(strcmp(btree_iter_key(&iter), "key04999") == 0);
+
+    iter = btree_seek(tree, "key01234x");
+    assert(strcmp(btree_iter_key(&iter), "key01235") == 0);
+    iter = btree_floor(tree, "key01234x");
+    assert(strcmp(btree_iter_key(&iter), "key01234") == 0);
+
+    // 被移除的key释放后, 内部节点的分隔key不能再引用它
+    for (int i = 0; i < 5000; i += 3)
+    {
+        sprintf(buf, "key%05d", i);
+        assert(btree_remove(tree, buf) == 0);
+    }
+    for (int i = 0; i < 5000; i++)
+    {
+        sprintf(buf, "key%05d", i);
+        assert(btree_exist(tree, buf) == (i % 3 != 0));
+    }
+    btree_free(tree);
+
+    // 16字节key, 默认memcmp按字节序
+    tree = btree_new(16, 0, NULL);
+    u8 key[16] = {0};
+    for (int i = 255; i >= 0; i--)
+    {
+        key[0] = (u8)i;
+        btree_set(tree, key, (void *)(uintptr_t)(i + 1));
+    }
+    iter = btree_begin(tree);
+    for (int i = 0; i < 256; i++, btree_iter_next(&iter))
+    {
+        assert(((u8 *)btree_iter_key(&iter))[0] == i);
+        assert((uintptr_t)btree_iter_value(&iter) == (uintptr_t)(i + 1));
+    }
+    btree_free(tree);
+}
+
+int main()
+{
+    printf("============== START ===========\n");
+    test_set_and_get();
+    test_floor_ceil();
+    test_remove();
+    test_load_sorted();
+    test_generic_keys();
+    printf("============== DONE ===========\n");
+    return 0;
+}
@@ -0,0 +1,48 @@
+// 以单头文件方式编译全部模块, 检查各.c文件合并后没有重名的符号
+#define CEXTLIB_IMPLEMENTATION
+#include "../cextlib.h"
+#include <assert.h>
+#include <stdio.h>
+
+void test_amalgamation()
+{
+    printf("============== test_amalgamation ===========\n");
+    vec *v = vec_new(sizeof(i32));
+    for (i32 i = 0; i < 1000; i++)
+    {
+        vec_push(v, &i);
+    }
+    i32 x = 500;
+    assert(vec_find_default(v, &x) == 500);
+    assert(vec_count_eq(v, &x) == 1);
+
+    i32 zero = 0, sum = 0;
+    assert(vec_reduce(v, &sum, &zero, vec_op_sum_i32, NULL, NULL) == 0);
+    assert(sum == 999 * 1000 / 2);
+    vec *prefix = vec_new(sizeof(i32));
+    assert(vec_scan(prefix, v, &zero, vec_op_sum_i32, NULL, NULL) == 0);
+    assert(*(i32 *)vec_get(prefix, -1) == sum);
+
+    hashmap *map = hashmap_new(sizeof(i32), sizeof(i32), 0, NULL, NULL);
+    for (i32 i = 0; i < 1000; i++)
+    {
+        hashmap_set(map, &i, &i);
+    }
+    assert(*(i32 *)hashmap_get(map, &x) == 500);
+
+    string *s = string_from_char("cextlib");
+    assert(s->len == 7);
+
+    hashmap_free(map);
+    string_free(s);
+    vec_free(prefix);
+    vec_free(v);
+}
+
+int main()
+{
+    printf("============== START ===========\n");
+    test_amalgamation();
+    printf("============== DONE ===========\n");
+    return 0;
+}
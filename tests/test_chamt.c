@@ -0,0 +1,167 @@
+#include "../chamt.h"
+#include <assert.h>
+#include <stdio.h>
+
+u64 bad_hasher(const void *data, usize dsize, u64 seed)
+{
+    // 只有8种hash, 用于测试冲突节点
+    return *(int *)data % 8;
+}
+
+int count_items(void *key, void *value, void *ctx)
+{
+    *(int *)ctx += 1;
+    return 0;
+}
+
+void test_set_and_get()
+{
+    printf("============== test_set_and_get ===========\n");
+    hamt *map = hamt_new(sizeof(int), sizeof(int), 123456, NULL, NULL);
+    assert(hamt_count(map) == 0);
+    assert(hamt_get(map, &(int){1}) == NULL);
+
+    for (int item = 0; item < 10000; item++)
+    {
+        assert(hamt_set(map, &item, &item) == 0);
+    }
+    assert(hamt_count(map) == 10000);
+
+    for (int item = 0; item < 10000; item++)
+    {
+        assert(*(int *)hamt_get(map, &item) == item);
+    }
+    assert(!hamt_exist(map, &(int){10000}));
+
+    hamt_set(map, &(int){1}, &(int){2});
+    assert(*(int *)hamt_get(map, &(int){1}) == 2);
+    assert(hamt_count(map) == 10000);
+
+    hamt_set(map, &(int){1}, NULL);
+    assert(hamt_exist(map, &(int){1}));
+    assert(hamt_get(map, &(int){1}) == NULL);
+
+    int n = 0;
+    hamt_foreach(map, count_items, &n);
+    assert(n == 10000);
+    hamt_free(map);
+}
+
+void test_remove()
+{
+    printf("============== test_remove ===========\n");
+    hamt *map = hamt_new(sizeof(int), sizeof(int), 123456, NULL, NULL);
+    for (int item = 0; item < 10000; item++)
+    {
+        hamt_set(map, &item, &item);
+    }
+
+    for (int item = 0; item < 10000; item += 2)
+    {
+        assert(hamt_remove(map, &item) == 0);
+    }
+    assert(hamt_count(map) == 5000);
+    assert(hamt_remove(map, &(int){0}) == 0);
+    assert(hamt_count(map) == 5000);
+
+    for (int item = 0; item < 10000; item++)
+    {
+        if (item % 2)
+        {
+            assert(*(int *)hamt_get(map, &item) == item);
+        }
+        else
+        {
+            assert(!hamt_exist(map, &item));
+        }
+    }
+
+    for (int item = 1; item < 10000; item += 2)
+    {
+        hamt_remove(map, &item);
+    }
+    assert(hamt_count(map) == 0);
+    assert(map->root == NULL);
+    hamt_free(map);
+}
+
+void test_snapshot()
+{
+    printf("============== test_snapshot ===========\n");
+    hamt *map = hamt_new(sizeof(int), sizeof(int), 123456, NULL, NULL);
+    for (int item = 0; item < 1000; item++)
+    {
+        hamt_set(map, &item, &item);
+    }
+
+    hamt *snapshot = hamt_snapshot(map);
+    assert(snapshot->root == map->root);
+
+    for (int item = 0; item < 1000; item += 3)
+    {
+        hamt_set(map, &item, &(int){-item});
+    }
+    hamt_remove(map, &(int){1});
+    hamt_set(map, &(int){5000}, &(int){5000});
+
+    hamt *snapshot2 = hamt_snapshot(map);
+    hamt_remove(map, &(int){2});
+
+    // 快照不受之后修改的影响
+    assert(hamt_count(snapshot) == 1000);
+    for (int item = 0; item < 1000; item++)
+    {
+        assert(*(int *)hamt_get(snapshot, &item) == item);
+    }
+    assert(!hamt_exist(snapshot, &(int){5000}));
+
+    assert(hamt_count(snapshot2) == 1000);
+    assert(!hamt_exist(snapshot2, &(int){1}));
+    assert(*(int *)hamt_get(snapshot2, &(int){2}) == 2);
+    assert(*(int *)hamt_get(snapshot2, &(int){3}) == -3);
+
+    assert(hamt_count(map) == 999);
+    assert(!hamt_exist(map, &(int){2}));
+
+    hamt_free(map);
+    assert(*(int *)hamt_get(snapshot2, &(int){5000}) == 5000);
+    hamt_free(snapshot2);
+    hamt_free(snapshot);
+}
+
+void test_collision()
+{
+    printf("============== test_collision ===========\n");
+    hamt *map = hamt_new(sizeof(int), sizeof(int), 123456, bad_hasher, NULL);
+    for (int item = 0; item < 200; item++)
+    {
+        hamt_set(map, &item, &item);
+    }
+    assert(hamt_count(map) == 200);
+
+    hamt *snapshot = hamt_snapshot(map);
+    for (int item = 0; item < 200; item += 2)
+    {
+        hamt_remove(map, &item);
+    }
+    assert(hamt_count(map) == 100);
+    for (int item = 0; item < 200; item++)
+    {
+        assert(hamt_exist(map, &item) == (item % 2));
+        assert(*(int *)hamt_get(snapshot, &item) == item);
+    }
+
+    hamt_free(snapshot);
+    hamt_free(map);
+}
+
+int main()
+{
+    printf("============== START ===========\n");
+    test_set_and_get();
+    test_remove();
+    test_snapshot();
+    test_collision();
+    printf("============== DONE ===========\n");
+    return 0;
+}
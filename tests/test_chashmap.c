@@ -121,6 +121,16 @@ void print_int_map_items(hashmap *map)
     }
 }
 
+u64 hasher_with_seed(const void *data, usize dsize, u64 seed)
+{
+    u64 hash = seed;
+    for (usize i = 0; i < dsize; i++)
+    {
+        hash = (hash ^ ((u8 *)data)[i]) * 0x100000001b3;
+    }
+    return hash;
+}
+
 void test_new()
 {
     printf("============== test_new ===========\n");
@@ -343,6 +353,490 @@ void test_free()
     // hashmap_set(map, &(int){4}, &(int){4});
 }
 
+void test_freeze()
+{
+    printf("============== test_freeze ===========\n");
+    hashmap *map;
+    hashmap_frozen *frozen;
+
+    map = hashmap_new(sizeof(int), sizeof(int), 123456, NULL, NULL);
+    for (int item = 0; item < 10000; item++)
+    {
+        hashmap_set(map, &item, &(int){item * 2});
+    }
+    hashmap_set(map, &(int){10000}, NULL);
+    hashmap_set(map, NULL, &(int){-1});
+
+    frozen = hashmap_freeze(map);
+    assert(frozen != NULL);
+    assert(hashmap_frozen_count(frozen) == hashmap_count(map));
+    for (int item = 0; item < 10000; item++)
+    {
+        assert(*(int *)hashmap_frozen_get(frozen, &item) == item * 2);
+    }
+    assert(hashmap_frozen_exist(frozen, &(int){10000}));
+    assert(hashmap_frozen_get(frozen, &(int){10000}) == NULL);
+    assert(!hashmap_frozen_exist(frozen, &(int){10001}));
+    assert(hashmap_frozen_get(frozen, &(int){-5}) == NULL);
+    assert(*(int *)hashmap_frozen_get(frozen, NULL) == -1);
+
+    assert(hashmap_frozen_save(frozen, "test_freeze.bin") == 0);
+    hashmap_frozen *loaded = hashmap_frozen_load("test_freeze.bin", NULL, NULL);
+    assert(loaded != NULL);
+    assert(hashmap_frozen_count(loaded) == hashmap_frozen_count(frozen));
+    for (int item = 0; item < 10000; item++)
+    {
+        assert(*(int *)hashmap_frozen_get(loaded, &item) == item * 2);
+    }
+    assert(!hashmap_frozen_exist(loaded, &(int){10001}));
+    assert(*(int *)hashmap_frozen_get(loaded, NULL) == -1);
+
+    // hasher不一致或文件损坏时失败
+    assert(hashmap_frozen_load("test_freeze.bin", hasher_with_seed, NULL) == NULL);
+    u64 header[12];
+    FILE *f = fopen("test_freeze.bin", "r+b");
+    assert(fread(header, sizeof(u64), 12, f) == 12);
+    u32 bad_remap = UINT32_MAX;
+    fseek(f, sizeof(header) + sizeof(u16) * header[5], SEEK_SET);
+    fwrite(&bad_remap, sizeof(u32), 1, f);
+    fclose(f);
+    assert(hashmap_frozen_load("test_freeze.bin", NULL, NULL) == NULL);
+    header[4] = UINT32_MAX; // len
+    f = fopen("test_freeze.bin", "r+b");
+    fwrite(header, sizeof(u64), 12, f);
+    fclose(f);
+    assert(hashmap_frozen_load("test_freeze.bin", NULL, NULL) == NULL);
+    remove("test_freeze.bin");
+
+    hashmap_frozen_free(loaded);
+    hashmap_frozen_free(frozen);
+    hashmap_free(map);
+
+    // 空表
+    map = hashmap_new(sizeof(int), 0, 123456, NULL, NULL);
+    frozen = hashmap_freeze(map);
+    assert(frozen != NULL);
+    assert(hashmap_frozen_count(frozen) == 0);
+    assert(!hashmap_frozen_exist(frozen, &(int){1}));
+    hashmap_frozen_free(frozen);
+    hashmap_free(map);
+}
+
+void test_snapshot()
+{
+    printf("============== test_snapshot ===========\n");
+    hashmap *map, *mapped;
+
+    map = hashmap_new(sizeof(int), sizeof(int), 123456, NULL, NULL);
+    for (int item = 0; item < 1000; item++)
+    {
+        hashmap_set(map, &item, &(int){item + 1});
+    }
+    assert(hashmap_save(map, "test_snapshot.bin") == 0);
+
+    // 只读映射
+    mapped = hashmap_open_mmap("test_snapshot.bin", HASHMAP_MMAP_READONLY | HASHMAP_MMAP_VERIFY, NULL, NULL);
+    assert(mapped != NULL);
+    assert(mapped->mmap_base != NULL);
+    assert(hashmap_count(mapped) == 1000);
+    for (int item = 0; item < 1000; item++)
+    {
+        assert(*(int *)hashmap_get(mapped, &item) == item + 1);
+    }
+    assert(!hashmap_exist(mapped, &(int){1000}));
+    assert(hashmap_set(mapped, &(int){1000}, &(int){1}) != 0);
+    assert(hashmap_remove(mapped, &(int){1}) != 0);
+    hashmap_free(mapped);
+
+    // 写时复制映射, 修改和扩容不影响文件
+    mapped = hashmap_open_mmap("test_snapshot.bin", HASHMAP_MMAP_PRIVATE, NULL, NULL);
+    assert(mapped != NULL);
+    hashmap_remove(mapped, &(int){0});
+    for (int item = 1000; item < 3000; item++)
+    {
+        assert(hashmap_set(mapped, &item, &(int){item + 1}) == 0);
+    }
+    assert(mapped->mmap_base == NULL);
+    assert(hashmap_count(mapped) == 2999);
+    assert(!hashmap_exist(mapped, &(int){0}));
+    assert(*(int *)hashmap_get(mapped, &(int){2999}) == 3000);
+    hashmap_free(mapped);
+
+    mapped = hashmap_open_mmap("test_snapshot.bin", HASHMAP_MMAP_READONLY | HASHMAP_MMAP_VERIFY, NULL, NULL);
+    assert(mapped != NULL);
+    assert(hashmap_count(mapped) == 1000);
+    assert(*(int *)hashmap_get(mapped, &(int){0}) == 1);
+    hashmap_free(mapped);
+
+    // seed不同的表
+    hashmap *map2 = hashmap_new(sizeof(int), sizeof(int), 654321, hasher_with_seed, NULL);
+    hashmap_set(map2, &(int){1}, &(int){1});
+    assert(hashmap_save(map2, "test_snapshot.bin") == 0);
+    assert(hashmap_open_mmap("test_snapshot.bin", HASHMAP_MMAP_READONLY, NULL, NULL) == NULL);
+    mapped = hashmap_open_mmap("test_snapshot.bin", HASHMAP_MMAP_READONLY, hasher_with_seed, NULL);
+    assert(mapped != NULL);
+    assert(*(int *)hashmap_get(mapped, &(int){1}) == 1);
+    hashmap_free(mapped);
+    hashmap_free(map2);
+
+    // cap过大使数组大小的乘法溢出, 偏移随之回绕仍落在文件内, 需要拒绝
+    assert(hashmap_save(map, "test_snapshot.bin") == 0);
+    FILE *f = fopen("test_snapshot.bin", "r+b");
+    u64 header[15];
+    assert(fread(header, sizeof(u64), 15, f) == 15);
+    header[5] = 1ull << 62;   // cap
+    header[13] -= 1ull << 62; // flags_off
+    fseek(f, 0, SEEK_SET);
+    fwrite(header, sizeof(u64), 15, f);
+    fclose(f);
+    assert(hashmap_open_mmap("test_snapshot.bin", HASHMAP_MMAP_READONLY, NULL, NULL) == NULL);
+
+    // 桶全部非空时查找不存在的key不会结束, 需要拒绝
+    assert(hashmap_save(map, "test_snapshot.bin") == 0);
+    f = fopen("test_snapshot.bin", "r+b");
+    assert(fread(header, sizeof(u64), 15, f) == 15);
+    fseek(f, header[10], SEEK_SET); // buckets_off
+    for (u64 i = 0; i < header[5]; i++)
+    {
+        fwrite(&(usize){1}, sizeof(usize), 1, f);
+    }
+    fclose(f);
+    assert(hashmap_open_mmap("test_snapshot.bin", HASHMAP_MMAP_READONLY, NULL, NULL) == NULL);
+    header[6] = header[5]; // len
+    f = fopen("test_snapshot.bin", "r+b");
+    fwrite(header, sizeof(u64), 15, f);
+    fclose(f);
+    assert(hashmap_open_mmap("test_snapshot.bin", HASHMAP_MMAP_READONLY, NULL, NULL) == NULL);
+
+    remove("test_snapshot.bin");
+    hashmap_free(map);
+}
+
+void test_int_key()
+{
+    printf("============== test_int_key ===========\n");
+    hashmap *map;
+
+    map = hashmap_new(sizeof(u32), sizeof(u32), 123456, NULL, NULL);
+    assert(map->key_kind == HASHMAP_KEY_U32);
+    hashmap_free(map);
+
+    map = hashmap_new(sizeof(u32), sizeof(u32), 123456, hasher_with_seed, NULL);
+    assert(map->key_kind == HASHMAP_KEY_GENERIC);
+    hashmap_free(map);
+
+    map = hashmap_new(sizeof(u64), sizeof(u64), 123456, NULL, NULL);
+    assert(map->key_kind == HASHMAP_KEY_U64);
+    for (u64 item = 0; item < 5000; item++)
+    {
+        hashmap_set(map, &(u64){item << 32 | item}, &item);
+    }
+    assert(hashmap_count(map) == 5000);
+    for (u64 item = 0; item < 5000; item += 2)
+    {
+        hashmap_remove(map, &(u64){item << 32 | item});
+    }
+    assert(hashmap_count(map) == 2500);
+    for (u64 item = 0; item < 5000; item++)
+    {
+        u64 *value = hashmap_get(map, &(u64){item << 32 | item});
+        if (item % 2)
+        {
+            assert(value && *value == item);
+        }
+        else
+        {
+            assert(value == NULL);
+        }
+    }
+    assert(!hashmap_exist(map, &(u64){1}));
+
+    hashmap *map2 = hashmap_clone(map);
+    assert(map2->key_kind == HASHMAP_KEY_U64);
+    assert(*(u64 *)hashmap_get(map2, &(u64){1ull << 32 | 1}) == 1);
+    hashmap_free(map2);
+    hashmap_free(map);
+}
+
+u64 weak_hasher(const void *data, usize dsize, u64 seed)
+{
+    // 模拟攻击者已知seed时构造的全冲突key
+    return seed == 123456 ? 0 : hashmap_siphash(data, dsize, seed);
+}
+
+void test_keyed()
+{
+    printf("============== test_keyed ===========\n");
+    hashmap *map;
+
+    assert(hashmap_siphash("abc", 3, 1) != hashmap_siphash("abc", 3, 2));
+    assert(hashmap_siphash("abc", 3, 1) != hashmap_siphash("abd", 3, 1));
+    assert(hashmap_siphash("abc", 3, 1) == hashmap_siphash("abc", 3, 1));
+
+    map = hashmap_new_keyed(INITIAL_BUCKETS, sizeof(int), sizeof(int), NULL);
+    assert(map->hasher == hashmap_siphash);
+    assert(map->reseed_psl == HASHMAP_RESEED_PSL);
+    for (int item = 0; item < 1000; item++)
+    {
+        hashmap_set(map, &item, &item);
+    }
+    for (int item = 0; item < 1000; item++)
+    {
+        assert(*(int *)hashmap_get(map, &item) == item);
+    }
+    hashmap_free(map);
+
+    map = hashmap_new_with_cap(256, sizeof(int), sizeof(int), 123456, weak_hasher, NULL);
+    hashmap_set_reseed(map, 8);
+    hashmap_set(map, NULL, &(int){-1});
+    hashmap_set(map, &(int){-2}, NULL);
+    for (int item = 0; item < 100; item++)
+    {
+        assert(hashmap_set(map, &item, &item) == 0);
+    }
+    assert(map->seed != 123456);
+    assert(hashmap_count(map) == 102);
+    for (int item = 0; item < 100; item++)
+    {
+        assert(*(int *)hashmap_get(map, &item) == item);
+    }
+    assert(*(int *)hashmap_get(map, NULL) == -1);
+    assert(hashmap_exist(map, &(int){-2}) && hashmap_get(map, &(int){-2}) == NULL);
+    for (usize i = 0; i < map->cap; i++)
+    {
+        assert(map->buckets[i].psl == SIZE_MAX || map->buckets[i].psl <= map->reseed_psl);
+    }
+    hashmap_free(map);
+}
+
+void test_counter()
+{
+    printf("============== test_counter ===========\n");
+    b32 inserted;
+    hashmap *global = hashmap_counter_new(1024, sizeof(int), 123456, NULL, NULL);
+    *(i64 *)hashmap_entry(global, &(int){7}, &inserted) += 3;
+    assert(inserted);
+    *(i64 *)hashmap_entry(global, &(int){7}, &inserted) += 4;
+    assert(!inserted);
+    assert(hashmap_counter_get(global, &(int){7}) == 7);
+    assert(hashmap_counter_get(global, &(int){8}) == 0);
+
+    for (int item = 0; item < 5000; item++)
+    {
+        assert(hashmap_counter_add(global, &(int){item % 100}, 1) == 0);
+    }
+    assert(hashmap_count(global) == 100);
+    assert(hashmap_counter_get(global, &(int){7}) == 57);
+    assert(hashmap_counter_get(global, &(int){99}) == 50);
+
+    // 局部计数器与全局计数器结构相同, 合并时不重新hash
+    hashmap *locals[4];
+    for (int t = 0; t < 4; t++)
+    {
+        locals[t] = hashmap_counter_like(global);
+        assert(locals[t]->cap == global->cap && locals[t]->seed == global->seed);
+        for (int item = 0; item < 200; item++)
+        {
+            hashmap_counter_add(locals[t], &item, t + 1);
+        }
+    }
+    hashmap_counter_add(locals[0], NULL, 5);
+    for (int t = 0; t < 4; t++)
+    {
+        assert(hashmap_counter_merge(global, locals[t]) == 0);
+        hashmap_free(locals[t]);
+    }
+    assert(hashmap_count(global) == 201);
+    assert(hashmap_counter_get(global, &(int){7}) == 67);
+    assert(hashmap_counter_get(global, &(int){150}) == 10);
+    assert(hashmap_counter_get(global, NULL) == 5);
+
+    // 结构不同时按hash合并
+    hashmap *other = hashmap_counter_new(16, sizeof(int), 654321, NULL, NULL);
+    for (int item = 0; item < 300; item++)
+    {
+        hashmap_counter_add(other, &item, item);
+    }
+    assert(hashmap_counter_merge(global, other) == 0);
+    assert(hashmap_counter_get(global, &(int){150}) == 160);
+    assert(hashmap_counter_get(global, &(int){299}) == 299);
+    hashmap_free(other);
+
+    void *keys[5];
+    i64 counts[5];
+    assert(hashmap_counter_top(global, 5, keys, counts) == 5);
+    for (int i = 0; i < 5; i++)
+    {
+        assert(*(int *)keys[i] == 299 - i);
+        assert(counts[i] == 299 - i);
+    }
+
+    // 局部计数器保留重新hash的阈值和过滤器
+    hashmap_set_reseed(global, 32);
+    assert(hashmap_filter_enable(global, 10, 0) == 0);
+    hashmap *like = hashmap_counter_like(global);
+    assert(like->reseed_psl == 32 && like->filter && like->filter->bits_per_key == 10);
+    hashmap_free(like);
+    hashmap_free(global);
+
+    // 全冲突时探测长度推算hash下标
+    global = hashmap_counter_new(1024, sizeof(int), 123456, weak_hasher, NULL);
+    hashmap *local = hashmap_counter_like(global);
+    for (int item = 0; item < 300; item++)
+    {
+        hashmap_counter_add(global, &item, 1);
+        hashmap_counter_add(local, &(int){299 - item}, item);
+    }
+    assert(hashmap_counter_merge(global, local) == 0);
+    assert(hashmap_count(global) == 300);
+    for (int item = 0; item < 300; item++)
+    {
+        assert(hashmap_counter_get(global, &item) == 300 - item);
+    }
+    void *all[300];
+    assert(hashmap_counter_top(global, 1000, all, NULL) == 300);
+    assert(*(int *)all[0] == 0 && *(int *)all[299] == 299);
+    hashmap_free(local);
+    hashmap_free(global);
+}
+
+void test_alloc()
+{
+    printf("============== test_alloc ===========\n");
+    int flags[] = {
+        HASHMAP_ALLOC_HUGEPAGE,
+        HASHMAP_ALLOC_HUGETLB,
+        HASHMAP_ALLOC_HUGEPAGE | HASHMAP_ALLOC_NUMA_INTERLEAVE,
+        HASHMAP_ALLOC_NUMA_BIND,
+    };
+    for (int f = 0; f < 4; f++)
+    {
+        hashmap *map = hashmap_new(sizeof(int), sizeof(int), 123456, NULL, NULL);
+        hashmap_set(map, &(int){-1}, &(int){-1});
+        assert(hashmap_set_alloc(map, flags[f], 1) == 0);
+        assert(map->alloc_mapped == 0);
+        assert(*(int *)hashmap_get(map, &(int){-1}) == -1);
+
+        // 扩容后数组超过HASHMAP_LARGE_ALLOC时使用mmap
+        for (int item = 0; item < 400000; item++)
+        {
+            hashmap_set(map, &item, &item);
+        }
+        assert(map->cap * sizeof(bucket) >= HASHMAP_LARGE_ALLOC);
+        assert(map->alloc_mapped & 1);
+        for (int item = 0; item < 400000; item++)
+        {
+            assert(*(int *)hashmap_get(map, &item) == item);
+        }
+
+        hashmap *clone = hashmap_clone(map);
+        assert(clone->alloc_flags == flags[f]);
+        assert(hashmap_count(clone) == 400001);
+        hashmap_free(clone);
+
+        // 切换回malloc
+        assert(hashmap_set_alloc(map, HASHMAP_ALLOC_MALLOC, 0) == 0);
+        assert(map->alloc_mapped == 0);
+        assert(*(int *)hashmap_get(map, &(int){399999}) == 399999);
+        hashmap_free(map);
+    }
+}
+
+void test_filter()
+{
+    printf("============== test_filter ===========\n");
+    hashmap *map = hashmap_new(sizeof(int), sizeof(int), 123456, NULL, NULL);
+    for (int item = 0; item < 1000; item++)
+    {
+        hashmap_set(map, &item, &item);
+    }
+    assert(hashmap_filter_enable(map, 10, 1) == 0);
+
+    // 扩容时重建
+    for (int item = 1000; item < 100000; item++)
+    {
+        hashmap_set(map, &item, &item);
+    }
+    for (int item = 0; item < 100000; item++)
+    {
+        assert(*(int *)hashmap_get(map, &item) == item);
+    }
+
+    for (int item = 100000; item < 200000; item++)
+    {
+        assert(!hashmap_exist(map, &item));
+        assert(hashmap_get(map, &item) == NULL);
+    }
+    hashmap_filter_stats stats = hashmap_filter_get_stats(map->filter);
+    assert(stats.queries == 300000);
+    assert(stats.rejects + stats.false_positives == 200000);
+    assert(stats.fpr < 0.05);
+    assert(stats.bytes > 0);
+
+    // 删除不清除位, 重建后仍然正确
+    for (int item = 0; item < 100000; item += 2)
+    {
+        hashmap_remove(map, &item);
+    }
+    assert(hashmap_filter_rebuild(map) == 0);
+    for (int item = 0; item < 100000; item++)
+    {
+        assert(hashmap_exist(map, &item) == (item % 2));
+    }
+
+    hashmap *clone = hashmap_clone(map);
+    assert(clone->filter != NULL);
+    assert(*(int *)hashmap_get(clone, &(int){99999}) == 99999);
+    hashmap_free(clone);
+
+    hashmap_frozen *frozen = hashmap_freeze(map);
+    assert(frozen->filter != NULL);
+    for (int item = 0; item < 200000; item++)
+    {
+        assert(hashmap_frozen_exist(frozen, &item) == (item < 100000 && item % 2));
+    }
+    stats = hashmap_filter_get_stats(frozen->filter);
+    assert(stats.queries == 200000 && stats.fpr < 0.05);
+    hashmap_frozen_free(frozen);
+
+    hashmap_clear(map);
+    assert(!hashmap_exist(map, &(int){1}));
+    hashmap_filter_disable(map);
+    assert(map->filter == NULL);
+    hashmap_free(map);
+}
+
+static void sum_item(void *key, void *value, void *ctx)
+{
+    u64 *sum = (u64 *)ctx;
+    sum[0] += (u64)*(int *)key;
+    sum[1] += (u64)*(int *)value;
+    sum[2] += 1;
+}
+
+void test_for_each_range()
+{
+    printf("============== test_for_each_range ===========\n");
+    hashmap *map = hashmap_new(sizeof(int), sizeof(int), 123456, NULL, NULL);
+    u64 sum[3] = {0};
+    assert(hashmap_for_each_range(map, 0, map->cap, sum_item, sum) == 0 && "hashmap_for_each_range empty failed");
+
+    int n = 100000;
+    for (int item = 0; item < n; item++)
+    {
+        int value = item * 2;
+        hashmap_set(map, &item, &value);
+    }
+
+    // 区间之和等于全部元素
+    usize half = map->cap / 2;
+    size cnt = hashmap_for_each_range(map, 0, half, sum_item, sum);
+    cnt += hashmap_for_each_range(map, half, map->cap + 10, sum_item, sum);
+    assert(cnt == n && sum[2] == (u64)n && sum[0] == (u64)n * (n - 1) / 2 && sum[1] == (u64)n * (n - 1) && "hashmap_for_each_range failed");
+
+    hashmap_free(map);
+}
+
 int main()
 {
     printf("============== START ===========\n");
@@ -353,6 +847,14 @@ int main()
     test_update();
     test_clone();
     test_free();
+    test_freeze();
+    test_snapshot();
+    test_int_key();
+    test_keyed();
+    test_counter();
+    test_alloc();
+    test_filter();
+    test_for_each_range();
     printf("============== DONE ===========\n");
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "../chashmap_parallel.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static void sum_item(void *key, void *value, void *ctx)
+{
+    u64 *sum = (u64 *)ctx;
+    __atomic_add_fetch(&sum[0], (u64)*(int *)key, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sum[1], (u64)*(int *)value, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sum[2], 1, __ATOMIC_RELAXED);
+}
+
+void test_parallel_for_each()
+{
+    printf("============== test_parallel_for_each ===========\n");
+    hashmap *map = hashmap_new(sizeof(int), sizeof(int), 123456, NULL, NULL);
+    u64 sum[3] = {0};
+    hashmap_parallel_for_each(map, NULL, sum_item, sum);
+    assert(sum[2] == 0 && "hashmap_parallel_for_each empty failed");
+
+    int n = 100000;
+    for (int item = 0; item < n; item++)
+    {
+        int value = item * 2;
+        hashmap_set(map, &item, &value);
+    }
+
+    usize threads[] = {1, 4};
+    for (usize t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+    {
+        cpool *pool = cpool_new(threads[t]);
+        memset(sum, 0, sizeof(sum));
+        hashmap_parallel_for_each(map, pool, sum_item, sum);
+        assert(sum[2] == (u64)n && sum[0] == (u64)n * (n - 1) / 2 && sum[1] == (u64)n * (n - 1) && "hashmap_parallel_for_each failed");
+        cpool_free(pool);
+    }
+
+    hashmap_free(map);
+}
+
+int main()
+{
+    printf("============== START ===========\n");
+    test_parallel_for_each();
+    printf("============== DONE ===========\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include "../chll.h"
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <stdio.h>
+
+double rel_error(double estimate, double actual)
+{
+    return fabs(estimate - actual) / actual;
+}
+
+void test_exact_and_upgrade()
+{
+    printf("============== test_exact_and_upgrade ===========\n");
+    hll *h = hll_new(14, sizeof(u64), 123456, NULL);
+    assert(h->mode == HLL_EXACT);
+    assert(hll_count(h) == 0);
+
+    // 重复添加不影响计数
+    for (u64 i = 0; i < HLL_EXACT_MAX; i++)
+    {
+        assert(hll_add(h, &i) == 0);
+        assert(hll_add(h, &i) == 0);
+        assert(hll_count(h) == (double)(i + 1));
+    }
+    assert(h->mode == HLL_EXACT);
+
+    // 超过后转为稀疏表示
+    u64 n = HLL_EXACT_MAX;
+    for (; n < 3000; n++)
+    {
+        hll_add(h, &n);
+    }
+    assert(h->mode == HLL_SPARSE);
+    assert(h->exact == NULL);
+    assert(rel_error(hll_count(h), (double)n) < 0.01);
+
+    // 稀疏表示大于寄存器时转为稠密表示
+    for (; n < 200000; n++)
+    {
+        hll_add(h, &n);
+        if (h->mode == HLL_SPARSE)
+        {
+            assert(h->sparse_len * sizeof(u32) <= h->m);
+        }
+    }
+    assert(h->mode == HLL_DENSE);
+    assert(h->sparse == NULL);
+    assert(((uintptr_t)h->registers & 63) == 0);
+    assert(rel_error(hll_count(h), (double)n) < 0.03);
+
+    hll_clear(h);
+    assert(h->mode == HLL_EXACT);
+    assert(hll_count(h) == 0);
+    hll_free(h);
+}
+
+void test_accuracy()
+{
+    printf("============== test_accuracy ===========\n");
+    // 各表示之间的过渡处估计值连续
+    for (u8 p = HLL_MIN_PRECISION; p <= HLL_MAX_PRECISION; p += 2)
+    {
+        hll *h = hll_new(p, sizeof(u64), 99, NULL);
+        double tolerance = 4 * 1.04 / sqrt((double)((u64)1 << p)) + 0.005;
+        u64 next = 10;
+        for (u64 i = 0; i < 1000000; i++)
+        {
+            hll_add(h, &i);
+            if (i + 1 == next)
+            {
+                assert(rel_error(hll_count(h), (double)next) < tolerance);
+                next = next * 3 / 2;
+            }
+        }
+        hll_free(h);
+    }
+
+    hll *h = hll_new(12, 0, 7, NULL);
+    char buf[32];
+    for (int i = 0; i < 100000; i++)
+    {
+        int len = sprintf(buf, "user-%d", i % 50000);
+        hll_add_data(h, buf, (usize)len);
+    }
+    assert(rel_error(hll_count(h), 50000) < 0.07);
+    hll_free(h);
+}
+
+void test_merge()
+{
+    printf("============== test_merge ===========\n");
+    // 模拟4个线程各自计数, 区间有重叠
+    hll *base = hll_new(14, sizeof(u64), 123456, NULL);
+    hll *parts[4];
+    u64 sizes[4] = {10, 1000, 100000, 300000};
+    for (int t = 0; t < 4; t++)
+    {
+        parts[t] = hll_like(base);
+        for (u64 i = 0; i < sizes[t]; i++)
+        {
+            u64 key = i + (u64)t * 50000;
+            hll_add(parts[t], &key);
+        }
+    }
+    assert(parts[0]->mode == HLL_EXACT);
+    assert(parts[1]->mode == HLL_SPARSE);
+    assert(parts[2]->mode == HLL_DENSE);
+
+    // 合并顺序不影响结果
+    hll *a = hll_like(base);
+    hll *b = hll_like(base);
+    for (int t = 0; t < 4; t++)
+    {
+        assert(hll_merge(a, parts[t]) == 0);
+        assert(hll_merge(b, parts[3 - t]) == 0);
+    }
+    assert(a->mode == HLL_DENSE && b->mode == HLL_DENSE);
+    assert(memcmp(a->registers, b->registers, a->m) == 0);
+    // 并集为[0, 10) + [50000, 51000) + [100000, 450000)
+    assert(rel_error(hll_count(a), 351010) < 0.03);
+
+    // 小的合并仍为精确计数或稀疏表示
+    hll *c = hll_like(base);
+    hll_merge(c, parts[0]);
+    assert(c->mode == HLL_EXACT && hll_count(c) == 10);
+    hll_merge(c, parts[1]);
+    assert(c->mode == HLL_SPARSE);
+    assert(rel_error(hll_count(c), 1010) < 0.01);
+
+    hll *other = hll_new(12, sizeof(u64), 123456, NULL);
+    assert(hll_merge(a, other) != 0);
+
+    hll_free(other);
+    hll_free(c);
+    hll_free(b);
+    hll_free(a);
+    for (int t = 0; t < 4; t++)
+    {
+        hll_free(parts[t]);
+    }
+    hll_free(base);
+    assert(hll_new(3, 8, 0, NULL) == NULL);
+    assert(hll_new(19, 8, 0, NULL) == NULL);
+}
+
+void test_sparse_batch()
+{
+    printf("============== test_sparse_batch ===========\n");
+    // 新项攒批合并, 插入顺序和重复不影响结果
+    hll *a = hll_new(18, sizeof(u64), 123456, NULL);
+    hll *b = hll_like(a);
+    u64 n = 20000;
+    for (u64 i = 0; i < n; i++)
+    {
+        hll_add(a, &i);
+        u64 key = n - 1 - i;
+        hll_add(b, &key);
+        key = i / 2;
+        hll_add(b, &key);
+    }
+    assert(a->mode == HLL_SPARSE && b->mode == HLL_SPARSE);
+    assert(a->sparse_pending > 0 || b->sparse_pending > 0);
+    for (usize i = 1; i < a->sparse_len; i++)
+    {
+        assert((a->sparse[i - 1] >> 6) < (a->sparse[i] >> 6));
+    }
+    // 未合并的新项也计入估计
+    assert(hll_count(a) == hll_count(b));
+    assert(rel_error(hll_count(a), (double)n) < 0.01);
+
+    // 合并稀疏表示时包括未合并的新项
+    hll *c = hll_like(a);
+    assert(hll_merge(c, b) == 0);
+    assert(c->mode == HLL_SPARSE);
+    assert(hll_count(c) == hll_count(a));
+
+    // 转为稠密表示后寄存器一致
+    for (u64 i = n; i < 200000; i++)
+    {
+        hll_add(a, &i);
+        hll_add(b, &i);
+        hll_add(c, &i);
+    }
+    assert(a->mode == HLL_DENSE && b->mode == HLL_DENSE && c->mode == HLL_DENSE);
+    assert(memcmp(a->registers, b->registers, a->m) == 0);
+    assert(memcmp(a->registers, c->registers, a->m) == 0);
+
+    hll_free(c);
+    hll_free(b);
+    hll_free(a);
+}
+
+int main()
+{
+    printf("============== START ===========\n");
+    test_exact_and_upgrade();
+    test_accuracy();
+    test_merge();
+    test_sparse_batch();
+    printf("============== DONE ===========\n");
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include "../clru.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct evict_log
+{
+    int n;
+    int keys[64];
+} evict_log;
+
+void on_evict(void *key, void *value, void *ctx)
+{
+    evict_log *log = (evict_log *)ctx;
+    log->keys[log->n++] = *(int *)key;
+}
+
+u64 weak_hasher(const void *data, usize dsize, u64 seed)
+{
+    // hash集中, 制造较长的探测序列和元素移动
+    return *(int *)data % 4;
+}
+
+void check_nodes(hashmap_lru *lru)
+{
+    // 每个节点记录的下标必须指向自己
+    size n = 0;
+    for (u32 id = lru->head; id != LRU_NIL; id = lru->next[id])
+    {
+        u32 stored;
+        memcpy(&stored, hashmap_value_at(lru->map, lru->slots[id]), sizeof(u32));
+        assert(stored == id);
+        n++;
+    }
+    assert(n == hashmap_lru_count(lru));
+}
+
+void test_evict_order()
+{
+    printf("============== test_evict_order ===========\n");
+    hashmap_lru *lru = hashmap_lru_new(3, 0, sizeof(int), sizeof(int), 123456, NULL, NULL);
+    evict_log log = {0};
+    hashmap_lru_set_evict(lru, on_evict, &log);
+
+    for (int item = 1; item <= 3; item++)
+    {
+        assert(hashmap_lru_set(lru, &item, &item, 1) == 0);
+    }
+
+    // 1被访问后, 最久未使用的是2
+    assert(*(int *)hashmap_lru_get(lru, &(int){1}) == 1);
+    hashmap_lru_set(lru, &(int){4}, &(int){4}, 1);
+    assert(log.n == 1 && log.keys[0] == 2);
+    assert(!hashmap_lru_exist(lru, &(int){2}));
+
+    // peek不改变顺序, 下一个淘汰3
+    assert(*(int *)hashmap_lru_peek(lru, &(int){3}) == 3);
+    hashmap_lru_set(lru, &(int){5}, &(int){5}, 1);
+    assert(log.n == 2 && log.keys[1] == 3);
+
+    // 更新已有key不淘汰
+    hashmap_lru_set(lru, &(int){1}, &(int){10}, 1);
+    assert(log.n == 2);
+    assert(*(int *)hashmap_lru_get(lru, &(int){1}) == 10);
+    assert(hashmap_lru_count(lru) == 3);
+
+    // 移除不触发淘汰回调
+    hashmap_lru_remove(lru, &(int){4});
+    assert(log.n == 2);
+    assert(hashmap_lru_count(lru) == 2);
+
+    assert(hashmap_lru_evict(lru) == 1);
+    assert(log.keys[2] == 5);
+    assert(hashmap_lru_evict(lru) == 1);
+    assert(hashmap_lru_evict(lru) == 0);
+    assert(hashmap_lru_count(lru) == 0);
+    hashmap_lru_free(lru);
+}
+
+void test_max_bytes()
+{
+    printf("============== test_max_bytes ===========\n");
+    hashmap_lru *lru = hashmap_lru_new(100, 10, sizeof(int), sizeof(int), 123456, NULL, NULL);
+    for (int item = 0; item < 5; item++)
+    {
+        hashmap_lru_set(lru, &item, &item, 2);
+    }
+    assert(lru->bytes == 10);
+    assert(hashmap_lru_count(lru) == 5);
+
+    hashmap_lru_set(lru, &(int){5}, &(int){5}, 4);
+    assert(lru->bytes <= 10);
+    assert(!hashmap_lru_exist(lru, &(int){0}));
+    assert(!hashmap_lru_exist(lru, &(int){1}));
+    assert(hashmap_lru_exist(lru, &(int){5}));
+
+    // 单个元素超出上限时仍然保留
+    hashmap_lru_set(lru, &(int){6}, &(int){6}, 20);
+    assert(hashmap_lru_count(lru) == 1);
+    assert(hashmap_lru_exist(lru, &(int){6}));
+    hashmap_lru_free(lru);
+}
+
+void test_pointer_values()
+{
+    printf("============== test_pointer_values ===========\n");
+    hashmap_lru *lru = hashmap_lru_new(8, 0, sizeof(int), 0, 123456, NULL, NULL);
+    hashmap_lru_set_vfree(lru, free);
+    for (int item = 0; item < 20; item++)
+    {
+        int *value = malloc(sizeof(int));
+        *value = item;
+        hashmap_lru_set(lru, &item, value, 1);
+    }
+    assert(hashmap_lru_count(lru) == 8);
+    assert(*(int *)hashmap_lru_get(lru, &(int){19}) == 19);
+
+    int *value = malloc(sizeof(int));
+    *value = 100;
+    hashmap_lru_set(lru, &(int){19}, value, 1);
+    assert(*(int *)hashmap_lru_get(lru, &(int){19}) == 100);
+    hashmap_lru_free(lru);
+}
+
+void test_random_ops()
+{
+    printf("============== test_random_ops ===========\n");
+    // 与简单的数组模型对比
+    enum { CAP = 16, KEYS = 64 };
+    hashmap_lru *lru = hashmap_lru_new(CAP, 0, sizeof(int), sizeof(int), 123456, weak_hasher, NULL);
+    int stamp[KEYS] = {0};
+    int value[KEYS] = {0};
+    int clock = 0;
+    srand(1);
+
+    for (int i = 0; i < 20000; i++)
+    {
+        int key = rand() % KEYS;
+        int op = rand() % 3;
+        if (op == 0)
+        {
+            int v = rand();
+            if (!stamp[key])
+            {
+                int count = 0, oldest = -1;
+                for (int k = 0; k < KEYS; k++)
+                {
+                    if (stamp[k])
+                    {
+                        count++;
+                        if (oldest < 0 || stamp[k] < stamp[oldest])
+                        {
+                            oldest = k;
+                        }
+                    }
+                }
+                if (count == CAP)
+                {
+                    stamp[oldest] = 0;
+                }
+            }
+            hashmap_lru_set(lru, &key, &v, 1);
+            stamp[key] = ++clock;
+            value[key] = v;
+        }
+        else if (op == 1)
+        {
+            int *got = hashmap_lru_get(lru, &key);
+            assert((got != NULL) == (stamp[key] != 0));
+            if (got)
+            {
+                assert(*got == value[key]);
+                stamp[key] = ++clock;
+            }
+        }
+        else
+        {
+            hashmap_lru_remove(lru, &key);
+            stamp[key] = 0;
+        }
+        check_nodes(lru);
+    }
+    hashmap_lru_free(lru);
+}
+
+int main()
+{
+    printf("============== START ===========\n");
+    test_evict_order();
+    test_max_bytes();
+    test_pointer_values();
+    test_random_ops();
+    printf("============== DONE ===========\n");
+    return 0;
+}
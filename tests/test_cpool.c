@@ -0,0 +1,170 @@
+#include "../cpool.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FOR_SIZE 1000000
+
+typedef struct fib_arg
+{
+    cpool_group *parent;
+    cpool *pool;
+    u64 n;
+    u64 result;
+} fib_arg;
+
+static void mark_range(usize begin, usize end, void *ctx)
+{
+    u8 *seen = (u8 *)ctx;
+    for (usize i = begin; i < end; i++)
+    {
+        __atomic_add_fetch(&seen[i], 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void sum_range(usize begin, usize end, void *ctx)
+{
+    u64 s = 0;
+    for (usize i = begin; i < end; i++)
+    {
+        s += i;
+    }
+    __atomic_add_fetch((u64 *)ctx, s, __ATOMIC_RELAXED);
+}
+
+static void count_task(void *arg)
+{
+    __atomic_add_fetch((usize *)arg, 1, __ATOMIC_RELAXED);
+}
+
+// 每一层fork两个子任务再join
+static void fib_task(void *arg)
+{
+    fib_arg *f = (fib_arg *)arg;
+    if (f->n < 12)
+    {
+        u64 a = 0, b = 1;
+        for (u64 i = 0; i < f->n; i++)
+        {
+            u64 t = a + b;
+            a = b;
+            b = t;
+        }
+        f->result = a;
+        return;
+    }
+
+    cpool_group g;
+    cpool_group_init(&g, f->pool);
+    fib_arg x = {&g, f->pool, f->n - 1, 0};
+    fib_arg y = {&g, f->pool, f->n - 2, 0};
+    cpool_spawn(&g, fib_task, &x);
+    cpool_spawn(&g, fib_task, &y);
+    cpool_wait(&g);
+    f->result = x.result + y.result;
+}
+
+// 任务中使用parallel_for
+static void nested_for_task(void *arg)
+{
+    void **a = (void **)arg;
+    u64 sum = 0;
+    cpool_parallel_for((cpool *)a[0], 0, 10000, 100, sum_range, &sum);
+    __atomic_add_fetch((u64 *)a[1], sum, __ATOMIC_RELAXED);
+}
+
+void test_parallel_for()
+{
+    printf("\n============== test_parallel_for ===========\n");
+    u8 *seen = (u8 *)calloc(FOR_SIZE, 1);
+    usize threads[] = {1, 2, 4, 8};
+    usize grains[] = {0, 1, 7, 1000, FOR_SIZE * 2};
+    for (usize t = 0; t < countof(threads); t++)
+    {
+        cpool *pool = cpool_new(threads[t]);
+        assert(pool && cpool_threads(pool) == threads[t] && "cpool_new failed");
+        for (usize k = 0; k < countof(grains); k++)
+        {
+            // 每个下标恰好访问一次
+            memset(seen, 0, FOR_SIZE);
+            usize n = grains[k] == 1 ? 100000 : FOR_SIZE;
+            cpool_parallel_for(pool, 0, n, grains[k], mark_range, seen);
+            for (usize i = 0; i < FOR_SIZE; i++)
+            {
+                assert(seen[i] == (i < n) && "cpool_parallel_for failed");
+            }
+        }
+
+        u64 sum = 0;
+        cpool_parallel_for(pool, 10, 20000, 0, sum_range, &sum);
+        assert(sum == (u64)(10 + 19999) * 19990 / 2 && "cpool_parallel_for sum failed");
+        sum = 0;
+        cpool_parallel_for(pool, 5, 5, 0, sum_range, &sum);
+        assert(sum == 0 && "cpool_parallel_for empty failed");
+        cpool_free(pool);
+    }
+    free(seen);
+
+    // 共享线程池
+    u64 sum = 0;
+    cpool_parallel_for(NULL, 0, 1000, 0, sum_range, &sum);
+    assert(sum == 999 * 1000 / 2 && cpool_global() && cpool_threads(NULL) >= 1 && "cpool_global failed");
+}
+
+void test_group()
+{
+    printf("\n============== test_group ===========\n");
+    usize threads[] = {1, 3, 8};
+    for (usize t = 0; t < countof(threads); t++)
+    {
+        cpool *pool = cpool_new(threads[t]);
+
+        // 超过deque容量的任务数
+        usize count = 0;
+        cpool_group g;
+        cpool_group_init(&g, pool);
+        for (int i = 0; i < CPOOL_DEQUE_CAP * 4; i++)
+        {
+            cpool_spawn(&g, count_task, &count);
+        }
+        cpool_wait(&g);
+        assert(count == CPOOL_DEQUE_CAP * 4 && "cpool_spawn failed");
+
+        // 递归fork/join
+        fib_arg f = {NULL, pool, 27, 0};
+        fib_task(&f);
+        assert(f.result == 196418 && "cpool fork/join failed");
+
+        // 在任务中fork, 任务在工作线程的deque中
+        f = (fib_arg){NULL, pool, 25, 0};
+        cpool_group_init(&g, pool);
+        cpool_spawn(&g, fib_task, &f);
+        cpool_wait(&g);
+        assert(f.result == 75025 && "cpool nested spawn failed");
+
+        u64 sum = 0;
+        void *arg[2] = {pool, &sum};
+        cpool_group_init(&g, pool);
+        for (int i = 0; i < 16; i++)
+        {
+            cpool_spawn(&g, nested_for_task, arg);
+        }
+        cpool_wait(&g);
+        assert(sum == (u64)16 * 9999 * 10000 / 2 && "cpool nested parallel_for failed");
+
+        // 没有任务时直接返回
+        cpool_group_init(&g, pool);
+        cpool_wait(&g);
+        cpool_free(pool);
+    }
+}
+
+int main()
+{
+    test_parallel_for();
+    test_group();
+
+    printf("\nDONE\n");
+    return 0;
+}
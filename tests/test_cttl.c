@@ -0,0 +1,144 @@
+#include "../cttl.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define KEYS 20000
+
+typedef struct expire_log
+{
+    u64 now;
+    int n;
+    u64 *expires;
+} expire_log;
+
+void on_expire(void *key, void *value, void *ctx)
+{
+    expire_log *log = (expire_log *)ctx;
+    int item = *(int *)key;
+    assert(*(int *)value == item);
+    assert(log->expires[item] <= log->now);
+    log->expires[item] = 0;
+    log->n++;
+}
+
+void test_set_and_get()
+{
+    printf("============== test_set_and_get ===========\n");
+    hashmap_ttl *ttl = hashmap_ttl_new(sizeof(int), sizeof(int), 0, 123456, NULL, NULL);
+    for (int item = 0; item < 100; item++)
+    {
+        assert(hashmap_ttl_set(ttl, &item, &item, 10 + item) == 0);
+    }
+    assert(hashmap_ttl_count(ttl) == 100);
+    assert(*(int *)hashmap_ttl_get(ttl, &(int){50}, 0) == 50);
+
+    // 惰性过期, 查找时移除
+    assert(hashmap_ttl_get(ttl, &(int){0}, 10) == NULL);
+    assert(!hashmap_ttl_exist(ttl, &(int){1}, 11));
+    assert(hashmap_ttl_exist(ttl, &(int){2}, 11));
+    assert(hashmap_ttl_count(ttl) == 98);
+
+    // 延长过期时间
+    assert(hashmap_ttl_touch(ttl, &(int){3}, 1000) == 0);
+    assert(hashmap_ttl_touch(ttl, &(int){0}, 1000) != 0);
+    hashmap_ttl_set(ttl, &(int){4}, &(int){-4}, 2000);
+    assert(*(int *)hashmap_ttl_get(ttl, &(int){4}, 0) == -4);
+
+    hashmap_ttl_remove(ttl, &(int){5});
+    assert(!hashmap_ttl_exist(ttl, &(int){5}, 0));
+    assert(hashmap_ttl_count(ttl) == 97);
+
+    assert(hashmap_ttl_expire_until(ttl, 999) == 95);
+    assert(hashmap_ttl_count(ttl) == 2);
+    assert(hashmap_ttl_expire_until(ttl, 1000) == 1);
+    assert(hashmap_ttl_expire_until(ttl, 5000) == 1);
+    assert(hashmap_ttl_count(ttl) == 0);
+
+    // 过期时间早于已处理的时间, 即使传入较早的now也视为已过期
+    hashmap_ttl_set(ttl, &(int){6}, &(int){6}, 3000);
+    assert(!hashmap_ttl_exist(ttl, &(int){6}, 0));
+    hashmap_ttl_set(ttl, &(int){7}, &(int){7}, 6000);
+    hashmap_ttl_touch(ttl, &(int){7}, 4000);
+    assert(hashmap_ttl_get(ttl, &(int){7}, 0) == NULL);
+    assert(hashmap_ttl_count(ttl) == 0);
+    hashmap_ttl_free(ttl);
+}
+
+void test_expire_until()
+{
+    printf("============== test_expire_until ===========\n");
+    u64 start = 1000003;
+    u64 *expires = calloc(KEYS, sizeof(u64));
+    expire_log log = {start, 0, expires};
+    hashmap_ttl *ttl = hashmap_ttl_new(sizeof(int), sizeof(int), start, 123456, NULL, NULL);
+    hashmap_ttl_set_expire(ttl, on_expire, &log);
+    srand(1);
+
+    // 覆盖每一层以及超出时间轮范围的过期时间
+    for (int item = 0; item < KEYS; item++)
+    {
+        u64 range = 1ULL << (rand() % 28);
+        expires[item] = start + 1 + (u64)rand() % range;
+        hashmap_ttl_set(ttl, &item, &item, expires[item]);
+    }
+
+    int alive = KEYS;
+    u64 now = start;
+    while (alive > 0)
+    {
+        now += 1 + (u64)rand() % 100000;
+        log.now = now;
+        int due = 0;
+        for (int item = 0; item < KEYS; item++)
+        {
+            if (expires[item] && expires[item] <= now)
+            {
+                due++;
+            }
+        }
+
+        log.n = 0;
+        assert(hashmap_ttl_expire_until(ttl, now) == (usize)due);
+        assert(log.n == due);
+        alive -= due;
+        assert(hashmap_ttl_count(ttl) == alive);
+
+        // 重新插入部分元素, 过期时间可能早于当前时间
+        int item = rand() % KEYS;
+        if (!expires[item] && now < start + (1ULL << 27))
+        {
+            expires[item] = now - 5 + (u64)rand() % 300000;
+            hashmap_ttl_set(ttl, &item, &item, expires[item]);
+            alive++;
+        }
+    }
+    hashmap_ttl_free(ttl);
+    free(expires);
+}
+
+void test_pointer_values()
+{
+    printf("============== test_pointer_values ===========\n");
+    hashmap_ttl *ttl = hashmap_ttl_new(sizeof(int), 0, 0, 123456, NULL, NULL);
+    hashmap_ttl_set_vfree(ttl, free);
+    for (int item = 0; item < 1000; item++)
+    {
+        int *value = malloc(sizeof(int));
+        *value = item;
+        hashmap_ttl_set(ttl, &item, value, item % 7 + 1);
+    }
+    assert(*(int *)hashmap_ttl_get(ttl, &(int){6}, 0) == 6);
+    assert(hashmap_ttl_expire_until(ttl, 3) == 429);
+    hashmap_ttl_free(ttl);
+}
+
+int main()
+{
+    printf("============== START ===========\n");
+    test_set_and_get();
+    test_expire_until();
+    test_pointer_values();
+    printf("============== DONE ===========\n");
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include "../cvec.h"
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define vec_get_tt(h, i)  *(tt *)vec_get(h, i)
 #define vec_get_int(h, i) *(int *)vec_get(h, i)
@@ -12,6 +13,9 @@ typedef struct tt
     char c;
 } tt;
 
+VEC_DEFINE(vec_int, int)
+VEC_DEFINE(vec_tt, tt)
+
 void test_new_push()
 {
     printf("============== test_new_push ===========\n");
@@ -154,6 +158,289 @@ void test_find()
     vec_push_v(vec1, 5);
     assert(vec_find_default_v(vec1, 2) == 1 && "vec_find failed");
     assert(vec_find_default_v(vec1, 5) == 4 && "vec_find failed");
+    vec_push_v(vec1, 1);
+    assert(vec_find_default_v(vec1, 1) == 0 && "vec_find_default failed");
+    assert(vec_find_default_last_v(vec1, 1) == 5 && "vec_find_default_last failed");
+    assert(vec_find_default_v(vec1, 6) == -1 && vec_find_default_last_v(vec1, 6) == -1 && "vec_find_default failed");
+    assert(vec_count_eq_v(vec1, 1) == 2 && vec_count_eq_v(vec1, 6) == 0 && "vec_count_eq failed");
+    vec_free(vec1);
+}
+
+void test_find_simd()
+{
+    printf("\n============== test_find_simd ===========\n");
+    srand(1234);
+    usize vsizes[] = {1, 2, 3, 4, 8, 16};
+    for (usize k = 0; k < countof(vsizes); k++)
+    {
+        usize vsize = vsizes[k];
+        for (usize len = 0; len < 300; len += 7)
+        {
+            vec *vec1 = vec_new(vsize);
+            u8 e[16];
+            for (usize i = 0; i < len; i++)
+            {
+                // 取值很少, 元素之间部分字节相等
+                for (usize j = 0; j < vsize; j++)
+                {
+                    e[j] = (u8)(rand() % 3);
+                }
+                vec_push(vec1, e);
+            }
+
+            u8 needle[16];
+            u64 bitmap[8];
+            for (int round = 0; round < 8; round++)
+            {
+                for (usize j = 0; j < vsize; j++)
+                {
+                    needle[j] = (u8)(rand() % 3);
+                }
+                size first = -1, last = -1, count = 0;
+                for (usize i = 0; i < len; i++)
+                {
+                    if (memcmp((u8 *)vec1->mem + i * vsize, needle, vsize) == 0)
+                    {
+                        first = first < 0 ? (size)i : first;
+                        last = i;
+                        count++;
+                    }
+                }
+                assert(vec_find_default(vec1, needle) == first && "vec_find_default failed");
+                assert(vec_find_default_last(vec1, needle) == last && "vec_find_default_last failed");
+                assert(vec_count_eq(vec1, needle) == count && "vec_count_eq failed");
+                assert(vec_find_all(vec1, needle, bitmap) == count && "vec_find_all failed");
+                for (usize i = 0; i < len; i++)
+                {
+                    b32 eq = memcmp((u8 *)vec1->mem + i * vsize, needle, vsize) == 0;
+                    assert(eq == ((bitmap[i >> 6] >> (i & 63)) & 1) && "vec_find_all failed");
+                }
+            }
+            vec_free(vec1);
+        }
+    }
+}
+
+void test_growth()
+{
+    printf("\n============== test_growth ===========\n");
+    int *arr = NULL;
+    vec *vec1 = vec_new_bind(arr);
+    int n = (VEC_MMAP_THRESHOLD / sizeof(int)) * 4;
+    for (int i = 0; i < n; i++)
+    {
+        assert(vec_push(vec1, &i) == i && "vec_push failed");
+    }
+    assert(arr == vec1->mem && "vec bind failed");
+#ifdef __linux__
+    assert(vec1->mem_kind == VEC_MEM_MAPPED && "vec mmap failed");
+#endif
+    for (int i = 0; i < n; i++)
+    {
+        assert(arr[i] == i && "vec growth failed");
+    }
+
+    assert(vec_insert_v(vec1, -1, 0) == 0 && "vec_insert failed");
+    assert(arr[0] == -1 && arr[1] == 0 && arr[n] == n - 1 && "vec_insert failed");
+
+    assert(vec_resize(vec1, 16) == 0 && "vec_resize failed");
+    assert(vec1->len == 16 && vec1->cap == 16 && arr == vec1->mem && "vec_resize failed");
+    for (int i = 1; i < 16; i++)
+    {
+        assert(arr[i] == i - 1 && "vec_resize failed");
+    }
+
+    assert(vec_resize(vec1, 0) == 0 && vec1->len == 0 && arr == NULL && "vec_resize failed");
+    vec_push_v(vec1, 7);
+    assert(arr[0] == 7 && "vec_push failed");
+    vec_free(vec1);
+    assert(arr == NULL && "vec_free failed");
+}
+
+void test_large()
+{
+    printf("\n============== test_large ===========\n");
+    vec *vec1 = vec_new(sizeof(u8));
+    usize n = ((usize)1 << 32) + 8;
+    // 只访问数据区的首尾, 匿名页不会全部占用物理内存
+    if (vec_resize(vec1, n))
+    {
+        printf("vec_resize %zu skip\n", n);
+        vec_free(vec1);
+        return;
+    }
+    assert(vec1->cap == n && "vec_resize failed");
+    vec1->len = n - 2;
+    assert(vec_push_v(vec1, (u8)7) == (size)(n - 2) && "vec_push failed");
+    assert(*(u8 *)vec_get(vec1, n - 2) == 7 && *(u8 *)vec_get(vec1, -1) == 7 && "vec_get failed");
+    assert(vec_put_v(vec1, (u8)9, -1) == 0 && ((u8 *)vec1->mem)[n - 2] == 9 && "vec_put failed");
+    assert(vec_get(vec1, n) == NULL && "vec_get failed");
+
+    // 字节数溢出
+    vec *vec2 = vec_new(16);
+    assert(vec_resize(vec2, PTRDIFF_MAX / 8) == 1 && vec2->cap == 0 && "vec_resize overflow failed");
+    assert(vec_new_cap(PTRDIFF_MAX, PTRDIFF_MAX / 2 + 1, 4) == PTRDIFF_MAX && "vec_new_cap overflow failed");
+    u8 src[4] = {1, 2, 3, 4};
+    assert(vec_from(16, src, (usize)PTRDIFF_MAX / 8) == NULL && "vec_from overflow failed");
+
+    vec_free(vec1);
+    vec_free(vec2);
+}
+
+void test_small()
+{
+    printf("\n============== test_small ===========\n");
+    int *arr = NULL;
+    vec *vec1 = vec_small_new_bind(arr, 4);
+    assert(vec1->cap == 4 && vec1->mem_kind == VEC_MEM_INLINE && arr == vec1->mem && "vec_small_new failed");
+    for (int i = 0; i < 4; i++)
+    {
+        vec_push(vec1, &i);
+    }
+    assert(vec1->mem_kind == VEC_MEM_INLINE && arr[3] == 3 && "vec_push failed");
+
+    // 溢出到堆上
+    vec_push_v(vec1, 4);
+    assert(vec1->mem_kind == VEC_MEM_HEAP && arr == vec1->mem && vec1->cap == 8 && "vec_push failed");
+    assert(vec_insert_v(vec1, -1, 0) == 0 && "vec_insert failed");
+    for (int i = 0; i < 6; i++)
+    {
+        assert(arr[i] == i - 1 && "vec_insert failed");
+    }
+
+    vec *vec2 = vec_clone(vec1);
+    assert(vec2->len == 6 && vec2->mem_kind == VEC_MEM_HEAP && *(int *)vec_get(vec2, -1) == 4 && "vec_clone failed");
+    vec_free(vec2);
+
+    // 缩容回到内联内存
+    assert(vec_resize(vec1, 3) == 0 && "vec_resize failed");
+    assert(vec1->mem_kind == VEC_MEM_INLINE && vec1->len == 3 && vec1->cap == 4 && arr == vec1->mem && "vec_resize failed");
+    assert(arr[0] == -1 && arr[2] == 1 && "vec_resize failed");
+    assert(vec_resize(vec1, 0) == 0 && vec1->len == 0 && vec1->cap == 4 && arr == vec1->mem && "vec_resize failed");
+
+    vec_free(vec1);
+    assert(arr == NULL && "vec_free failed");
+
+    vec *vec3 = vec_small_new(sizeof(tt), 0);
+    tt t = {1, 1.0, 'a'};
+    vec_push(vec3, &t);
+    assert(vec3->mem_kind == VEC_MEM_HEAP && ((tt *)vec_get(vec3, 0))->c == 'a' && "vec_small_new failed");
+    vec_free(vec3);
+}
+
+void test_typed()
+{
+    printf("\n============== test_typed ===========\n");
+    int *arr = NULL;
+    vec *vec1 = vec_new_bind(arr);
+    for (int i = 0; i < 100; i++)
+    {
+        assert(vec_int_push(vec1, i) == i && "vec_int_push failed");
+    }
+    assert(arr == vec_int_data(vec1) && arr[99] == 99 && "vec_int_push failed");
+    assert(*vec_int_get(vec1, -1) == 99 && vec_int_get(vec1, 100) == NULL && vec_int_get(vec1, -101) == NULL && "vec_int_get failed");
+    assert(vec_int_at(vec1, 10) == 10 && "vec_int_at failed");
+
+    // 与通用函数共用
+    vec_push_v(vec1, 100);
+    assert(vec_int_at(vec1, 100) == 100 && *(int *)vec_get(vec1, 50) == 50 && "vec_int mix failed");
+
+    assert(vec_int_insert(vec1, -1, 0) == 0 && arr[0] == -1 && arr[1] == 0 && vec1->len == 102 && "vec_int_insert failed");
+    assert(vec_int_insert(vec1, 7, 102) == 0 && arr[102] == 7 && "vec_int_insert failed");
+    assert(vec_int_insert(vec1, 7, 104) == 1 && "vec_int_insert failed");
+    assert(vec_int_remove(vec1, 0) == 0 && arr[0] == 0 && vec1->len == 102 && "vec_int_remove failed");
+    assert(vec_int_remove(vec1, 102) == 1 && "vec_int_remove failed");
+    assert(vec_int_put(vec1, 42, -1) == 0 && vec_int_pop(vec1) == 42 && vec1->len == 101 && "vec_int_put failed");
+    vec_free(vec1);
+
+    vec *vec2 = vec_tt_small_new(2);
+    tt t1 = {1, 1.0, 'a'};
+    tt t2 = {2, 2.0, 'b'};
+    tt t3 = {3, 3.0, 'c'};
+    vec_tt_push(vec2, t1);
+    vec_tt_push(vec2, t3);
+    vec_tt_insert(vec2, t2, 1);
+    assert(vec2->vsize == sizeof(tt) && vec2->mem_kind == VEC_MEM_HEAP && "vec_tt_insert failed");
+    for (int i = 0; i < 3; i++)
+    {
+        assert(vec_tt_at(vec2, i).a == i + 1 && (vec_get_tt(vec2, i)).c == 'a' + i && "vec_tt failed");
+    }
+    vec_free(vec2);
+}
+
+void test_bulk()
+{
+    printf("\n============== test_bulk ===========\n");
+    int *arr = NULL;
+    vec *vec1 = vec_new_bind(arr);
+    int src[100];
+    for (int i = 0; i < 100; i++)
+    {
+        src[i] = i;
+    }
+
+    // 一次扩容到足够的cap
+    assert(vec_reserve(vec1, 100) == 0 && vec1->cap >= 100 && vec1->len == 0 && "vec_reserve failed");
+    void *mem = vec1->mem;
+    assert(vec_extend(vec1, src, 100) == 0 && vec1->len == 100 && vec1->mem == mem && "vec_extend failed");
+    assert(vec_reserve(vec1, 0) == 0 && vec1->mem == mem && "vec_reserve failed");
+    assert(vec_reserve(vec1, (usize)PTRDIFF_MAX) == 1 && "vec_reserve overflow failed");
+    assert(vec_extend(vec1, NULL, 0) == 0 && vec_extend(vec1, NULL, 1) == 1 && "vec_extend failed");
+
+    // 0..9 [100..104] 10..99
+    int ins[5] = {100, 101, 102, 103, 104};
+    assert(vec_insert_n(vec1, 10, ins, 5) == 0 && vec1->len == 105 && "vec_insert_n failed");
+    for (int i = 0; i < 105; i++)
+    {
+        assert(arr[i] == (i < 10 ? i : i < 15 ? 90 + i : i - 5) && "vec_insert_n failed");
+    }
+    assert(vec_insert_n(vec1, 106, ins, 5) == 1 && vec_insert_n(vec1, -106, ins, 5) == 1 && "vec_insert_n bounds failed");
+    assert(vec_insert_n(vec1, -1, ins, 1) == 0 && arr[104] == 100 && arr[105] == 99 && "vec_insert_n negative failed");
+    assert(vec_insert_n(vec1, 106, ins + 4, 1) == 0 && arr[106] == 104 && "vec_insert_n end failed");
+
+    assert(vec_remove_range(vec1, 104, 105) == 0 && vec_remove_range(vec1, 105, 106) == 0 && vec1->len == 105 && "vec_remove_range failed");
+    assert(vec_remove_range(vec1, 10, 15) == 0 && vec1->len == 100 && "vec_remove_range failed");
+    assert(memcmp(arr, src, sizeof(src)) == 0 && "vec_remove_range failed");
+    assert(vec_remove_range(vec1, 5, 4) == 1 && vec_remove_range(vec1, 0, 101) == 1 && vec_remove_range(vec1, 7, 7) == 0 && "vec_remove_range bounds failed");
+
+    // 插入自身的元素: 插入点之前, 之后, 跨过插入点
+    int ref[300];
+    usize cases[][3] = {{50, 10, 20}, {20, 40, 20}, {30, 20, 30}, {0, 0, 100}, {100, 0, 100}};
+    for (usize k = 0; k < countof(cases); k++)
+    {
+        usize at = cases[k][0], off = cases[k][1], n = cases[k][2];
+        vec_clear(vec1);
+        vec_extend(vec1, src, 100);
+        memcpy(ref, src, at * sizeof(int));
+        memcpy(ref + at, src + off, n * sizeof(int));
+        memcpy(ref + at + n, src + at, (100 - at) * sizeof(int));
+        // 先缩容, 插入时重新分配
+        vec_resize(vec1, 100);
+        assert(vec_insert_n(vec1, at, arr + off, n) == 0 && vec1->len == 100 + n && "vec_insert_n self failed");
+        assert(memcmp(arr, ref, (100 + n) * sizeof(int)) == 0 && "vec_insert_n self failed");
+    }
+
+    vec_clear(vec1);
+    vec_extend(vec1, src, 100);
+    vec_resize(vec1, 100);
+    assert(vec_extend(vec1, arr, 100) == 0 && vec1->len == 200 && "vec_extend self failed");
+    assert(memcmp(arr, src, sizeof(src)) == 0 && memcmp(arr + 100, src, sizeof(src)) == 0 && "vec_extend self failed");
+
+    assert(vec_swap_remove(vec1, 0) == 0 && arr[0] == 99 && vec1->len == 199 && "vec_swap_remove failed");
+    assert(vec_swap_remove(vec1, -1) == 0 && arr[197] == 97 && vec1->len == 198 && "vec_swap_remove last failed");
+    assert(vec_swap_remove(vec1, 198) == 1 && vec_swap_remove(vec1, -199) == 1 && "vec_swap_remove bounds failed");
+
+    assert(vec_int_swap_remove(vec1, 1) == 0 && arr[1] == 97 && vec1->len == 197 && "vec_int_swap_remove failed");
+    assert(vec_int_extend(vec1, src, 3) == 0 && arr[197] == 0 && arr[199] == 2 && "vec_int_extend failed");
+    vec_free(vec1);
+
+    // 内联内存
+    vec *vec2 = vec_small_new(sizeof(int), 8);
+    assert(vec_extend(vec2, src, 8) == 0 && vec2->mem_kind == VEC_MEM_INLINE && "vec_extend small failed");
+    assert(vec_insert_n(vec2, 4, vec2->mem, 8) == 0 && vec2->mem_kind == VEC_MEM_HEAP && vec2->len == 16 && "vec_insert_n small failed");
+    int expect[16] = {0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 6, 7, 4, 5, 6, 7};
+    assert(memcmp(vec2->mem, expect, sizeof(expect)) == 0 && "vec_insert_n small failed");
+    vec_free(vec2);
 }
 
 int main()
@@ -164,6 +451,12 @@ int main()
     test_remove();
     test_insert();
     test_find();
+    test_find_simd();
+    test_growth();
+    test_large();
+    test_small();
+    test_typed();
+    test_bulk();
 
     return 0;
 }
\ No newline at end of file
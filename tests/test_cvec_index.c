@@ -0,0 +1,246 @@
+#include "../cvec_index.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct record
+{
+    int id;
+    char name[12];
+    double score;
+} record;
+
+const void *record_name(const void *elem, void *ctx)
+{
+    return ((const record *)elem)->name;
+}
+
+record make_record(int id)
+{
+    record r = {0};
+    r.id = id;
+    snprintf(r.name, sizeof(r.name), "n%d", id);
+    r.score = id * 0.5;
+    return r;
+}
+
+void check_index(vec_index *idx)
+{
+    // 每个元素都能通过索引找到自己
+    assert(vec_index_count(idx) == idx->v->len);
+    for (size i = 0; i < idx->v->len; i++)
+    {
+        record *r = vec_get(idx->v, i);
+        assert(vec_index_find(idx, &r->id) == i);
+    }
+}
+
+void test_offset_key()
+{
+    printf("============== test_offset_key ===========\n");
+    vec *v = vec_new(sizeof(record));
+    for (int id = 0; id < 10; id++)
+    {
+        vec_push_v(v, make_record(id));
+    }
+
+    // 创建时索引已有元素
+    vec_index *idx = vec_index_new(v, offsetof(record, id), sizeof(int), NULL, NULL);
+    check_index(idx);
+    assert(vec_index_find(idx, &(int){100}) == -1);
+    assert(vec_index_get(idx, &(int){100}) == NULL);
+
+    for (int id = 10; id < 1000; id++)
+    {
+        record r = make_record(id);
+        assert(vec_index_push(idx, &r) == id);
+    }
+    check_index(idx);
+    assert(((record *)vec_index_get(idx, &(int){500}))->score == 250.0);
+
+    // 删除和插入后修正下标
+    assert(vec_index_remove(idx, 0) == 0);
+    assert(vec_index_remove(idx, -1) == 0);
+    assert(vec_index_find(idx, &(int){0}) == -1);
+    assert(vec_index_find(idx, &(int){999}) == -1);
+    assert(vec_index_find(idx, &(int){1}) == 0);
+    record r = make_record(-5);
+    assert(vec_index_insert(idx, &r, 3) == 0);
+    assert(vec_index_find(idx, &(int){-5}) == 3);
+    assert(vec_index_find(idx, &(int){4}) == 4);
+    check_index(idx);
+
+    // 修改元素的key
+    r = make_record(5000);
+    assert(vec_index_put(idx, &r, 10) == 0);
+    assert(vec_index_find(idx, &(int){5000}) == 10);
+    assert(vec_index_find(idx, &(int){10}) == -1);
+    check_index(idx);
+
+    // key重复时指向新元素, 删除新元素后指向旧元素
+    r = make_record(7);
+    size dup = vec_index_push(idx, &r);
+    assert(vec_index_find(idx, &(int){7}) == dup);
+    assert(vec_index_count(idx) == v->len - 1);
+    vec_index_remove(idx, dup);
+    assert(vec_index_find(idx, &(int){7}) == 7);
+    assert(vec_index_rebuild(idx) == 0);
+    assert(vec_index_find(idx, &(int){7}) == 7);
+    check_index(idx);
+
+    vec_index_free(idx);
+    vec_free(v);
+}
+
+void test_key_of()
+{
+    printf("============== test_key_of ===========\n");
+    vec *v = vec_new(sizeof(record));
+    vec_index *idx = vec_index_new_with(v, sizeof(((record *)0)->name), record_name, NULL, NULL, NULL);
+    for (int id = 0; id < 100; id++)
+    {
+        record r = make_record(id);
+        vec_index_push(idx, &r);
+    }
+
+    char name[12] = "n42";
+    assert(vec_index_find(idx, name) == 42);
+    assert(((record *)vec_index_get(idx, name))->id == 42);
+    vec_index_remove(idx, 10);
+    assert(vec_index_find(idx, name) == 41);
+    vec_index_free(idx);
+    vec_free(v);
+}
+
+void test_duplicate_keys()
+{
+    printf("============== test_duplicate_keys ===========\n");
+    vec *v = vec_new(sizeof(record));
+    vec_index *idx = vec_index_new(v, offsetof(record, id), sizeof(int), NULL, NULL);
+    record r1 = make_record(1), r2 = make_record(2);
+    vec_index_push(idx, &r1);
+    vec_index_push(idx, &r1);
+    vec_index_push(idx, &r2);
+    assert(vec_index_count(idx) == 2);
+    assert(vec_index_find(idx, &(int){1}) == 1);
+
+    // 删除被索引的重复元素, 索引改为指向剩余的元素
+    assert(vec_index_remove(idx, 1) == 0);
+    assert(vec_index_find(idx, &(int){1}) == 0);
+    assert(vec_index_find(idx, &(int){2}) == 1);
+
+    // 删除未被索引的重复元素, 索引不变
+    vec_index_push(idx, &r1);
+    assert(vec_index_find(idx, &(int){1}) == 2);
+    assert(vec_index_remove(idx, 0) == 0);
+    assert(vec_index_find(idx, &(int){1}) == 1);
+    assert(vec_index_find(idx, &(int){2}) == 0);
+
+    // 覆盖被索引的重复元素
+    vec_index_insert(idx, &r1, 0);
+    assert(vec_index_find(idx, &(int){1}) == 0);
+    assert(vec_index_put(idx, &r2, 0) == 0);
+    assert(vec_index_find(idx, &(int){1}) == 2);
+    assert(vec_index_put(idx, &r2, 2) == 0);
+    assert(vec_index_find(idx, &(int){1}) == -1);
+    assert(vec_index_count(idx) == 1);
+
+    // 随机操作, 每个key都指向key相同的某个元素
+    srand(2);
+    for (int n = 0; n < 2000; n++)
+    {
+        record r = make_record(rand() % 16);
+        int op = rand() % 4;
+        if (op == 0 || v->len == 0)
+        {
+            vec_index_push(idx, &r);
+        }
+        else if (op == 1)
+        {
+            assert(vec_index_insert(idx, &r, rand() % v->len) == 0);
+        }
+        else if (op == 2)
+        {
+            assert(vec_index_put(idx, &r, rand() % v->len) == 0);
+        }
+        else
+        {
+            assert(vec_index_remove(idx, rand() % v->len) == 0);
+        }
+
+        size distinct = 0;
+        for (int id = 0; id < 16; id++)
+        {
+            b32 present = 0;
+            for (size i = 0; i < v->len; i++)
+            {
+                present |= ((record *)vec_get(v, i))->id == id;
+            }
+            size found = vec_index_find(idx, &id);
+            if (present)
+            {
+                assert(found >= 0 && ((record *)vec_get(v, found))->id == id);
+                distinct++;
+            }
+            else
+            {
+                assert(found == -1);
+            }
+        }
+        assert(vec_index_count(idx) == distinct);
+    }
+
+    vec_index_free(idx);
+    vec_free(v);
+}
+
+void test_random_ops()
+{
+    printf("============== test_random_ops ===========\n");
+    vec *v = vec_new(sizeof(record));
+    vec_index *idx = vec_index_new(v, offsetof(record, id), sizeof(int), NULL, NULL);
+    int next_id = 0;
+    srand(1);
+
+    for (int n = 0; n < 3000; n++)
+    {
+        int op = rand() % 4;
+        record r = make_record(next_id++);
+        if (op == 0 || v->len == 0)
+        {
+            vec_index_push(idx, &r);
+        }
+        else if (op == 1)
+        {
+            assert(vec_index_insert(idx, &r, rand() % v->len) == 0);
+        }
+        else if (op == 2)
+        {
+            assert(vec_index_put(idx, &r, rand() % v->len) == 0);
+        }
+        else
+        {
+            assert(vec_index_remove(idx, rand() % v->len) == 0);
+        }
+
+        if (n % 100 == 0)
+        {
+            check_index(idx);
+        }
+    }
+    check_index(idx);
+    vec_index_free(idx);
+    vec_free(v);
+}
+
+int main()
+{
+    printf("============== START ===========\n");
+    test_offset_key();
+    test_key_of();
+    test_duplicate_keys();
+    test_random_ops();
+    printf("============== DONE ===========\n");
+    return 0;
+}
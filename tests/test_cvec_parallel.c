@@ -0,0 +1,253 @@
+#include "../cvec_parallel.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_SIZE 1000003
+
+typedef struct pt
+{
+    i32 x;
+    i32 y;
+    i32 z;
+} pt;
+
+static void square(const void *in, void *out, usize n, void *ctx)
+{
+    (void)ctx;
+    const i32 *p = (const i32 *)in;
+    i64 *q = (i64 *)out;
+    for (usize i = 0; i < n; i++)
+    {
+        q[i] = (i64)p[i] * p[i];
+    }
+}
+
+static void add_ctx(const void *in, void *out, usize n, void *ctx)
+{
+    const i32 *p = (const i32 *)in;
+    i32 *q = (i32 *)out;
+    for (usize i = 0; i < n; i++)
+    {
+        q[i] = p[i] + *(i32 *)ctx;
+    }
+}
+
+static b32 is_even(const void *elem, void *ctx)
+{
+    (void)ctx;
+    return *(const i32 *)elem % 2 == 0;
+}
+
+static b32 pt_sum_mod(const void *elem, void *ctx)
+{
+    const pt *p = (const pt *)elem;
+    return (p->x + p->y + p->z) % *(i32 *)ctx == 0;
+}
+
+// 分量分别求和的通用运算
+static void pt_add(void *acc, const void *x, void *ctx)
+{
+    (void)ctx;
+    pt *a = (pt *)acc;
+    const pt *b = (const pt *)x;
+    a->x += b->x;
+    a->y += b->y;
+    a->z += b->z;
+}
+
+static vec *make_i32(usize n)
+{
+    vec *v = vec_new(sizeof(i32));
+    for (usize i = 0; i < n; i++)
+    {
+        i32 x = (i32)(rand() % 2001) - 1000;
+        vec_push(v, &x);
+    }
+    return v;
+}
+
+void test_map_filter()
+{
+    printf("\n============== test_map_filter ===========\n");
+    usize threads[] = {1, 3, 8};
+    usize sizes[] = {0, 1, 777, TEST_SIZE};
+    for (usize t = 0; t < countof(threads); t++)
+    {
+        cpool *pool = cpool_new(threads[t]);
+        for (usize k = 0; k < countof(sizes); k++)
+        {
+            vec *v = make_i32(sizes[k]);
+            i32 *src = (i32 *)v->mem;
+
+            // vsize不同
+            vec *sq = vec_new(sizeof(i64));
+            assert(vec_map(sq, v, square, NULL, pool) == 0 && sq->len == v->len && "vec_map failed");
+            for (usize i = 0; i < v->len; i++)
+            {
+                assert(((i64 *)sq->mem)[i] == (i64)src[i] * src[i] && "vec_map failed");
+            }
+
+            vec *even = vec_new(sizeof(i32));
+            assert(vec_filter(even, v, is_even, NULL, pool) == 0 && "vec_filter failed");
+            usize j = 0;
+            for (usize i = 0; i < v->len; i++)
+            {
+                if (src[i] % 2 == 0)
+                {
+                    assert(j < even->len && ((i32 *)even->mem)[j] == src[i] && "vec_filter failed");
+                    j++;
+                }
+            }
+            assert(j == even->len && "vec_filter len failed");
+
+            // 原地
+            i32 one = 1;
+            vec *ref = vec_clone(v);
+            assert(vec_map(v, v, add_ctx, &one, pool) == 0 && v->len == ref->len && "vec_map self failed");
+            src = (i32 *)v->mem;
+            for (usize i = 0; i < v->len; i++)
+            {
+                assert(src[i] == ((i32 *)ref->mem)[i] + 1 && "vec_map self failed");
+            }
+            // 加1后奇偶互换
+            assert(vec_filter(v, v, is_even, NULL, pool) == 0 && v->len + even->len == ref->len && "vec_filter self failed");
+            for (usize i = 1; i < v->len; i++)
+            {
+                assert(src[i] % 2 == 0 && "vec_filter self failed");
+            }
+
+            vec_free(v);
+            vec_free(sq);
+            vec_free(even);
+            vec_free(ref);
+        }
+        cpool_free(pool);
+    }
+
+    // 非2的幂的vsize
+    vec *pts = vec_new(sizeof(pt));
+    for (i32 i = 0; i < 300000; i++)
+    {
+        pt p = {i, -i, i % 7};
+        vec_push(pts, &p);
+    }
+    vec *out = vec_new(sizeof(pt));
+    i32 mod = 3;
+    assert(vec_filter(out, pts, pt_sum_mod, &mod, NULL) == 0 && "vec_filter pt failed");
+    for (usize i = 0; i < out->len; i++)
+    {
+        pt *p = (pt *)out->mem + i;
+        assert(p->z == p->x % 7 && p->z % 3 == 0 && "vec_filter pt failed");
+    }
+    vec *bad = vec_new(sizeof(i32));
+    assert(vec_filter(bad, pts, pt_sum_mod, &mod, NULL) == 1 && "vec_filter vsize failed");
+    vec_free(bad);
+    vec_free(pts);
+    vec_free(out);
+}
+
+void test_reduce_scan()
+{
+    printf("\n============== test_reduce_scan ===========\n");
+    usize threads[] = {1, 4, 7};
+    usize sizes[] = {0, 5, 4099, TEST_SIZE};
+    for (usize t = 0; t < countof(threads); t++)
+    {
+        cpool *pool = cpool_new(threads[t]);
+        for (usize k = 0; k < countof(sizes); k++)
+        {
+            vec *v = make_i32(sizes[k]);
+            i32 *src = (i32 *)v->mem;
+            i32 sum = 0, mn = INT32_MAX, mx = INT32_MIN;
+            for (usize i = 0; i < v->len; i++)
+            {
+                sum += src[i];
+                mn = src[i] < mn ? src[i] : mn;
+                mx = src[i] > mx ? src[i] : mx;
+            }
+
+            i32 zero = 0, hi = INT32_MAX, lo = INT32_MIN, r;
+            assert(vec_reduce(v, &r, &zero, vec_op_sum_i32, NULL, pool) == 0 && r == sum && "vec_reduce sum failed");
+            assert(vec_reduce(v, &r, &hi, vec_op_min_i32, NULL, pool) == 0 && r == mn && "vec_reduce min failed");
+            assert(vec_reduce(v, &r, &lo, vec_op_max_i32, NULL, pool) == 0 && r == mx && "vec_reduce max failed");
+
+            vec *ps = vec_new(sizeof(i32));
+            assert(vec_scan(ps, v, &zero, vec_op_sum_i32, NULL, pool) == 0 && ps->len == v->len && "vec_scan failed");
+            vec *pm = vec_new(sizeof(i32));
+            assert(vec_scan(pm, v, &lo, vec_op_max_i32, NULL, pool) == 0 && "vec_scan max failed");
+            i32 acc = 0, amax = INT32_MIN;
+            for (usize i = 0; i < v->len; i++)
+            {
+                acc += src[i];
+                amax = src[i] > amax ? src[i] : amax;
+                assert(((i32 *)ps->mem)[i] == acc && "vec_scan failed");
+                assert(((i32 *)pm->mem)[i] == amax && "vec_scan max failed");
+            }
+
+            // 原地
+            assert(vec_scan(v, v, &zero, vec_op_sum_i32, NULL, pool) == 0 && "vec_scan self failed");
+            assert((v->len == 0 || memcmp(v->mem, ps->mem, v->len * sizeof(i32)) == 0) && "vec_scan self failed");
+
+            vec_free(v);
+            vec_free(ps);
+            vec_free(pm);
+        }
+        cpool_free(pool);
+    }
+
+    // 其他数值类型
+    vec *vd = vec_new(sizeof(double));
+    vec *vu = vec_new(sizeof(u64));
+    for (usize i = 1; i <= 200000; i++)
+    {
+        double d = 0.5 * i;
+        u64 u = i;
+        vec_push(vd, &d);
+        vec_push(vu, &u);
+    }
+    double dz = 0, dr;
+    u64 uz = 0, ur;
+    assert(vec_reduce(vd, &dr, &dz, vec_op_sum_f64, NULL, NULL) == 0 && dr == 0.5 * 200000 * 200001 / 2 && "vec_reduce f64 failed");
+    assert(vec_reduce(vu, &ur, &uz, vec_op_max_u64, NULL, NULL) == 0 && ur == 200000 && "vec_reduce u64 failed");
+    assert(vec_scan(vu, vu, &uz, vec_op_sum_u64, NULL, NULL) == 0 && ((u64 *)vu->mem)[199999] == (u64)200000 * 200001 / 2 && "vec_scan u64 failed");
+    // 类型不匹配
+    assert(vec_reduce(vd, &dr, &dz, vec_op_sum_i32, NULL, NULL) == 1 && "vec_reduce vsize failed");
+    vec_free(vd);
+    vec_free(vu);
+
+    // 通用运算
+    vec *pts = vec_new(sizeof(pt));
+    for (i32 i = 0; i < 100000; i++)
+    {
+        pt p = {1, i % 1000, -(i % 1000)};
+        vec_push(pts, &p);
+    }
+    pt pz = {0, 0, 0}, pr;
+    cpool *pool = cpool_new(4);
+    assert(vec_reduce(pts, &pr, &pz, pt_add, NULL, pool) == 0 && "vec_reduce generic failed");
+    assert(pr.x == 100000 && pr.y == 100 * 999 * 1000 / 2 && pr.z == -pr.y && "vec_reduce generic failed");
+    assert(vec_scan(pts, pts, &pz, pt_add, NULL, pool) == 0 && "vec_scan generic failed");
+    pt acc = pz;
+    for (i32 i = 0; i < 100000; i++)
+    {
+        pt *p = (pt *)pts->mem + i;
+        acc.x += 1;
+        acc.y += i % 1000;
+        acc.z -= i % 1000;
+        assert(p->x == acc.x && p->y == acc.y && p->z == acc.z && "vec_scan generic failed");
+    }
+    cpool_free(pool);
+    vec_free(pts);
+}
+
+int main()
+{
+    srand(42);
+    test_map_filter();
+    test_reduce_scan();
+
+    printf("\nDONE\n");
+    return 0;
+}
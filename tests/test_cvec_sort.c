@@ -0,0 +1,430 @@
+#include "../cvec_sort.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct rec
+{
+    u32 id;
+    i32 score;
+    u32 pad;
+} rec;
+
+static int cmp_u32(const void *a, const void *b)
+{
+    u32 x = *(const u32 *)a, y = *(const u32 *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    u64 x = *(const u64 *)a, y = *(const u64 *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int cmp_rec(const void *a, const void *b)
+{
+    i32 x = ((const rec *)a)->score, y = ((const rec *)b)->score;
+    return x < y ? -1 : x > y;
+}
+
+static u64 key_rec(const void *elem)
+{
+    // 有符号整数翻转符号位后按无符号排序
+    return (u64)(u32)((const rec *)elem)->score ^ 0x80000000u;
+}
+
+// 0随机 1升序 2降序 3大量重复 4锯齿 5全部相同
+static u64 gen(int pattern, usize i, usize n)
+{
+    switch (pattern)
+    {
+    case 0:
+        return ((u64)rand() << 31) ^ (u64)rand();
+    case 1:
+        return i;
+    case 2:
+        return n - i;
+    case 3:
+        return rand() % 16;
+    case 4:
+        return i % 1000;
+    default:
+        return 7;
+    }
+}
+
+static vec *make_u32(int pattern, usize n)
+{
+    vec *v = vec_new(sizeof(u32));
+    for (usize i = 0; i < n; i++)
+    {
+        u32 x = (u32)gen(pattern, i, n);
+        vec_push(v, &x);
+    }
+    return v;
+}
+
+static void check_sorted_u32(vec *v, vec *ref)
+{
+    if (!ref->len)
+    {
+        assert(v->len == 0 && "sort len failed");
+        return;
+    }
+    qsort(ref->mem, ref->len, sizeof(u32), cmp_u32);
+    assert(v->len == ref->len && "sort len failed");
+    assert(memcmp(v->mem, ref->mem, v->len * sizeof(u32)) == 0 && "sort failed");
+}
+
+void test_sort()
+{
+    printf("============== test_sort ===========\n");
+    usize sizes[] = {0, 1, 2, 10, 23, 24, 25, 129, 1000, 100000};
+    for (int pattern = 0; pattern < 6; pattern++)
+    {
+        for (usize k = 0; k < countof(sizes); k++)
+        {
+            vec *v = make_u32(pattern, sizes[k]);
+            vec *ref = vec_clone(v);
+            vec *gv = vec_clone(v);
+            assert(vec_sort(v, NULL) == 0 && "vec_sort failed");
+            check_sorted_u32(v, ref);
+            // 通用实现
+            assert(vec_sort(gv, cmp_u32) == 0 && "vec_sort cmp failed");
+            assert(memcmp(gv->mem, ref->mem, gv->len * sizeof(u32)) == 0 && "vec_sort cmp failed");
+            vec_free(v);
+            vec_free(ref);
+            vec_free(gv);
+        }
+    }
+
+    // u8 u16 u64
+    vec *v8 = vec_new(sizeof(u8));
+    vec *v16 = vec_new(sizeof(u16));
+    vec *v64 = vec_new(sizeof(u64));
+    for (int i = 0; i < 5000; i++)
+    {
+        u64 x = gen(0, i, 0);
+        vec_push(v8, &x);
+        vec_push(v16, &x);
+        vec_push(v64, &x);
+    }
+    vec_sort(v8, NULL);
+    vec_sort(v16, NULL);
+    vec_sort(v64, NULL);
+    for (int i = 1; i < 5000; i++)
+    {
+        assert(((u8 *)v8->mem)[i - 1] <= ((u8 *)v8->mem)[i] && "vec_sort u8 failed");
+        assert(((u16 *)v16->mem)[i - 1] <= ((u16 *)v16->mem)[i] && "vec_sort u16 failed");
+        assert(((u64 *)v64->mem)[i - 1] <= ((u64 *)v64->mem)[i] && "vec_sort u64 failed");
+    }
+    vec_free(v8);
+    vec_free(v16);
+    vec_free(v64);
+
+    // 结构体, 12字节, 自定义比较
+    vec *vr = vec_new(sizeof(rec));
+    for (u32 i = 0; i < 20000; i++)
+    {
+        rec r = {i, (i32)(rand() % 2001) - 1000, 0};
+        vec_push(vr, &r);
+    }
+    vec_sort(vr, cmp_rec);
+    for (usize i = 1; i < vr->len; i++)
+    {
+        assert(((rec *)vr->mem)[i - 1].score <= ((rec *)vr->mem)[i].score && "vec_sort rec failed");
+    }
+    vec_free(vr);
+}
+
+void test_sort_radix()
+{
+    printf("\n============== test_sort_radix ===========\n");
+    for (int pattern = 0; pattern < 6; pattern++)
+    {
+        vec *v = make_u32(pattern, 50000);
+        vec *ref = vec_clone(v);
+        assert(vec_sort_radix(v, NULL) == 0 && "vec_sort_radix failed");
+        check_sorted_u32(v, ref);
+        vec_free(v);
+        vec_free(ref);
+    }
+
+    vec *v64 = vec_new(sizeof(u64));
+    for (int i = 0; i < 30000; i++)
+    {
+        u64 x = gen(0, i, 0) << 20;
+        vec_push(v64, &x);
+    }
+    vec *ref = vec_clone(v64);
+    vec_sort_radix(v64, NULL);
+    qsort(ref->mem, ref->len, sizeof(u64), cmp_u64);
+    assert(memcmp(v64->mem, ref->mem, v64->len * sizeof(u64)) == 0 && "vec_sort_radix u64 failed");
+    vec_free(v64);
+    vec_free(ref);
+
+    // 按key排序并且稳定
+    vec *vr = vec_new(sizeof(rec));
+    for (u32 i = 0; i < 20000; i++)
+    {
+        rec r = {i, (i32)(rand() % 201) - 100, 0};
+        vec_push(vr, &r);
+    }
+    assert(vec_sort_radix(vr, key_rec) == 0 && "vec_sort_radix key failed");
+    for (usize i = 1; i < vr->len; i++)
+    {
+        rec *a = (rec *)vr->mem + i - 1, *b = (rec *)vr->mem + i;
+        assert((a->score < b->score || (a->score == b->score && a->id < b->id)) && "vec_sort_radix key failed");
+    }
+    vec_free(vr);
+
+    vec *v3 = vec_new(3);
+    assert(vec_sort_radix(v3, NULL) == 1 && "vec_sort_radix vsize failed");
+    vec_free(v3);
+}
+
+void test_sort_parallel()
+{
+    printf("\n============== test_sort_parallel ===========\n");
+    usize threads[] = {0, 2, 3, 4, 7};
+    for (int pattern = 0; pattern < 6; pattern++)
+    {
+        for (usize k = 0; k < countof(threads); k++)
+        {
+            vec *v = make_u32(pattern, 300000 + k);
+            vec *ref = vec_clone(v);
+            assert(vec_sort_parallel(v, NULL, threads[k]) == 0 && "vec_sort_parallel failed");
+            check_sorted_u32(v, ref);
+            vec_free(v);
+            vec_free(ref);
+        }
+    }
+
+    vec *vr = vec_new(sizeof(rec));
+    for (u32 i = 0; i < 200000; i++)
+    {
+        rec r = {i, (i32)(rand() % 2001) - 1000, 0};
+        vec_push(vr, &r);
+    }
+    assert(vec_sort_parallel(vr, cmp_rec, 5) == 0 && "vec_sort_parallel rec failed");
+    for (usize i = 1; i < vr->len; i++)
+    {
+        assert(((rec *)vr->mem)[i - 1].score <= ((rec *)vr->mem)[i].score && "vec_sort_parallel rec failed");
+    }
+    vec_free(vr);
+
+    // 共享的线程池
+    usize pool_threads[] = {1, 3, 6};
+    for (usize k = 0; k < countof(pool_threads); k++)
+    {
+        cpool *pool = cpool_new(pool_threads[k]);
+        vec *v = make_u32(0, 250000);
+        vec *ref = vec_clone(v);
+        assert(vec_sort_pool(v, NULL, pool) == 0 && "vec_sort_pool failed");
+        check_sorted_u32(v, ref);
+        vec_free(v);
+        vec_free(ref);
+        cpool_free(pool);
+    }
+
+    // 元素很少时单线程
+    vec *v = make_u32(0, 100);
+    vec *ref = vec_clone(v);
+    assert(vec_sort_parallel(v, NULL, 8) == 0 && "vec_sort_parallel small failed");
+    check_sorted_u32(v, ref);
+    vec_free(v);
+    vec_free(ref);
+}
+
+// 随机生成去重后的有序集合, 值域[0, range)
+static vec *make_set(usize vsize, usize n, u64 range, int (*cmp)(const void *, const void *))
+{
+    vec *v = vec_new(vsize);
+    for (usize i = 0; i < n; i++)
+    {
+        u64 x = (((u64)rand() << 31) ^ (u64)rand()) % range;
+        vec_push(v, &x);
+    }
+    vec_sort(v, cmp);
+    vec_dedup_sorted(v, cmp);
+    return v;
+}
+
+static u64 elem_u64(vec *v, usize i)
+{
+    u64 x = 0;
+    memcpy(&x, (u8 *)v->mem + i * v->vsize, v->vsize);
+    return x;
+}
+
+static b32 naive_contains(vec *v, u64 x)
+{
+    for (usize i = 0; i < v->len; i++)
+    {
+        if (elem_u64(v, i) == x)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void test_sorted_search()
+{
+    printf("\n============== test_sorted_search ===========\n");
+    vec *v = vec_new(sizeof(u32));
+    assert(vec_lower_bound(v, &(u32){1}, NULL) == 0 && "vec_lower_bound empty failed");
+    assert(vec_upper_bound(v, &(u32){1}, NULL) == 0 && "vec_upper_bound empty failed");
+    assert(!vec_contains_sorted(v, &(u32){1}, NULL) && "vec_contains_sorted empty failed");
+
+    // 0 0 2 2 4 4 ... 198 198
+    for (u32 i = 0; i < 200; i++)
+    {
+        u32 x = i / 2 * 2;
+        vec_push(v, &x);
+    }
+    for (u32 x = 0; x < 202; x++)
+    {
+        usize lo = x <= 198 ? (x + 1) / 2 * 2 : 200;
+        usize hi = x <= 198 ? x / 2 * 2 + 2 : 200;
+        assert(vec_lower_bound(v, &x, NULL) == (size)lo && "vec_lower_bound failed");
+        assert(vec_upper_bound(v, &x, NULL) == (size)hi && "vec_upper_bound failed");
+        assert(vec_lower_bound(v, &x, cmp_u32) == (size)lo && "vec_lower_bound cmp failed");
+        assert(vec_upper_bound(v, &x, cmp_u32) == (size)hi && "vec_upper_bound cmp failed");
+        assert(vec_contains_sorted(v, &x, NULL) == (x % 2 == 0 && x < 200) && "vec_contains_sorted failed");
+    }
+
+    assert(vec_dedup_sorted(v, NULL) == 100 && "vec_dedup_sorted failed");
+    for (u32 i = 0; i < 100; i++)
+    {
+        assert(((u32 *)v->mem)[i] == i * 2 && "vec_dedup_sorted failed");
+    }
+    vec_free(v);
+
+    // 其他vsize
+    usize vsizes[] = {1, 2, 8, 3};
+    for (usize k = 0; k < countof(vsizes); k++)
+    {
+        u64 range = vsizes[k] == 1 ? 256 : 1000;
+        vec *s = make_set(vsizes[k], 300, range, NULL);
+        for (usize i = 1; i < s->len; i++)
+        {
+            // vsize为3时按字节序, 其他按整数
+            b32 lt = s->vsize == 3 ? memcmp((u8 *)s->mem + (i - 1) * 3, (u8 *)s->mem + i * 3, 3) < 0
+                                   : elem_u64(s, i - 1) < elem_u64(s, i);
+            assert(lt && "vec_dedup_sorted failed");
+        }
+        for (u64 x = 0; x < range; x += 7)
+        {
+            b32 has = naive_contains(s, x);
+            assert(vec_contains_sorted(s, &x, NULL) == has && "vec_contains_sorted vsize failed");
+            size lo = vec_lower_bound(s, &x, NULL);
+            size hi = vec_upper_bound(s, &x, NULL);
+            assert(hi - lo == has && "vec_upper_bound vsize failed");
+        }
+        vec_free(s);
+    }
+}
+
+static void check_set_ops(usize vsize, usize na, usize nb, u64 range, int (*cmp)(const void *, const void *))
+{
+    vec *a = make_set(vsize, na, range, cmp);
+    vec *b = make_set(vsize, nb, range, cmp);
+
+    vec *m = vec_merge(a, b, cmp);
+    assert(m && m->len == a->len + b->len && "vec_merge len failed");
+    vec *i = vec_intersect_sorted(a, b, cmp);
+    vec *u = vec_union_sorted(a, b, cmp);
+    assert(i && u && "vec set op failed");
+
+    usize ni = 0;
+    for (usize k = 0; k < a->len; k++)
+    {
+        ni += naive_contains(b, elem_u64(a, k));
+    }
+    assert(i->len == ni && "vec_intersect_sorted len failed");
+    assert(u->len == a->len + b->len - ni && "vec_union_sorted len failed");
+    for (usize k = 0; k < i->len; k++)
+    {
+        u64 x = elem_u64(i, k);
+        assert(naive_contains(a, x) && naive_contains(b, x) && "vec_intersect_sorted failed");
+    }
+    // 结果有序, merge不去重
+    for (usize k = 1; k < m->len; k++)
+    {
+        assert(elem_u64(m, k - 1) <= elem_u64(m, k) && "vec_merge failed");
+    }
+    for (usize k = 1; k < i->len; k++)
+    {
+        assert(elem_u64(i, k - 1) < elem_u64(i, k) && "vec_intersect_sorted order failed");
+    }
+    for (usize k = 1; k < u->len; k++)
+    {
+        assert(elem_u64(u, k - 1) < elem_u64(u, k) && "vec_union_sorted order failed");
+    }
+
+    vec_free(a);
+    vec_free(b);
+    vec_free(m);
+    vec_free(i);
+    vec_free(u);
+}
+
+void test_sorted_set()
+{
+    printf("\n============== test_sorted_set ===========\n");
+    usize sizes[][2] = {{0, 0}, {0, 50}, {1, 1}, {7, 9}, {100, 120}, {1000, 900}, {10, 5000}, {3000, 40}};
+    for (usize k = 0; k < countof(sizes); k++)
+    {
+        // u32走SIMD, u64按cmp比较, u16按整数比较
+        check_set_ops(4, sizes[k][0], sizes[k][1], 3000, NULL);
+        check_set_ops(8, sizes[k][0], sizes[k][1], 3000, cmp_u64);
+        check_set_ops(2, sizes[k][0], sizes[k][1], 3000, NULL);
+    }
+
+    // 完全相同和完全不相交
+    vec *a = vec_new(sizeof(u32));
+    vec *b = vec_new(sizeof(u32));
+    for (u32 x = 0; x < 1000; x++)
+    {
+        u32 y = x * 2 + 1, z = x * 2;
+        vec_push(a, &z);
+        vec_push(b, &y);
+    }
+    vec *i = vec_intersect_sorted(a, b, NULL);
+    vec *u = vec_union_sorted(a, b, NULL);
+    assert(i->len == 0 && "vec_intersect_sorted disjoint failed");
+    assert(u->len == 2000 && "vec_union_sorted disjoint failed");
+    for (u32 x = 0; x < 2000; x++)
+    {
+        assert(((u32 *)u->mem)[x] == x && "vec_union_sorted disjoint failed");
+    }
+    vec_free(i);
+    i = vec_intersect_sorted(a, a, NULL);
+    assert(i->len == a->len && memcmp(i->mem, a->mem, a->len * sizeof(u32)) == 0 && "vec_intersect_sorted self failed");
+    vec_free(i);
+    vec_free(u);
+
+    // vsize不同
+    vec *c = vec_new(sizeof(u64));
+    assert(vec_merge(a, c, NULL) == NULL && "vec_merge vsize failed");
+    assert(vec_intersect_sorted(a, c, NULL) == NULL && "vec_intersect_sorted vsize failed");
+    assert(vec_union_sorted(a, c, NULL) == NULL && "vec_union_sorted vsize failed");
+    vec_free(a);
+    vec_free(b);
+    vec_free(c);
+}
+
+int main()
+{
+    srand(42);
+    test_sort();
+    test_sort_radix();
+    test_sort_parallel();
+    test_sorted_search();
+    test_sorted_set();
+
+    printf("\nDONE\n");
+    return 0;
+}